@@ -0,0 +1,120 @@
+#include <Autotune.h>
+#include <math.h>
+
+// Same speed estimate as the balance controller, so the tuned loop sees the same lag
+static const float rateFilterGain = 0.3f;
+// Cycles left out while the wheel spins up and the bias settles
+static const uint32_t settleCycles = 2;
+
+void beginAutotune(RelayAutotune* tune, float setpoint, float relay, float hysteresis)
+{
+    tune->setpoint = setpoint;
+    tune->relay = relay;
+    tune->hysteresis = hysteresis;
+    tune->bias = 0.0f;
+
+    tune->time = 0.0f;
+    tune->wheelAngle = 0.0f;
+    tune->wheelSpeed = 0.0f;
+    tune->initialized = false;
+    tune->high = setpoint >= 0.0f;
+
+    tune->riseTime = 0.0f;
+    tune->fallTime = 0.0f;
+    tune->speedMax = 0.0f;
+    tune->speedMin = 0.0f;
+    tune->rises = 0;
+
+    tune->cycles = 0;
+    tune->periodSum = 0.0f;
+    tune->amplitudeSum = 0.0f;
+}
+
+static void finishCycle(RelayAutotune* tune)
+{
+    float period = tune->time - tune->riseTime;
+    float highTime = tune->fallTime - tune->riseTime;
+    float lowTime = tune->time - tune->fallTime;
+
+    // A longer high half means the wheel needs more input than the bias at the setpoint
+    if (period > 0.0f) {
+        float limit = 1.0f - tune->relay;
+        tune->bias += 0.5f * tune->relay * (highTime - lowTime) / period;
+        tune->bias = fminf(fmaxf(tune->bias, -limit), limit);
+    }
+
+    if (tune->rises > settleCycles) {
+        tune->cycles++;
+        tune->periodSum += period;
+        tune->amplitudeSum += 0.5f * (tune->speedMax - tune->speedMin);
+    }
+}
+
+float autotuneStep(RelayAutotune* tune, float wheelAngle, float dt)
+{
+    if (tune->initialized) {
+        float wheelSpeed = (wheelAngle - tune->wheelAngle) / dt;
+        tune->wheelSpeed += rateFilterGain * (wheelSpeed - tune->wheelSpeed);
+        tune->time += dt;
+    }
+    tune->wheelAngle = wheelAngle;
+    tune->initialized = true;
+
+    float speed = tune->wheelSpeed;
+    tune->speedMax = fmaxf(tune->speedMax, speed);
+    tune->speedMin = fminf(tune->speedMin, speed);
+
+    if (tune->high && speed > tune->setpoint + tune->hysteresis) {
+        tune->high = false;
+        tune->fallTime = tune->time;
+    } else if (!tune->high && speed < tune->setpoint - tune->hysteresis) {
+        tune->high = true;
+        if (tune->rises > 0) {
+            finishCycle(tune);
+        }
+        tune->rises++;
+        tune->riseTime = tune->time;
+        tune->speedMax = speed;
+        tune->speedMin = speed;
+    }
+
+    float input = tune->bias + (tune->high ? tune->relay : -tune->relay);
+    return fminf(fmaxf(input, -1.0f), 1.0f);
+}
+
+uint32_t autotuneCycles(const RelayAutotune* tune)
+{
+    return tune->cycles;
+}
+
+bool autotuneUltimate(const RelayAutotune* tune, float* gain, float* period, float* amplitude)
+{
+    if (tune->cycles == 0) {
+        return false;
+    }
+
+    *period = tune->periodSum / tune->cycles;
+    *amplitude = tune->amplitudeSum / tune->cycles;
+
+    // Describing function of a relay with hysteresis; without any, the plain 4 d / (pi a)
+    float h = tune->hysteresis;
+    float effective = (*amplitude > h) ? sqrtf(*amplitude * *amplitude - h * h) : *amplitude;
+    if (!(effective > 0.0f)) {
+        return false;
+    }
+    *gain = 4.0f * tune->relay / (static_cast<float>(M_PI) * effective);
+    return true;
+}
+
+void zieglerNicholsGains(TuningRule rule, float ultimateGain, float ultimatePeriod, float* kp, float* ki, float* kd)
+{
+    if (rule == TUNING_PI) {
+        *kp = 0.45f * ultimateGain;
+        *ki = *kp * 1.2f / ultimatePeriod;
+        *kd = 0.0f;
+    } else {
+        *kp = 0.6f * ultimateGain;
+        *ki = *kp * 2.0f / ultimatePeriod;
+        *kd = *kp * ultimatePeriod / 8.0f;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdint.h>
+
+// Relay feedback experiment (Astrom-Hagglund) on the wheel speed loop.
+// The motor input switches between bias + relay and bias - relay whenever the speed leaves
+// the hysteresis band around the setpoint. The loop settles into a limit cycle at its
+// ultimate period, and the speed amplitude a gives the ultimate gain 4 d / (pi sqrt(a^2 - h^2)).
+// The bias follows the input the wheel needs at the setpoint (friction), so both halves of
+// the cycle end up equally long.
+typedef struct {
+    float setpoint;
+    float relay;
+    float hysteresis;
+    float bias;
+
+    float time;
+    float wheelAngle;
+    float wheelSpeed;
+    bool initialized;
+    bool high;
+
+    // Cycle in progress, from one rising switch to the next
+    float riseTime;
+    float fallTime;
+    float speedMax;
+    float speedMin;
+    uint32_t rises;
+
+    // Settled cycles
+    uint32_t cycles;
+    float periodSum;
+    float amplitudeSum;
+} RelayAutotune;
+
+typedef enum {
+    TUNING_PI = 0,
+    TUNING_PID = 1,
+} TuningRule;
+
+void beginAutotune(RelayAutotune* tune, float setpoint, float relay, float hysteresis);
+
+// Returns the motor input in [-1, 1]. Speeds are estimated like in balanceStep.
+float autotuneStep(RelayAutotune* tune, float wheelAngle, float dt);
+
+// Cycles measured after the start-up transient
+uint32_t autotuneCycles(const RelayAutotune* tune);
+
+// Ultimate gain (input per rad/s), period (s) and speed amplitude (rad/s), averaged over
+// the measured cycles. Returns false before the first one.
+bool autotuneUltimate(const RelayAutotune* tune, float* gain, float* period, float* amplitude);
+
+// Ziegler-Nichols gains from the ultimate point, for u = kp e + ki int(e) + kd de/dt.
+// kd is 0 for TUNING_PI.
+void zieglerNicholsGains(TuningRule rule, float ultimateGain, float ultimatePeriod, float* kp, float* ki, float* kd);
+
+#endif // AUTOTUNE_H
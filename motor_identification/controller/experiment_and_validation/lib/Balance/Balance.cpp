@@ -0,0 +1,33 @@
+#include <Balance.h>
+#include <math.h>
+
+// Weight of the newest finite difference in the rate estimates
+static const float rateFilterGain = 0.3f;
+
+void resetBalance(BalanceState* state)
+{
+    state->tilt = 0.0f;
+    state->tiltRate = 0.0f;
+    state->wheelAngle = 0.0f;
+    state->wheelSpeed = 0.0f;
+    state->initialized = false;
+}
+
+float balanceStep(BalanceState* state, float tilt, float wheelAngle, float dt)
+{
+    if (state->initialized) {
+        float tiltRate = (tilt - state->tilt) / dt;
+        float wheelSpeed = (wheelAngle - state->wheelAngle) / dt;
+        state->tiltRate += rateFilterGain * (tiltRate - state->tiltRate);
+        state->wheelSpeed += rateFilterGain * (wheelSpeed - state->wheelSpeed);
+    }
+    state->tilt = tilt;
+    state->wheelAngle = wheelAngle;
+    state->initialized = true;
+
+    float gains[GAIN_STATES];
+    scheduleGains(state->tilt, state->wheelSpeed, gains);
+
+    float input = -(gains[0] * state->tilt + gains[1] * state->tiltRate + gains[2] * state->wheelSpeed);
+    return fminf(fmaxf(input, -1.0f), 1.0f);
+}
@@ -0,0 +1,21 @@
+#ifndef BALANCE_H
+#define BALANCE_H
+
+#include <GainSchedule.h>
+
+// Gain-scheduled state feedback for the reaction wheel pendulum.
+// Rates are estimated from the measured angles with filtered finite differences.
+typedef struct {
+    float tilt;
+    float tiltRate;
+    float wheelAngle;
+    float wheelSpeed;
+    bool initialized;
+} BalanceState;
+
+void resetBalance(BalanceState* state);
+
+// Returns the motor input in [-1, 1]
+float balanceStep(BalanceState* state, float tilt, float wheelAngle, float dt);
+
+#endif // BALANCE_H
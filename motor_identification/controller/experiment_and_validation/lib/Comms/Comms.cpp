@@ -1,13 +1,479 @@
 #include <Comms.h>
+#include <Params.h>
+#include <Trace.h>
+
+static Transport* commsLink = NULL;
+static const uint8_t* chunkSource = NULL;
+static uint32_t chunkSourceSize = 0;
+static CapabilityReport capabilities;
+static uint32_t linkBaudRate = 0;
+static bool runActive = false;
+static int pendingCode = -1;      // Read, but the rest of its request has not arrived yet
+static uint32_t droppedBytes = 0; // Payload of a refused request still to be dropped
+
+// Every byte the firmware consumes goes through the trace, so a run can be replayed natively
+static int linkAvailable()
+{
+    return traceInt(TRACE_SERIAL_AVAILABLE, commsLink->available());
+}
+
+static int linkRead()
+{
+    return traceInt(TRACE_SERIAL_READ, commsLink->read());
+}
+
+static int linkPeek()
+{
+    return traceInt(TRACE_SERIAL_PEEK, commsLink->peek());
+}
+
+static size_t linkReadBytes(uint8_t* buffer, size_t length)
+{
+    return traceBytes(TRACE_SERIAL_BYTES, buffer, length, commsLink->readBytes(buffer, length));
+}
+
+static void writeValue(const ParamValue& value)
+{
+    commsLink->write(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+}
+
+static void writeFloat(float value)
+{
+    commsLink->write(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+}
+
+// Reply: DEVICE_PARAM_INFO, count, then per parameter:
+// id, type, min (f32), max (f32), default (f32), name length, name
+static void sendParamList()
+{
+    commsLink->write(DEVICE_PARAM_INFO);
+    commsLink->write(static_cast<uint8_t>(PARAM_COUNT));
+
+    for (uint8_t id = 0; id < PARAM_COUNT; id++) {
+        const ParamInfo* info = paramInfo(id);
+        uint8_t nameLength = strlen(info->name);
+
+        commsLink->write(id);
+        commsLink->write(static_cast<uint8_t>(info->type));
+        writeFloat(info->min);
+        writeFloat(info->max);
+        writeFloat(info->defaultValue);
+        commsLink->write(nameLength);
+        commsLink->write(reinterpret_cast<const uint8_t*>(info->name), nameLength);
+    }
+}
+
+// Request: id. Reply: DEVICE_PARAM_VALUE, id, value; or DEVICE_PARAM_ERROR, id.
+static void answerParamGet()
+{
+    uint8_t id;
+    ParamValue value;
+
+    if (linkReadBytes(&id, 1) != 1) {
+        return;
+    }
+
+    if (!getStagedParam(id, &value)) {
+        commsLink->write(DEVICE_PARAM_ERROR);
+        commsLink->write(id);
+        return;
+    }
+
+    commsLink->write(DEVICE_PARAM_VALUE);
+    commsLink->write(id);
+    writeValue(value);
+}
+
+// Request: id, value. Same replies as a get, after staging the value.
+static void answerParamSet()
+{
+    uint8_t id;
+    ParamValue value;
+
+    if (linkReadBytes(&id, 1) != 1) {
+        return;
+    }
+    if (linkReadBytes(reinterpret_cast<uint8_t*>(&value), sizeof(value)) != sizeof(value)) {
+        return;
+    }
+
+    if (!stageParam(id, value)) {
+        commsLink->write(DEVICE_PARAM_ERROR);
+        commsLink->write(id);
+        return;
+    }
+
+    commsLink->write(DEVICE_PARAM_VALUE);
+    commsLink->write(id);
+    writeValue(value);
+}
+
+// Reply: DEVICE_TRACE_DATA, length (u32), overflow flag (u8), log. Ends the recording.
+static void sendTrace()
+{
+    size_t length;
+    bool overflowed;
+    const uint8_t* log = traceLog(&length, &overflowed);
+    uint32_t length32 = length;
+
+    commsLink->write(DEVICE_TRACE_DATA);
+    commsLink->write(reinterpret_cast<const uint8_t*>(&length32), sizeof(length32));
+    commsLink->write(static_cast<uint8_t>(overflowed));
+    if (length > 0) {
+        commsLink->write(log, length);
+    }
+}
+
+// Request: seq. Reply: DEVICE_TIME_SYNC, seq, receive time (u32 us), transmit time (u32 us).
+// The host derives the clock offset from both timestamps, NTP-style.
+static void answerTimeSync()
+{
+    uint32_t receivedUs = traceU32(TRACE_MICROS, micros());
+    uint8_t seq;
+
+    if (linkReadBytes(&seq, 1) != 1) {
+        return;
+    }
+
+    uint8_t frame[2 + 2 * sizeof(uint32_t)];
+    frame[0] = DEVICE_TIME_SYNC;
+    frame[1] = seq;
+    memcpy(&frame[2], &receivedUs, sizeof(receivedUs));
+
+    uint32_t sentUs = traceU32(TRACE_MICROS, micros());
+    memcpy(&frame[2 + sizeof(receivedUs)], &sentUs, sizeof(sentUs));
+    commsLink->write(frame, sizeof(frame));
+}
+
+// --- Link self-test ---
+
+static const uint32_t supportedBaudRates[] = { 115200, 230400, 460800, 921600 };
+static const uint32_t maxBulkSize = 1048576;
+static const unsigned long bulkTimeoutMs = 2000;
+
+// Bulk transfers carry this pattern, so both ends can check every byte without a buffer
+static uint8_t bulkPattern(uint32_t index)
+{
+    return static_cast<uint8_t>(index ^ (index >> 8) ^ (index >> 16));
+}
+
+// Request: length (u8), payload. Reply: DEVICE_ECHO, length, payload.
+static void answerEcho()
+{
+    uint8_t payload[255];
+    uint8_t length;
+
+    if (linkReadBytes(&length, 1) != 1) {
+        return;
+    }
+    if (linkReadBytes(payload, length) != length) {
+        return;
+    }
+
+    commsLink->write(DEVICE_ECHO);
+    commsLink->write(length);
+    commsLink->write(payload, length);
+}
+
+// Request: size (u32). Reply: DEVICE_BULK_DATA, size (u32), pattern bytes.
+static void sendBulk()
+{
+    uint32_t size;
+    uint8_t chunk[256];
+
+    if (linkReadBytes(reinterpret_cast<uint8_t*>(&size), sizeof(size)) != sizeof(size)) {
+        return;
+    }
+    size = min(size, maxBulkSize);
+
+    commsLink->write(DEVICE_BULK_DATA);
+    commsLink->write(reinterpret_cast<const uint8_t*>(&size), sizeof(size));
+
+    for (uint32_t sent = 0; sent < size; sent += sizeof(chunk)) {
+        uint32_t length = min(static_cast<uint32_t>(sizeof(chunk)), size - sent);
+        for (uint32_t i = 0; i < length; i++) {
+            chunk[i] = bulkPattern(sent + i);
+        }
+        commsLink->write(chunk, length);
+    }
+}
+
+// Request: size (u32), pattern bytes.
+// Reply: DEVICE_BULK_RESULT, received (u32), mismatches (u32), first to last byte (u32 us).
+static void receiveBulk()
+{
+    uint32_t size;
+    uint32_t result[3] = { 0, 0, 0 };
+    uint8_t chunk[256];
+
+    if (linkReadBytes(reinterpret_cast<uint8_t*>(&size), sizeof(size)) != sizeof(size)) {
+        return;
+    }
+    size = min(size, maxBulkSize);
+
+    uint32_t firstUs = 0;
+    uint32_t lastUs = 0;
+    uint32_t lastProgressMs = traceU32(TRACE_MILLIS, millis());
+
+    while (result[0] < size && !traceDeadline(TRACE_MILLIS, millis(), lastProgressMs + bulkTimeoutMs)) {
+        int available = linkAvailable();
+        if (available <= 0) {
+            continue;
+        }
+
+        size_t length = min(static_cast<size_t>(available), min(sizeof(chunk), static_cast<size_t>(size - result[0])));
+        length = linkReadBytes(chunk, length);
+
+        lastUs = traceU32(TRACE_MICROS, micros());
+        if (result[0] == 0) {
+            firstUs = lastUs;
+        }
+        lastProgressMs = traceU32(TRACE_MILLIS, millis());
+
+        for (size_t i = 0; i < length; i++) {
+            if (chunk[i] != bulkPattern(result[0] + i)) {
+                result[1]++;
+            }
+        }
+        result[0] += length;
+    }
+    result[2] = lastUs - firstUs;
+
+    commsLink->write(DEVICE_BULK_RESULT);
+    commsLink->write(reinterpret_cast<const uint8_t*>(result), sizeof(result));
+}
+
+// Request: baud rate (u32). Reply: DEVICE_BAUD_ACK, baud rate (u32), or 0 if unsupported.
+// The reply goes out at the old rate; the host switches once it has it.
+static void changeBaudRate()
+{
+    uint32_t baudRate;
+
+    if (linkReadBytes(reinterpret_cast<uint8_t*>(&baudRate), sizeof(baudRate)) != sizeof(baudRate)) {
+        return;
+    }
+
+    bool supported = false;
+    for (size_t i = 0; i < sizeof(supportedBaudRates) / sizeof(supportedBaudRates[0]); i++) {
+        supported = supported || (baudRate == supportedBaudRates[i]);
+    }
+    uint32_t reply = supported ? baudRate : 0;
+
+    commsLink->write(DEVICE_BAUD_ACK);
+    commsLink->write(reinterpret_cast<const uint8_t*>(&reply), sizeof(reply));
+    commsLink->flush();
+
+    if (supported) {
+        commsLink->setBaudRate(baudRate);
+        linkBaudRate = baudRate;
+    }
+}
+
+// Reply: DEVICE_VERSION, length (u8), version string
+static void sendVersion()
+{
+    const char version[] = FIRMWARE_VERSION;
+    uint8_t length = sizeof(version) - 1;
+
+    commsLink->write(DEVICE_VERSION);
+    commsLink->write(length);
+    commsLink->write(reinterpret_cast<const uint8_t*>(version), length);
+}
+
+// Reply: DEVICE_BOARD_ID, factory MAC address (6 bytes), unique per board
+static void sendBoardId()
+{
+    uint64_t mac = ESP.getEfuseMac();
+    uint32_t low = traceU32(TRACE_BOARD_ID, static_cast<uint32_t>(mac));
+    uint32_t high = traceU32(TRACE_BOARD_ID, static_cast<uint32_t>(mac >> 32));
+
+    uint8_t frame[1 + 6] = { DEVICE_BOARD_ID };
+    memcpy(&frame[1], &low, sizeof(low));
+    memcpy(&frame[1 + sizeof(low)], &high, 2);
+    commsLink->write(frame, sizeof(frame));
+}
+
+// Request: offset (u32), length (u16). Reply: DEVICE_CHUNK, see setChunkSource in Comms.h.
+static void sendChunk()
+{
+    uint8_t request[sizeof(uint32_t) + sizeof(uint16_t)];
+    if (linkReadBytes(request, sizeof(request)) != sizeof(request)) {
+        return;
+    }
+
+    uint32_t offset;
+    uint16_t length;
+    memcpy(&offset, &request[0], sizeof(offset));
+    memcpy(&length, &request[sizeof(offset)], sizeof(length));
+
+    length = min(length, commsMaxChunkSize);
+    if (offset >= chunkSourceSize) {
+        length = 0;
+    } else if (length > chunkSourceSize - offset) {
+        length = chunkSourceSize - offset;
+    }
+    memcpy(&request[sizeof(offset)], &length, sizeof(length));
+
+    uint16_t crc = transportCrc16(request, sizeof(request));
+    if (length > 0) {
+        crc = transportCrc16(chunkSource + offset, length, crc);
+    }
+
+    commsLink->write(DEVICE_CHUNK);
+    commsLink->write(request, sizeof(request));
+    if (length > 0) {
+        commsLink->write(chunkSource + offset, length);
+    }
+    commsLink->write(reinterpret_cast<const uint8_t*>(&crc), sizeof(crc));
+}
+
+// Reply: DEVICE_CAPABILITIES, CapabilityReport
+static void sendCapabilities()
+{
+    CapabilityReport report = capabilities;
+    report.linkBaudRate = commsLink->pacedByBaudRate() ? linkBaudRate : 0;
+
+    commsLink->write(DEVICE_CAPABILITIES);
+    commsLink->write(reinterpret_cast<const uint8_t*>(&report), sizeof(report));
+}
+
+// Commands that may arrive at any point of the sequence. Anything else is dropped.
+static void serviceCommand(uint8_t code)
+{
+    switch (code) {
+    case HOST_PARAM_LIST:
+        sendParamList();
+        break;
+    case HOST_PARAM_GET:
+        answerParamGet();
+        break;
+    case HOST_PARAM_SET:
+        answerParamSet();
+        break;
+    case HOST_REQUEST_TRACE:
+        sendTrace();
+        break;
+    case HOST_TIME_SYNC:
+        answerTimeSync();
+        break;
+    case HOST_PING:
+        commsLink->write(DEVICE_PING);
+        break;
+    case HOST_ECHO:
+        answerEcho();
+        break;
+    case HOST_BULK_REQUEST:
+        sendBulk();
+        break;
+    case HOST_BULK_SEND:
+        receiveBulk();
+        break;
+    case HOST_SET_BAUD:
+        changeBaudRate();
+        break;
+    case HOST_GET_VERSION:
+        sendVersion();
+        break;
+    case HOST_GET_BOARD_ID:
+        sendBoardId();
+        break;
+    case HOST_READ_CHUNK:
+        sendChunk();
+        break;
+    case HOST_GET_CAPABILITIES:
+        sendCapabilities();
+        break;
+    default:
+        break;
+    }
+}
+
+// Request bytes that follow the code. For echo and bulk sends only the part before the payload.
+static size_t requestLength(uint8_t code)
+{
+    switch (code) {
+    case HOST_PARAM_GET:
+    case HOST_TIME_SYNC:
+    case HOST_ECHO:
+        return 1;
+    case HOST_PARAM_SET:
+        return 1 + sizeof(ParamValue);
+    case HOST_BULK_REQUEST:
+    case HOST_BULK_SEND:
+    case HOST_SET_BAUD:
+        return sizeof(uint32_t);
+    case HOST_READ_CHUNK:
+        return sizeof(uint32_t) + sizeof(uint16_t);
+    default:
+        return 0;
+    }
+}
+
+// Commands that would hold up a sample: long replies, payloads to wait for, a baud change
+static bool refusedDuringRun(uint8_t code)
+{
+    switch (code) {
+    case HOST_PARAM_LIST:
+    case HOST_REQUEST_TRACE:
+    case HOST_ECHO:
+    case HOST_BULK_REQUEST:
+    case HOST_BULK_SEND:
+    case HOST_SET_BAUD:
+    case HOST_READ_CHUNK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Reply: DEVICE_BUSY, code. The request has fully arrived; a payload after it is dropped later.
+static void refuseCommand(uint8_t code)
+{
+    uint8_t request[sizeof(uint32_t) + sizeof(uint16_t)];
+    linkReadBytes(request, requestLength(code));
+
+    if (code == HOST_ECHO) {
+        droppedBytes = request[0];
+    } else if (code == HOST_BULK_SEND) {
+        memcpy(&droppedBytes, request, sizeof(droppedBytes));
+    }
+
+    uint8_t reply[2] = { DEVICE_BUSY, code };
+    commsLink->write(reply, sizeof(reply));
+}
+
+void setCapabilities(const CapabilityReport* report)
+{
+    capabilities = *report;
+}
+
+void setChunkSource(const uint8_t* data, uint32_t size)
+{
+    chunkSource = data;
+    chunkSourceSize = size;
+}
+
+ResultCode beginComms(Transport* transport, uint32_t baudRate)
+{
+    commsLink = transport;
+    linkBaudRate = baudRate;
+    return commsLink->begin(baudRate) ? RESULT_OK : RESULT_ERROR;
+}
+
+Transport* commsTransport()
+{
+    return commsLink;
+}
 
 ResultCode waitForConnectionCheck()
 {
     while (true) {
-        if (Serial.available() > 0) {
-            uint8_t code = Serial.read();
+        if (linkAvailable() > 0) {
+            uint8_t code = linkRead();
             if (code == HOST_CHECK_CONNECTION) {
                 return RESULT_OK;
             }
+            serviceCommand(code);
         }
         yield();
     }
@@ -15,7 +481,7 @@ ResultCode waitForConnectionCheck()
 
 ResultCode answerConnectionCheck()
 {
-    Serial.write(DEVICE_CHECK_CONNECTION);
+    commsLink->write(DEVICE_CHECK_CONNECTION);
     return RESULT_OK;
 }
 
@@ -30,14 +496,28 @@ ResultCode connectionCheck()
     return RESULT_OK;
 }
 
-ResultCode waitForStartCommand()
+ResultCode waitForStartCommand(TestMode* mode)
 {
     while (true) {
-        if (Serial.available() > 0) {
-            uint8_t code = Serial.read();
+        if (linkAvailable() > 0) {
+            uint8_t code = linkRead();
             if (code == HOST_START_TEST) {
+                *mode = TEST_MOTOR;
+                return RESULT_OK;
+            }
+            if (code == HOST_START_HIL) {
+                *mode = TEST_HIL;
+                return RESULT_OK;
+            }
+            if (code == HOST_START_AUTOTUNE) {
+                *mode = TEST_AUTOTUNE;
                 return RESULT_OK;
             }
+            if (code == HOST_START_MIMO) {
+                *mode = TEST_MIMO;
+                return RESULT_OK;
+            }
+            serviceCommand(code);
         }
         yield();
     }
@@ -47,24 +527,32 @@ ResultCode waitForStartCommand()
 
 ResultCode ackStartCommand()
 {
-    Serial.write(DEVICE_ACK_START);
+    commsLink->write(DEVICE_ACK_START);
+    return RESULT_OK;
+}
+
+ResultCode refuseStartCommand(uint8_t id)
+{
+    commsLink->write(DEVICE_PARAM_ERROR);
+    commsLink->write(id);
     return RESULT_OK;
 }
 
 ResultCode sendSuccessMessage()
 {
-    Serial.write(DEVICE_TEST_SUCCESS);
+    commsLink->write(DEVICE_TEST_SUCCESS);
     return RESULT_OK;
 }
 
 ResultCode waitForDataRequest()
 {
     while (true) {
-        if (Serial.available() > 0) {
-            uint8_t code = Serial.read();
+        if (linkAvailable() > 0) {
+            uint8_t code = linkRead();
             if (code == HOST_REQUEST_DATA) {
                 return RESULT_OK;
             }
+            serviceCommand(code);
         }
         yield();
     }
@@ -74,6 +562,123 @@ ResultCode waitForDataRequest()
 
 ResultCode ackDataRequest()
 {
-    Serial.write(DEVICE_DATA_REQUEST_ACK);
+    commsLink->write(DEVICE_DATA_REQUEST_ACK);
     return RESULT_OK;
 }
+
+static const size_t hilSensorFrameSize = 1 + sizeof(uint16_t) + 2 * sizeof(float);
+
+ResultCode sendHilActuator(uint16_t tick, float input)
+{
+    uint8_t frame[1 + sizeof(tick) + sizeof(input)];
+
+    frame[0] = DEVICE_HIL_ACTUATOR;
+    memcpy(&frame[1], &tick, sizeof(tick));
+    memcpy(&frame[1 + sizeof(tick)], &input, sizeof(input));
+
+    commsLink->write(frame, sizeof(frame));
+    return RESULT_OK;
+}
+
+ResultCode receiveHilSensor(uint16_t tick, uint32_t deadlineUs, HilSensor* sensor)
+{
+    uint8_t frame[hilSensorFrameSize];
+
+    while (!traceDeadline(TRACE_MICROS, micros(), deadlineUs)) {
+        int available = linkAvailable();
+        if (available == 0) {
+            continue;
+        }
+
+        // Resynchronize on the frame code after a lost byte
+        if (linkPeek() != HOST_HIL_SENSOR) {
+            linkRead();
+            continue;
+        }
+        if (available < static_cast<int>(hilSensorFrameSize)) {
+            continue;
+        }
+
+        linkReadBytes(frame, hilSensorFrameSize);
+
+        uint16_t frameTick;
+        memcpy(&frameTick, &frame[1], sizeof(frameTick));
+        if (frameTick != tick) {
+            continue; // Late answer to an earlier tick
+        }
+
+        memcpy(&sensor->tilt, &frame[1 + sizeof(frameTick)], sizeof(sensor->tilt));
+        memcpy(&sensor->wheelAngle, &frame[1 + sizeof(frameTick) + sizeof(sensor->tilt)], sizeof(sensor->wheelAngle));
+        return RESULT_OK;
+    }
+
+    return RESULT_ERROR;
+}
+
+ResultCode sendHilReport(const HilReport* report)
+{
+    commsLink->write(DEVICE_HIL_REPORT);
+    commsLink->write(reinterpret_cast<const uint8_t*>(report), sizeof(*report));
+    return RESULT_OK;
+}
+
+ResultCode sendAutotuneReport(const AutotuneReport* report)
+{
+    commsLink->write(DEVICE_AUTOTUNE_REPORT);
+    commsLink->write(reinterpret_cast<const uint8_t*>(report), sizeof(*report));
+    return RESULT_OK;
+}
+
+ResultCode pollCommands()
+{
+    while (true) {
+        int available = linkAvailable();
+
+        if (droppedBytes > 0) {
+            if (runActive && available <= 0) {
+                return RESULT_OK;
+            }
+            uint8_t scratch[64];
+            size_t length = min(static_cast<size_t>(droppedBytes), sizeof(scratch));
+            if (runActive) {
+                length = min(length, static_cast<size_t>(available));
+            }
+            size_t dropped = linkReadBytes(scratch, length);
+            droppedBytes = (dropped > 0) ? droppedBytes - dropped : 0; // The host gave up on the rest
+            continue;
+        }
+
+        if (pendingCode < 0) {
+            if (available <= 0) {
+                return RESULT_OK;
+            }
+            pendingCode = linkRead();
+            continue;
+        }
+
+        // During a run only a request that has fully arrived is read, so a sample never waits
+        if (runActive && available < static_cast<int>(requestLength(pendingCode))) {
+            return RESULT_OK;
+        }
+        uint8_t code = pendingCode;
+        pendingCode = -1;
+        if (runActive && refusedDuringRun(code)) {
+            refuseCommand(code);
+        } else {
+            serviceCommand(code);
+        }
+    }
+}
+
+void beginRun()
+{
+    runActive = true;
+}
+
+void endRun()
+{
+    runActive = false;
+
+    // Whatever the run left half-read is finished now that waiting is allowed again
+    pollCommands();
+}
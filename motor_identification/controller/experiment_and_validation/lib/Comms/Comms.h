@@ -2,6 +2,12 @@
 #define COMMS_H
 
 #include <Arduino.h>
+#include <Transport.h>
+
+// 1 kHz HIL frames need at least 460800 baud, see the nodemcu-32s-hil environment
+#ifndef COMMS_BAUD_RATE
+#define COMMS_BAUD_RATE 115200
+#endif
 
 typedef enum {
     HOST_CHECK_CONNECTION = 0x01,
@@ -11,8 +17,48 @@ typedef enum {
     DEVICE_TEST_SUCCESS = 0x05,
     HOST_REQUEST_DATA = 0x06,
     DEVICE_DATA_REQUEST_ACK = 0x07,
+    HOST_PARAM_LIST = 0x08,
+    HOST_PARAM_GET = 0x09,
+    HOST_PARAM_SET = 0x0A,
+    DEVICE_PARAM_INFO = 0x0B,
+    DEVICE_PARAM_VALUE = 0x0C,
+    DEVICE_PARAM_ERROR = 0x0D,
+    HOST_START_HIL = 0x0E,
+    DEVICE_HIL_ACTUATOR = 0x0F,
+    HOST_HIL_SENSOR = 0x10,
+    DEVICE_HIL_REPORT = 0x11,
+    HOST_REQUEST_TRACE = 0x12,
+    DEVICE_TRACE_DATA = 0x13,
+    HOST_TIME_SYNC = 0x14,
+    DEVICE_TIME_SYNC = 0x15,
+    HOST_PING = 0x16,
+    DEVICE_PING = 0x17,
+    HOST_ECHO = 0x18,
+    DEVICE_ECHO = 0x19,
+    HOST_BULK_REQUEST = 0x1A,
+    DEVICE_BULK_DATA = 0x1B,
+    HOST_BULK_SEND = 0x1C,
+    DEVICE_BULK_RESULT = 0x1D,
+    HOST_SET_BAUD = 0x1E,
+    DEVICE_BAUD_ACK = 0x1F,
+    HOST_GET_VERSION = 0x20,
+    DEVICE_VERSION = 0x21,
+    HOST_GET_BOARD_ID = 0x22,
+    DEVICE_BOARD_ID = 0x23,
+    HOST_READ_CHUNK = 0x24,
+    DEVICE_CHUNK = 0x25,
+    HOST_START_AUTOTUNE = 0x26,
+    DEVICE_AUTOTUNE_REPORT = 0x27,
+    HOST_GET_CAPABILITIES = 0x28,
+    DEVICE_CAPABILITIES = 0x29,
+    HOST_START_MIMO = 0x2A,
+    DEVICE_BUSY = 0x2B,
 } CommCode;
 
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION __DATE__ " " __TIME__
+#endif
+
 static const char DEVICE_DATA_STREAM_START[] = "DATA_START";
 static const char DEVICE_DATA_STREAM_END[] = "DATA_END";
 
@@ -21,14 +67,104 @@ typedef enum {
     RESULT_ERROR = 0x01,
 } ResultCode;
 
+typedef enum {
+    TEST_MOTOR = 0x00,
+    TEST_HIL = 0x01,
+    TEST_AUTOTUNE = 0x02,
+    TEST_MIMO = 0x03,
+} TestMode;
+
+// Simulated sensor values sent by the host every HIL tick
+typedef struct {
+    float tilt;
+    float wheelAngle;
+} HilSensor;
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t misses;
+    uint32_t rttMinUs;
+    uint32_t rttMeanUs;
+    uint32_t rttMaxUs;
+} HilReport;
+
+// Outcome of the relay autotune. Gains map the speed error (rad/s) to the motor input.
+// cycles is 0 when the relay never settled into a limit cycle; the rest is then 0 too.
+typedef struct {
+    uint32_t cycles;
+    float ultimateGain;
+    float ultimatePeriod; // s
+    float amplitude;      // rad/s
+    float bias;           // Input the relay centred on
+    float piKp;
+    float piKi;
+    float pidKp;
+    float pidKi;
+    float pidKd;
+} AutotuneReport;
+
+// What this build keeps up with, measured by the capability probe at boot
+typedef struct {
+    uint32_t sampleWorstUs;     // Slowest motor test sample, without commands, telemetry or the wait
+    uint32_t sampleMeanUs;
+    uint32_t minSamplePeriodMs; // Smallest sample_period_ms with headroom over sampleWorstUs
+    uint32_t bufferSamples;     // Samples per motor test run
+    uint32_t hilWorstUs;        // Slowest HIL controller step, without the link
+    uint32_t hilPeriodUs;
+    uint32_t linkBaudRate;      // Current rate when sent, 0 if the link has no baud rate limit
+    uint32_t telemetryChannels; // Streamed per sample, 0 without TELEMETRY_UDP
+} CapabilityReport;
+
+// Begins the transport and routes every message through it. Call before anything else.
+ResultCode beginComms(Transport* transport, uint32_t baudRate);
+// For bulk payloads sent outside the command handlers (e.g. test data)
+Transport* commsTransport();
+
 ResultCode waitForConnectionCheck();
 ResultCode answerConnectionCheck();
 ResultCode connectionCheck();
-ResultCode waitForStartCommand();
+ResultCode waitForStartCommand(TestMode* mode);
 ResultCode ackStartCommand();
+// Answers the start command with DEVICE_PARAM_ERROR, id instead of the ack: the staged
+// parameter id does not fit the requested run, which does not start.
+ResultCode refuseStartCommand(uint8_t id);
 
 ResultCode sendSuccessMessage();
 ResultCode waitForDataRequest();
 ResultCode ackDataRequest();
 
+// Data served by HOST_READ_CHUNK, so a host can fetch again whatever part of the
+// data stream arrived damaged. Must stay valid for as long as commands are serviced.
+// Request: offset (u32), length (u16).
+// Reply: DEVICE_CHUNK, offset (u32), length (u16), data, CRC-16/CCITT (u16) over offset to data.
+// length is clipped to commsMaxChunkSize and to the end of the data.
+static const uint16_t commsMaxChunkSize = 1024;
+void setChunkSource(const uint8_t* data, uint32_t size);
+
+// Descriptor served by HOST_GET_CAPABILITIES. Reply: DEVICE_CAPABILITIES, CapabilityReport.
+// Until it is set the reply is all zeros, which hosts take as "not probed".
+void setCapabilities(const CapabilityReport* report);
+
+// Frames: DEVICE_HIL_ACTUATOR, tick (u16), input (f32)
+//         HOST_HIL_SENSOR, tick (u16), tilt (f32), wheel angle (f32)
+//         DEVICE_HIL_REPORT, HilReport
+ResultCode sendHilActuator(uint16_t tick, float input);
+// Waits until deadlineUs (micros()) for the sensor frame of the given tick, dropping stale ones
+ResultCode receiveHilSensor(uint16_t tick, uint32_t deadlineUs, HilSensor* sensor);
+ResultCode sendHilReport(const HilReport* report);
+
+// Frame: DEVICE_AUTOTUNE_REPORT, AutotuneReport
+ResultCode sendAutotuneReport(const AutotuneReport* report);
+
+// Services pending host commands that are not part of the test sequence (e.g. parameters).
+// Never blocks when nothing is pending.
+ResultCode pollCommands();
+
+// Brackets a sampled run. In between, pollCommands() never blocks: a request is handled once
+// all of it has arrived, and commands whose request or reply takes longer than a sample
+// (parameter list, trace, echo, bulk transfers, baud change, chunk reads) are answered with
+// DEVICE_BUSY, code. Their payload is dropped as it arrives.
+void beginRun();
+void endRun();
+
 #endif // COMMS_H
@@ -0,0 +1,58 @@
+#include <Excitation.h>
+#include <ExcitationTable.h>
+#include <stdint.h>
+
+static const unsigned int rampPeriods = 2;
+static const float dwellLevels[] = { 0.1f, -0.1f, 0.25f, -0.25f, 0.5f, -0.5f, 1.0f, -1.0f };
+static const unsigned int dwellCount = sizeof(dwellLevels) / sizeof(dwellLevels[0]);
+
+// One period of the sequence, built on first use
+static uint8_t prbsBits[(PRBS_PERIOD + 7) / 8];
+static bool prbsReady = false;
+
+float frictionProfile(unsigned int sample, unsigned int length, float amplitude)
+{
+    unsigned int rampLength = length / 2;
+
+    if (sample < rampLength) {
+        // Triangle 0 -> +1 -> 0 -> -1 -> 0, rampPeriods times
+        float phase = static_cast<float>(sample * rampPeriods % rampLength) / rampLength * 4.0f;
+        float shape = (phase < 1.0f) ? phase : (phase < 3.0f) ? 2.0f - phase : phase - 4.0f;
+        return amplitude * shape;
+    }
+
+    unsigned int dwell = (sample - rampLength) * dwellCount / (length - rampLength);
+    return amplitude * dwellLevels[dwell < dwellCount ? dwell : dwellCount - 1];
+}
+
+static void buildPrbs()
+{
+    uint16_t state = 0x1FF;
+    for (unsigned int i = 0; i < PRBS_PERIOD; i++) {
+        uint8_t bit = state & 1;
+        prbsBits[i / 8] |= bit << (i % 8);
+        uint16_t feedback = ((state >> 0) ^ (state >> 4)) & 1;
+        state = (state >> 1) | (feedback << 8);
+    }
+    prbsReady = true;
+}
+
+float prbsLevel(unsigned int sample, unsigned int shiftBits, unsigned int hold, float amplitude)
+{
+    if (!prbsReady) {
+        buildPrbs();
+    }
+    unsigned int index = (sample / hold + shiftBits) % PRBS_PERIOD;
+    return (prbsBits[index / 8] >> (index % 8) & 1) ? amplitude : -amplitude;
+}
+
+float designedLevel(unsigned int sample)
+{
+    unsigned int index = sample > 0 ? (sample - 1) / EXCITATION_TABLE_HOLD_SAMPLES : EXCITATION_TABLE_LENGTH;
+    return index < EXCITATION_TABLE_LENGTH ? EXCITATION_TABLE[index] : 0.0f;
+}
+
+unsigned int designedSamplePeriodMs()
+{
+    return EXCITATION_TABLE_SAMPLE_PERIOD_MS;
+}
@@ -0,0 +1,36 @@
+#ifndef EXCITATION_H
+#define EXCITATION_H
+
+// Input signal of the motor test, selected with the "excitation" parameter
+typedef enum {
+    EXCITATION_RANDOM_STEPS = 0, // Random levels in [-amplitude, amplitude], see input_change_time_ms
+    EXCITATION_FRICTION = 1,     // Slow ramps and low-speed dwells for friction identification
+    EXCITATION_PRBS = 2,         // Pseudo-random binary sequence, see prbsLevel()
+    EXCITATION_DESIGNED = 3,     // Sequence of ExcitationTable.h, see designedLevel()
+} Excitation;
+
+// Maximum-length sequence of a 9-bit LFSR (x^9 + x^5 + 1)
+static const unsigned int PRBS_PERIOD = 511;
+
+// Friction run over length samples: the first half is two slow triangles through
+// +amplitude and -amplitude, the second half holds levels of alternating sign and growing
+// size (10 % to 100 % of amplitude), long enough for the wheel to settle at each.
+// The host fitter (host/tools friction_fit) does not depend on the exact shape.
+float frictionProfile(unsigned int sample, unsigned int length, float amplitude);
+
+// +amplitude or -amplitude, holding each bit of the sequence for hold samples, starting
+// shiftBits into it. Copies shifted against each other correlate at -1/PRBS_PERIOD only,
+// so two motors driven with copies half a period apart can be told apart in one run.
+float prbsLevel(unsigned int sample, unsigned int shiftBits, unsigned int hold, float amplitude);
+
+// Level of the designed sequence (host/tools excitation_design) recorded at sample: each
+// entry of ExcitationTable.h holds for EXCITATION_TABLE_HOLD_SAMPLES samples, starting with
+// the first one after sample 0, and the motor rests once the table is over. The levels are
+// absolute inputs, so input_amplitude does not apply. The first and last entries are 0.
+float designedLevel(unsigned int sample);
+
+// sample_period_ms the designed sequence was computed for. Its holds and rate limit only
+// mean something at that period, so a designed run at any other one is refused.
+unsigned int designedSamplePeriodMs();
+
+#endif // EXCITATION_H
@@ -0,0 +1,66 @@
+// Generated by motor_identification/host/tools excitation_design. Do not edit.
+// D-optimal for sample_period_ms = 10, 4096 samples, log det F = 127.529
+#ifndef EXCITATION_TABLE_H
+#define EXCITATION_TABLE_H
+
+constexpr unsigned int EXCITATION_TABLE_LENGTH = 410;
+constexpr unsigned int EXCITATION_TABLE_HOLD_SAMPLES = 10;
+constexpr unsigned int EXCITATION_TABLE_SAMPLE_PERIOD_MS = 10;
+
+// Motor input per hold of EXCITATION_TABLE_HOLD_SAMPLES samples
+constexpr float EXCITATION_TABLE[EXCITATION_TABLE_LENGTH] = {
+    0.0f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, 0.125f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.0f, 0.0625f, 0.0f, 0.0625f, -0.0625f, 0.125f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f,
+    0.25f, 0.25f, 0.25f, 0.25f, 0.25f, 0.0f, 0.0625f, 0.0625f,
+    -0.125f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f, -0.0625f, -0.125f,
+    -0.0625f, 0.25f, 0.25f, 0.125f, 0.125f, 0.25f, 0.25f, -0.125f,
+    -0.25f, -0.25f, 0.125f, -0.25f, -0.1875f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.25f, -0.1875f, -0.25f, -0.25f, -0.25f, -0.25f, -0.25f,
+    -0.25f, -0.1875f, -0.25f, -0.1875f, -0.25f, -0.25f, -0.25f, -0.1875f,
+    -0.25f, -0.25f, -0.1875f, 0.0625f, -0.0625f, -0.25f, -0.25f, -0.1875f,
+    -0.1875f, -0.0625f, -0.25f, -0.1875f, -0.0625f, -0.25f, -0.25f, 0.125f,
+    0.0f, -0.25f, 0.25f, 0.125f, 0.25f, -0.1875f, 0.0f, -0.0625f,
+    0.25f, 0.0f, 0.125f, -0.0625f, 0.0625f, 0.125f, -0.125f, -0.1875f,
+    0.125f, -0.0625f, 0.25f, 0.0f, 0.0f, 0.125f, -0.0625f, -0.25f,
+    -0.25f, -0.25f, 0.25f, 0.0f, 0.0f, 0.0625f, 0.125f, 0.125f,
+    0.25f, 0.1875f, 0.1875f, 0.0f, -0.25f, 0.125f, 0.1875f, 0.0625f,
+    -0.0625f, 0.0f, 0.0f, -0.25f, 0.25f, 0.0625f, 0.0625f, -0.1875f,
+    0.25f, -0.25f, 0.1875f, -0.0625f, 0.1875f, -0.0625f, -0.1875f, -0.1875f,
+    -0.0625f, 0.1875f, 0.0f, 0.0625f, -0.125f, -0.0625f, 0.0625f, 0.125f,
+    0.25f, -0.25f, 0.1875f, 0.25f, -0.0625f, -0.125f, 0.25f, -0.0625f,
+    0.0f, 0.125f, -0.0625f, 0.0f, 0.0625f, -0.1875f, 0.25f, 0.0f,
+    0.0f, 0.0f,
+};
+
+#endif // EXCITATION_TABLE_H
@@ -0,0 +1,13 @@
+#include <Friction.h>
+#include <math.h>
+
+float frictionCompensation(float wheelSpeed)
+{
+    float speedPos = (fminf(fmaxf(wheelSpeed, FRICTION_SPEED_MIN), FRICTION_SPEED_MAX) - FRICTION_SPEED_MIN) * FRICTION_SPEED_STEP_INV;
+
+    // The upper border belongs to the last cell
+    unsigned int cell = static_cast<unsigned int>(fminf(speedPos, FRICTION_SPEED_POINTS - 2));
+    float frac = speedPos - cell;
+
+    return FRICTION_TABLE[cell] + frac * (FRICTION_TABLE[cell + 1] - FRICTION_TABLE[cell]);
+}
@@ -0,0 +1,12 @@
+#ifndef FRICTION_H
+#define FRICTION_H
+
+#include <FrictionTable.h>
+
+// Motor input that cancels the identified wheel friction at the given speed (rad/s),
+// interpolated linearly in the table. Speeds outside the table are clamped to its border.
+// The table crosses zero speed linearly, so the sign change of the Coulomb and Stribeck
+// terms is spread over one grid step rather than chattering around standstill.
+float frictionCompensation(float wheelSpeed);
+
+#endif // FRICTION_H
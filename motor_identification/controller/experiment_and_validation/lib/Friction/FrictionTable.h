@@ -0,0 +1,22 @@
+// Placeholder until host/tools friction_fit has run against the motor: no compensation.
+// friction_fit overwrites this file. Do not edit.
+#ifndef FRICTION_TABLE_H
+#define FRICTION_TABLE_H
+
+constexpr unsigned int FRICTION_SPEED_POINTS = 41;
+
+constexpr float FRICTION_SPEED_MIN = -400.0f;
+constexpr float FRICTION_SPEED_MAX = 400.0f;
+constexpr float FRICTION_SPEED_STEP_INV = 0.05f;
+
+// Motor input per wheel speed, from FRICTION_SPEED_MIN to FRICTION_SPEED_MAX
+constexpr float FRICTION_TABLE[FRICTION_SPEED_POINTS] = {
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f,
+};
+
+#endif // FRICTION_TABLE_H
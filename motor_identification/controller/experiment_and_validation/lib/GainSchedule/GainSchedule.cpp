@@ -0,0 +1,27 @@
+#include <GainSchedule.h>
+#include <math.h>
+
+void scheduleGains(float tilt, float wheelSpeed, float gains[GAIN_STATES])
+{
+    // Fractional grid coordinates, using the precomputed reciprocals of the grid steps
+    float tiltPos = (fminf(fmaxf(tilt, GAIN_TILT_MIN), GAIN_TILT_MAX) - GAIN_TILT_MIN) * GAIN_TILT_STEP_INV;
+    float speedPos = (fminf(fmaxf(wheelSpeed, GAIN_SPEED_MIN), GAIN_SPEED_MAX) - GAIN_SPEED_MIN) * GAIN_SPEED_STEP_INV;
+
+    // The upper border belongs to the last cell
+    unsigned int tiltCell = static_cast<unsigned int>(fminf(tiltPos, GAIN_TILT_POINTS - 2));
+    unsigned int speedCell = static_cast<unsigned int>(fminf(speedPos, GAIN_SPEED_POINTS - 2));
+
+    float tiltFrac = tiltPos - tiltCell;
+    float speedFrac = speedPos - speedCell;
+
+    const float* g00 = &GAIN_TABLE[(tiltCell * GAIN_SPEED_POINTS + speedCell) * GAIN_STATES];
+    const float* g01 = g00 + GAIN_STATES;
+    const float* g10 = g00 + GAIN_SPEED_POINTS * GAIN_STATES;
+    const float* g11 = g10 + GAIN_STATES;
+
+    for (unsigned int i = 0; i < GAIN_STATES; i++) {
+        float low = g00[i] + speedFrac * (g01[i] - g00[i]);
+        float high = g10[i] + speedFrac * (g11[i] - g10[i]);
+        gains[i] = low + tiltFrac * (high - low);
+    }
+}
@@ -0,0 +1,10 @@
+#ifndef GAIN_SCHEDULE_H
+#define GAIN_SCHEDULE_H
+
+#include <GainTable.h>
+
+// Bilinear interpolation of the state feedback gains over the (tilt, wheel speed) grid.
+// Operating points outside the grid are clamped to its border.
+void scheduleGains(float tilt, float wheelSpeed, float gains[GAIN_STATES]);
+
+#endif // GAIN_SCHEDULE_H
@@ -0,0 +1,84 @@
+// Generated by motor_identification/host/gain_schedule.py. Do not edit.
+#ifndef GAIN_TABLE_H
+#define GAIN_TABLE_H
+
+constexpr unsigned int GAIN_STATES = 3;
+constexpr unsigned int GAIN_TILT_POINTS = 8;
+constexpr unsigned int GAIN_SPEED_POINTS = 7;
+
+constexpr float GAIN_TILT_MIN = -0.35f;
+constexpr float GAIN_TILT_MAX = 0.35f;
+constexpr float GAIN_TILT_STEP_INV = 10.0f;
+constexpr float GAIN_SPEED_MIN = -300.0f;
+constexpr float GAIN_SPEED_MAX = 300.0f;
+constexpr float GAIN_SPEED_STEP_INV = 0.01f;
+
+// [tilt][wheel speed][state], row-major
+constexpr float GAIN_TABLE[GAIN_TILT_POINTS * GAIN_SPEED_POINTS * GAIN_STATES] = {
+    // tilt = -0.3500 rad
+    -92.5263611f, -12.0512037f, -0.0317012408f,
+    -60.4099343f, -7.8541738f, -0.0314598888f,
+    -49.7951966f, -6.46282299f, -0.0313421402f,
+    -44.5048724f, -5.76781587f, -0.0312550343f,
+    -49.7951966f, -6.46282299f, -0.0313421402f,
+    -60.4099343f, -7.8541738f, -0.0314598888f,
+    -92.5263611f, -12.0512037f, -0.0317012408f,
+    // tilt = -0.2500 rad
+    -94.9564109f, -12.1800731f, -0.0316975603f,
+    -61.8133719f, -7.91681158f, -0.0314563055f,
+    -50.8576381f, -6.50363361f, -0.0313386328f,
+    -45.397578f, -5.79787006f, -0.0312515849f,
+    -50.8576381f, -6.50363361f, -0.0313386328f,
+    -61.8133719f, -7.91681158f, -0.0314563055f,
+    -94.9564109f, -12.1800731f, -0.0316975603f,
+    // tilt = -0.1500 rad
+    -96.5870393f, -12.2656558f, -0.0316951162f,
+    -62.7539246f, -7.95843318f, -0.0314539245f,
+    -51.5689355f, -6.53075941f, -0.0313363015f,
+    -45.9947457f, -5.81784927f, -0.0312492919f,
+    -51.5689355f, -6.53075941f, -0.0313363015f,
+    -62.7539246f, -7.95843318f, -0.0314539245f,
+    -96.5870393f, -12.2656558f, -0.0316951162f,
+    // tilt = -0.0500 rad
+    -97.4055533f, -12.3083515f, -0.0316938968f,
+    -63.225694f, -7.97920438f, -0.0314527362f,
+    -51.925498f, -6.54429883f, -0.0313351378f,
+    -46.2939508f, -5.82782245f, -0.0312481472f,
+    -51.925498f, -6.54429883f, -0.0313351378f,
+    -63.225694f, -7.97920438f, -0.0314527362f,
+    -97.4055533f, -12.3083515f, -0.0316938968f,
+    // tilt = +0.0500 rad
+    -97.4055533f, -12.3083515f, -0.0316938968f,
+    -63.225694f, -7.97920438f, -0.0314527362f,
+    -51.925498f, -6.54429883f, -0.0313351378f,
+    -46.2939508f, -5.82782245f, -0.0312481472f,
+    -51.925498f, -6.54429883f, -0.0313351378f,
+    -63.225694f, -7.97920438f, -0.0314527362f,
+    -97.4055533f, -12.3083515f, -0.0316938968f,
+    // tilt = +0.1500 rad
+    -96.5870393f, -12.2656558f, -0.0316951162f,
+    -62.7539246f, -7.95843318f, -0.0314539245f,
+    -51.5689355f, -6.53075941f, -0.0313363015f,
+    -45.9947457f, -5.81784927f, -0.0312492919f,
+    -51.5689355f, -6.53075941f, -0.0313363015f,
+    -62.7539246f, -7.95843318f, -0.0314539245f,
+    -96.5870393f, -12.2656558f, -0.0316951162f,
+    // tilt = +0.2500 rad
+    -94.9564109f, -12.1800731f, -0.0316975603f,
+    -61.8133719f, -7.91681158f, -0.0314563055f,
+    -50.8576381f, -6.50363361f, -0.0313386328f,
+    -45.397578f, -5.79787006f, -0.0312515849f,
+    -50.8576381f, -6.50363361f, -0.0313386328f,
+    -61.8133719f, -7.91681158f, -0.0314563055f,
+    -94.9564109f, -12.1800731f, -0.0316975603f,
+    // tilt = +0.3500 rad
+    -92.5263611f, -12.0512037f, -0.0317012408f,
+    -60.4099343f, -7.8541738f, -0.0314598888f,
+    -49.7951966f, -6.46282299f, -0.0313421402f,
+    -44.5048724f, -5.76781587f, -0.0312550343f,
+    -49.7951966f, -6.46282299f, -0.0313421402f,
+    -60.4099343f, -7.8541738f, -0.0314598888f,
+    -92.5263611f, -12.0512037f, -0.0317012408f,
+};
+
+#endif // GAIN_TABLE_H
@@ -0,0 +1,99 @@
+#include <Params.h>
+
+static const ParamInfo paramTable[PARAM_COUNT] = {
+    // name, type, min, max, default
+    { "sample_period_ms", PARAM_TYPE_UINT32, 1.0f, 100.0f, 10.0f },
+    { "input_change_time_ms", PARAM_TYPE_UINT32, 10.0f, 10000.0f, 200.0f },
+    { "input_amplitude", PARAM_TYPE_FLOAT, 0.0f, 1.0f, 0.25f },
+    { "hil_ticks", PARAM_TYPE_UINT32, 1.0f, 3600000.0f, 10000.0f },
+    { "excitation", PARAM_TYPE_UINT32, 0.0f, 3.0f, 0.0f }, // See Excitation.h
+    { "friction_compensation", PARAM_TYPE_FLOAT, 0.0f, 1.0f, 0.0f }, // Share of FrictionTable.h added in HIL runs
+    { "autotune_setpoint", PARAM_TYPE_FLOAT, -200.0f, 200.0f, 20.0f }, // rad/s
+    { "autotune_relay", PARAM_TYPE_FLOAT, 0.01f, 1.0f, 0.1f },
+    { "autotune_hysteresis", PARAM_TYPE_FLOAT, 0.0f, 50.0f, 1.0f }, // rad/s
+    { "autotune_cycles", PARAM_TYPE_UINT32, 1.0f, 50.0f, 5.0f },
+    { "prbs_hold_samples", PARAM_TYPE_UINT32, 1.0f, 100.0f, 2.0f },
+};
+
+// Double buffer: the control loop reads the active set while the host edits the other one.
+// Commands are serviced from the loop task, so staging and committing never interleave;
+// the swap only guarantees that a whole control period sees one consistent set.
+static ParamValue paramBuffers[2][PARAM_COUNT];
+static volatile uint8_t activeBuffer = 0;
+static volatile bool paramsStaged = false;
+
+void resetParams()
+{
+    for (unsigned int i = 0; i < PARAM_COUNT; i++) {
+        ParamValue value;
+        if (paramTable[i].type == PARAM_TYPE_UINT32) {
+            value.u = static_cast<uint32_t>(paramTable[i].defaultValue);
+        } else {
+            value.f = paramTable[i].defaultValue;
+        }
+        paramBuffers[0][i] = value;
+        paramBuffers[1][i] = value;
+    }
+    activeBuffer = 0;
+    paramsStaged = false;
+}
+
+const ParamInfo* paramInfo(uint8_t id)
+{
+    if (id >= PARAM_COUNT) {
+        return NULL;
+    }
+    return &paramTable[id];
+}
+
+uint32_t paramUint(ParamId id)
+{
+    return paramBuffers[activeBuffer][id].u;
+}
+
+float paramFloat(ParamId id)
+{
+    return paramBuffers[activeBuffer][id].f;
+}
+
+bool getStagedParam(uint8_t id, ParamValue* value)
+{
+    if (id >= PARAM_COUNT) {
+        return false;
+    }
+    *value = paramBuffers[1 - activeBuffer][id];
+    return true;
+}
+
+bool stageParam(uint8_t id, ParamValue value)
+{
+    const ParamInfo* info = paramInfo(id);
+    if (info == NULL) {
+        return false;
+    }
+
+    float asFloat = (info->type == PARAM_TYPE_UINT32) ? static_cast<float>(value.u) : value.f;
+    if (!(asFloat >= info->min && asFloat <= info->max)) { // Also rejects NaN
+        return false;
+    }
+
+    paramBuffers[1 - activeBuffer][id] = value;
+    paramsStaged = true;
+    return true;
+}
+
+void commitParams()
+{
+    if (!paramsStaged) {
+        return;
+    }
+
+    uint8_t staged = 1 - activeBuffer;
+    activeBuffer = staged;
+
+    // The next edits start from the set that is now active
+    for (unsigned int i = 0; i < PARAM_COUNT; i++) {
+        paramBuffers[1 - staged][i] = paramBuffers[staged][i];
+    }
+    paramsStaged = false;
+}
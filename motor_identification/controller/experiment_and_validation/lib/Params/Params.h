@@ -0,0 +1,58 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The ID of a parameter is its position in the registry
+typedef enum {
+    PARAM_SAMPLE_PERIOD_MS = 0x00,
+    PARAM_INPUT_CHANGE_TIME_MS = 0x01,
+    PARAM_INPUT_AMPLITUDE = 0x02,
+    PARAM_HIL_TICKS = 0x03,
+    PARAM_EXCITATION = 0x04,
+    PARAM_FRICTION_COMPENSATION = 0x05,
+    PARAM_AUTOTUNE_SETPOINT = 0x06,
+    PARAM_AUTOTUNE_RELAY = 0x07,
+    PARAM_AUTOTUNE_HYSTERESIS = 0x08,
+    PARAM_AUTOTUNE_CYCLES = 0x09,
+    PARAM_PRBS_HOLD_SAMPLES = 0x0A,
+    PARAM_COUNT
+} ParamId;
+
+typedef enum {
+    PARAM_TYPE_UINT32 = 0x00,
+    PARAM_TYPE_FLOAT = 0x01,
+} ParamType;
+
+typedef union {
+    uint32_t u;
+    float f;
+} ParamValue;
+
+typedef struct {
+    const char* name;
+    ParamType type;
+    float min;
+    float max;
+    float defaultValue;
+} ParamInfo;
+
+// Loads the defaults into both buffers. Call it once from setup().
+void resetParams();
+
+// Returns NULL for unknown IDs
+const ParamInfo* paramInfo(uint8_t id);
+
+// Active set, read by the control loop. It only changes in commitParams().
+uint32_t paramUint(ParamId id);
+float paramFloat(ParamId id);
+
+// Staged set, written by the host. Values outside the range are rejected.
+bool getStagedParam(uint8_t id, ParamValue* value);
+bool stageParam(uint8_t id, ParamValue value);
+
+// Publishes the staged set. Call it at a control period boundary.
+void commitParams();
+
+#endif // PARAMS_H
@@ -0,0 +1,88 @@
+#include <Telemetry.h>
+
+#if defined(TELEMETRY_UDP)
+
+#include <Arduino.h>
+#include <UdpTransport.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <WiFi.h>
+#endif
+
+static const unsigned long wifiTimeoutMs = 10000;
+
+static UdpTransport udp(TELEMETRY_HOST, TELEMETRY_PORT);
+static bool connected = false;
+
+static uint8_t frame[udpMaxDatagramSize];
+static size_t frameLength = TELEMETRY_HEADER_SIZE;
+static uint8_t frameChannels = 0;
+static uint8_t frameSamples = 0;
+static uint32_t sequence = 0;
+static uint32_t failedFrames = 0;
+
+static bool joinNetwork()
+{
+#if defined(ARDUINO_ARCH_ESP32) && defined(TELEMETRY_WIFI_SSID)
+    WiFi.mode(WIFI_STA);
+    WiFi.setSleep(false); // Power save adds up to a beacon interval of latency per frame
+    WiFi.begin(TELEMETRY_WIFI_SSID, TELEMETRY_WIFI_PASSWORD);
+
+    unsigned long startMs = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        if (millis() - startMs > wifiTimeoutMs) {
+            return false;
+        }
+        delay(100);
+    }
+#endif
+    return true;
+}
+
+bool beginTelemetry()
+{
+    connected = joinNetwork() && udp.begin(0);
+    return connected;
+}
+
+void flushTelemetry()
+{
+    if (frameSamples == 0) {
+        return;
+    }
+
+    frame[0] = TELEMETRY_VERSION;
+    frame[1] = frameChannels;
+    frame[2] = frameSamples;
+    frame[3] = 0;
+    memcpy(&frame[4], &sequence, sizeof(sequence));
+    memcpy(&frame[8], &failedFrames, sizeof(failedFrames));
+
+    if (!udp.sendDatagram(frame, frameLength)) {
+        failedFrames++;
+    }
+
+    sequence++;
+    frameLength = TELEMETRY_HEADER_SIZE;
+    frameSamples = 0;
+}
+
+void telemetrySample(uint32_t timeUs, const float* values, uint8_t channels)
+{
+    if (!connected || channels > TELEMETRY_MAX_CHANNELS) {
+        return;
+    }
+
+    size_t sampleSize = sizeof(timeUs) + channels * sizeof(float);
+    if (channels != frameChannels || frameLength + sampleSize > sizeof(frame) || frameSamples == UINT8_MAX) {
+        flushTelemetry();
+        frameChannels = channels;
+    }
+
+    memcpy(&frame[frameLength], &timeUs, sizeof(timeUs));
+    memcpy(&frame[frameLength + sizeof(timeUs)], values, channels * sizeof(float));
+    frameLength += sampleSize;
+    frameSamples++;
+}
+
+#endif
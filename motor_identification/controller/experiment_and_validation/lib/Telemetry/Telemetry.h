@@ -0,0 +1,44 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Live sample stream over UDP, received by host/tools telemetry_rx. Samples are batched
+// into datagrams, each one numbered so the receiver can account for lost, duplicated and
+// reordered frames. Only built with TELEMETRY_UDP; otherwise every call compiles away.
+//
+// Frame (little-endian): version (u8), channels (u8), samples (u8), reserved (u8),
+// sequence (u32), frames the device failed to send so far (u32),
+// then per sample: device time (u32 us), channels x f32
+
+#ifndef TELEMETRY_HOST
+#define TELEMETRY_HOST "127.0.0.1"
+#endif
+
+#ifndef TELEMETRY_PORT
+#define TELEMETRY_PORT 5600
+#endif
+
+static const uint8_t TELEMETRY_VERSION = 1;
+static const uint8_t TELEMETRY_MAX_CHANNELS = 8;
+static const size_t TELEMETRY_HEADER_SIZE = 12;
+
+#if defined(TELEMETRY_UDP)
+
+// Joins the network (ESP32) and opens the socket. Without it every sample is discarded.
+bool beginTelemetry();
+// Queues one sample, sending the frame once full or when the channel count changes
+void telemetrySample(uint32_t timeUs, const float* values, uint8_t channels);
+// Sends the partial frame, e.g. at the end of a run
+void flushTelemetry();
+
+#else
+
+inline bool beginTelemetry() { return false; }
+inline void telemetrySample(uint32_t, const float*, uint8_t) {}
+inline void flushTelemetry() {}
+
+#endif
+
+#endif // TELEMETRY_H
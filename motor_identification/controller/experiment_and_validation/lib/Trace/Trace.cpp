@@ -0,0 +1,342 @@
+#include <Trace.h>
+
+#if defined(TRACE_RECORD) || defined(TRACE_REPLAY)
+
+#include <string.h>
+
+// Event layout: tag, then
+//   TRACE_MILLIS, TRACE_MICROS:        varint delta from the previous value of the same clock
+//   TRACE_RANDOM, TRACE_ANGLE, TRACE_BOARD_ID: 4 raw bytes
+//   TRACE_SERIAL_AVAILABLE/READ/PEEK:  zigzag varint
+//   TRACE_SERIAL_BYTES:                varint count, then the bytes
+//   TRACE_IDLE_POLLS:                  varint count
+// Polling an empty serial port is by far the most frequent event, hence the run-length encoding.
+// A traceDeadline() wait is logged as the one clock event that ended it.
+
+static uint32_t lastMillis = 0;
+static uint32_t lastMicros = 0;
+static uint32_t idlePolls = 0;
+
+static uint32_t* lastClock(TraceTag tag)
+{
+    if (tag == TRACE_MILLIS) {
+        return &lastMillis;
+    }
+    if (tag == TRACE_MICROS) {
+        return &lastMicros;
+    }
+    return NULL;
+}
+
+#if defined(TRACE_RECORD)
+
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 65536
+#endif
+
+static uint8_t traceBuffer[TRACE_BUFFER_SIZE] = { 'T', 'R', 'C', '1' };
+static size_t traceLength = sizeof(TRACE_MAGIC) - 1;
+static bool traceOverflowed = false;
+static bool traceStopped = false;
+
+// Events are written whole or not at all, so a full log still replays up to its end
+static bool reserve(size_t length)
+{
+    if (traceStopped || traceLength + length > TRACE_BUFFER_SIZE) {
+        traceOverflowed = traceOverflowed || !traceStopped;
+        traceStopped = true;
+        return false;
+    }
+    return true;
+}
+
+static uint32_t zigzag(int value)
+{
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+static void putVarint(uint32_t value)
+{
+    while (value >= 0x80) {
+        traceBuffer[traceLength++] = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    traceBuffer[traceLength++] = static_cast<uint8_t>(value);
+}
+
+static void flushIdlePolls()
+{
+    if (idlePolls == 0 || !reserve(6)) {
+        return;
+    }
+    traceBuffer[traceLength++] = TRACE_IDLE_POLLS;
+    putVarint(idlePolls);
+    idlePolls = 0;
+}
+
+uint32_t traceU32(TraceTag tag, uint32_t value)
+{
+    flushIdlePolls();
+    if (!reserve(6)) {
+        return value;
+    }
+    traceBuffer[traceLength++] = tag;
+
+    uint32_t* last = lastClock(tag);
+    if (last != NULL) {
+        putVarint(value - *last);
+        *last = value;
+    } else {
+        memcpy(&traceBuffer[traceLength], &value, sizeof(value));
+        traceLength += sizeof(value);
+    }
+    return value;
+}
+
+float traceFloat(TraceTag tag, float value)
+{
+    flushIdlePolls();
+    if (!reserve(1 + sizeof(value))) {
+        return value;
+    }
+    traceBuffer[traceLength++] = tag;
+    memcpy(&traceBuffer[traceLength], &value, sizeof(value));
+    traceLength += sizeof(value);
+    return value;
+}
+
+int traceInt(TraceTag tag, int value)
+{
+    if (tag == TRACE_SERIAL_AVAILABLE && value == 0 && !traceStopped) {
+        if (++idlePolls == UINT32_MAX) {
+            flushIdlePolls();
+        }
+        return value;
+    }
+
+    flushIdlePolls();
+    if (!reserve(6)) {
+        return value;
+    }
+    traceBuffer[traceLength++] = tag;
+    putVarint(zigzag(value));
+    return value;
+}
+
+size_t traceBytes(TraceTag tag, uint8_t* buffer, size_t, size_t count)
+{
+    flushIdlePolls();
+    if (!reserve(6 + count)) {
+        return count;
+    }
+    traceBuffer[traceLength++] = tag;
+    putVarint(count);
+    memcpy(&traceBuffer[traceLength], buffer, count);
+    traceLength += count;
+    return count;
+}
+
+bool traceDeadline(TraceTag clock, uint32_t now, uint32_t deadline)
+{
+    if (static_cast<int32_t>(now - deadline) < 0) {
+        return false;
+    }
+    traceU32(clock, now);
+    return true;
+}
+
+const uint8_t* traceLog(size_t* length, bool* overflowed)
+{
+    flushIdlePolls();
+    traceStopped = true;
+    *length = traceLength;
+    *overflowed = traceOverflowed;
+    return traceBuffer;
+}
+
+#else // TRACE_REPLAY
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned long eventCount = 0;
+static bool headerChecked = false;
+
+static int unzigzag(uint32_t value)
+{
+    return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+static void finish(const char* reason)
+{
+    fprintf(stderr, "[replay] %s after %lu events\n", reason, eventCount);
+    exit(0);
+}
+
+static void diverge(TraceTag expected, int found)
+{
+    fprintf(stderr, "[replay] Diverged at event %lu: code asked for tag 0x%02x, log has 0x%02x\n", eventCount, expected, found);
+    exit(1);
+}
+
+static uint8_t getByte()
+{
+    int c = getchar();
+    if (c == EOF) {
+        finish("End of log");
+    }
+    return static_cast<uint8_t>(c);
+}
+
+static uint32_t getVarint()
+{
+    uint32_t value = 0;
+    for (unsigned int shift = 0; shift < 35; shift += 7) {
+        uint8_t byte = getByte();
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            break;
+        }
+    }
+    return value;
+}
+
+// Next tag in the log, checking the header first
+static int nextTag()
+{
+    if (!headerChecked) {
+        char magic[sizeof(TRACE_MAGIC) - 1];
+        for (size_t i = 0; i < sizeof(magic); i++) {
+            magic[i] = getByte();
+        }
+        if (memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+            fprintf(stderr, "[replay] Not a trace log\n");
+            exit(1);
+        }
+        headerChecked = true;
+    }
+
+    int found = getchar();
+    if (found == EOF) {
+        finish("End of log");
+    }
+    return found;
+}
+
+static void expectTag(TraceTag tag)
+{
+    int found = nextTag();
+    if (found != tag) {
+        diverge(tag, found);
+    }
+    eventCount++;
+}
+
+uint32_t traceU32(TraceTag tag, uint32_t)
+{
+    expectTag(tag);
+
+    uint32_t* last = lastClock(tag);
+    if (last != NULL) {
+        *last += getVarint();
+        return *last;
+    }
+
+    uint32_t value;
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(&value);
+    for (size_t i = 0; i < sizeof(value); i++) {
+        bytes[i] = getByte();
+    }
+    return value;
+}
+
+float traceFloat(TraceTag tag, float)
+{
+    expectTag(tag);
+
+    float value;
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(&value);
+    for (size_t i = 0; i < sizeof(value); i++) {
+        bytes[i] = getByte();
+    }
+    return value;
+}
+
+int traceInt(TraceTag tag, int)
+{
+    if (tag == TRACE_SERIAL_AVAILABLE) {
+        if (idlePolls > 0) {
+            idlePolls--;
+            return 0;
+        }
+
+        // An idle run is followed by the poll that found data, or by anything else
+        int next = nextTag();
+        if (next == TRACE_IDLE_POLLS) {
+            eventCount++;
+            idlePolls = getVarint() - 1;
+            return 0;
+        }
+        ungetc(next, stdin);
+    }
+
+    expectTag(tag);
+    return unzigzag(getVarint());
+}
+
+size_t traceBytes(TraceTag tag, uint8_t* buffer, size_t capacity, size_t)
+{
+    expectTag(tag);
+
+    size_t logged = getVarint();
+    if (logged > capacity) {
+        fprintf(stderr, "[replay] Event %lu read %u bytes, the code asks for %u\n", eventCount,
+            static_cast<unsigned int>(logged), static_cast<unsigned int>(capacity));
+        exit(1);
+    }
+    for (size_t i = 0; i < logged; i++) {
+        buffer[i] = getByte();
+    }
+    return logged;
+}
+
+// Events used up when the last wait returned false, to tell a wait loop that reads the
+// hardware from one that only spins
+static bool deadlinePending = false;
+static unsigned long deadlineEvents = 0;
+static uint32_t deadlineIdlePolls = 0;
+
+// The wait ended where the log has the clock reading; until then it only has hardware reads
+bool traceDeadline(TraceTag clock, uint32_t, uint32_t)
+{
+    int next = (idlePolls > 0) ? TRACE_SERIAL_AVAILABLE : nextTag();
+    if (idlePolls == 0) {
+        ungetc(next, stdin);
+    }
+    if (next == clock) {
+        deadlinePending = false;
+        traceU32(clock, 0);
+        return true;
+    }
+
+    // Two misses without an event in between: the loop reads nothing else, so the log
+    // never gets to the clock
+    if (deadlinePending && eventCount == deadlineEvents && idlePolls == deadlineIdlePolls) {
+        diverge(clock, next);
+    }
+    deadlinePending = true;
+    deadlineEvents = eventCount;
+    deadlineIdlePolls = idlePolls;
+    return false;
+}
+
+const uint8_t* traceLog(size_t* length, bool* overflowed)
+{
+    *length = 0;
+    *overflowed = false;
+    return NULL;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Record-and-replay of every nondeterministic input the firmware consumes.
+// Wrap each hardware read: the value is passed through and, depending on the build,
+//   - TRACE_RECORD: appended to a compact log in RAM, downloaded with HOST_REQUEST_TRACE
+//   - TRACE_REPLAY: replaced by the next logged value (native build, log on stdin)
+//   - neither: passed through untouched, at no cost
+
+typedef enum {
+    TRACE_MILLIS = 0x01,
+    TRACE_MICROS = 0x02,
+    TRACE_RANDOM = 0x03,
+    TRACE_ANGLE = 0x04,
+    TRACE_SERIAL_AVAILABLE = 0x05,
+    TRACE_SERIAL_READ = 0x06,
+    TRACE_SERIAL_PEEK = 0x07,
+    TRACE_SERIAL_BYTES = 0x08,
+    TRACE_IDLE_POLLS = 0x09, // Run of TRACE_SERIAL_AVAILABLE events that returned 0
+    TRACE_BOARD_ID = 0x0A,
+} TraceTag;
+
+static const char TRACE_MAGIC[] = "TRC1";
+
+#if defined(TRACE_RECORD) || defined(TRACE_REPLAY)
+
+uint32_t traceU32(TraceTag tag, uint32_t value);
+float traceFloat(TraceTag tag, float value);
+int traceInt(TraceTag tag, int value);
+// count is what the hardware read delivered into buffer, capacity what was asked for
+size_t traceBytes(TraceTag tag, uint8_t* buffer, size_t capacity, size_t count);
+// Busy-wait condition on a clock (TRACE_MILLIS or TRACE_MICROS): true once now has reached
+// deadline. Only the reading that ends the wait is logged, so a spin costs one event however
+// long it lasts. After a false result the code must not read the same clock again before
+// its next logged read, otherwise replay cannot tell the two apart.
+bool traceDeadline(TraceTag clock, uint32_t now, uint32_t deadline);
+
+// Stops recording and returns the log, including the magic header
+const uint8_t* traceLog(size_t* length, bool* overflowed);
+
+#else
+
+inline uint32_t traceU32(TraceTag, uint32_t value) { return value; }
+inline float traceFloat(TraceTag, float value) { return value; }
+inline int traceInt(TraceTag, int value) { return value; }
+inline size_t traceBytes(TraceTag, uint8_t*, size_t, size_t count) { return count; }
+inline bool traceDeadline(TraceTag, uint32_t now, uint32_t deadline) { return static_cast<int32_t>(now - deadline) >= 0; }
+
+inline const uint8_t* traceLog(size_t* length, bool* overflowed)
+{
+    *length = 0;
+    *overflowed = false;
+    return NULL;
+}
+
+#endif
+
+#endif // TRACE_H
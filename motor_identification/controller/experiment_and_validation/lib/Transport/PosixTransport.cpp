@@ -0,0 +1,194 @@
+#include <PosixTransport.h>
+
+#if defined(COMMS_TRANSPORT_POSIX)
+
+#include <Arduino.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+PosixTransport::PosixTransport()
+    : fd(-1)
+    , ptySlave(-1)
+    , inputStart(0)
+    , inputEnd(0)
+{
+}
+
+PosixTransport::~PosixTransport()
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (ptySlave >= 0) {
+        close(ptySlave);
+    }
+}
+
+bool PosixTransport::begin(uint32_t)
+{
+    const char* tcpPort = getenv("COMMS_TCP_PORT");
+    bool opened = tcpPort != NULL ? listenTcp(atoi(tcpPort)) : openPty();
+
+    if (!opened) {
+        fprintf(stderr, "[native] Could not open the comms link: %s\n", strerror(errno));
+        exit(1);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+bool PosixTransport::openPty()
+{
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        return false;
+    }
+
+    const char* path = ptsname(fd);
+    ptySlave = open(path, O_RDWR | O_NOCTTY);
+    if (ptySlave < 0) {
+        return false;
+    }
+
+    // Raw from the start, otherwise the line discipline echoes output back as input
+    // until the host configures the port
+    termios options;
+    tcgetattr(ptySlave, &options);
+    cfmakeraw(&options);
+    tcsetattr(ptySlave, TCSANOW, &options);
+
+    fprintf(stderr, "[native] Comms on %s\n", path);
+    return true;
+}
+
+bool PosixTransport::listenTcp(uint16_t port)
+{
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0) {
+        return false;
+    }
+
+    int enable = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(server, 1) != 0) {
+        close(server);
+        return false;
+    }
+
+    fprintf(stderr, "[native] Waiting for the host on 127.0.0.1:%u\n", port);
+    fd = accept(server, NULL, NULL);
+    close(server);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Small command replies must not wait for Nagle
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return true;
+}
+
+bool PosixTransport::setBaudRate(uint32_t)
+{
+    return true;
+}
+
+void PosixTransport::fill()
+{
+    if (inputStart == inputEnd) {
+        inputStart = inputEnd = 0;
+    }
+    if (inputEnd == sizeof(input)) {
+        return;
+    }
+
+    ssize_t count = ::read(fd, input + inputEnd, sizeof(input) - inputEnd);
+    if (count > 0) {
+        inputEnd += count;
+    }
+}
+
+int PosixTransport::available()
+{
+    fill();
+    return inputEnd - inputStart;
+}
+
+int PosixTransport::read()
+{
+    fill();
+    return inputStart < inputEnd ? input[inputStart++] : -1;
+}
+
+int PosixTransport::peek()
+{
+    fill();
+    return inputStart < inputEnd ? input[inputStart] : -1;
+}
+
+size_t PosixTransport::readBytes(uint8_t* buffer, size_t length)
+{
+    size_t count = 0;
+    unsigned long start = millis();
+
+    while (count < length) {
+        fill();
+        size_t chunk = min(length - count, inputEnd - inputStart);
+        memcpy(buffer + count, input + inputStart, chunk);
+        inputStart += chunk;
+        count += chunk;
+
+        if (count == length) {
+            break;
+        }
+
+        int waitedMs = millis() - start;
+        if (waitedMs >= static_cast<int>(transportTimeoutMs)) {
+            break;
+        }
+        pollfd request = { fd, POLLIN, 0 };
+        poll(&request, 1, transportTimeoutMs - waitedMs);
+    }
+
+    return count;
+}
+
+size_t PosixTransport::write(const uint8_t* data, size_t length)
+{
+    size_t written = 0;
+
+    while (written < length) {
+        ssize_t count = ::write(fd, data + written, length - written);
+        if (count > 0) {
+            written += count;
+        } else if (count < 0 && errno != EAGAIN && errno != EINTR) {
+            break;
+        } else {
+            pollfd request = { fd, POLLOUT, 0 };
+            poll(&request, 1, transportTimeoutMs);
+        }
+    }
+
+    nativeOutput(data, written);
+    return written;
+}
+
+void PosixTransport::flush()
+{
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef POSIX_TRANSPORT_H
+#define POSIX_TRANSPORT_H
+
+#include <Transport.h>
+
+#if defined(COMMS_TRANSPORT_POSIX)
+
+// Native builds: a pty the host tools open like a serial port, or a TCP socket on
+// 127.0.0.1 when COMMS_TCP_PORT is set (pyserial: socket://localhost:<port>).
+// Either way the device path or port is printed to stderr and there is no baud rate limit.
+class PosixTransport : public Transport {
+public:
+    PosixTransport();
+    ~PosixTransport();
+
+    bool begin(uint32_t baudRate) override;
+    bool setBaudRate(uint32_t baudRate) override;
+    bool pacedByBaudRate() const override { return false; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(uint8_t* buffer, size_t length) override;
+
+    size_t write(const uint8_t* data, size_t length) override;
+    void flush() override;
+
+    using Transport::write;
+
+private:
+    bool openPty();
+    bool listenTcp(uint16_t port);
+    // Moves whatever the kernel holds into the input buffer without blocking
+    void fill();
+
+    int fd;
+    int ptySlave; // Kept open so the master does not see a hangup between host sessions
+    uint8_t input[4096];
+    size_t inputStart;
+    size_t inputEnd;
+};
+
+#endif
+
+#endif // POSIX_TRANSPORT_H
@@ -0,0 +1,45 @@
+#include <SerialTransport.h>
+#include <Arduino.h>
+
+bool SerialTransport::begin(uint32_t baudRate)
+{
+    Serial.begin(baudRate);
+    Serial.setTimeout(transportTimeoutMs);
+    return true;
+}
+
+bool SerialTransport::setBaudRate(uint32_t baudRate)
+{
+    Serial.updateBaudRate(baudRate);
+    return true;
+}
+
+int SerialTransport::available()
+{
+    return Serial.available();
+}
+
+int SerialTransport::read()
+{
+    return Serial.read();
+}
+
+int SerialTransport::peek()
+{
+    return Serial.peek();
+}
+
+size_t SerialTransport::readBytes(uint8_t* buffer, size_t length)
+{
+    return Serial.readBytes(buffer, length);
+}
+
+size_t SerialTransport::write(const uint8_t* data, size_t length)
+{
+    return Serial.write(data, length);
+}
+
+void SerialTransport::flush()
+{
+    Serial.flush();
+}
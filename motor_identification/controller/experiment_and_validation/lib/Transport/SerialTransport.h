@@ -0,0 +1,24 @@
+#ifndef SERIAL_TRANSPORT_H
+#define SERIAL_TRANSPORT_H
+
+#include <Transport.h>
+
+// The Arduino Serial object: UART0 through the core's driver on the nodemcu-32s,
+// USB-CDC on boards that map Serial to it
+class SerialTransport : public Transport {
+public:
+    bool begin(uint32_t baudRate) override;
+    bool setBaudRate(uint32_t baudRate) override;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(uint8_t* buffer, size_t length) override;
+
+    size_t write(const uint8_t* data, size_t length) override;
+    void flush() override;
+
+    using Transport::write;
+};
+
+#endif // SERIAL_TRANSPORT_H
@@ -0,0 +1,38 @@
+#include <Transport.h>
+#include <string.h>
+
+#if defined(COMMS_TRANSPORT_POSIX)
+#include <PosixTransport.h>
+#elif defined(COMMS_TRANSPORT_UART_DRIVER)
+#include <UartTransport.h>
+#else
+#include <SerialTransport.h>
+#endif
+
+Transport* defaultTransport()
+{
+#if defined(COMMS_TRANSPORT_POSIX)
+    static PosixTransport transport;
+#elif defined(COMMS_TRANSPORT_UART_DRIVER)
+    static UartTransport transport(UART_NUM_0);
+#else
+    static SerialTransport transport;
+#endif
+    return &transport;
+}
+
+size_t Transport::write(const char* text)
+{
+    return write(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+uint16_t transportCrc16(const uint8_t* data, size_t length, uint16_t crc)
+{
+    for (size_t i = 0; i < length; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,45 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte link the protocol runs over. The default build uses the Arduino Serial object;
+// build flags pick another implementation (see defaultTransport()).
+//   - COMMS_TRANSPORT_UART_DRIVER: ESP-IDF UART driver, see UartTransport.h
+//   - COMMS_TRANSPORT_POSIX: pty or TCP socket for native builds, see PosixTransport.h
+
+static const unsigned long transportTimeoutMs = 1000;
+
+class Transport {
+public:
+    virtual ~Transport() {}
+
+    virtual bool begin(uint32_t baudRate) = 0;
+    // Links without a baud rate accept any value
+    virtual bool setBaudRate(uint32_t baudRate) = 0;
+    // False for links whose throughput does not depend on the baud rate (pty, sockets)
+    virtual bool pacedByBaudRate() const { return true; }
+
+    virtual int available() = 0;
+    // Both return -1 when nothing is pending
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    // Waits up to transportTimeoutMs for length bytes. Returns the number read.
+    virtual size_t readBytes(uint8_t* buffer, size_t length) = 0;
+
+    virtual size_t write(const uint8_t* data, size_t length) = 0;
+    // Blocks until everything written has left the device
+    virtual void flush() = 0;
+
+    size_t write(uint8_t byte) { return write(&byte, 1); }
+    size_t write(const char* text);
+};
+
+// CRC-16/CCITT, for the replies that carry their own check (see HOST_READ_CHUNK)
+uint16_t transportCrc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+// The transport selected by the build flags, not yet begun
+Transport* defaultTransport();
+
+#endif // TRANSPORT_H
@@ -0,0 +1,103 @@
+#include <UartTransport.h>
+
+#if defined(COMMS_TRANSPORT_UART_DRIVER)
+
+// Sized for a whole bulk chunk or trace burst in either direction
+static const int uartRxBufferSize = 8192;
+static const int uartTxBufferSize = 8192;
+// Interrupt after this many bytes, or after this many idle symbols, whichever comes first
+static const uint8_t uartRxFullThreshold = 64;
+static const uint8_t uartRxTimeoutSymbols = 2;
+
+UartTransport::UartTransport(uart_port_t port, int txPin, int rxPin)
+    : port(port)
+    , txPin(txPin)
+    , rxPin(rxPin)
+    , peeked(-1)
+{
+}
+
+bool UartTransport::begin(uint32_t baudRate)
+{
+    uart_config_t config = {};
+    config.baud_rate = baudRate;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    config.source_clk = UART_SCLK_APB;
+
+    if (uart_driver_install(port, uartRxBufferSize, uartTxBufferSize, 0, NULL, 0) != ESP_OK) {
+        return false;
+    }
+    if (uart_param_config(port, &config) != ESP_OK) {
+        return false;
+    }
+    if (uart_set_pin(port, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK) {
+        return false;
+    }
+    uart_set_rx_full_threshold(port, uartRxFullThreshold);
+    uart_set_rx_timeout(port, uartRxTimeoutSymbols);
+
+    peeked = -1;
+    return true;
+}
+
+bool UartTransport::setBaudRate(uint32_t baudRate)
+{
+    uart_wait_tx_done(port, portMAX_DELAY);
+    return uart_set_baudrate(port, baudRate) == ESP_OK;
+}
+
+int UartTransport::available()
+{
+    size_t length = 0;
+    uart_get_buffered_data_len(port, &length);
+    return static_cast<int>(length) + (peeked >= 0 ? 1 : 0);
+}
+
+int UartTransport::read()
+{
+    if (peeked >= 0) {
+        int byte = peeked;
+        peeked = -1;
+        return byte;
+    }
+
+    uint8_t byte;
+    return uart_read_bytes(port, &byte, 1, 0) == 1 ? byte : -1;
+}
+
+int UartTransport::peek()
+{
+    if (peeked < 0) {
+        peeked = read();
+    }
+    return peeked;
+}
+
+size_t UartTransport::readBytes(uint8_t* buffer, size_t length)
+{
+    size_t count = 0;
+
+    if (length > 0 && peeked >= 0) {
+        buffer[count++] = peeked;
+        peeked = -1;
+    }
+
+    int received = uart_read_bytes(port, buffer + count, length - count, pdMS_TO_TICKS(transportTimeoutMs));
+    return count + (received > 0 ? received : 0);
+}
+
+size_t UartTransport::write(const uint8_t* data, size_t length)
+{
+    int written = uart_write_bytes(port, reinterpret_cast<const char*>(data), length);
+    return written > 0 ? written : 0;
+}
+
+void UartTransport::flush()
+{
+    uart_wait_tx_done(port, portMAX_DELAY);
+}
+
+#endif
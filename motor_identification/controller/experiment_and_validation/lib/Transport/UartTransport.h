@@ -0,0 +1,39 @@
+#ifndef UART_TRANSPORT_H
+#define UART_TRANSPORT_H
+
+#include <Transport.h>
+
+#if defined(COMMS_TRANSPORT_UART_DRIVER)
+
+#include <driver/uart.h>
+
+// ESP-IDF UART driver, bypassing the Arduino core. Received bytes are moved from the
+// hardware FIFO into a large ring buffer by the driver's interrupt, so long transfers
+// need no polling from the loop. Serial must not be begun on the same port.
+class UartTransport : public Transport {
+public:
+    explicit UartTransport(uart_port_t port, int txPin = UART_PIN_NO_CHANGE, int rxPin = UART_PIN_NO_CHANGE);
+
+    bool begin(uint32_t baudRate) override;
+    bool setBaudRate(uint32_t baudRate) override;
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(uint8_t* buffer, size_t length) override;
+
+    size_t write(const uint8_t* data, size_t length) override;
+    void flush() override;
+
+    using Transport::write;
+
+private:
+    uart_port_t port;
+    int txPin;
+    int rxPin;
+    int peeked; // Byte taken out of the driver by peek(), or -1
+};
+
+#endif
+
+#endif // UART_TRANSPORT_H
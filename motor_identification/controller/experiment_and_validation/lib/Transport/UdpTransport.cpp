@@ -0,0 +1,138 @@
+#include <UdpTransport.h>
+
+#if defined(TELEMETRY_UDP)
+
+#include <Arduino.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+UdpTransport::UdpTransport(const char* host, uint16_t port)
+    : host(host)
+    , port(port)
+    , fd(-1)
+    , inputStart(0)
+    , inputEnd(0)
+{
+}
+
+UdpTransport::~UdpTransport()
+{
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool UdpTransport::begin(uint32_t)
+{
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1) {
+        return false;
+    }
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return false;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        fd = -1;
+        return false;
+    }
+
+    // A full send queue drops the datagram instead of stalling the control loop
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    return true;
+}
+
+bool UdpTransport::setBaudRate(uint32_t)
+{
+    return true;
+}
+
+bool UdpTransport::receiveDatagram(int timeoutMs)
+{
+    pollfd request = { fd, POLLIN, 0 };
+    if (poll(&request, 1, timeoutMs) <= 0) {
+        return false;
+    }
+
+    ssize_t count = recv(fd, input, sizeof(input), 0);
+    if (count <= 0) {
+        return false;
+    }
+    inputStart = 0;
+    inputEnd = count;
+    return true;
+}
+
+int UdpTransport::available()
+{
+    if (inputStart == inputEnd) {
+        receiveDatagram(0);
+    }
+    return inputEnd - inputStart;
+}
+
+int UdpTransport::read()
+{
+    return available() > 0 ? input[inputStart++] : -1;
+}
+
+int UdpTransport::peek()
+{
+    return available() > 0 ? input[inputStart] : -1;
+}
+
+size_t UdpTransport::readBytes(uint8_t* buffer, size_t length)
+{
+    size_t count = 0;
+
+    while (count < length) {
+        if (inputStart == inputEnd && !receiveDatagram(transportTimeoutMs)) {
+            break;
+        }
+        size_t chunk = min(length - count, inputEnd - inputStart);
+        memcpy(buffer + count, input + inputStart, chunk);
+        inputStart += chunk;
+        count += chunk;
+    }
+
+    return count;
+}
+
+size_t UdpTransport::write(const uint8_t* data, size_t length)
+{
+    size_t written = 0;
+
+    while (written < length) {
+        size_t chunk = min(length - written, udpMaxDatagramSize);
+        if (!sendDatagram(data + written, chunk)) {
+            break;
+        }
+        written += chunk;
+    }
+
+    return written;
+}
+
+void UdpTransport::flush()
+{
+}
+
+bool UdpTransport::sendDatagram(const uint8_t* payload, size_t length)
+{
+    if (fd < 0 || length > udpMaxDatagramSize) {
+        return false;
+    }
+    return send(fd, payload, length, 0) == static_cast<ssize_t>(length);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#include <Transport.h>
+
+#if defined(TELEMETRY_UDP)
+
+static const size_t udpMaxDatagramSize = 1024;
+
+// Connected UDP socket (lwIP on the ESP32, the host stack on native builds).
+// Byte-level writes go out as one datagram each. Delivery and order are not guaranteed.
+class UdpTransport : public Transport {
+public:
+    UdpTransport(const char* host, uint16_t port);
+    ~UdpTransport();
+
+    bool begin(uint32_t baudRate) override;
+    bool setBaudRate(uint32_t baudRate) override;
+    bool pacedByBaudRate() const override { return false; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(uint8_t* buffer, size_t length) override;
+
+    size_t write(const uint8_t* data, size_t length) override;
+    void flush() override;
+
+    // One datagram of at most udpMaxDatagramSize bytes. Never blocks: fails on a full queue.
+    bool sendDatagram(const uint8_t* payload, size_t length);
+
+    using Transport::write;
+
+private:
+    // Takes the next datagram into the input buffer, waiting up to timeoutMs
+    bool receiveDatagram(int timeoutMs);
+
+    const char* host;
+    uint16_t port;
+    int fd;
+    uint8_t input[udpMaxDatagramSize];
+    size_t inputStart;
+    size_t inputEnd;
+};
+
+#endif
+
+#endif // UDP_TRANSPORT_H
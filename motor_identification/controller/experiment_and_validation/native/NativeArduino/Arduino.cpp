@@ -0,0 +1,155 @@
+#include <Arduino.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+void setup();
+void loop();
+
+NativeSerial Serial;
+NativeEsp ESP;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// FNV-1a over every output byte
+static uint64_t outputDigest = 0xcbf29ce484222325ULL;
+static unsigned long outputBytes = 0;
+
+void nativeOutput(const void* data, size_t length)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; i++) {
+        outputDigest = (outputDigest ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    outputBytes += length;
+}
+
+static void printSummary()
+{
+    fflush(stdout);
+    fprintf(stderr, "[native] %lu output bytes, digest %016llx\n", outputBytes, static_cast<unsigned long long>(outputDigest));
+}
+
+int main()
+{
+    atexit(printSummary);
+
+    setup();
+    while (true) {
+        loop();
+    }
+}
+
+void NativeSerial::begin(unsigned long)
+{
+}
+
+void NativeSerial::updateBaudRate(unsigned long)
+{
+}
+
+void NativeSerial::setTimeout(unsigned long)
+{
+}
+
+int NativeSerial::available()
+{
+    return 0;
+}
+
+int NativeSerial::read()
+{
+    return -1;
+}
+
+int NativeSerial::peek()
+{
+    return -1;
+}
+
+size_t NativeSerial::readBytes(uint8_t*, size_t)
+{
+    return 0;
+}
+
+size_t NativeSerial::write(uint8_t byte)
+{
+    return write(&byte, 1);
+}
+
+size_t NativeSerial::write(const uint8_t* buffer, size_t length)
+{
+    nativeOutput(buffer, length);
+    return fwrite(buffer, 1, length, stdout);
+}
+
+size_t NativeSerial::write(const char* text)
+{
+    return write(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+void NativeSerial::flush()
+{
+    fflush(stdout);
+}
+
+unsigned long millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// A replay takes its time from the log, so waiting would only slow it down
+void delay(unsigned long ms)
+{
+#ifndef TRACE_REPLAY
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#else
+    (void)ms;
+#endif
+}
+
+void delayMicroseconds(unsigned int us)
+{
+#ifndef TRACE_REPLAY
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+#else
+    (void)us;
+#endif
+}
+
+void yield()
+{
+}
+
+uint64_t NativeEsp::getEfuseMac()
+{
+    const char* id = getenv("NATIVE_BOARD_ID");
+    if (id != NULL) {
+        return strtoull(id, NULL, 16) & 0xFFFFFFFFFFFFULL;
+    }
+    // Locally administered address, like a virtual NIC
+    return 0x02ULL | (static_cast<uint64_t>(getpid()) << 16);
+}
+
+uint32_t esp_random()
+{
+    static std::mt19937 generator(std::random_device{}());
+    return generator();
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t, uint8_t)
+{
+}
@@ -0,0 +1,64 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// The subset of the Arduino-ESP32 API the firmware uses, for native builds.
+// Everything the firmware outputs (serial bytes, motor commands) is folded into a
+// digest printed at exit, so two runs over the same trace can be compared at a glance.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#define HIGH 0x1
+#define LOW 0x0
+#define OUTPUT 0x03
+#define LED_BUILTIN 2
+
+class NativeSerial {
+public:
+    void begin(unsigned long baudRate);
+    void updateBaudRate(unsigned long baudRate);
+    void setTimeout(unsigned long timeoutMs);
+
+    int available();
+    int read();
+    int peek();
+    size_t readBytes(uint8_t* buffer, size_t length);
+
+    size_t write(uint8_t byte);
+    size_t write(const uint8_t* buffer, size_t length);
+    size_t write(const char* text);
+    void flush();
+};
+
+extern NativeSerial Serial;
+
+class NativeEsp {
+public:
+    // NATIVE_BOARD_ID if set, otherwise derived from the process ID, so that several
+    // native boards on one host tell apart
+    uint64_t getEfuseMac();
+};
+
+extern NativeEsp ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+uint32_t esp_random();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+
+void nativeOutput(const void* data, size_t length);
+
+#endif // NATIVE_ARDUINO_H
@@ -0,0 +1,28 @@
+#include <Nidec24H.h>
+#include <Arduino.h>
+
+Nidec24H::Nidec24H(int, int, int, int, int, int, int, int)
+{
+}
+
+void Nidec24H::begin()
+{
+}
+
+void Nidec24H::brake(bool engaged)
+{
+    uint8_t record[2] = { 'B', static_cast<uint8_t>(engaged) };
+    nativeOutput(record, sizeof(record));
+}
+
+void Nidec24H::setSpeed(float speed)
+{
+    uint8_t record[1 + sizeof(speed)] = { 'S' };
+    memcpy(&record[1], &speed, sizeof(speed));
+    nativeOutput(record, sizeof(record));
+}
+
+float Nidec24H::readAngle()
+{
+    return 0.0f;
+}
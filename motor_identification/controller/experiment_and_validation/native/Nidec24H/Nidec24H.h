@@ -0,0 +1,16 @@
+#ifndef NATIVE_NIDEC24H_H
+#define NATIVE_NIDEC24H_H
+
+// Stand-in for the Nidec24H library in native builds.
+// Commands are folded into the output digest; the angle is whatever the trace says.
+class Nidec24H {
+public:
+    Nidec24H(int pwmPin, int dirPin, int brakePin, int encoderAPin, int encoderBPin, int pwmFrequency, int pwmResolution, int encoderPulses);
+
+    void begin();
+    void brake(bool engaged);
+    void setSpeed(float speed);
+    float readAngle();
+};
+
+#endif // NATIVE_NIDEC24H_H
@@ -1,31 +1,70 @@
 #include <Arduino.h>
 #include <Nidec24H.h>
 #include <Comms.h>
-
+#include <Params.h>
+#include <Balance.h>
+#include <Excitation.h>
+#include <Friction.h>
+#include <Autotune.h>
+#include <Trace.h>
+#include <Telemetry.h>
+
+// Sample period, input change time and input amplitude live in the parameter registry
 const unsigned int testDataLength = 4096;
-const unsigned int samplePeriodMs = 10;
-const unsigned int inputChangeTimeMs = 200;
+const unsigned int mimoDataLength = 2048; // Two periods of the PRBS at the default hold of 2 samples
+const unsigned int hilPeriodUs = 1000;
+const unsigned long autotuneTimeoutMs = 30000;
+const unsigned int probeSamples = 256;
+const float probeHeadroom = 1.5f;
 
 Nidec24H motor(27, 26, 25, 33, 32, 20000, 8, 100);
+// Second wheel (M1 on the PCB), only driven in MIMO runs
+Nidec24H rollMotor(19, 18, 5, 17, 16, 20000, 8, 100);
 
+void probeCapabilities();
+bool motorTestSample(unsigned int i, float* inputValue, unsigned int* lastTimeMs);
+void waitForSample(uint32_t* nextSampleUs);
 ResultCode runMotorTest();
-ResultCode sendTestData();
+ResultCode runHil();
+ResultCode runAutotune();
+ResultCode runMimoTest();
+ResultCode sendTestData(const uint8_t* data, size_t size);
 
 typedef struct {
     float input[testDataLength];
     float angle[testDataLength];
+    uint32_t timeUs[testDataLength]; // Device clock, mapped to host time with HOST_TIME_SYNC
 } TestData;
 
-TestData testData;
+// Both wheels, sampled together. Arrays are indexed by wheel: 0 is motor, 1 is rollMotor.
+typedef struct {
+    float input[2][mimoDataLength];
+    float angle[2][mimoDataLength];
+    uint32_t timeUs[mimoDataLength];
+} MimoData;
+
+// Only one kind of run happens per boot, so they share the RAM
+union {
+    TestData single;
+    MimoData mimo;
+} runData;
+TestData& testData = runData.single;
+MimoData& mimoData = runData.mimo;
 ResultCode testResult = RESULT_ERROR;
 
 void setup()
 {
-    Serial.begin(115200);
+    beginComms(defaultTransport(), COMMS_BAUD_RATE);
+    beginTelemetry();
     motor.begin();
+    rollMotor.begin();
+    resetParams();
 
     pinMode(LED_BUILTIN, OUTPUT);
 
+    // Worst-case loop times of this build, advertised to the host with HOST_GET_CAPABILITIES
+    probeCapabilities();
+
     // Check connection with host
     if (connectionCheck() != RESULT_OK) {
         testResult = RESULT_ERROR;
@@ -33,7 +72,18 @@ void setup()
     }
 
     // Wait for start command from host
-    if (waitForStartCommand() != RESULT_OK) {
+    TestMode mode;
+    if (waitForStartCommand(&mode) != RESULT_OK) {
+        testResult = RESULT_ERROR;
+        return;
+    }
+
+    // The staged parameters become the run's own here, so they can be checked before it starts.
+    // A designed input only fits the sample period it was designed for.
+    commitParams();
+    if (mode == TEST_MOTOR && paramUint(PARAM_EXCITATION) == EXCITATION_DESIGNED
+        && paramUint(PARAM_SAMPLE_PERIOD_MS) != designedSamplePeriodMs()) {
+        refuseStartCommand(PARAM_SAMPLE_PERIOD_MS);
         testResult = RESULT_ERROR;
         return;
     }
@@ -44,12 +94,29 @@ void setup()
         return;
     }
 
-    // Run motor test
-    if (runMotorTest() != RESULT_OK) {
+    // Run the controller against the host's simulated pendulum. There is no data to download.
+    if (mode == TEST_HIL) {
+        testResult = runHil();
+        return;
+    }
+
+    // A few relay cycles on the wheel speed, answered with the proposed gains only
+    if (mode == TEST_AUTOTUNE) {
+        testResult = runAutotune();
+        return;
+    }
+
+    // Run motor test, or drive both wheels at once
+    if ((mode == TEST_MIMO ? runMimoTest() : runMotorTest()) != RESULT_OK) {
         testResult = RESULT_ERROR;
         return;
     }
 
+    // The stream below can be fetched again piecewise if it arrives damaged
+    const uint8_t* data = (mode == TEST_MIMO) ? reinterpret_cast<const uint8_t*>(&mimoData) : reinterpret_cast<const uint8_t*>(&testData);
+    size_t dataSize = (mode == TEST_MIMO) ? sizeof(mimoData) : sizeof(testData);
+    setChunkSource(data, dataSize);
+
     // Send success message to host
     if (sendSuccessMessage() != RESULT_OK) {
         testResult = RESULT_ERROR;
@@ -69,7 +136,7 @@ void setup()
     }
 
     // Send test data to host
-    if (sendTestData() != RESULT_OK) {
+    if (sendTestData(data, dataSize) != RESULT_OK) {
         testResult = RESULT_ERROR;
         return;
     }
@@ -79,55 +146,294 @@ void setup()
 
 void loop() {
 
-    int ledHalfPeriodMs = (testResult == RESULT_OK) ? 200 : 1000;
+    // Still answers parameter, trace and chunk requests after the test
+    pollCommands();
+
+    // The blink never blocks, so those requests are answered within a millisecond
+    unsigned long ledHalfPeriodMs = (testResult == RESULT_OK) ? 200 : 1000;
+    digitalWrite(LED_BUILTIN, (millis() / ledHalfPeriodMs) % 2 == 0 ? HIGH : LOW);
+    delay(1);
+}
 
-    digitalWrite(LED_BUILTIN, HIGH);
-    delay(ledHalfPeriodMs);
-    digitalWrite(LED_BUILTIN, LOW);
-    delay(ledHalfPeriodMs);
+// Records sample i and picks the next input. Returns true when the motor needs the new input.
+// The capability probe times this same code, so the run matches what was measured.
+bool motorTestSample(unsigned int i, float* inputValue, unsigned int* lastTimeMs)
+{
+    testData.input[i] = *inputValue;
+    testData.timeUs[i] = traceU32(TRACE_MICROS, micros());
+    testData.angle[i] = traceFloat(TRACE_ANGLE, motor.readAngle());
+
+    unsigned int currentTimeMs = traceU32(TRACE_MILLIS, millis());
+    if (paramUint(PARAM_EXCITATION) == EXCITATION_FRICTION) {
+        *inputValue = frictionProfile(i + 1, testDataLength, paramFloat(PARAM_INPUT_AMPLITUDE));
+        return true;
+    }
+    if (paramUint(PARAM_EXCITATION) == EXCITATION_PRBS) {
+        *inputValue = prbsLevel(i + 1, 0, paramUint(PARAM_PRBS_HOLD_SAMPLES), paramFloat(PARAM_INPUT_AMPLITUDE));
+        return true;
+    }
+    if (paramUint(PARAM_EXCITATION) == EXCITATION_DESIGNED) {
+        *inputValue = designedLevel(i + 1);
+        return true;
+    }
+    if (currentTimeMs - *lastTimeMs >= paramUint(PARAM_INPUT_CHANGE_TIME_MS)) {
+        float amplitude = paramFloat(PARAM_INPUT_AMPLITUDE);
+        *inputValue = (static_cast<float>(traceU32(TRACE_RANDOM, esp_random())) / UINT32_MAX) * 2.0f * amplitude - amplitude; // Random value between -amplitude and +amplitude
+        *lastTimeMs = currentTimeMs;
+        return true;
+    }
+    return false;
 }
 
 ResultCode runMotorTest()
 {
 
-    unsigned int lastTimeMs = millis(), currentTimeMs = millis();
+    unsigned int lastTimeMs = traceU32(TRACE_MILLIS, millis());
 
     float inputValue = 0.0f;
 
     motor.brake(false);
     motor.setSpeed(inputValue);
 
+    uint32_t nextSampleUs = traceU32(TRACE_MICROS, micros());
+    beginRun();
+
     for (unsigned int i = 0; i < testDataLength; i++) {
-        testData.input[i] = inputValue;
-        testData.angle[i] = motor.readAngle();
+        // Parameter updates take effect at a sample boundary only
+        pollCommands();
+        commitParams();
+
+        bool changed = motorTestSample(i, &inputValue, &lastTimeMs);
+
+        float channels[2] = { testData.input[i], testData.angle[i] };
+        telemetrySample(testData.timeUs[i], channels, 2);
 
-        currentTimeMs = millis();
-        if (currentTimeMs - lastTimeMs >= inputChangeTimeMs) {
-            inputValue = (static_cast<float>(esp_random()) / UINT32_MAX) / 2.0f - 0.25f; // Random value between -0.25 and +0.25
+        if (changed) {
             motor.setSpeed(inputValue);
-            lastTimeMs = currentTimeMs;
         }
 
-        delay(samplePeriodMs);
+        waitForSample(&nextSampleUs);
     }
 
     motor.setSpeed(0.0f);
     motor.brake(true);
+    endRun();
+    flushTelemetry();
 
     return RESULT_OK;
 }
 
-ResultCode sendTestData()
+// Waits for the start of the next sample. Samples sit on a grid of whole periods from the
+// start of the run, so the period holds whatever the sample took, as long as it fits in it.
+void waitForSample(uint32_t* nextSampleUs)
+{
+    *nextSampleUs += paramUint(PARAM_SAMPLE_PERIOD_MS) * 1000;
+    while (!traceDeadline(TRACE_MICROS, micros(), *nextSampleUs)) {
+        yield();
+    }
+}
+
+// Times the motor test sample and the HIL controller step with the motor held at rest.
+// Only the sample itself is timed: the host is not serviced and nothing is streamed.
+void probeCapabilities()
+{
+    CapabilityReport report = { 0, 0, 0, testDataLength, 0, hilPeriodUs, 0, 0 };
+    uint64_t sumUs = 0;
+
+    unsigned int lastTimeMs = traceU32(TRACE_MILLIS, millis());
+    float inputValue = 0.0f;
+    for (unsigned int i = 0; i < probeSamples; i++) {
+        uint32_t startUs = traceU32(TRACE_MICROS, micros());
+        if (motorTestSample(i, &inputValue, &lastTimeMs)) {
+            motor.setSpeed(0.0f);
+        }
+        uint32_t elapsedUs = traceU32(TRACE_MICROS, micros()) - startUs;
+        report.sampleWorstUs = max(report.sampleWorstUs, elapsedUs);
+        sumUs += elapsedUs;
+    }
+    report.sampleMeanUs = static_cast<uint32_t>(sumUs / probeSamples);
+
+    BalanceState balance;
+    resetBalance(&balance);
+    for (unsigned int i = 0; i < probeSamples; i++) {
+        uint32_t startUs = traceU32(TRACE_MICROS, micros());
+        float input = balanceStep(&balance, 0.0f, 0.0f, hilPeriodUs * 1e-6f);
+        input += paramFloat(PARAM_FRICTION_COMPENSATION) * frictionCompensation(balance.wheelSpeed);
+        (void)input;
+        uint32_t elapsedUs = traceU32(TRACE_MICROS, micros()) - startUs;
+        report.hilWorstUs = max(report.hilWorstUs, elapsedUs);
+    }
+
+    // The run waits for a deadline, so a period the sample fits in never drifts. The headroom
+    // covers what the probe leaves out: commands serviced and telemetry sent every sample.
+    uint32_t periodUs = static_cast<uint32_t>(report.sampleWorstUs * probeHeadroom);
+    report.minSamplePeriodMs = max(static_cast<uint32_t>(1), (periodUs + 999) / 1000);
+#if defined(TELEMETRY_UDP)
+    report.telemetryChannels = 2;
+#endif
+
+    setCapabilities(&report);
+}
+
+ResultCode runHil()
 {
-    Serial.write(DEVICE_DATA_STREAM_START);
+    commitParams();
+    const uint32_t ticks = paramUint(PARAM_HIL_TICKS);
+
+    BalanceState balance;
+    resetBalance(&balance);
+
+    HilSensor sensor = { 0.0f, 0.0f };
+    HilReport report = { 0, 0, UINT32_MAX, 0, 0 };
+    uint64_t rttSumUs = 0;
+
+    uint32_t nextTickUs = traceU32(TRACE_MICROS, micros());
+
+    for (uint32_t tick = 0; tick < ticks; tick++) {
+        while (!traceDeadline(TRACE_MICROS, micros(), nextTickUs)) {
+        }
+        nextTickUs += hilPeriodUs;
+
+        float input = balanceStep(&balance, sensor.tilt, sensor.wheelAngle, hilPeriodUs * 1e-6f);
+        input += paramFloat(PARAM_FRICTION_COMPENSATION) * frictionCompensation(balance.wheelSpeed);
+        input = fminf(fmaxf(input, -1.0f), 1.0f);
+
+        uint32_t sentUs = traceU32(TRACE_MICROS, micros());
+        sendHilActuator(static_cast<uint16_t>(tick), input);
+
+        float channels[3] = { input, sensor.tilt, sensor.wheelAngle };
+        telemetrySample(sentUs, channels, 3);
+
+        // The plant has until the next tick to answer, otherwise the last sample is reused
+        if (receiveHilSensor(static_cast<uint16_t>(tick), nextTickUs, &sensor) == RESULT_OK) {
+            uint32_t rttUs = traceU32(TRACE_MICROS, micros()) - sentUs;
+            report.rttMinUs = min(report.rttMinUs, rttUs);
+            report.rttMaxUs = max(report.rttMaxUs, rttUs);
+            rttSumUs += rttUs;
+        } else {
+            report.misses++;
+        }
+        report.ticks++;
+    }
+
+    flushTelemetry();
+
+    uint32_t answered = report.ticks - report.misses;
+    report.rttMeanUs = (answered > 0) ? static_cast<uint32_t>(rttSumUs / answered) : 0;
+    if (answered == 0) {
+        report.rttMinUs = 0;
+    }
+
+    return sendHilReport(&report);
+}
+
+ResultCode runAutotune()
+{
+    commitParams();
+    const uint32_t periodUs = paramUint(PARAM_SAMPLE_PERIOD_MS) * 1000;
+    const uint32_t cycles = paramUint(PARAM_AUTOTUNE_CYCLES);
+
+    RelayAutotune tune;
+    beginAutotune(&tune, paramFloat(PARAM_AUTOTUNE_SETPOINT), paramFloat(PARAM_AUTOTUNE_RELAY), paramFloat(PARAM_AUTOTUNE_HYSTERESIS));
+
+    motor.brake(false);
+
+    unsigned long startMs = traceU32(TRACE_MILLIS, millis());
+    uint32_t nextTickUs = traceU32(TRACE_MICROS, micros());
+
+    while (autotuneCycles(&tune) < cycles && traceU32(TRACE_MILLIS, millis()) - startMs < autotuneTimeoutMs) {
+        while (!traceDeadline(TRACE_MICROS, micros(), nextTickUs)) {
+        }
+        nextTickUs += periodUs;
+
+        float angle = traceFloat(TRACE_ANGLE, motor.readAngle());
+        float input = autotuneStep(&tune, angle, periodUs * 1e-6f);
+        motor.setSpeed(input);
+
+        float channels[2] = { input, angle };
+        telemetrySample(nextTickUs - periodUs, channels, 2);
+    }
+
+    motor.setSpeed(0.0f);
+    motor.brake(true);
+    flushTelemetry();
+
+    AutotuneReport report = { 0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    if (autotuneUltimate(&tune, &report.ultimateGain, &report.ultimatePeriod, &report.amplitude)) {
+        float unused;
+        report.cycles = autotuneCycles(&tune);
+        report.bias = tune.bias;
+        zieglerNicholsGains(TUNING_PI, report.ultimateGain, report.ultimatePeriod, &report.piKp, &report.piKi, &unused);
+        zieglerNicholsGains(TUNING_PID, report.ultimateGain, report.ultimatePeriod, &report.pidKp, &report.pidKi, &report.pidKd);
+    } else {
+        report.ultimateGain = 0.0f;
+        report.ultimatePeriod = 0.0f;
+        report.amplitude = 0.0f;
+    }
+
+    return sendAutotuneReport(&report);
+}
+
+ResultCode runMimoTest()
+{
+    float inputValues[2] = { 0.0f, 0.0f };
+
+    motor.brake(false);
+    rollMotor.brake(false);
+    motor.setSpeed(inputValues[0]);
+    rollMotor.setSpeed(inputValues[1]);
+
+    uint32_t nextSampleUs = traceU32(TRACE_MICROS, micros());
+    beginRun();
+
+    for (unsigned int i = 0; i < mimoDataLength; i++) {
+        pollCommands();
+        commitParams();
+
+        // Both encoders right after the timestamp, so the pair belongs to one instant
+        mimoData.timeUs[i] = traceU32(TRACE_MICROS, micros());
+        mimoData.angle[0][i] = traceFloat(TRACE_ANGLE, motor.readAngle());
+        mimoData.angle[1][i] = traceFloat(TRACE_ANGLE, rollMotor.readAngle());
+        mimoData.input[0][i] = inputValues[0];
+        mimoData.input[1][i] = inputValues[1];
+
+        float channels[4] = { inputValues[0], mimoData.angle[0][i], inputValues[1], mimoData.angle[1][i] };
+        telemetrySample(mimoData.timeUs[i], channels, 4);
+
+        // Half a period apart, the two sequences are uncorrelated
+        unsigned int hold = paramUint(PARAM_PRBS_HOLD_SAMPLES);
+        float amplitude = paramFloat(PARAM_INPUT_AMPLITUDE);
+        inputValues[0] = prbsLevel(i + 1, 0, hold, amplitude);
+        inputValues[1] = prbsLevel(i + 1, PRBS_PERIOD / 2, hold, amplitude);
+        motor.setSpeed(inputValues[0]);
+        rollMotor.setSpeed(inputValues[1]);
+
+        waitForSample(&nextSampleUs);
+    }
+
+    motor.setSpeed(0.0f);
+    rollMotor.setSpeed(0.0f);
+    motor.brake(true);
+    rollMotor.brake(true);
+    endRun();
+    flushTelemetry();
+
+    return RESULT_OK;
+}
+
+// The run's arrays back to back: motor test input, angle, time; MIMO inputs, angles, time
+ResultCode sendTestData(const uint8_t* data, size_t size)
+{
+    Transport* transport = commsTransport();
+
+    transport->write(DEVICE_DATA_STREAM_START);
 
-    Serial.flush();
+    transport->flush();
 
-    Serial.write((uint8_t*)testData.input, sizeof(testData.input));
-    Serial.write((uint8_t*)testData.angle, sizeof(testData.angle));
+    transport->write(data, size);
 
-    Serial.flush();
+    transport->flush();
 
-    Serial.write(DEVICE_DATA_STREAM_END);
+    transport->write(DEVICE_DATA_STREAM_END);
     return RESULT_OK;
 }
\ No newline at end of file
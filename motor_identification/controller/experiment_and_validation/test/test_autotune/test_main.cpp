@@ -0,0 +1,111 @@
+#include <Arduino.h>
+#include <Autotune.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unity.h>
+
+// Wheel speed as an integrator behind a dead time: speed' = gain (u(t - delay) - friction).
+// Under a relay of amplitude d with hysteresis h the speed is a triangle of slope gain d,
+// which overshoots the band by the slope times the loop delay before it turns, so
+//   amplitude = h + gain d delay, period = 4 h / (gain d) + 4 delay
+// where the delay also counts the lag of the speed estimate.
+static const float plantGain = 100.0f;
+static const float plantFriction = 0.05f;
+static const float deadTime = 0.05f;
+static const float dt = 0.001f;
+static const int delaySteps = 50;
+// Lag of the speed filter in autotuneStep: (1 - 0.3) / 0.3 samples
+static const float filterLag = dt * 0.7f / 0.3f;
+
+static const float setpoint = 20.0f;
+static const float relay = 0.1f;
+static const float hysteresis = 0.5f;
+
+static RelayAutotune tune;
+
+static void runRelay(float seconds)
+{
+    float delayed[delaySteps] = {};
+    float angle = 0.0f;
+    float speed = 0.0f;
+    int steps = static_cast<int>(seconds / dt);
+    for (int k = 0; k < steps; k++) {
+        float input = autotuneStep(&tune, angle, dt);
+        float applied = delayed[k % delaySteps];
+        delayed[k % delaySteps] = input;
+        speed += plantGain * (applied - plantFriction) * dt;
+        angle += speed * dt;
+    }
+}
+
+void setUp()
+{
+    beginAutotune(&tune, setpoint, relay, hysteresis);
+}
+
+void tearDown()
+{
+}
+
+void test_no_result_before_a_cycle()
+{
+    float gain, period, amplitude;
+    TEST_ASSERT_FALSE(autotuneUltimate(&tune, &gain, &period, &amplitude));
+    runRelay(1.0f); // Still spinning up
+    TEST_ASSERT_EQUAL_UINT32(0, autotuneCycles(&tune));
+    TEST_ASSERT_FALSE(autotuneUltimate(&tune, &gain, &period, &amplitude));
+}
+
+void test_bias_settles_on_friction()
+{
+    runRelay(30.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, plantFriction, tune.bias);
+}
+
+void test_limit_cycle_of_integrator_with_delay()
+{
+    runRelay(30.0f);
+    TEST_ASSERT_TRUE(autotuneCycles(&tune) > 20);
+
+    float gain, period, amplitude;
+    TEST_ASSERT_TRUE(autotuneUltimate(&tune, &gain, &period, &amplitude));
+
+    float delay = deadTime + filterLag;
+    float slope = plantGain * relay;
+    TEST_ASSERT_FLOAT_WITHIN(0.05f * (hysteresis + slope * delay), hysteresis + slope * delay, amplitude);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f * (4.0f * hysteresis / slope + 4.0f * delay), 4.0f * hysteresis / slope + 4.0f * delay,
+        period);
+
+    // Describing function of the relay with hysteresis
+    float expected = 4.0f * relay / (static_cast<float>(M_PI) * sqrtf(amplitude * amplitude - hysteresis * hysteresis));
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f * expected, expected, gain);
+}
+
+void test_ziegler_nichols_gains()
+{
+    float kp, ki, kd;
+    zieglerNicholsGains(TUNING_PI, 2.0f, 0.4f, &kp, &ki, &kd);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.9f, kp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 2.7f, ki);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, kd);
+
+    zieglerNicholsGains(TUNING_PID, 2.0f, 0.4f, &kp, &ki, &kd);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.2f, kp);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 6.0f, ki);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.06f, kd);
+}
+
+// NativeArduino calls loop() forever, so the run ends here with the result
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_no_result_before_a_cycle);
+    RUN_TEST(test_bias_settles_on_friction);
+    RUN_TEST(test_limit_cycle_of_integrator_with_delay);
+    RUN_TEST(test_ziegler_nichols_gains);
+    exit(UNITY_END());
+}
+
+void loop()
+{
+}
@@ -0,0 +1,135 @@
+#include <Arduino.h>
+#include <Comms.h>
+#include <Transport.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+// Link that serves the queued request bytes and keeps what the device writes back
+class BufferTransport : public Transport {
+public:
+    uint8_t in[16];
+    size_t inLength = 0;
+    size_t inPosition = 0;
+    uint8_t out[commsMaxChunkSize + 16];
+    size_t outLength = 0;
+
+    bool begin(uint32_t) override { return true; }
+    bool setBaudRate(uint32_t) override { return true; }
+    int available() override { return static_cast<int>(inLength - inPosition); }
+    int read() override { return inPosition < inLength ? in[inPosition++] : -1; }
+    int peek() override { return inPosition < inLength ? in[inPosition] : -1; }
+    size_t readBytes(uint8_t* buffer, size_t length) override
+    {
+        size_t count = 0;
+        while (count < length && inPosition < inLength) {
+            buffer[count++] = in[inPosition++];
+        }
+        return count;
+    }
+    size_t write(const uint8_t* data, size_t length) override
+    {
+        memcpy(&out[outLength], data, length);
+        outLength += length;
+        return length;
+    }
+    void flush() override {}
+};
+
+static BufferTransport host;
+static uint8_t source[3000];
+
+// Sends HOST_READ_CHUNK and returns the length field of the reply, checked against its size
+static uint16_t readChunk(uint32_t offset, uint16_t length)
+{
+    host.in[0] = HOST_READ_CHUNK;
+    memcpy(&host.in[1], &offset, sizeof(offset));
+    memcpy(&host.in[1 + sizeof(offset)], &length, sizeof(length));
+    host.inLength = 1 + sizeof(offset) + sizeof(length);
+    host.inPosition = 0;
+    host.outLength = 0;
+    TEST_ASSERT_EQUAL(RESULT_OK, pollCommands());
+
+    uint16_t replyLength;
+    memcpy(&replyLength, &host.out[1 + sizeof(offset)], sizeof(replyLength));
+    TEST_ASSERT_EQUAL_UINT8(DEVICE_CHUNK, host.out[0]);
+    TEST_ASSERT_EQUAL(1 + sizeof(offset) + sizeof(length) + replyLength + sizeof(uint16_t), host.outLength);
+    return replyLength;
+}
+
+void setUp()
+{
+    for (size_t i = 0; i < sizeof(source); i++) {
+        source[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+    }
+    beginComms(&host, 115200);
+    setChunkSource(source, sizeof(source));
+}
+
+void tearDown()
+{
+}
+
+void test_crc_check_value()
+{
+    // CRC-16/CCITT-FALSE, the binascii.crc_hqx(data, 0xFFFF) host/chunks.py compares with
+    const char* check = "123456789";
+    TEST_ASSERT_EQUAL_HEX16(0x29B1, transportCrc16(reinterpret_cast<const uint8_t*>(check), strlen(check)));
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, transportCrc16(nullptr, 0));
+}
+
+void test_crc_chains()
+{
+    uint16_t whole = transportCrc16(source, 1000);
+    TEST_ASSERT_EQUAL_HEX16(whole, transportCrc16(source + 300, 700, transportCrc16(source, 300)));
+}
+
+void test_crc_catches_single_bit_errors()
+{
+    uint8_t data[64];
+    memcpy(data, source, sizeof(data));
+    uint16_t crc = transportCrc16(data, sizeof(data));
+    for (size_t bit = 0; bit < 8 * sizeof(data); bit++) {
+        data[bit / 8] ^= 1 << (bit % 8);
+        TEST_ASSERT_NOT_EQUAL(crc, transportCrc16(data, sizeof(data)));
+        data[bit / 8] ^= 1 << (bit % 8);
+    }
+}
+
+void test_reply_carries_crc_over_offset_to_data()
+{
+    TEST_ASSERT_EQUAL_UINT16(100, readChunk(500, 100));
+    TEST_ASSERT_EQUAL_MEMORY(source + 500, &host.out[7], 100);
+
+    uint16_t crc;
+    memcpy(&crc, &host.out[host.outLength - sizeof(crc)], sizeof(crc));
+    TEST_ASSERT_EQUAL_HEX16(transportCrc16(&host.out[1], host.outLength - 1 - sizeof(crc)), crc);
+}
+
+void test_reply_length_is_clipped()
+{
+    TEST_ASSERT_EQUAL_UINT16(commsMaxChunkSize, readChunk(0, 0xFFFF));
+    TEST_ASSERT_EQUAL_UINT16(200, readChunk(sizeof(source) - 200, 1000));
+    TEST_ASSERT_EQUAL_UINT16(0, readChunk(sizeof(source), 10));
+
+    // The CRC covers the clipped length the reply carries, not the one requested
+    uint16_t crc;
+    memcpy(&crc, &host.out[host.outLength - sizeof(crc)], sizeof(crc));
+    TEST_ASSERT_EQUAL_HEX16(transportCrc16(&host.out[1], 6), crc);
+}
+
+// NativeArduino calls loop() forever, so the run ends here with the result
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_crc_check_value);
+    RUN_TEST(test_crc_chains);
+    RUN_TEST(test_crc_catches_single_bit_errors);
+    RUN_TEST(test_reply_carries_crc_over_offset_to_data);
+    RUN_TEST(test_reply_length_is_clipped);
+    exit(UNITY_END());
+}
+
+void loop()
+{
+}
@@ -0,0 +1,108 @@
+#include <Arduino.h>
+#include <GainSchedule.h>
+#include <stdlib.h>
+#include <unity.h>
+
+// Grid node (i, j) of GainTable.h and its gains
+static float nodeTilt(unsigned int i)
+{
+    return GAIN_TILT_MIN + i / GAIN_TILT_STEP_INV;
+}
+
+static float nodeSpeed(unsigned int j)
+{
+    return GAIN_SPEED_MIN + j / GAIN_SPEED_STEP_INV;
+}
+
+static const float* nodeGains(unsigned int i, unsigned int j)
+{
+    return &GAIN_TABLE[(i * GAIN_SPEED_POINTS + j) * GAIN_STATES];
+}
+
+static void assertGains(const float* expected, const float* gains)
+{
+    for (unsigned int k = 0; k < GAIN_STATES; k++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f * fabsf(expected[k]) + 1e-6f, expected[k], gains[k]);
+    }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_grid_spacing_matches_bounds()
+{
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, GAIN_TILT_MAX, nodeTilt(GAIN_TILT_POINTS - 1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, GAIN_SPEED_MAX, nodeSpeed(GAIN_SPEED_POINTS - 1));
+}
+
+void test_nodes_return_table_gains()
+{
+    float gains[GAIN_STATES];
+    for (unsigned int i = 0; i < GAIN_TILT_POINTS; i++) {
+        for (unsigned int j = 0; j < GAIN_SPEED_POINTS; j++) {
+            scheduleGains(nodeTilt(i), nodeSpeed(j), gains);
+            assertGains(nodeGains(i, j), gains);
+        }
+    }
+}
+
+void test_cell_centre_is_corner_mean()
+{
+    float gains[GAIN_STATES];
+    for (unsigned int i = 0; i + 1 < GAIN_TILT_POINTS; i++) {
+        for (unsigned int j = 0; j + 1 < GAIN_SPEED_POINTS; j++) {
+            float expected[GAIN_STATES];
+            for (unsigned int k = 0; k < GAIN_STATES; k++) {
+                expected[k] = 0.25f * (nodeGains(i, j)[k] + nodeGains(i, j + 1)[k] + nodeGains(i + 1, j)[k] + nodeGains(i + 1, j + 1)[k]);
+            }
+            scheduleGains(0.5f * (nodeTilt(i) + nodeTilt(i + 1)), 0.5f * (nodeSpeed(j) + nodeSpeed(j + 1)), gains);
+            assertGains(expected, gains);
+        }
+    }
+}
+
+void test_linear_along_an_edge()
+{
+    // A quarter of the way along the first tilt step, at a speed node
+    float gains[GAIN_STATES];
+    float expected[GAIN_STATES];
+    unsigned int j = GAIN_SPEED_POINTS / 2;
+    for (unsigned int k = 0; k < GAIN_STATES; k++) {
+        expected[k] = 0.75f * nodeGains(0, j)[k] + 0.25f * nodeGains(1, j)[k];
+    }
+    scheduleGains(nodeTilt(0) + 0.25f / GAIN_TILT_STEP_INV, nodeSpeed(j), gains);
+    assertGains(expected, gains);
+}
+
+void test_outside_points_clamp_to_border()
+{
+    float inside[GAIN_STATES], outside[GAIN_STATES];
+    scheduleGains(GAIN_TILT_MAX, GAIN_SPEED_MIN, inside);
+    scheduleGains(10.0f * GAIN_TILT_MAX, 10.0f * GAIN_SPEED_MIN, outside);
+    assertGains(inside, outside);
+    assertGains(nodeGains(GAIN_TILT_POINTS - 1, 0), outside);
+
+    scheduleGains(-1e9f, 1e9f, outside);
+    assertGains(nodeGains(0, GAIN_SPEED_POINTS - 1), outside);
+}
+
+// NativeArduino calls loop() forever, so the run ends here with the result
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_grid_spacing_matches_bounds);
+    RUN_TEST(test_nodes_return_table_gains);
+    RUN_TEST(test_cell_centre_is_corner_mean);
+    RUN_TEST(test_linear_along_an_edge);
+    RUN_TEST(test_outside_points_clamp_to_border);
+    exit(UNITY_END());
+}
+
+void loop()
+{
+}
@@ -0,0 +1,132 @@
+#include <Arduino.h>
+#include <Params.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unity.h>
+
+static ParamValue uintValue(uint32_t u)
+{
+    ParamValue value;
+    value.u = u;
+    return value;
+}
+
+static ParamValue floatValue(float f)
+{
+    ParamValue value;
+    value.f = f;
+    return value;
+}
+
+void setUp()
+{
+    resetParams();
+}
+
+void tearDown()
+{
+}
+
+void test_defaults_in_both_buffers()
+{
+    for (uint8_t id = 0; id < PARAM_COUNT; id++) {
+        const ParamInfo* info = paramInfo(id);
+        TEST_ASSERT_NOT_NULL(info);
+        TEST_ASSERT_TRUE(info->defaultValue >= info->min && info->defaultValue <= info->max);
+
+        ParamValue staged;
+        TEST_ASSERT_TRUE(getStagedParam(id, &staged));
+        if (info->type == PARAM_TYPE_UINT32) {
+            TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(info->defaultValue), paramUint(static_cast<ParamId>(id)));
+            TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(info->defaultValue), staged.u);
+        } else {
+            TEST_ASSERT_EQUAL_FLOAT(info->defaultValue, paramFloat(static_cast<ParamId>(id)));
+            TEST_ASSERT_EQUAL_FLOAT(info->defaultValue, staged.f);
+        }
+    }
+}
+
+void test_staged_value_waits_for_commit()
+{
+    uint32_t active = paramUint(PARAM_SAMPLE_PERIOD_MS);
+    TEST_ASSERT_TRUE(stageParam(PARAM_SAMPLE_PERIOD_MS, uintValue(active + 5)));
+
+    ParamValue staged;
+    TEST_ASSERT_TRUE(getStagedParam(PARAM_SAMPLE_PERIOD_MS, &staged));
+    TEST_ASSERT_EQUAL_UINT32(active + 5, staged.u);
+    TEST_ASSERT_EQUAL_UINT32(active, paramUint(PARAM_SAMPLE_PERIOD_MS));
+
+    commitParams();
+    TEST_ASSERT_EQUAL_UINT32(active + 5, paramUint(PARAM_SAMPLE_PERIOD_MS));
+}
+
+void test_next_edits_start_from_active_set()
+{
+    TEST_ASSERT_TRUE(stageParam(PARAM_SAMPLE_PERIOD_MS, uintValue(20)));
+    commitParams();
+    TEST_ASSERT_TRUE(stageParam(PARAM_INPUT_AMPLITUDE, floatValue(0.5f)));
+    commitParams();
+
+    // The second swap must not bring back the buffer from before the first one
+    TEST_ASSERT_EQUAL_UINT32(20, paramUint(PARAM_SAMPLE_PERIOD_MS));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, paramFloat(PARAM_INPUT_AMPLITUDE));
+
+    ParamValue staged;
+    TEST_ASSERT_TRUE(getStagedParam(PARAM_SAMPLE_PERIOD_MS, &staged));
+    TEST_ASSERT_EQUAL_UINT32(20, staged.u);
+}
+
+void test_commit_without_staging_keeps_active_set()
+{
+    TEST_ASSERT_TRUE(stageParam(PARAM_PRBS_HOLD_SAMPLES, uintValue(7)));
+    commitParams();
+    commitParams();
+    TEST_ASSERT_EQUAL_UINT32(7, paramUint(PARAM_PRBS_HOLD_SAMPLES));
+}
+
+void test_out_of_range_values_are_rejected()
+{
+    const ParamInfo* period = paramInfo(PARAM_SAMPLE_PERIOD_MS);
+    const ParamInfo* amplitude = paramInfo(PARAM_INPUT_AMPLITUDE);
+
+    TEST_ASSERT_TRUE(stageParam(PARAM_SAMPLE_PERIOD_MS, uintValue(static_cast<uint32_t>(period->min))));
+    TEST_ASSERT_TRUE(stageParam(PARAM_SAMPLE_PERIOD_MS, uintValue(static_cast<uint32_t>(period->max))));
+    TEST_ASSERT_FALSE(stageParam(PARAM_SAMPLE_PERIOD_MS, uintValue(static_cast<uint32_t>(period->max) + 1)));
+    TEST_ASSERT_FALSE(stageParam(PARAM_SAMPLE_PERIOD_MS, uintValue(static_cast<uint32_t>(period->min) - 1)));
+    TEST_ASSERT_FALSE(stageParam(PARAM_INPUT_AMPLITUDE, floatValue(amplitude->max * 1.01f)));
+    TEST_ASSERT_FALSE(stageParam(PARAM_INPUT_AMPLITUDE, floatValue(-0.01f)));
+    TEST_ASSERT_FALSE(stageParam(PARAM_INPUT_AMPLITUDE, floatValue(NAN)));
+
+    // A rejected value leaves the last accepted one staged
+    ParamValue staged;
+    TEST_ASSERT_TRUE(getStagedParam(PARAM_SAMPLE_PERIOD_MS, &staged));
+    TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(period->max), staged.u);
+    TEST_ASSERT_TRUE(getStagedParam(PARAM_INPUT_AMPLITUDE, &staged));
+    TEST_ASSERT_EQUAL_FLOAT(amplitude->defaultValue, staged.f);
+}
+
+void test_unknown_ids_are_rejected()
+{
+    ParamValue value = uintValue(1);
+    TEST_ASSERT_NULL(paramInfo(PARAM_COUNT));
+    TEST_ASSERT_FALSE(stageParam(PARAM_COUNT, value));
+    TEST_ASSERT_FALSE(getStagedParam(PARAM_COUNT, &value));
+    TEST_ASSERT_FALSE(stageParam(0xFF, value));
+}
+
+// NativeArduino calls loop() forever, so the run ends here with the result
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_defaults_in_both_buffers);
+    RUN_TEST(test_staged_value_waits_for_commit);
+    RUN_TEST(test_next_edits_start_from_active_set);
+    RUN_TEST(test_commit_without_staging_keeps_active_set);
+    RUN_TEST(test_out_of_range_values_are_rejected);
+    RUN_TEST(test_unknown_ids_are_rejected);
+    exit(UNITY_END());
+}
+
+void loop()
+{
+}
@@ -0,0 +1,77 @@
+#include <Arduino.h>
+#include <Excitation.h>
+#include <stdlib.h>
+#include <unity.h>
+
+static int bitAt(unsigned int index)
+{
+    return prbsLevel(index, 0, 1, 1.0f) > 0.0f ? 1 : -1;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_every_nonzero_state_once()
+{
+    // A maximum-length LFSR walks through all 2^9 - 1 nonzero states before it repeats,
+    // so each nonzero 9-bit window of one period shows up exactly once
+    static bool seen[PRBS_PERIOD + 1];
+    for (unsigned int i = 0; i < PRBS_PERIOD; i++) {
+        unsigned int window = 0;
+        for (unsigned int bit = 0; bit < 9; bit++) {
+            window |= (bitAt(i + bit) > 0 ? 1u : 0u) << bit;
+        }
+        TEST_ASSERT_TRUE(window != 0);
+        TEST_ASSERT_FALSE(seen[window]);
+        seen[window] = true;
+    }
+}
+
+void test_balance()
+{
+    int sum = 0;
+    for (unsigned int i = 0; i < PRBS_PERIOD; i++) {
+        sum += bitAt(i);
+    }
+    TEST_ASSERT_EQUAL(1, sum); // 256 ones, 255 zeros
+}
+
+void test_autocorrelation_off_peak()
+{
+    for (unsigned int shift = 0; shift < PRBS_PERIOD; shift++) {
+        int sum = 0;
+        for (unsigned int i = 0; i < PRBS_PERIOD; i++) {
+            sum += bitAt(i) * bitAt(i + shift);
+        }
+        TEST_ASSERT_EQUAL(shift == 0 ? static_cast<int>(PRBS_PERIOD) : -1, sum);
+    }
+}
+
+void test_hold_and_shift()
+{
+    const unsigned int hold = 3;
+    const unsigned int shift = PRBS_PERIOD / 2;
+    for (unsigned int sample = 0; sample < 2 * hold * PRBS_PERIOD; sample++) {
+        TEST_ASSERT_EQUAL_FLOAT(0.4f * bitAt(sample / hold + shift), prbsLevel(sample, shift, hold, 0.4f));
+    }
+}
+
+// NativeArduino calls loop() forever, so the run ends here with the result
+void setup()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_nonzero_state_once);
+    RUN_TEST(test_balance);
+    RUN_TEST(test_autocorrelation_off_peak);
+    RUN_TEST(test_hold_and_shift);
+    exit(UNITY_END());
+}
+
+void loop()
+{
+}
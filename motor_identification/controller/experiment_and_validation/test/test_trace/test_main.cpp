@@ -0,0 +1,186 @@
+#include <Arduino.h>
+#include <Trace.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+// One log, checked from both ends: the native-record environment must write exactly these
+// bytes, the replay environment must read the same values back from them.
+//   pio test -e native-record -f test_trace
+//   pio test -e replay -f test_trace
+static const uint8_t expectedLog[] = {
+    'T', 'R', 'C', '1',
+    TRACE_MILLIS, 0xE8, 0x07,                   // 1000: varint delta from 0
+    TRACE_MILLIS, 0xAC, 0x02,                   // 1300: +300
+    TRACE_MILLIS, 0xF1, 0xF5, 0xFF, 0xFF, 0x0F, // 5: the clock wrapped
+    TRACE_IDLE_POLLS, 0x03,                     // Three empty polls, one event
+    TRACE_SERIAL_AVAILABLE, 0x04,               // 2, zigzag
+    TRACE_SERIAL_READ, 0x01,                    // -1, zigzag
+    TRACE_ANGLE, 0x00, 0x00, 0xC0, 0x3F,        // 1.5f
+    TRACE_RANDOM, 0xEF, 0xBE, 0xAD, 0xDE,       // 0xDEADBEEF
+    TRACE_SERIAL_BYTES, 0x03, 0x01, 0x02, 0x03,
+    TRACE_MICROS, 0xF0, 0xA2, 0x04,             // The reading that ended a wait: 70000
+    TRACE_IDLE_POLLS, 0x02,
+    TRACE_MICROS, 0x0A,                         // 70010
+};
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+#if defined(TRACE_RECORD)
+
+void test_record_encodes_events()
+{
+    TEST_ASSERT_EQUAL_UINT32(1000, traceU32(TRACE_MILLIS, 1000));
+    traceU32(TRACE_MILLIS, 1300);
+    traceU32(TRACE_MILLIS, 5);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(0, traceInt(TRACE_SERIAL_AVAILABLE, 0));
+    }
+    TEST_ASSERT_EQUAL_INT(2, traceInt(TRACE_SERIAL_AVAILABLE, 2));
+    TEST_ASSERT_EQUAL_INT(-1, traceInt(TRACE_SERIAL_READ, -1));
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, traceFloat(TRACE_ANGLE, 1.5f));
+    traceU32(TRACE_RANDOM, 0xDEADBEEF);
+    uint8_t bytes[8] = { 1, 2, 3 };
+    TEST_ASSERT_EQUAL_UINT32(3, traceBytes(TRACE_SERIAL_BYTES, bytes, sizeof(bytes), 3));
+
+    // Only the reading that ends the wait is logged
+    TEST_ASSERT_FALSE(traceDeadline(TRACE_MICROS, 90, 100));
+    TEST_ASSERT_FALSE(traceDeadline(TRACE_MICROS, 99, 100));
+    TEST_ASSERT_TRUE(traceDeadline(TRACE_MICROS, 70000, 100));
+
+    traceInt(TRACE_SERIAL_AVAILABLE, 0);
+    traceInt(TRACE_SERIAL_AVAILABLE, 0);
+    traceU32(TRACE_MICROS, 70010);
+
+    size_t length;
+    bool overflowed;
+    const uint8_t* log = traceLog(&length, &overflowed);
+    TEST_ASSERT_FALSE(overflowed);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expectedLog), length);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expectedLog, log, sizeof(expectedLog));
+
+    // Stopped: later events are not appended
+    traceU32(TRACE_MILLIS, 6000);
+    traceLog(&length, &overflowed);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expectedLog), length);
+    TEST_ASSERT_FALSE(overflowed);
+}
+
+#elif defined(TRACE_REPLAY)
+
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Puts the log on stdin, as in a replay run
+static void replayFrom(const uint8_t* log, size_t length)
+{
+    FILE* file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_UINT32(length, fwrite(log, 1, length, file));
+    fflush(file);
+    rewind(file);
+    TEST_ASSERT_TRUE(dup2(fileno(file), STDIN_FILENO) >= 0);
+}
+
+void test_replay_stops_a_spin_that_never_reaches_the_clock()
+{
+    // The wait reads nothing else, so a log that goes on with millis has diverged
+    pid_t child = fork();
+    TEST_ASSERT_TRUE(child >= 0);
+    if (child == 0) {
+        const uint8_t log[] = { 'T', 'R', 'C', '1', TRACE_MILLIS, 0x05 };
+        replayFrom(log, sizeof(log));
+        for (int i = 0; i < 3; i++) {
+            traceDeadline(TRACE_MICROS, 0, 100);
+        }
+        _exit(0);
+    }
+    int status = 0;
+    TEST_ASSERT_EQUAL(child, waitpid(child, &status, 0));
+    TEST_ASSERT_TRUE(WIFEXITED(status));
+    TEST_ASSERT_EQUAL_INT(1, WEXITSTATUS(status));
+}
+
+void test_replay_decodes_events()
+{
+    replayFrom(expectedLog, sizeof(expectedLog));
+
+    // The log starts with a millis reading, so a micros wait has not ended yet
+    TEST_ASSERT_FALSE(traceDeadline(TRACE_MICROS, 0, 0));
+
+    TEST_ASSERT_EQUAL_UINT32(1000, traceU32(TRACE_MILLIS, 0));
+    TEST_ASSERT_EQUAL_UINT32(1300, traceU32(TRACE_MILLIS, 0));
+    TEST_ASSERT_EQUAL_UINT32(5, traceU32(TRACE_MILLIS, 0));
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_INT(0, traceInt(TRACE_SERIAL_AVAILABLE, 7));
+    }
+    TEST_ASSERT_EQUAL_INT(2, traceInt(TRACE_SERIAL_AVAILABLE, 7));
+    TEST_ASSERT_EQUAL_INT(-1, traceInt(TRACE_SERIAL_READ, 7));
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, traceFloat(TRACE_ANGLE, 0.0f));
+    TEST_ASSERT_EQUAL_UINT32(0xDEADBEEF, traceU32(TRACE_RANDOM, 0));
+    uint8_t bytes[8] = {};
+    const uint8_t expectedBytes[] = { 1, 2, 3 };
+    TEST_ASSERT_EQUAL_UINT32(3, traceBytes(TRACE_SERIAL_BYTES, bytes, sizeof(bytes), 0));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expectedBytes, bytes, sizeof(expectedBytes));
+
+    // However long the recorded spin was, the replayed wait ends at its logged reading
+    unsigned int spins = 0;
+    while (!traceDeadline(TRACE_MICROS, 0, 100)) {
+        spins++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, spins);
+
+    TEST_ASSERT_EQUAL_INT(0, traceInt(TRACE_SERIAL_AVAILABLE, 7));
+    TEST_ASSERT_EQUAL_INT(0, traceInt(TRACE_SERIAL_AVAILABLE, 7));
+    // The delta only adds up if the wait restored the clock
+    TEST_ASSERT_EQUAL_UINT32(70010, traceU32(TRACE_MICROS, 0));
+}
+
+#else
+
+void test_passthrough()
+{
+    TEST_ASSERT_EQUAL_UINT32(1234, traceU32(TRACE_MILLIS, 1234));
+    TEST_ASSERT_EQUAL_INT(-5, traceInt(TRACE_SERIAL_READ, -5));
+    TEST_ASSERT_EQUAL_FLOAT(1.5f, traceFloat(TRACE_ANGLE, 1.5f));
+
+    // Deadlines compare across the clock wrap
+    TEST_ASSERT_TRUE(traceDeadline(TRACE_MICROS, 100, 100));
+    TEST_ASSERT_FALSE(traceDeadline(TRACE_MICROS, 99, 100));
+    TEST_ASSERT_TRUE(traceDeadline(TRACE_MICROS, 5, 0xFFFFFFF0));
+    TEST_ASSERT_FALSE(traceDeadline(TRACE_MICROS, 0xFFFFFFF0, 5));
+
+    size_t length = 1;
+    bool overflowed = true;
+    TEST_ASSERT_NULL(traceLog(&length, &overflowed));
+    TEST_ASSERT_EQUAL_UINT32(0, length);
+    TEST_ASSERT_FALSE(overflowed);
+}
+
+#endif
+
+// NativeArduino calls loop() forever, so the run ends here with the result
+void setup()
+{
+    UNITY_BEGIN();
+#if defined(TRACE_RECORD)
+    RUN_TEST(test_record_encodes_events);
+#elif defined(TRACE_REPLAY)
+    RUN_TEST(test_replay_stops_a_spin_that_never_reaches_the_clock);
+    RUN_TEST(test_replay_decodes_events);
+#else
+    RUN_TEST(test_passthrough);
+#endif
+    exit(UNITY_END());
+}
+
+void loop()
+{
+}
@@ -0,0 +1,111 @@
+import json
+import socket
+import sys
+from acquisitiond import SOCKET_PATH
+
+class AcquisitionClient:
+    """
+    Blocking client for acquisitiond.py. Any number of scripts can hold one at the same
+    time; events that arrive while waiting for a reply are kept for next_event().
+    """
+
+    def __init__(self, path=SOCKET_PATH):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.file = self.sock.makefile('rb')
+        self.next_id = 0
+        self.pending_events = []
+
+    def close(self):
+        self.file.close()
+        self.sock.close()
+
+    def _read_message(self, timeout=None):
+        self.sock.settimeout(timeout)
+        line = self.file.readline()
+        if not line:
+            raise ConnectionError("Daemon closed the connection")
+        return json.loads(line)
+
+    def request(self, cmd, timeout=None, **fields):
+        self.next_id += 1
+        message = dict(id=self.next_id, cmd=cmd, **fields)
+        self.sock.sendall((json.dumps(message) + '\n').encode())
+
+        while True:
+            reply = self._read_message(timeout)
+            if 'event' in reply:
+                self.pending_events.append(reply)
+                continue
+            if reply.get('id') != self.next_id:
+                continue
+            if not reply['ok']:
+                raise RuntimeError(reply['error'])
+            return reply['result']
+
+    def subscribe(self, *topics):
+        return self.request('subscribe', topics=list(topics)) if topics else self.request('subscribe')
+
+    def next_event(self, timeout=None):
+        """
+        Returns the next event, or None on timeout.
+        """
+        if self.pending_events:
+            return self.pending_events.pop(0)
+        try:
+            return self._read_message(timeout)
+        except socket.timeout:
+            return None
+
+def main():
+    usage = "Usage: acquisition_client.py status | params | get <name> | set <name> <value> | run | reset | monitor [topics...]"
+    if len(sys.argv) < 2:
+        print(usage)
+        return
+
+    command = sys.argv[1]
+    try:
+        client = AcquisitionClient()
+    except OSError as e:
+        print(f"Error: Could not reach the daemon at {SOCKET_PATH}: {e}")
+        return
+
+    try:
+        if command == 'status':
+            for key, value in client.request('status').items():
+                print(f"{key:<16} {value}")
+        elif command == 'params':
+            for name, param in client.request('params').items():
+                print(f"{param['id']:>3}  {name:<24} {client.request('get_param', name=name):>10g}")
+        elif command == 'get' and len(sys.argv) == 3:
+            print(f"{sys.argv[2]} = {client.request('get_param', name=sys.argv[2])}")
+        elif command == 'set' and len(sys.argv) == 4:
+            value = float(sys.argv[3])
+            print(f"{sys.argv[2]} = {client.request('set_param', name=sys.argv[2], value=value)} (staged)")
+        elif command == 'run':
+            print("Test running...")
+            result = client.request('run_test')
+            print(f"   -> {result['samples']} samples, drift {result['drift_ppm']:+.1f} ppm.")
+        elif command == 'reset':
+            print(f"Device is {client.request('reset')}.")
+        elif command == 'monitor':
+            print(f"Subscribed to {', '.join(client.subscribe(*sys.argv[2:]))}. Ctrl-C to stop.")
+            while True:
+                event = client.next_event()
+                if event['event'] == 'telemetry':
+                    print(f"telemetry  seq {event['sequence']:>6}  {len(event['samples'])} samples")
+                elif event['event'] == 'run':
+                    print(f"run        board {event['board_id']}  {len(event['input'])} samples")
+                else:
+                    print(f"{event['event']:<10} {event}")
+        else:
+            print(usage)
+    except RuntimeError as e:
+        print(f"Error: {e}")
+    except KeyboardInterrupt:
+        pass
+    finally:
+        client.close()
+
+if __name__ == "__main__":
+    main()
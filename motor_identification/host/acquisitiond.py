@@ -0,0 +1,265 @@
+import asyncio
+import json
+import os
+import signal
+import socket
+import struct
+import sys
+from clock_sync import ClockSync, SYNC_INTERVAL_SEC
+from device import Device, DeviceError
+
+# --- Configuration ---
+SERIAL_PORT = '/dev/ttyUSB0' # Change as needed, or pass the port as the first argument
+SOCKET_PATH = '/tmp/motor_acquisition.sock'
+TELEMETRY_PORT = 5600        # UDP telemetry to fan out (TELEMETRY_UDP builds), None to disable
+CLIENT_QUEUE_LENGTH = 1024   # Events buffered per subscriber before the oldest are dropped
+TEST_TIMEOUT_SEC = 120
+
+TOPICS = ('status', 'run', 'telemetry')
+
+# --- Telemetry Frame (Must match Telemetry.h) ---
+TELEMETRY_VERSION = 1
+TELEMETRY_HEADER = struct.Struct('<BBBBII') # version, channels, samples, reserved, sequence, failed frames
+
+class Client:
+    """
+    One local connection. Replies are sent directly; events are queued so a slow
+    subscriber loses its oldest events instead of stalling the device.
+    """
+
+    def __init__(self, writer):
+        self.writer = writer
+        self.write_lock = asyncio.Lock()
+        self.topics = set()
+        self.queue = asyncio.Queue(CLIENT_QUEUE_LENGTH)
+        self.dropped = 0
+
+    def publish(self, message):
+        if self.queue.full():
+            self.queue.get_nowait()
+            self.dropped += 1
+        self.queue.put_nowait(message)
+
+    async def send(self, message):
+        async with self.write_lock:
+            self.writer.write((json.dumps(message) + '\n').encode())
+            await self.writer.drain()
+
+class AcquisitionDaemon:
+    """
+    Owns the device connection for as long as it runs. Clients send JSON lines
+    {"id": n, "cmd": name, ...} and get {"id": n, "ok": true, "result": ...} back;
+    subscribers also receive {"event": topic, ...} lines.
+    """
+
+    def __init__(self, port):
+        self.device = Device(port)
+        self.lock = asyncio.Lock() # One command on the wire at a time, whoever sent it
+        self.clients = set()
+        self.sync = ClockSync(None)
+        self.params = {}
+        self.state = 'disconnected'
+        self.telemetry = {'frames': 0, 'lost': 0, 'next_sequence': None}
+
+    # --- Device side ---
+
+    async def connect(self):
+        await self.device.open()
+        await self.device.handshake()
+        await self.device.read_board_id()
+        self.params = await self.device.list_params()
+        await self.device.sync_burst(self.sync)
+        self.set_state('idle')
+
+    def set_state(self, state):
+        self.state = state
+        self.publish('status', state=state, board_id=self.device.board_id)
+
+    async def keep_clock_synced(self):
+        while True:
+            await asyncio.sleep(SYNC_INTERVAL_SEC)
+            if self.state == 'idle' and not self.lock.locked():
+                async with self.lock:
+                    await self.device.sync_burst(self.sync)
+
+    def param(self, name):
+        if name not in self.params:
+            raise DeviceError(f"Unknown parameter '{name}'")
+        return self.params[name]
+
+    async def run_test(self):
+        if self.state != 'idle':
+            raise DeviceError(f"Device is {self.state}; a run needs a fresh reset")
+
+        self.set_state('running')
+        try:
+            await self.device.run_test(self.sync, TEST_TIMEOUT_SEC)
+            await self.device.sync_burst(self.sync)
+            input_values, angle_values, time_values = await self.device.download()
+        except DeviceError:
+            self.set_state('error')
+            raise
+
+        # The firmware only starts one run per reset
+        self.set_state('done')
+
+        device_time = self.sync.unwrap(time_values) / 1e6
+        _, drift, uncertainty = self.sync.fit()
+        run = {
+            'board_id': self.device.board_id,
+            'time': list(device_time - device_time[0]),
+            'input': list(input_values),
+            'angle': list(angle_values),
+            'host_time': list(self.sync.to_host_time(time_values)),
+            'host_time_uncertainty': uncertainty,
+            'drift_ppm': drift * 1e6,
+        }
+        self.publish('run', **run)
+        return {'samples': len(input_values), 'drift_ppm': run['drift_ppm'], 'host_time_uncertainty': uncertainty}
+
+    async def reset(self):
+        self.set_state('resetting')
+        self.device.close()
+        self.sync = ClockSync(None)
+        await self.connect()
+
+    async def raw(self, data, reply_length):
+        """
+        Escape hatch for commands the daemon has no verb for; the reply length must be fixed.
+        """
+        self.device.write(bytes.fromhex(data))
+        return (await self.device.read_exact(reply_length)).hex() if reply_length > 0 else ''
+
+    # --- Client side ---
+
+    def publish(self, topic, **fields):
+        message = dict(event=topic, **fields)
+        for client in self.clients:
+            if topic in client.topics:
+                client.publish(message)
+
+    async def execute(self, client, request):
+        cmd = request.get('cmd')
+
+        if cmd == 'subscribe':
+            topics = set(request.get('topics', TOPICS))
+            if not topics <= set(TOPICS):
+                raise ValueError(f"Unknown topics {sorted(topics - set(TOPICS))}, known: {', '.join(TOPICS)}")
+            client.topics |= topics
+            return sorted(client.topics)
+        if cmd == 'unsubscribe':
+            client.topics -= set(request.get('topics', TOPICS))
+            return sorted(client.topics)
+        if cmd == 'status':
+            return {'state': self.state, 'board_id': self.device.board_id, 'port': self.device.port,
+                    'clients': len(self.clients), 'dropped_events': client.dropped,
+                    'sync_points': len(self.sync.points), 'telemetry': {k: v for k, v in self.telemetry.items() if k != 'next_sequence'}}
+        if cmd == 'params':
+            return self.params
+
+        async with self.lock:
+            if cmd == 'get_param':
+                return await self.device.get_param(self.param(request['name']))
+            if cmd == 'set_param':
+                return await self.device.set_param(self.param(request['name']), request['value'])
+            if cmd == 'run_test':
+                return await self.run_test()
+            if cmd == 'reset':
+                await self.reset()
+                return self.state
+            if cmd == 'raw':
+                return await self.raw(request['data'], int(request.get('reply_length', 0)))
+
+        raise ValueError(f"Unknown command '{cmd}'")
+
+    async def forward_events(self, client):
+        while True:
+            await client.send(await client.queue.get())
+
+    async def serve_client(self, reader, writer):
+        client = Client(writer)
+        self.clients.add(client)
+        forwarder = asyncio.create_task(self.forward_events(client))
+
+        try:
+            while True:
+                line = await reader.readline()
+                if not line:
+                    break
+                request = {}
+                try:
+                    request = json.loads(line)
+                    result = await self.execute(client, request)
+                    reply = {'id': request.get('id'), 'ok': True, 'result': result}
+                except (DeviceError, ValueError, KeyError, TypeError, AttributeError, struct.error) as e:
+                    reply = {'id': request.get('id') if isinstance(request, dict) else None, 'ok': False, 'error': str(e)}
+                await client.send(reply)
+        except ConnectionError:
+            pass
+        finally:
+            forwarder.cancel()
+            self.clients.discard(client)
+            writer.close()
+
+    # --- Telemetry ---
+
+    def on_telemetry(self, datagram):
+        if len(datagram) < TELEMETRY_HEADER.size:
+            return
+        version, channels, count, _, sequence, failed = TELEMETRY_HEADER.unpack_from(datagram)
+        sample = struct.Struct(f'<I{channels}f')
+        if version != TELEMETRY_VERSION or len(datagram) != TELEMETRY_HEADER.size + count * sample.size:
+            return
+
+        expected = self.telemetry['next_sequence']
+        if expected is not None and sequence > expected:
+            self.telemetry['lost'] += sequence - expected
+        self.telemetry['next_sequence'] = sequence + 1
+        self.telemetry['frames'] += 1
+
+        samples = [sample.unpack_from(datagram, TELEMETRY_HEADER.size + i * sample.size) for i in range(count)]
+        self.publish('telemetry', sequence=sequence, device_failed=failed, channels=channels, samples=samples)
+
+async def serve(port):
+    daemon = AcquisitionDaemon(port)
+
+    print(f"Connecting to {port}...")
+    await daemon.connect()
+    print(f"   -> Board {daemon.device.board_id} ready, {len(daemon.params)} parameters.")
+
+    if os.path.exists(SOCKET_PATH):
+        os.unlink(SOCKET_PATH)
+    server = await asyncio.start_unix_server(daemon.serve_client, path=SOCKET_PATH)
+    print(f"Serving clients on {SOCKET_PATH}")
+
+    loop = asyncio.get_running_loop()
+    if TELEMETRY_PORT is not None:
+        telemetry = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        telemetry.bind(('0.0.0.0', TELEMETRY_PORT))
+        telemetry.setblocking(False)
+        loop.add_reader(telemetry.fileno(), lambda: daemon.on_telemetry(telemetry.recv(65536)))
+        print(f"Fanning out UDP telemetry from port {TELEMETRY_PORT}")
+
+    stop = asyncio.Event()
+    for sig in (signal.SIGINT, signal.SIGTERM):
+        loop.add_signal_handler(sig, stop.set)
+
+    syncer = asyncio.create_task(daemon.keep_clock_synced())
+    await stop.wait()
+
+    syncer.cancel()
+    server.close()
+    daemon.device.close()
+    os.unlink(SOCKET_PATH)
+    print("Stopped.")
+
+def main():
+    print("--- Acquisition Daemon ---")
+    port = sys.argv[1] if len(sys.argv) > 1 else SERIAL_PORT
+    try:
+        asyncio.run(serve(port))
+    except (DeviceError, OSError) as e:
+        print(f"Error: {e}")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,115 @@
+import serial
+import time
+import struct
+import json
+import os
+from params import apply_params
+
+# --- Configuration ---
+SERIAL_PORT = '/dev/ttyUSB0' # Change as needed
+BAUD_RATE = 115200
+TIMEOUT_SEC = 2
+RUN_TIMEOUT_SEC = 40         # The device gives up after 30 s without enough cycles
+MODEL_FILE = 'model_parameters.json'
+
+# Staged on the device before the run, e.g. {'autotune_setpoint': 30.0, 'sample_period_ms': 5}
+AUTOTUNE_PARAMS = {}
+
+# --- Protocol Definitions (Must match Comms.h) ---
+HOST_CHECK_CONNECTION   = b'\x01'
+DEVICE_CHECK_CONNECTION = b'\x02'
+DEVICE_ACK_START        = b'\x04'
+HOST_START_AUTOTUNE     = b'\x26'
+DEVICE_AUTOTUNE_REPORT  = b'\x27'
+
+# AutotuneReport: cycles, ultimate gain, ultimate period, amplitude, bias, PI kp/ki, PID kp/ki/kd
+REPORT_FORMAT = '<I9f'
+REPORT_FIELDS = ['cycles', 'ultimate_gain', 'ultimate_period', 'amplitude', 'bias',
+                 'pi_kp', 'pi_ki', 'pid_kp', 'pid_ki', 'pid_kd']
+
+def save_gains(report):
+    """Adds the proposed speed loop gains to the model file, keeping what is already there."""
+    data = {}
+    if os.path.exists(MODEL_FILE):
+        with open(MODEL_FILE, 'r') as f:
+            data = json.load(f)
+    for field in REPORT_FIELDS[1:]:
+        data[f"speed_{field}"] = report[field]
+    with open(MODEL_FILE, 'w') as f:
+        json.dump(data, f, indent=4)
+
+def main():
+    print("--- Speed Loop Relay Autotune ---")
+
+    try:
+        ser = serial.Serial(SERIAL_PORT, BAUD_RATE, timeout=TIMEOUT_SEC)
+        time.sleep(2) # Wait for Arduino to reset after serial connection
+    except serial.SerialException as e:
+        print(f"Error opening serial port {SERIAL_PORT}: {e}")
+        return
+
+    try:
+        ser.reset_input_buffer()
+        ser.reset_output_buffer()
+
+        # 1. Check connection with controller
+        print("1. Checking connection with controller...")
+        ser.write(HOST_CHECK_CONNECTION)
+        response = b''
+        while response != DEVICE_CHECK_CONNECTION:
+            response = ser.read(1)
+        print("   -> Connection confirmed.")
+
+        # 2. Stage the relay settings
+        apply_params(ser, AUTOTUNE_PARAMS)
+        print(f"   -> Parameters staged {AUTOTUNE_PARAMS}.")
+
+        # 3. Start the relay experiment
+        input("2. The wheel will spin up. Press [Enter] to start the autotune...")
+        ser.write(HOST_START_AUTOTUNE)
+        response = ser.read(1)
+        if response != DEVICE_ACK_START:
+            print(f"Error: Device did not acknowledge start. Received: {response}")
+            return
+        print("   -> Start acknowledged. Relay running...")
+
+        # 4. Only the result comes back
+        ser.timeout = RUN_TIMEOUT_SEC
+        response = ser.read(1)
+        if response != DEVICE_AUTOTUNE_REPORT:
+            print(f"Error: No autotune report. Received: {response}")
+            return
+        payload = ser.read(struct.calcsize(REPORT_FORMAT))
+        if len(payload) != struct.calcsize(REPORT_FORMAT):
+            print("Error: Autotune report incomplete.")
+            return
+        report = dict(zip(REPORT_FIELDS, struct.unpack(REPORT_FORMAT, payload)))
+
+        if report['cycles'] == 0:
+            print("Error: The relay never settled into a limit cycle.")
+            print("Raise autotune_relay, or bring autotune_setpoint within reach of the wheel.")
+            return
+
+        print("\n--- Results ---")
+        print(f"Cycles measured:   {report['cycles']}")
+        print(f"Ultimate gain Ku:  {report['ultimate_gain']:.5f} input per rad/s")
+        print(f"Ultimate period:   {report['ultimate_period'] * 1000:.1f} ms")
+        print(f"Speed amplitude:   {report['amplitude']:.2f} rad/s")
+        print(f"Relay bias:        {report['bias']:+.4f} (input needed at the setpoint)")
+        print(f"PI  (Ziegler-Nichols): Kp = {report['pi_kp']:.5f}, Ki = {report['pi_ki']:.5f}")
+        print(f"PID (Ziegler-Nichols): Kp = {report['pid_kp']:.5f}, Ki = {report['pid_ki']:.5f}, Kd = {report['pid_kd']:.6f}")
+
+        save_gains(report)
+        print(f"\n[SUCCESS] Gains saved to '{MODEL_FILE}'.")
+
+    except KeyboardInterrupt:
+        print("\nOperation cancelled by user.")
+    except Exception as e:
+        print(f"\nAn unexpected error occurred: {e}")
+    finally:
+        if ser.is_open:
+            ser.close()
+            print("Serial port closed.")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,92 @@
+import binascii
+import struct
+
+# --- Configuration ---
+MAX_ATTEMPTS = 50   # Per chunk, and per resync
+QUIET_SEC = 0.05    # Silence that marks the end of whatever was still in flight
+REPLY_TIMEOUT_SEC = 0.05 # Turnaround allowance on top of the time on the wire
+
+# --- Protocol Definitions (Must match Comms.h) ---
+HOST_PING       = b'\x16'
+DEVICE_PING     = b'\x17'
+HOST_READ_CHUNK = b'\x24'
+DEVICE_CHUNK    = b'\x25'
+MAX_CHUNK_SIZE  = 1024
+MIN_CHUNK_SIZE  = 16
+
+def crc16(data, crc=0xFFFF):
+    """
+    CRC-16/CCITT, like transportCrc16 in Transport.cpp.
+    """
+    return binascii.crc_hqx(data, crc)
+
+def reply_timeout(length, baud_rate):
+    """
+    A lost byte costs a full timeout, so it is kept as short as the reply allows (8N1).
+    """
+    return REPLY_TIMEOUT_SEC + 2 * length * 10 / baud_rate
+
+def resync(ser, attempts=MAX_ATTEMPTS):
+    """
+    Discards whatever is still in flight until a ping gets exactly one reply. A request
+    the device is still completing swallows pings until its own read times out.
+    """
+    timeout = ser.timeout
+    try:
+        for _ in range(attempts):
+            ser.timeout = QUIET_SEC
+            while ser.read(4096):
+                pass
+            ser.write(HOST_PING)
+            ser.timeout = reply_timeout(1, ser.baudrate)
+            if ser.read(1) == DEVICE_PING:
+                ser.timeout = QUIET_SEC
+                if not ser.read(1):
+                    return
+        raise IOError("Device did not get back in sync")
+    finally:
+        ser.timeout = timeout
+
+def read_chunk(ser, offset, length):
+    """
+    One chunk of the device's test data, checked against its CRC. Raises IOError when damaged.
+    """
+    request = struct.pack('<IH', offset, length)
+    reply_length = 1 + len(request) + length + 2
+    ser.write(HOST_READ_CHUNK + request)
+
+    timeout = ser.timeout
+    try:
+        ser.timeout = reply_timeout(reply_length, ser.baudrate)
+        reply = ser.read(reply_length)
+    finally:
+        ser.timeout = timeout
+    if len(reply) != reply_length:
+        raise IOError(f"Chunk at {offset} incomplete")
+    if reply[0:1] != DEVICE_CHUNK or reply[1:7] != request:
+        raise IOError(f"Unexpected chunk reply at {offset}")
+    if crc16(reply[1:-2]) != struct.unpack('<H', reply[-2:])[0]:
+        raise IOError(f"Chunk at {offset} failed its CRC")
+    return reply[7:-2]
+
+def read_chunks(ser, size):
+    """
+    Reads size bytes of the last run's data piecewise, fetching damaged chunks again.
+    Chunks shrink after every failure and grow back after every success, so a noisy
+    link still gets chunks through that are short enough to arrive intact.
+    """
+    data = bytearray()
+    chunk_size = MAX_CHUNK_SIZE
+    while len(data) < size:
+        length = min(chunk_size, size - len(data))
+        for attempt in range(MAX_ATTEMPTS):
+            try:
+                data += read_chunk(ser, len(data), length)
+                chunk_size = min(2 * chunk_size, MAX_CHUNK_SIZE)
+                break
+            except IOError:
+                chunk_size = length = max(length // 2, MIN_CHUNK_SIZE)
+                resync(ser)
+        else:
+            raise IOError(f"Chunk at {len(data)} still damaged after {MAX_ATTEMPTS} attempts")
+    return bytes(data)
@@ -0,0 +1,157 @@
+import struct
+import time
+import numpy as np
+
+# --- Configuration ---
+BURST_SIZE = 16           # Exchanges per sync point; the one with the smallest delay is kept
+EXCHANGE_TIMEOUT_SEC = 0.2
+SYNC_INTERVAL_SEC = 5.0   # Between sync points while waiting on a long run
+
+# --- Protocol Definitions (Must match Comms.h) ---
+HOST_TIME_SYNC   = b'\x14'
+DEVICE_TIME_SYNC = b'\x15'
+
+SYNC_REPLY_LENGTH = 1 + 4 + 4 # seq, receive time (us), transmit time (us)
+
+DEVICE_CLOCK_WRAP = 2**32 # micros() wraps after about 71 minutes
+
+class ClockSync:
+    """
+    NTP-style estimate of the device clock against host wall-clock time.
+
+    Each exchange yields t0 (host send), t1 (device receive), t2 (device transmit)
+    and t3 (host receive). The host-minus-device offset is ((t0 - t1) + (t3 - t2)) / 2
+    and is off by at most half the path delay (t3 - t0) - (t2 - t1). Commands are only
+    serviced once per sample during a run, so bursts keep the exchange that waited least.
+    Sync points are fitted with a line, giving the offset and the drift of the device clock.
+    """
+
+    def __init__(self, ser):
+        self.ser = ser
+        self.seq = 0
+        self.points = [] # (device time (s), offset (s), delay (s))
+        self.reference_us = None
+        self.pending = b''
+
+    def unwrap(self, device_us):
+        """
+        Unwraps raw micros() values to the ones closest to the last sync point.
+        """
+        device_us = np.asarray(device_us, dtype=np.int64)
+        if self.reference_us is None:
+            self.reference_us = int(device_us.flat[0])
+        delta = (device_us - self.reference_us) % DEVICE_CLOCK_WRAP
+        delta = np.where(delta >= DEVICE_CLOCK_WRAP // 2, delta - DEVICE_CLOCK_WRAP, delta)
+        return self.reference_us + delta
+
+    def exchange(self):
+        """
+        One ping. Returns (device time (s), offset (s), delay (s)), or None on a timeout or
+        when some other message arrived first; that byte is kept in self.pending.
+        """
+        self.seq = (self.seq + 1) % 256
+        old_timeout = self.ser.timeout
+        self.ser.timeout = EXCHANGE_TIMEOUT_SEC
+
+        try:
+            t0 = time.time()
+            self.ser.write(HOST_TIME_SYNC + bytes([self.seq]))
+
+            while True:
+                code = self.ser.read(1)
+                t3 = time.time()
+                if code == b'':
+                    return None
+                if code != DEVICE_TIME_SYNC:
+                    self.pending = code
+                    return None
+
+                reply = self.ser.read(SYNC_REPLY_LENGTH)
+                if len(reply) != SYNC_REPLY_LENGTH:
+                    return None
+                seq, t1_us, t2_us = struct.unpack('<BII', reply)
+                if seq == self.seq:
+                    break
+                # Late reply to an earlier exchange, keep waiting for ours
+        finally:
+            self.ser.timeout = old_timeout
+
+        t1, t2 = self.unwrap([t1_us, t2_us]) / 1e6
+        self.reference_us = int(t2 * 1e6)
+
+        offset = ((t0 - t1) + (t3 - t2)) / 2.0
+        delay = (t3 - t0) - (t2 - t1)
+        return t2, offset, delay
+
+    def burst(self, count=BURST_SIZE):
+        """
+        Adds a sync point from the best of count exchanges. Returns False if none succeeded.
+        """
+        best = None
+        for _ in range(count):
+            sample = self.exchange()
+            if self.pending:
+                break
+            if sample is not None and (best is None or sample[2] < best[2]):
+                best = sample
+
+        if best is None:
+            return False
+        self.points.append(best)
+        return True
+
+    def wait_for_byte(self, timeout_sec):
+        """
+        Waits for the next message byte from the device, adding a sync point every
+        SYNC_INTERVAL_SEC in the meantime. Returns b'' on timeout.
+        """
+        deadline = time.time() + timeout_sec
+        old_timeout = self.ser.timeout
+
+        try:
+            while time.time() < deadline:
+                if not self.pending:
+                    self.burst()
+                if self.pending:
+                    code, self.pending = self.pending, b''
+                    return code
+
+                self.ser.timeout = max(0.0, min(SYNC_INTERVAL_SEC, deadline - time.time()))
+                code = self.ser.read(1)
+                if code == DEVICE_TIME_SYNC:
+                    self.ser.read(SYNC_REPLY_LENGTH) # Reply that missed its exchange
+                elif code:
+                    return code
+        finally:
+            self.ser.timeout = old_timeout
+
+        return b''
+
+    def fit(self):
+        """
+        Returns (offset at device time 0 (s), drift (s/s), uncertainty (s)).
+        With a single sync point the drift is taken as zero.
+        """
+        if not self.points:
+            raise ValueError("No sync points")
+
+        device_time, offset, delay = (np.array(column) for column in zip(*self.points))
+
+        if len(self.points) >= 2 and np.ptp(device_time) > 0:
+            drift, intercept = np.polyfit(device_time, offset, 1)
+            residual = offset - (intercept + drift * device_time)
+            spread = np.sqrt(np.sum(residual**2) / max(len(residual) - 2, 1))
+        else:
+            drift, intercept, spread = 0.0, offset[0], 0.0
+
+        # Path asymmetry is bounded by half the best delay, the fit adds its residual spread
+        uncertainty = np.min(delay) / 2.0 + 2.0 * spread
+        return intercept, drift, uncertainty
+
+    def to_host_time(self, device_us):
+        """
+        Maps raw device micros() values to host wall-clock time (s since the epoch).
+        """
+        intercept, drift, _ = self.fit()
+        device_time = self.unwrap(device_us) / 1e6
+        return device_time + intercept + drift * device_time
@@ -0,0 +1,327 @@
+import asyncio
+import struct
+import time
+import serial
+from params import encode_value, decode_value, decode_capabilities, CAPABILITY_FORMAT
+from clock_sync import BURST_SIZE, SYNC_INTERVAL_SEC
+from chunks import (crc16, HOST_PING, DEVICE_PING, HOST_READ_CHUNK, DEVICE_CHUNK, MAX_CHUNK_SIZE, MIN_CHUNK_SIZE,
+                    MAX_ATTEMPTS, QUIET_SEC, reply_timeout)
+
+# --- Configuration ---
+BAUD_RATE = 115200
+TIMEOUT_SEC = 2
+RESET_DELAY_SEC = 2 # Boards reset when the port opens
+TEST_DATA_LENGTH = 4096
+
+# --- Protocol Definitions (Must match Comms.h) ---
+HOST_CHECK_CONNECTION   = b'\x01'
+DEVICE_CHECK_CONNECTION = b'\x02'
+HOST_START_TEST         = b'\x03'
+DEVICE_ACK_START        = b'\x04'
+DEVICE_TEST_SUCCESS     = b'\x05'
+HOST_REQUEST_DATA       = b'\x06'
+DEVICE_DATA_REQUEST_ACK = b'\x07'
+HOST_PARAM_LIST         = b'\x08'
+HOST_PARAM_GET          = b'\x09'
+HOST_PARAM_SET          = b'\x0a'
+DEVICE_PARAM_INFO       = b'\x0b'
+DEVICE_PARAM_VALUE      = b'\x0c'
+DEVICE_PARAM_ERROR      = b'\x0d'
+HOST_TIME_SYNC          = b'\x14'
+DEVICE_TIME_SYNC        = b'\x15'
+HOST_GET_BOARD_ID       = b'\x22'
+DEVICE_BOARD_ID         = b'\x23'
+HOST_GET_CAPABILITIES   = b'\x28'
+DEVICE_CAPABILITIES     = b'\x29'
+
+DEVICE_DATA_STREAM_START = b'DATA_START'
+DEVICE_DATA_STREAM_END   = b'DATA_END'
+
+class DeviceError(Exception):
+    pass
+
+class Device:
+    """
+    One board driven from an asyncio event loop. Reads are fed by the loop's reader
+    callback, so any number of boards can wait on replies at the same time.
+    """
+
+    def __init__(self, port):
+        self.port = port
+        self.ser = None
+        self.buffer = bytearray()
+        self.data_ready = asyncio.Event()
+        self.board_id = None
+        self.capabilities = None
+
+    async def open(self, reset_delay=RESET_DELAY_SEC):
+        self.ser = serial.Serial(self.port, BAUD_RATE, timeout=0)
+        asyncio.get_running_loop().add_reader(self.ser.fileno(), self._on_readable)
+        await asyncio.sleep(reset_delay)
+        self.ser.reset_input_buffer()
+        self.buffer.clear()
+
+    def close(self):
+        if self.ser is not None:
+            asyncio.get_running_loop().remove_reader(self.ser.fileno())
+            self.ser.close()
+            self.ser = None
+
+    def _on_readable(self):
+        try:
+            data = self.ser.read(self.ser.in_waiting or 1)
+        except serial.SerialException:
+            data = b''
+        if data:
+            self.buffer += data
+            self.data_ready.set()
+
+    def write(self, data):
+        self.ser.write(data)
+
+    def unread(self, data):
+        """
+        Puts bytes back in front of the buffer, e.g. a message that interrupted a sync exchange.
+        """
+        self.buffer[:0] = data
+
+    async def read_exact(self, length, timeout=TIMEOUT_SEC):
+        deadline = time.monotonic() + timeout
+        while len(self.buffer) < length:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise DeviceError(f"Expected {length} bytes, got {len(self.buffer)}")
+            self.data_ready.clear()
+            try:
+                await asyncio.wait_for(self.data_ready.wait(), remaining)
+            except asyncio.TimeoutError:
+                pass
+        data = bytes(self.buffer[:length])
+        del self.buffer[:length]
+        return data
+
+    async def expect(self, code, timeout=TIMEOUT_SEC):
+        response = await self.read_exact(1, timeout)
+        if response != code:
+            raise DeviceError(f"Expected {code}, received {response}")
+
+    async def handshake(self, attempts=10):
+        # The device drops anything before it is ready, so the check is repeated
+        for _ in range(attempts):
+            self.write(HOST_CHECK_CONNECTION)
+            try:
+                while await self.read_exact(1, 0.5) != DEVICE_CHECK_CONNECTION:
+                    pass
+                break
+            except DeviceError:
+                continue
+        else:
+            raise DeviceError("Device did not answer the connection check")
+        await self.read_capabilities()
+
+    async def read_capabilities(self):
+        """
+        Descriptor the device measured at boot, see params.read_capabilities.
+        """
+        self.write(HOST_GET_CAPABILITIES)
+        await self.expect(DEVICE_CAPABILITIES)
+        self.capabilities = decode_capabilities(await self.read_exact(struct.calcsize(CAPABILITY_FORMAT)))
+        return self.capabilities
+
+    async def read_board_id(self):
+        """
+        Factory MAC address as 12 hex digits, unique per board.
+        """
+        self.write(HOST_GET_BOARD_ID)
+        await self.expect(DEVICE_BOARD_ID)
+        self.board_id = (await self.read_exact(6)).hex()
+        return self.board_id
+
+    async def list_params(self):
+        """
+        Returns {name: {'id', 'type', 'min', 'max', 'default'}}, like params.list_params.
+        """
+        self.write(HOST_PARAM_LIST)
+        await self.expect(DEVICE_PARAM_INFO)
+        params = {}
+        for _ in range((await self.read_exact(1))[0]):
+            param_id, param_type = await self.read_exact(2)
+            minimum, maximum, default = struct.unpack('<3f', await self.read_exact(12))
+            name = (await self.read_exact((await self.read_exact(1))[0])).decode('ascii')
+            params[name] = {'id': param_id, 'type': param_type, 'min': minimum, 'max': maximum, 'default': default}
+        return params
+
+    async def _read_value_reply(self, param):
+        reply = await self.read_exact(2)
+        if reply[0:1] == DEVICE_PARAM_ERROR:
+            raise DeviceError(f"Device rejected parameter {reply[1]}")
+        if reply[0:1] != DEVICE_PARAM_VALUE or reply[1] != param['id']:
+            raise DeviceError(f"Unexpected parameter reply: {reply}")
+        return decode_value(param['type'], await self.read_exact(4))
+
+    async def get_param(self, param):
+        self.write(HOST_PARAM_GET + bytes([param['id']]))
+        return await self._read_value_reply(param)
+
+    async def set_param(self, param, value):
+        self.write(HOST_PARAM_SET + bytes([param['id']]) + encode_value(param['type'], value))
+        return await self._read_value_reply(param)
+
+    async def apply_params(self, values):
+        """
+        Stages every {name: value} pair, like params.apply_params.
+        """
+        if not values:
+            return
+        params = await self.list_params()
+        for name, value in values.items():
+            if name not in params:
+                raise DeviceError(f"Unknown parameter '{name}'")
+            await self.set_param(params[name], value)
+
+    async def sync_exchange(self, sync):
+        """
+        Same exchange as ClockSync.exchange, without blocking the loop.
+        Returns False when some other message arrived first; it stays in the buffer.
+        """
+        sync.seq = (sync.seq + 1) % 256
+        t0 = time.time()
+        self.write(HOST_TIME_SYNC + bytes([sync.seq]))
+
+        while True:
+            try:
+                code = await self.read_exact(1, 0.2)
+            except DeviceError:
+                return None
+            t3 = time.time()
+            if code != DEVICE_TIME_SYNC:
+                self.unread(code)
+                return False
+            seq, t1_us, t2_us = struct.unpack('<BII', await self.read_exact(9))
+            if seq == sync.seq:
+                break
+
+        t1, t2 = sync.unwrap([t1_us, t2_us]) / 1e6
+        sync.reference_us = int(t2 * 1e6)
+        return t2, ((t0 - t1) + (t3 - t2)) / 2.0, (t3 - t0) - (t2 - t1)
+
+    async def sync_burst(self, sync, count=BURST_SIZE):
+        best = None
+        for _ in range(count):
+            sample = await self.sync_exchange(sync)
+            if sample is False:
+                break
+            if sample is not None and (best is None or sample[2] < best[2]):
+                best = sample
+        if best is not None:
+            sync.points.append(best)
+        return best is not None
+
+    async def wait_for(self, code, timeout, sync=None):
+        """
+        Waits for a message code, adding clock sync points every SYNC_INTERVAL_SEC meanwhile.
+        """
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            if sync is not None and not self.buffer:
+                await self.sync_burst(sync)
+            try:
+                response = await self.read_exact(1, min(SYNC_INTERVAL_SEC, max(deadline - time.monotonic(), 0.01)))
+            except DeviceError:
+                continue
+            if response == DEVICE_TIME_SYNC:
+                await self.read_exact(9) # Reply that missed its exchange
+                continue
+            if response != code:
+                raise DeviceError(f"Expected {code}, received {response}")
+            return
+        raise DeviceError(f"Timed out waiting for {code}")
+
+    async def run_test(self, sync=None, timeout=120):
+        self.write(HOST_START_TEST)
+        response = await self.read_exact(1)
+        if response == DEVICE_PARAM_ERROR:
+            await self.read_exact(1)
+            raise DeviceError("Device refused the run: sample_period_ms does not match the designed excitation table")
+        if response != DEVICE_ACK_START:
+            raise DeviceError(f"Expected {DEVICE_ACK_START}, received {response}")
+        await self.wait_for(DEVICE_TEST_SUCCESS, timeout, sync)
+
+    async def resync(self, attempts=MAX_ATTEMPTS):
+        """
+        Same as chunks.resync: discards whatever is in flight until a ping gets exactly one reply.
+        """
+        for _ in range(attempts):
+            while True:
+                self.buffer.clear()
+                self.data_ready.clear()
+                try:
+                    await asyncio.wait_for(self.data_ready.wait(), QUIET_SEC)
+                except asyncio.TimeoutError:
+                    break
+            self.write(HOST_PING)
+            try:
+                reply = await self.read_exact(1, reply_timeout(1, BAUD_RATE))
+            except DeviceError:
+                continue
+            await asyncio.sleep(QUIET_SEC)
+            if reply == DEVICE_PING and not self.buffer:
+                return
+        raise DeviceError("Device did not get back in sync")
+
+    async def read_chunk(self, offset, length):
+        request = struct.pack('<IH', offset, length)
+        self.write(HOST_READ_CHUNK + request)
+        reply_length = 1 + len(request) + length + 2
+        reply = await self.read_exact(reply_length, reply_timeout(reply_length, BAUD_RATE))
+        if reply[0:1] != DEVICE_CHUNK or reply[1:7] != request:
+            raise DeviceError(f"Unexpected chunk reply at {offset}")
+        if crc16(reply[1:-2]) != struct.unpack('<H', reply[-2:])[0]:
+            raise DeviceError(f"Chunk at {offset} failed its CRC")
+        return reply[7:-2]
+
+    async def read_chunks(self, size):
+        """
+        Same as chunks.read_chunks: the last run's data, damaged chunks fetched again.
+        """
+        data = bytearray()
+        chunk_size = MAX_CHUNK_SIZE
+        while len(data) < size:
+            length = min(chunk_size, size - len(data))
+            for _ in range(MAX_ATTEMPTS):
+                try:
+                    data += await self.read_chunk(len(data), length)
+                    chunk_size = min(2 * chunk_size, MAX_CHUNK_SIZE)
+                    break
+                except DeviceError:
+                    chunk_size = length = max(length // 2, MIN_CHUNK_SIZE)
+                    await self.resync()
+            else:
+                raise DeviceError(f"Chunk at {len(data)} still damaged after {MAX_ATTEMPTS} attempts")
+        return bytes(data)
+
+    async def download(self):
+        """
+        Returns (input, angle, device time (us)) of the last run. A damaged stream is
+        fetched again in CRC-checked chunks.
+        """
+        self.write(HOST_REQUEST_DATA)
+        await self.expect(DEVICE_DATA_REQUEST_ACK)
+
+        bytes_per_array = TEST_DATA_LENGTH * 4
+        try:
+            if await self.read_exact(len(DEVICE_DATA_STREAM_START)) != DEVICE_DATA_STREAM_START:
+                raise DeviceError("Invalid data header")
+            raw = await self.read_exact(3 * bytes_per_array)
+            if await self.read_exact(len(DEVICE_DATA_STREAM_END)) != DEVICE_DATA_STREAM_END:
+                raise DeviceError("Invalid data footer")
+        except DeviceError as e:
+            print(f"[{self.port}] {e}, fetching the data again in checked chunks...")
+            await self.resync()
+            raw = await self.read_chunks(3 * bytes_per_array)
+
+        fmt = f'<{TEST_DATA_LENGTH}f'
+        input_values = struct.unpack_from(fmt, raw, 0)
+        angle_values = struct.unpack_from(fmt, raw, bytes_per_array)
+        time_values = struct.unpack_from(f'<{TEST_DATA_LENGTH}I', raw, 2 * bytes_per_array)
+        return input_values, angle_values, time_values
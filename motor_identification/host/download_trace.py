@@ -0,0 +1,65 @@
+import serial
+import struct
+import sys
+from params import open_without_reset, read_exact
+
+# --- Configuration ---
+SERIAL_PORT = '/dev/ttyUSB0' # Change as needed
+TIMEOUT_SEC = 10
+OUTPUT_FILENAME = 'trace.bin'
+
+# --- Protocol Definitions (Must match Comms.h) ---
+HOST_REQUEST_TRACE = b'\x12'
+DEVICE_TRACE_DATA  = b'\x13'
+
+TRACE_MAGIC = b'TRC1'
+
+def main():
+    """
+    Downloads the input log of a board flashed with the nodemcu-32s-record environment.
+    Run it after the experiment; the port is opened without resetting the board.
+    Replay it with: .pio/build/replay/program < trace.bin > output.bin
+    """
+    print("--- Trace Download ---")
+    output_filename = sys.argv[1] if len(sys.argv) > 1 else OUTPUT_FILENAME
+
+    try:
+        ser = open_without_reset(SERIAL_PORT)
+        ser.timeout = TIMEOUT_SEC
+    except serial.SerialException as e:
+        print(f"Error opening serial port {SERIAL_PORT}: {e}")
+        return
+
+    try:
+        ser.reset_input_buffer()
+        ser.write(HOST_REQUEST_TRACE)
+
+        if read_exact(ser, 1) != DEVICE_TRACE_DATA:
+            print("Error: Device did not answer the trace request.")
+            return
+
+        length, overflowed = struct.unpack('<IB', read_exact(ser, 5))
+        if length == 0:
+            print("Error: Empty trace. Was the firmware built with the nodemcu-32s-record environment?")
+            return
+
+        print(f"   -> Receiving {length} bytes...")
+        log = read_exact(ser, length)
+        if not log.startswith(TRACE_MAGIC):
+            print("Error: Invalid trace header.")
+            return
+
+        with open(output_filename, 'wb') as f:
+            f.write(log)
+
+        print(f"[SUCCESS] Trace saved to '{output_filename}'.")
+        if overflowed:
+            print("Warning: The trace buffer filled up. The replay stops where the recording did.")
+
+    except IOError as e:
+        print(f"Error: {e}")
+    finally:
+        ser.close()
+
+if __name__ == "__main__":
+    main()
@@ -1,13 +1,15 @@
 import pandas as pd
 import numpy as np
 import matplotlib.pyplot as plt
-from scipy.signal import savgol_filter
-from scipy import stats
 import json
+import sys
+import result_cache
+from native import savgol_filter, linregress, backend
 
 # --- Configuration ---
 INPUT_FILENAME = 'experiment_data.csv'
 OUTPUT_MODEL_FILE = 'model_parameters.json'
+ESTIMATOR_VERSION = 2 # Bump when the processing below changes; cached results are keyed by it
 
 # --- Hardcoded Physics Constants ---
 # Shape: Ring (Thick-walled cylinder)
@@ -18,42 +20,58 @@ RADIUS_OUTER = 0.06  # meters
 def main():
     print("--- Motor Parameter Estimator ---")
 
-    # 1. Read experiment data
-    try:
-        print(f"Reading data from {INPUT_FILENAME}...")
-        df = pd.read_csv(INPUT_FILENAME)
-    except FileNotFoundError:
-        print(f"Error: Could not find {INPUT_FILENAME}. Run experiment.py first.")
-        return
+    input_filename = sys.argv[1] if len(sys.argv) > 1 else INPUT_FILENAME
 
-    # Check columns
-    required_cols = ['Time(s)', 'Input', 'Angle']
-    if not all(col in df.columns for col in required_cols):
-        print(f"Error: CSV missing columns. Found: {df.columns}. Expected: {required_cols}")
-        return
-
-    # 2. Clean data & Compute Derivatives
-    print("Processing data...")
-    dt = df['Time(s)'].diff().mean()
-    
     # Savitzky-Golay filter settings
     window_length = 11 
     poly_order = 3
 
-    df['Velocity'] = savgol_filter(df['Angle'], window_length, poly_order, deriv=1, delta=dt)
-    df['Acceleration'] = savgol_filter(df['Angle'], window_length, poly_order, deriv=2, delta=dt)
-
-    # 3. Physics Calculation
     print(f"Load Properties: Ring (Mass={MASS}kg, R_in={RADIUS_INNER}m, R_out={RADIUS_OUTER}m)")
     
     # Inertia for thick-walled ring
     inertia = 0.5 * MASS * (RADIUS_INNER**2 + RADIUS_OUTER**2)
     print(f"Calculated Moment of Inertia (I): {inertia:.6e} kg*m^2")
 
-    df['Estimated_Torque'] = inertia * df['Acceleration']
-
-    # 4. Estimate Transfer Function
-    slope, intercept, r_value, p_value, std_err = stats.linregress(df['Input'], df['Estimated_Torque'])
+    # Same capture, settings and code as an earlier run: the key only hashes the file bytes,
+    # so a hit takes every column it needs from the cache and the CSV is never parsed
+    settings = {'window_length': window_length, 'poly_order': poly_order, 'inertia': inertia}
+    try:
+        key = result_cache.cache_key(input_filename, settings, ESTIMATOR_VERSION)
+    except FileNotFoundError:
+        print(f"Error: Could not find {input_filename}. Run experiment.py first.")
+        return
+    cached = result_cache.load(key)
+    if cached is not None:
+        print(f"Using cached results for {input_filename} ({key[:12]})...")
+        columns, fit = cached
+        df = pd.DataFrame(columns)
+        slope, intercept, r_value = fit['slope'], fit['intercept'], fit['r_value']
+    else:
+        # 1. Read experiment data
+        print(f"Reading data from {input_filename}...")
+        df = pd.read_csv(input_filename)
+
+        # Check columns
+        required_cols = ['Time(s)', 'Input', 'Angle']
+        if not all(col in df.columns for col in required_cols):
+            print(f"Error: CSV missing columns. Found: {df.columns}. Expected: {required_cols}")
+            return
+
+        # 2. Clean data & Compute Derivatives
+        print(f"Processing data ({backend()} kernels)...")
+        dt = df['Time(s)'].diff().mean()
+
+        df['Velocity'] = savgol_filter(df['Angle'], window_length, poly_order, deriv=1, delta=dt)
+        df['Acceleration'] = savgol_filter(df['Angle'], window_length, poly_order, deriv=2, delta=dt)
+
+        # 3. Physics Calculation
+        df['Estimated_Torque'] = inertia * df['Acceleration']
+
+        # 4. Estimate Transfer Function
+        slope, intercept, r_value = linregress(df['Input'], df['Estimated_Torque'])
+        plotted = ['Time(s)', 'Input', 'Angle', 'Velocity', 'Acceleration']
+        result_cache.store(key, {name: df[name] for name in plotted},
+                           {'slope': float(slope), 'intercept': float(intercept), 'r_value': float(r_value)})
     
     transfer_function_str = f"Torque(N*m) = {slope:.4f} * Input_Signal + {intercept:.4f}"
     
@@ -75,6 +93,7 @@ def main():
             json.dump(model_data, f, indent=4)
         print(f"\n[SUCCESS] Model parameters saved to '{OUTPUT_MODEL_FILE}'.")
         print("You can now run validate.py without manual input.")
+        print("For confidence intervals on the parameters, run host/tools bootstrap_ci.")
     except Exception as e:
         print(f"Error saving model file: {e}")
 
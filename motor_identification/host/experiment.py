@@ -1,15 +1,21 @@
 import serial
 import time
-import struct
 import csv
 import matplotlib.pyplot as plt
+from params import (list_params, get_param, apply_params, read_capabilities, feasible_params, run_timeout_sec,
+                    DEVICE_PARAM_ERROR)
+from clock_sync import ClockSync
+from chunks import resync, read_chunks
+from native import decode_capture
 
 # --- Configuration ---
 SERIAL_PORT = '/dev/ttyUSB0' # Change as needed
 BAUD_RATE = 115200
 TEST_DATA_LENGTH = 4096
 TIMEOUT_SEC = 2
-SAMPLE_PERIOD_SEC = 0.01 # 10 ms
+
+# Staged on the device before the run, e.g. {'input_amplitude': 0.3}
+TEST_PARAMS = {}
 
 # --- Protocol Definitions (Must match Comms.h) ---
 HOST_CHECK_CONNECTION   = b'\x01'
@@ -49,6 +55,22 @@ def main():
             response = ser.read(1)
         print("   -> Connection confirmed.")
 
+        # 1b. Stage run parameters and read back the effective sample period
+        capabilities = read_capabilities(ser)
+        if capabilities['buffer_samples'] not in (0, TEST_DATA_LENGTH):
+            print(f"Error: Device records {capabilities['buffer_samples']} samples, expected {TEST_DATA_LENGTH}.")
+            return
+        run_params = feasible_params(capabilities, TEST_PARAMS)
+        apply_params(ser, run_params)
+        sample_period_sec = get_param(ser, list_params(ser)['sample_period_ms']) / 1000.0
+        print(f"   -> Parameters staged {run_params}, sample period {sample_period_sec * 1000:.0f} ms.")
+
+        # 1c. First clock sync point, more follow during and after the run
+        sync = ClockSync(ser)
+        if not sync.burst():
+            print("Error: Device did not answer the clock sync.")
+            return
+
         # 2. Wait for user to start experiment
         input("2. Press [Enter] to start the experiment...")
 
@@ -58,25 +80,31 @@ def main():
 
         # 4. Wait for controller to acknowledge
         response = ser.read(1)
+        if response == DEVICE_PARAM_ERROR:
+            # The only refusal: excitation = 3 at a period ExcitationTable.h was not designed for
+            ser.read(1)
+            print("Error: Device refused the run: sample_period_ms does not match the designed excitation table "
+                  "(rerun excitation_design for this period). Reset the device before the next run.")
+            return
         if response != DEVICE_ACK_START:
             print(f"Error: Device did not acknowledge start. Received: {response}")
             return
         print("   -> Start acknowledged. Test running...")
 
         # 5. Wait for controller to send success message
-        # Note: The C++ loop runs for ~41 seconds (4096 * 10ms). 
-        # We temporarily increase timeout to avoid giving up too early.
-        ser.timeout = 120 
-        print("5. Waiting for test completion (approx. 40-45 seconds)...")
+        # Note: The C++ loop runs for TEST_DATA_LENGTH sample periods.
+        # The clock keeps being synced while waiting.
+        run_sec = TEST_DATA_LENGTH * sample_period_sec
+        print(f"5. Waiting for test completion (approx. {run_sec:.0f} seconds)...")
         
-        response = ser.read(1)
+        response = sync.wait_for_byte(run_timeout_sec(capabilities, sample_period_sec * 1000, TEST_DATA_LENGTH))
         if response != DEVICE_TEST_SUCCESS:
             print(f"Error: Test failed or timed out. Received: {response}")
             return
         print("   -> Test completed successfully.")
         
-        # Reset timeout to normal for data transfer
-        ser.timeout = TIMEOUT_SEC 
+        # Last sync point, closing the run
+        sync.burst()
 
         # 6. Request data from controller
         print("6. Requesting data...")
@@ -90,52 +118,54 @@ def main():
         print("   -> Data request acknowledged. Receiving stream...")
 
         # 8. Read data from controller
-        # Expect: "DATA_START" -> [Input Floats] -> [Angle Floats] -> "DATA_END"
+        # Expect: "DATA_START" -> [Input Floats] -> [Angle Floats] -> [Time uint32 (us)] -> "DATA_END"
         
         # Check header
-        header = ser.read(len(DEVICE_DATA_STREAM_START))
-        if header != DEVICE_DATA_STREAM_START:
-            print(f"Error: Invalid data header. Received: {header}")
-            return
-
-        # Calculate bytes to read: 4096 floats * 4 bytes/float
         bytes_per_array = TEST_DATA_LENGTH * 4
-        
-        print(f"   -> Reading {TEST_DATA_LENGTH} Input samples...")
-        raw_input_data = ser.read(bytes_per_array)
-        if len(raw_input_data) != bytes_per_array:
-            print(f"Error: Incomplete input data. Got {len(raw_input_data)} bytes.")
-            return
-
-        print(f"   -> Reading {TEST_DATA_LENGTH} Angle samples...")
-        raw_angle_data = ser.read(bytes_per_array)
-        if len(raw_angle_data) != bytes_per_array:
-            print(f"Error: Incomplete angle data. Got {len(raw_angle_data)} bytes.")
-            return
-
-        # Check footer
-        footer = ser.read(len(DEVICE_DATA_STREAM_END))
-        if footer != DEVICE_DATA_STREAM_END:
-            print(f"Warning: Invalid data footer. Received: {footer}")
-            # We don't abort here, as we might have valid data anyway.
-
-        # Unpack binary data to float lists
-        # '<' = little-endian (standard for ESP32), 'f' = float
-        fmt = f'<{TEST_DATA_LENGTH}f'
-        input_values = struct.unpack(fmt, raw_input_data)
-        angle_values = struct.unpack(fmt, raw_angle_data)
+        header = ser.read(len(DEVICE_DATA_STREAM_START))
+        raw_data = footer = b''
+        if header == DEVICE_DATA_STREAM_START:
+            # 4096 floats * 4 bytes/float, per array
+            print(f"   -> Reading {TEST_DATA_LENGTH} Input, Angle and Time samples...")
+            raw_data = ser.read(3 * bytes_per_array)
+            footer = ser.read(len(DEVICE_DATA_STREAM_END))
+
+        # A damaged stream is fetched again in CRC-checked chunks, the device keeps the data
+        if header != DEVICE_DATA_STREAM_START or len(raw_data) != 3 * bytes_per_array or footer != DEVICE_DATA_STREAM_END:
+            print(f"   -> Stream damaged (header {header}, {len(raw_data)} of {3 * bytes_per_array} bytes). "
+                  "Fetching it again in checked chunks...")
+            try:
+                resync(ser)
+                raw_data = read_chunks(ser, 3 * bytes_per_array)
+            except IOError as e:
+                print(f"Error: {e}")
+                return
+            print("   -> Data recovered.")
+
+        # Unpack the little-endian (ESP32) arrays; written out at full float64 precision as before
+        input_values, angle_values, time_values = decode_capture(raw_data)
+        input_values = input_values.astype(float)
+        angle_values = angle_values.astype(float)
 
         # 9. Save data to file
         filename = "experiment_data.csv"
         print(f"9. Saving data to {filename}...")
 
-        time_axis = [i * SAMPLE_PERIOD_SEC for i in range(TEST_DATA_LENGTH)]
+        # Sample times from the device clock, and the same instants in host wall-clock time
+        device_time = sync.unwrap(time_values) / 1e6
+        time_axis = list(device_time - device_time[0])
+        host_time = sync.to_host_time(time_values)
+        offset, drift, uncertainty = sync.fit()
+        print(f"   -> Clock sync: {len(sync.points)} points, drift {drift * 1e6:+.1f} ppm, "
+              f"uncertainty +/- {uncertainty * 1000:.3f} ms.")
+        print(f"   -> Nominal sample period {sample_period_sec * 1000:.0f} ms, "
+              f"measured {(time_axis[-1] / (TEST_DATA_LENGTH - 1)) * 1000:.3f} ms.")
         
         with open(filename, 'w', newline='') as csvfile:
             writer = csv.writer(csvfile)
-            writer.writerow(["Time(s)", "Input", "Angle"])
+            writer.writerow(["Time(s)", "Input", "Angle", "HostTime(s)", "HostTimeUncertainty(s)"])
             for i in range(TEST_DATA_LENGTH):
-                writer.writerow([time_axis[i], input_values[i], angle_values[i]])
+                writer.writerow([time_axis[i], input_values[i], angle_values[i], f"{host_time[i]:.6f}", f"{uncertainty:.6f}"])
 
         # 10. Report experiment success
         print("10. Experiment finished successfully.")
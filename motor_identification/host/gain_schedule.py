@@ -0,0 +1,132 @@
+import numpy as np
+from scipy.linalg import solve_discrete_are
+from scipy.signal import cont2discrete
+import json
+
+# --- Configuration ---
+MODEL_FILE = 'model_parameters.json'
+OUTPUT_HEADER = '../controller/experiment_and_validation/lib/GainSchedule/GainTable.h'
+
+CONTROL_PERIOD_SEC = 0.001 # 1 kHz control loop
+
+# Operating point grid (tilt in rad, wheel speed in rad/s)
+TILT_MIN, TILT_MAX, TILT_POINTS = -0.35, 0.35, 8
+SPEED_MIN, SPEED_MAX, SPEED_POINTS = -300.0, 300.0, 7
+
+# LQR weights for the state [tilt, tilt rate, wheel speed] and the input
+Q = np.diag([100.0, 1.0, 0.001])
+R = np.array([[1.0]])
+
+# --- Hardcoded Physics Constants ---
+# Placeholders until the pendulum geometry is captured (see README)
+BODY_MASS = 0.8          # kg
+COM_HEIGHT = 0.12        # meters, pivot to centre of mass
+BODY_INERTIA = 0.015     # kg*m^2, about the pivot
+NO_LOAD_SPEED = 400.0    # rad/s, wheel speed at which the motor torque vanishes
+WHEEL_FRICTION = 1e-5    # N*m*s/rad
+GRAVITY = 9.81           # m/s^2
+
+def load_motor_model():
+    with open(MODEL_FILE, 'r') as f:
+        data = json.load(f)
+    return data['slope'], data['inertia']
+
+def linearize(tilt, wheel_speed, torque_gain, wheel_inertia):
+    """
+    Linearized reaction wheel pendulum around (tilt, wheel_speed).
+    The available torque drops linearly with the wheel speed.
+    """
+    gravity_term = BODY_MASS * GRAVITY * COM_HEIGHT * np.cos(tilt) / BODY_INERTIA
+    input_gain = torque_gain * max(1.0 - abs(wheel_speed) / NO_LOAD_SPEED, 0.05)
+
+    A = np.array([
+        [0.0,           1.0, 0.0],
+        [gravity_term,  0.0, WHEEL_FRICTION / BODY_INERTIA],
+        [-gravity_term, 0.0, -WHEEL_FRICTION * (1.0 / wheel_inertia + 1.0 / BODY_INERTIA)],
+    ])
+    B = np.array([
+        [0.0],
+        [-input_gain / BODY_INERTIA],
+        [input_gain * (1.0 / wheel_inertia + 1.0 / BODY_INERTIA)],
+    ])
+    return A, B
+
+def lqr_gains(A, B):
+    Ad, Bd, _, _, _ = cont2discrete((A, B, np.eye(3), np.zeros((3, 1))), CONTROL_PERIOD_SEC)
+    P = solve_discrete_are(Ad, Bd, Q, R)
+    K = np.linalg.solve(R + Bd.T @ P @ Bd, Bd.T @ P @ Ad)
+    return K.flatten()
+
+def c_float(value):
+    text = f'{value:.9g}'
+    if '.' not in text and 'e' not in text:
+        text += '.0'
+    return text + 'f'
+
+def format_floats(values):
+    return ', '.join(c_float(v) for v in values)
+
+def write_header(tilts, speeds, table):
+    tilt_step = tilts[1] - tilts[0]
+    speed_step = speeds[1] - speeds[0]
+
+    lines = [
+        '// Generated by motor_identification/host/gain_schedule.py. Do not edit.',
+        '#ifndef GAIN_TABLE_H',
+        '#define GAIN_TABLE_H',
+        '',
+        f'constexpr unsigned int GAIN_STATES = {table.shape[2]};',
+        f'constexpr unsigned int GAIN_TILT_POINTS = {len(tilts)};',
+        f'constexpr unsigned int GAIN_SPEED_POINTS = {len(speeds)};',
+        '',
+        f'constexpr float GAIN_TILT_MIN = {c_float(tilts[0])};',
+        f'constexpr float GAIN_TILT_MAX = {c_float(tilts[-1])};',
+        f'constexpr float GAIN_TILT_STEP_INV = {c_float(1.0 / tilt_step)};',
+        f'constexpr float GAIN_SPEED_MIN = {c_float(speeds[0])};',
+        f'constexpr float GAIN_SPEED_MAX = {c_float(speeds[-1])};',
+        f'constexpr float GAIN_SPEED_STEP_INV = {c_float(1.0 / speed_step)};',
+        '',
+        '// [tilt][wheel speed][state], row-major',
+        'constexpr float GAIN_TABLE[GAIN_TILT_POINTS * GAIN_SPEED_POINTS * GAIN_STATES] = {',
+    ]
+    for i, tilt in enumerate(tilts):
+        lines.append(f'    // tilt = {tilt:+.4f} rad')
+        for j in range(len(speeds)):
+            lines.append(f'    {format_floats(table[i, j])},')
+    lines += [
+        '};',
+        '',
+        '#endif // GAIN_TABLE_H',
+        '',
+    ]
+
+    with open(OUTPUT_HEADER, 'w') as f:
+        f.write('\n'.join(lines))
+
+def main():
+    print("--- Gain Schedule Generator ---")
+
+    try:
+        torque_gain, wheel_inertia = load_motor_model()
+    except FileNotFoundError:
+        print(f"Error: Could not find {MODEL_FILE}. Run estimate.py first.")
+        return
+
+    print(f"Motor: Torque gain = {torque_gain:.4f} N*m, Wheel inertia = {wheel_inertia:.6e} kg*m^2")
+
+    tilts = np.linspace(TILT_MIN, TILT_MAX, TILT_POINTS)
+    speeds = np.linspace(SPEED_MIN, SPEED_MAX, SPEED_POINTS)
+    table = np.zeros((TILT_POINTS, SPEED_POINTS, 3))
+
+    print(f"Computing LQR gains over a {TILT_POINTS}x{SPEED_POINTS} grid...")
+    for i, tilt in enumerate(tilts):
+        for j, speed in enumerate(speeds):
+            A, B = linearize(tilt, speed, torque_gain, wheel_inertia)
+            table[i, j] = lqr_gains(A, B)
+
+    write_header(tilts, speeds, table)
+    print(f"[SUCCESS] Gain table written to '{OUTPUT_HEADER}'.")
+    print("To check the gains against the parameter spread, run host/tools monte_carlo.")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,144 @@
+import serial
+import time
+import struct
+import csv
+import matplotlib.pyplot as plt
+from params import list_params, get_param, apply_params, read_capabilities, feasible_params, run_timeout_sec
+from chunks import resync, read_chunks
+
+# --- Configuration ---
+SERIAL_PORT = '/dev/ttyUSB0' # Change as needed
+BAUD_RATE = 115200
+MIMO_DATA_LENGTH = 2048      # Must match mimoDataLength in main.cpp
+TIMEOUT_SEC = 2
+OUTPUT_FILE = 'mimo_data.csv'
+
+# Staged on the device before the run, e.g. {'input_amplitude': 0.3, 'prbs_hold_samples': 2}
+TEST_PARAMS = {}
+
+# --- Protocol Definitions (Must match Comms.h) ---
+HOST_CHECK_CONNECTION   = b'\x01'
+DEVICE_CHECK_CONNECTION = b'\x02'
+DEVICE_ACK_START        = b'\x04'
+DEVICE_TEST_SUCCESS     = b'\x05'
+HOST_REQUEST_DATA       = b'\x06'
+DEVICE_DATA_REQUEST_ACK = b'\x07'
+HOST_START_MIMO         = b'\x2a'
+
+DEVICE_DATA_STREAM_START = b'DATA_START'
+DEVICE_DATA_STREAM_END   = b'DATA_END'
+
+def main():
+    print("--- Two-Wheel (MIMO) Experiment Host ---")
+
+    try:
+        ser = serial.Serial(SERIAL_PORT, BAUD_RATE, timeout=TIMEOUT_SEC)
+        time.sleep(2) # Wait for Arduino to reset after serial connection
+    except serial.SerialException as e:
+        print(f"Error opening serial port {SERIAL_PORT}: {e}")
+        return
+
+    try:
+        ser.reset_input_buffer()
+        ser.reset_output_buffer()
+
+        # 1. Check connection with controller
+        print("1. Checking connection with controller...")
+        ser.write(HOST_CHECK_CONNECTION)
+        response = b''
+        while response != DEVICE_CHECK_CONNECTION:
+            response = ser.read(1)
+        print("   -> Connection confirmed.")
+
+        capabilities = read_capabilities(ser)
+        run_params = feasible_params(capabilities, TEST_PARAMS)
+        apply_params(ser, run_params)
+        sample_period_sec = get_param(ser, list_params(ser)['sample_period_ms']) / 1000.0
+        print(f"   -> Parameters staged {run_params}, sample period {sample_period_sec * 1000:.0f} ms.")
+
+        # 2. Both wheels are driven with shifted PRBS copies at once
+        input("2. Both wheels will move. Press [Enter] to start the experiment...")
+        ser.write(HOST_START_MIMO)
+        response = ser.read(1)
+        if response != DEVICE_ACK_START:
+            print(f"Error: Device did not acknowledge start. Received: {response}")
+            return
+        print(f"   -> Start acknowledged. Test running (approx. {MIMO_DATA_LENGTH * sample_period_sec:.0f} seconds)...")
+
+        ser.timeout = run_timeout_sec(capabilities, sample_period_sec * 1000, MIMO_DATA_LENGTH)
+        response = ser.read(1)
+        ser.timeout = TIMEOUT_SEC
+        if response != DEVICE_TEST_SUCCESS:
+            print(f"Error: Test failed or timed out. Received: {response}")
+            return
+        print("   -> Test completed successfully.")
+
+        # 3. Request data. Expect: "DATA_START" -> [Input 0] [Input 1] [Angle 0] [Angle 1] [Time (us)] -> "DATA_END"
+        print("3. Requesting data...")
+        ser.write(HOST_REQUEST_DATA)
+        response = ser.read(1)
+        if response != DEVICE_DATA_REQUEST_ACK:
+            print(f"Error: Device did not ack data request. Received: {response}")
+            return
+
+        bytes_per_array = MIMO_DATA_LENGTH * 4
+        header = ser.read(len(DEVICE_DATA_STREAM_START))
+        raw_data = footer = b''
+        if header == DEVICE_DATA_STREAM_START:
+            raw_data = ser.read(5 * bytes_per_array)
+            footer = ser.read(len(DEVICE_DATA_STREAM_END))
+
+        # A damaged stream is fetched again in CRC-checked chunks, the device keeps the data
+        if header != DEVICE_DATA_STREAM_START or len(raw_data) != 5 * bytes_per_array or footer != DEVICE_DATA_STREAM_END:
+            print(f"   -> Stream damaged ({len(raw_data)} of {5 * bytes_per_array} bytes). Fetching it again in checked chunks...")
+            try:
+                resync(ser)
+                raw_data = read_chunks(ser, 5 * bytes_per_array)
+            except IOError as e:
+                print(f"Error: {e}")
+                return
+            print("   -> Data recovered.")
+
+        fmt = f'<{MIMO_DATA_LENGTH}f'
+        arrays = [struct.unpack(fmt, raw_data[k * bytes_per_array:(k + 1) * bytes_per_array]) for k in range(4)]
+        inputs, angles = arrays[0:2], arrays[2:4]
+        time_values = struct.unpack(f'<{MIMO_DATA_LENGTH}I', raw_data[4 * bytes_per_array:])
+
+        # 4. Save data to file, one row per sample with both wheels
+        print(f"4. Saving data to {OUTPUT_FILE}...")
+        time_axis = [((t - time_values[0]) & 0xFFFFFFFF) / 1e6 for t in time_values]
+        with open(OUTPUT_FILE, 'w', newline='') as csvfile:
+            writer = csv.writer(csvfile)
+            writer.writerow(["Time(s)", "Input0", "Angle0", "Input1", "Angle1"])
+            for i in range(MIMO_DATA_LENGTH):
+                writer.writerow([time_axis[i], inputs[0][i], angles[0][i], inputs[1][i], angles[1][i]])
+        print("   -> Run host/tools mimo_paths on it to separate the direct and cross paths,")
+        print("      or subspace_id for a two-input, two-output state-space model.")
+
+        # 5. Plot data
+        plot_filename = "mimo_results.png"
+        plt.figure(figsize=(10, 8))
+        for wheel in range(2):
+            plt.subplot(2, 1, wheel + 1)
+            plt.plot(time_axis, angles[wheel], label=f'Angle {wheel}')
+            plt.step(time_axis, inputs[wheel], where='post', alpha=0.6, label=f'Input {wheel}')
+            plt.ylabel(f'Wheel {wheel}')
+            plt.grid(True, alpha=0.5)
+            plt.legend(loc='upper right')
+        plt.xlabel('Time (seconds)')
+        plt.tight_layout()
+        plt.savefig(plot_filename)
+        print(f"   -> Plot saved to {plot_filename}")
+        plt.show()
+
+    except KeyboardInterrupt:
+        print("\nOperation cancelled by user.")
+    except Exception as e:
+        print(f"\nAn unexpected error occurred: {e}")
+    finally:
+        if ser.is_open:
+            ser.close()
+            print("Serial port closed.")
+
+if __name__ == "__main__":
+    main()
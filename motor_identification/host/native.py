@@ -0,0 +1,52 @@
+import os
+import sys
+import numpy as np
+
+# The compiled kernels (tools/python/motor_native.cpp) when they are built, numpy/scipy when
+# not: both give the same results, the scripts do not need to know which one runs.
+# An in-place build (python setup.py build_ext --inplace) is found without installing it.
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), 'tools', 'python'))
+try:
+    import motor_native
+except ImportError:
+    motor_native = None
+
+def backend():
+    """
+    Name of the implementation in use, for the scripts to report.
+    """
+    return 'native' if motor_native is not None else 'numpy'
+
+def decode_capture(raw_data):
+    """
+    Splits a motor test download (all inputs, all angles, all sample times, little-endian)
+    into (input, angle, time_us) arrays of float32, float32 and uint32.
+    """
+    if motor_native is not None:
+        return motor_native.decode_capture(raw_data)
+    samples = len(raw_data) // 12
+    if len(raw_data) != 12 * samples:
+        raise ValueError("capture length is not a whole number of samples")
+    input_values = np.frombuffer(raw_data, dtype='<f4', count=samples)
+    angle_values = np.frombuffer(raw_data, dtype='<f4', count=samples, offset=4 * samples)
+    time_values = np.frombuffer(raw_data, dtype='<u4', count=samples, offset=8 * samples)
+    return input_values, angle_values, time_values
+
+def savgol_filter(x, window_length, polyorder, deriv=0, delta=1.0):
+    """
+    scipy.signal.savgol_filter with its default mode='interp'.
+    """
+    if motor_native is not None:
+        return motor_native.savgol_filter(np.asarray(x, dtype=np.float64), window_length, polyorder, deriv, delta)
+    from scipy.signal import savgol_filter as scipy_savgol_filter
+    return scipy_savgol_filter(x, window_length, polyorder, deriv=deriv, delta=delta)
+
+def linregress(x, y):
+    """
+    Least-squares line through (x, y): (slope, intercept, r_value) of scipy.stats.linregress.
+    """
+    if motor_native is not None:
+        return motor_native.linregress(np.asarray(x, dtype=np.float64), np.asarray(y, dtype=np.float64))
+    from scipy import stats
+    result = stats.linregress(x, y)
+    return result.slope, result.intercept, result.rvalue
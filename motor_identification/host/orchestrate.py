@@ -0,0 +1,112 @@
+import asyncio
+import csv
+import os
+import sys
+import time
+from clock_sync import ClockSync
+from device import Device, DeviceError, TEST_DATA_LENGTH
+from params import feasible_params, run_timeout_sec
+
+# --- Configuration ---
+SERIAL_PORTS = ['/dev/ttyUSB0', '/dev/ttyUSB1'] # Change as needed, or pass ports as arguments
+OUTPUT_DIR = 'campaign'
+
+# Staged on every board before the run, e.g. {'input_amplitude': 0.3}
+TEST_PARAMS = {}
+
+async def run_board(port):
+    """
+    Full experiment on one board. Returns a summary row; never raises, so one failing
+    board does not cancel the others.
+    """
+    device = Device(port)
+    started = time.monotonic()
+    summary = {'Port': port, 'BoardId': '', 'Status': 'error', 'Duration(s)': 0.0,
+               'Samples': 0, 'Drift(ppm)': '', 'SyncUncertainty(s)': '', 'File': ''}
+    label = port
+
+    try:
+        await device.open()
+        await device.handshake()
+        board_id = await device.read_board_id()
+        summary['BoardId'] = board_id
+        label = f"{board_id} on {port}"
+        print(f"[{label}] Connected.")
+
+        # A requested period too fast for this board is raised to what its probe found safe
+        params = feasible_params(device.capabilities, TEST_PARAMS)
+        await device.apply_params(params)
+        sample_period_ms = await device.get_param((await device.list_params())['sample_period_ms'])
+        print(f"[{label}] Sample period {sample_period_ms} ms.")
+
+        sync = ClockSync(None)
+        if not await device.sync_burst(sync):
+            raise DeviceError("Device did not answer the clock sync")
+
+        print(f"[{label}] Test running...")
+        await device.run_test(sync, run_timeout_sec(device.capabilities, sample_period_ms, TEST_DATA_LENGTH))
+        await device.sync_burst(sync)
+
+        print(f"[{label}] Test completed, downloading...")
+        input_values, angle_values, time_values = await device.download()
+
+        device_time = sync.unwrap(time_values) / 1e6
+        time_axis = device_time - device_time[0]
+        host_time = sync.to_host_time(time_values)
+        _, drift, uncertainty = sync.fit()
+
+        filename = os.path.join(OUTPUT_DIR, f"experiment_data_{board_id}.csv")
+        with open(filename, 'w', newline='') as csvfile:
+            writer = csv.writer(csvfile)
+            writer.writerow(["Time(s)", "Input", "Angle", "HostTime(s)", "HostTimeUncertainty(s)"])
+            for i in range(TEST_DATA_LENGTH):
+                writer.writerow([time_axis[i], input_values[i], angle_values[i], f"{host_time[i]:.6f}", f"{uncertainty:.6f}"])
+
+        summary.update({'Status': 'ok', 'Samples': TEST_DATA_LENGTH, 'Drift(ppm)': f"{drift * 1e6:+.1f}",
+                        'SyncUncertainty(s)': f"{uncertainty:.6f}", 'File': filename})
+        print(f"[{label}] Data saved to {filename}.")
+
+    except (DeviceError, OSError) as e:
+        print(f"[{label}] Error: {e}")
+    finally:
+        device.close()
+        summary['Duration(s)'] = round(time.monotonic() - started, 2)
+
+    return summary
+
+async def run_campaign(ports):
+    return await asyncio.gather(*(run_board(port) for port in ports))
+
+def main():
+    print("--- Multi-Board Experiment Orchestrator ---")
+
+    ports = sys.argv[1:] or SERIAL_PORTS
+    if len(set(ports)) != len(ports):
+        print("Error: A port is listed twice.")
+        return
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+
+    print(f"Running {len(ports)} boards concurrently: {', '.join(ports)}")
+    started = time.monotonic()
+    summaries = asyncio.run(run_campaign(ports))
+    elapsed = time.monotonic() - started
+
+    summary_file = os.path.join(OUTPUT_DIR, 'campaign.csv')
+    with open(summary_file, 'w', newline='') as csvfile:
+        writer = csv.DictWriter(csvfile, fieldnames=list(summaries[0].keys()))
+        writer.writeheader()
+        writer.writerows(summaries)
+
+    succeeded = sum(1 for summary in summaries if summary['Status'] == 'ok')
+    slowest = max(summary['Duration(s)'] for summary in summaries)
+    total = sum(summary['Duration(s)'] for summary in summaries)
+
+    print("\n--- Campaign Summary ---")
+    for summary in summaries:
+        print(f"  {summary['BoardId'] or '?':<12}  {summary['Port']:<16} {summary['Status']:<6} {summary['Duration(s)']:>7.1f} s")
+    print(f"Boards succeeded:  {succeeded} of {len(summaries)}")
+    print(f"Campaign time:     {elapsed:.1f} s (slowest board {slowest:.1f} s, sequential would be {total:.1f} s)")
+    print(f"Summary saved to {summary_file}")
+
+if __name__ == "__main__":
+    main()
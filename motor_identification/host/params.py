@@ -0,0 +1,216 @@
+import serial
+import struct
+import sys
+
+# --- Configuration ---
+SERIAL_PORT = '/dev/ttyUSB0' # Change as needed
+BAUD_RATE = 115200
+TIMEOUT_SEC = 2
+
+# --- Protocol Definitions (Must match Comms.h) ---
+HOST_PARAM_LIST    = b'\x08'
+HOST_PARAM_GET     = b'\x09'
+HOST_PARAM_SET     = b'\x0a'
+DEVICE_PARAM_INFO  = b'\x0b'
+DEVICE_PARAM_VALUE = b'\x0c'
+DEVICE_PARAM_ERROR = b'\x0d'
+HOST_GET_CAPABILITIES = b'\x28'
+DEVICE_CAPABILITIES   = b'\x29'
+DEVICE_BUSY           = b'\x2b'
+
+# CapabilityReport (Must match Comms.h)
+CAPABILITY_FORMAT = '<8I'
+CAPABILITY_FIELDS = ['sample_worst_us', 'sample_mean_us', 'min_sample_period_ms', 'buffer_samples',
+                     'hil_worst_us', 'hil_period_us', 'link_baud_rate', 'telemetry_channels']
+# A HIL tick sends a 7-byte actuator frame and receives an 11-byte sensor frame (8N1)
+HIL_FRAME_BYTES = 11
+# Time allowed for a run on top of its nominal length before giving up on it
+RUN_TIMEOUT_MARGIN = 1.5
+RUN_TIMEOUT_SLACK_SEC = 10
+
+# --- Parameter Types (Must match Params.h) ---
+PARAM_TYPE_UINT32 = 0
+PARAM_TYPE_FLOAT  = 1
+
+def read_exact(ser, length):
+    data = ser.read(length)
+    if len(data) != length:
+        raise IOError(f"Expected {length} bytes, got {len(data)}")
+    return data
+
+def encode_value(param_type, value):
+    if param_type == PARAM_TYPE_UINT32:
+        return struct.pack('<I', int(value))
+    return struct.pack('<f', float(value))
+
+def decode_value(param_type, raw):
+    if param_type == PARAM_TYPE_UINT32:
+        return struct.unpack('<I', raw)[0]
+    return struct.unpack('<f', raw)[0]
+
+def list_params(ser):
+    """
+    Returns {name: {'id', 'type', 'min', 'max', 'default'}} as advertised by the device.
+    """
+    ser.write(HOST_PARAM_LIST)
+    reply = read_exact(ser, 1)
+    if reply == DEVICE_BUSY:
+        read_exact(ser, 1)
+        raise IOError("Device is sampling a run, list the parameters before starting it")
+    if reply != DEVICE_PARAM_INFO:
+        raise IOError("Device did not answer the parameter list request")
+
+    count = read_exact(ser, 1)[0]
+    params = {}
+    for _ in range(count):
+        param_id, param_type = read_exact(ser, 2)
+        minimum, maximum, default = struct.unpack('<3f', read_exact(ser, 12))
+        name_length = read_exact(ser, 1)[0]
+        name = read_exact(ser, name_length).decode('ascii')
+        params[name] = {
+            'id': param_id,
+            'type': param_type,
+            'min': minimum,
+            'max': maximum,
+            'default': default,
+        }
+    return params
+
+def _read_value_reply(ser, param):
+    reply = read_exact(ser, 2)
+    if reply[0:1] == DEVICE_PARAM_ERROR:
+        raise ValueError(f"Device rejected parameter {reply[1]}")
+    if reply[0:1] != DEVICE_PARAM_VALUE or reply[1] != param['id']:
+        raise IOError(f"Unexpected parameter reply: {reply}")
+    return decode_value(param['type'], read_exact(ser, 4))
+
+def get_param(ser, param):
+    ser.write(HOST_PARAM_GET + bytes([param['id']]))
+    return _read_value_reply(ser, param)
+
+def set_param(ser, param, value):
+    """
+    Stages a value. The device applies it at the next sample boundary of a run.
+    """
+    ser.write(HOST_PARAM_SET + bytes([param['id']]) + encode_value(param['type'], value))
+    return _read_value_reply(ser, param)
+
+def apply_params(ser, values):
+    """
+    Stages every {name: value} pair, e.g. from a tuning session config.
+    """
+    params = list_params(ser)
+    for name, value in values.items():
+        if name not in params:
+            raise KeyError(f"Unknown parameter '{name}'")
+        set_param(ser, params[name], value)
+
+def decode_capabilities(payload):
+    return dict(zip(CAPABILITY_FIELDS, struct.unpack(CAPABILITY_FORMAT, payload)))
+
+def read_capabilities(ser):
+    """
+    The descriptor the device measured at boot: {'sample_worst_us', 'min_sample_period_ms', ...}.
+    """
+    ser.write(HOST_GET_CAPABILITIES)
+    if read_exact(ser, 1) != DEVICE_CAPABILITIES:
+        raise IOError("Device did not answer the capability request")
+    return decode_capabilities(read_exact(ser, struct.calcsize(CAPABILITY_FORMAT)))
+
+def feasible_params(capabilities, values):
+    """
+    Returns a copy of the {name: value} run config the device can keep up with: a requested
+    sample_period_ms faster than the probe found safe is raised to it. Without one the device
+    keeps its own period, so default runs sample alike on every board.
+    """
+    chosen = dict(values)
+    minimum = capabilities['min_sample_period_ms']
+    requested = chosen.get('sample_period_ms')
+    if minimum == 0 or requested is None:
+        return chosen # Not probed (e.g. older firmware), or nothing to check
+    if requested < minimum:
+        print(f"   -> Note: sample_period_ms {requested} is faster than the device keeps up with, using {minimum}.")
+        chosen['sample_period_ms'] = minimum
+    return chosen
+
+def run_timeout_sec(capabilities, sample_period_ms, samples):
+    """
+    How long a run of samples at sample_period_ms may take. The device samples on a grid of
+    whole periods, so the run only stretches when a sample is slower than its period.
+    """
+    sample_sec = max(sample_period_ms / 1000.0, capabilities['sample_worst_us'] / 1e6)
+    return samples * sample_sec * RUN_TIMEOUT_MARGIN + RUN_TIMEOUT_SLACK_SEC
+
+def hil_problem(capabilities):
+    """
+    Why a HIL run would miss ticks with this descriptor, or None if it fits.
+    """
+    period_us = capabilities['hil_period_us']
+    if capabilities['hil_worst_us'] >= period_us:
+        return f"the controller step takes up to {capabilities['hil_worst_us']} us of the {period_us} us tick"
+    needed_baud = HIL_FRAME_BYTES * 10 * 1e6 / period_us
+    if 0 < capabilities['link_baud_rate'] < needed_baud:
+        return f"{capabilities['link_baud_rate']} baud cannot carry a frame per tick, it needs {needed_baud:.0f}"
+    return None
+
+def open_without_reset(port):
+    # Keeping DTR/RTS low on open avoids resetting the board, which would discard staged values
+    ser = serial.Serial()
+    ser.port = port
+    ser.baudrate = BAUD_RATE
+    ser.timeout = TIMEOUT_SEC
+    ser.dtr = False
+    ser.rts = False
+    ser.open()
+    return ser
+
+def main():
+    usage = "Usage: params.py list | get <name> | set <name> <value> | capabilities"
+    if len(sys.argv) < 2:
+        print(usage)
+        return
+
+    command = sys.argv[1]
+
+    try:
+        ser = open_without_reset(SERIAL_PORT)
+    except serial.SerialException as e:
+        print(f"Error opening serial port {SERIAL_PORT}: {e}")
+        return
+
+    try:
+        params = list_params(ser)
+
+        if command == 'capabilities':
+            capabilities = read_capabilities(ser)
+            for name, value in capabilities.items():
+                print(f"{name:<22} {value}")
+            problem = hil_problem(capabilities)
+            print(f"HIL at this rate: {'ok' if problem is None else problem}")
+        elif command == 'list':
+            print(f"{'ID':>3}  {'Name':<24} {'Type':<7} {'Min':>10} {'Max':>10} {'Default':>10} {'Value':>10}")
+            for name, param in params.items():
+                type_name = 'uint32' if param['type'] == PARAM_TYPE_UINT32 else 'float'
+                value = get_param(ser, param)
+                print(f"{param['id']:>3}  {name:<24} {type_name:<7} {param['min']:>10g} {param['max']:>10g} {param['default']:>10g} {value:>10g}")
+        elif command in ('get', 'set') and len(sys.argv) >= 3:
+            name = sys.argv[2]
+            if name not in params:
+                print(f"Error: Unknown parameter '{name}'. Known: {', '.join(params)}")
+                return
+            if command == 'get':
+                print(f"{name} = {get_param(ser, params[name])}")
+            elif len(sys.argv) == 4:
+                print(f"{name} = {set_param(ser, params[name], sys.argv[3])} (staged)")
+            else:
+                print(usage)
+        else:
+            print(usage)
+
+    except (IOError, ValueError) as e:
+        print(f"Error: {e}")
+    finally:
+        ser.close()
+
+if __name__ == "__main__":
+    main()
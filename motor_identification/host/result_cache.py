@@ -0,0 +1,55 @@
+import hashlib
+import json
+import os
+import numpy as np
+
+# --- Configuration ---
+CACHE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '.result_cache')  # Safe to delete at any time
+READ_BLOCK_BYTES = 1 << 20
+
+def cache_key(data_path, settings, version):
+    """
+    SHA-256 of the capture file bytes, the processing settings and the version of the code
+    that uses them. Any change to one of the three gives a new key, so entries never go stale:
+    bump the version whenever the processing itself changes.
+    """
+    digest = hashlib.sha256()
+    with open(data_path, 'rb') as f:
+        for block in iter(lambda: f.read(READ_BLOCK_BYTES), b''):
+            digest.update(block)
+    digest.update(json.dumps(settings, sort_keys=True).encode())
+    digest.update(str(version).encode())
+    return digest.hexdigest()
+
+def _entry_path(key):
+    return os.path.join(CACHE_DIR, key[:2], key + '.npz')
+
+def load(key):
+    """
+    Returns (columns, result) stored under key: a dict of numpy arrays and the JSON-able
+    result. None when there is no entry or it cannot be read.
+    """
+    try:
+        with np.load(_entry_path(key), allow_pickle=False) as entry:
+            result = json.loads(str(entry['__result__']))
+            columns = {name: entry[name] for name in entry.files if name != '__result__'}
+            return columns, result
+    except (OSError, ValueError, KeyError):
+        return None
+
+def store(key, columns, result):
+    """
+    Saves the derived columns and the result under key. The entry is written to a temporary
+    file and renamed, so a concurrent reader sees either the whole entry or none.
+    """
+    path = _entry_path(key)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    temp_path = f"{path}.{os.getpid()}.tmp"
+    try:
+        with open(temp_path, 'wb') as f:
+            np.savez(f, __result__=json.dumps(result), **{name: np.asarray(values) for name, values in columns.items()})
+        os.replace(temp_path, path)
+    except OSError as e:
+        print(f"Warning: could not cache results: {e}")
+        if os.path.exists(temp_path):
+            os.remove(temp_path)
@@ -0,0 +1,34 @@
+#include <Capture.h>
+
+#include <cstring>
+
+static const size_t bytesPerSample = 3 * sizeof(uint32_t);
+
+static uint32_t littleEndian32(const uint8_t* bytes)
+{
+    return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 | static_cast<uint32_t>(bytes[2]) << 16
+        | static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+bool decodeCapture(const uint8_t* data, size_t length, Capture& capture)
+{
+    if (length % bytesPerSample != 0) {
+        return false;
+    }
+    size_t samples = length / bytesPerSample;
+    const uint8_t* inputBytes = data;
+    const uint8_t* angleBytes = data + samples * sizeof(uint32_t);
+    const uint8_t* timeBytes = data + 2 * samples * sizeof(uint32_t);
+
+    capture.input.resize(samples);
+    capture.angle.resize(samples);
+    capture.timeUs.resize(samples);
+    for (size_t i = 0; i < samples; i++) {
+        uint32_t input = littleEndian32(inputBytes + 4 * i);
+        uint32_t angle = littleEndian32(angleBytes + 4 * i);
+        std::memcpy(&capture.input[i], &input, sizeof(float));
+        std::memcpy(&capture.angle[i], &angle, sizeof(float));
+        capture.timeUs[i] = littleEndian32(timeBytes + 4 * i);
+    }
+    return true;
+}
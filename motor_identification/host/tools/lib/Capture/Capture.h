@@ -0,0 +1,20 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Motor test download, as the firmware sends it between DATA_START and DATA_END (or as
+// read_chunks fetches it again): all inputs, then all angles, then all sample times, one
+// little-endian 32-bit value per sample each.
+typedef struct {
+    std::vector<float> input;
+    std::vector<float> angle;     // rad
+    std::vector<uint32_t> timeUs; // device micros(), not unwrapped
+} Capture;
+
+// False when length is not a whole number of samples
+bool decodeCapture(const uint8_t* data, size_t length, Capture& capture);
+
+#endif // CAPTURE_H
@@ -0,0 +1,81 @@
+#include <CsvTable.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+bool CsvTable::load(const std::string& path)
+{
+    names.clear();
+    columns.clear();
+
+    std::ifstream file(path);
+    std::string line;
+    if (!file || !std::getline(file, line)) {
+        return false;
+    }
+
+    std::stringstream header(line);
+    std::string name;
+    while (std::getline(header, name, ',')) {
+        if (!name.empty() && name.back() == '\r') {
+            name.pop_back();
+        }
+        names.push_back(name);
+    }
+    columns.resize(names.size());
+
+    // Cells are parsed in place, long captures have millions of them
+    std::vector<double> values;
+    while (std::getline(file, line)) {
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+        values.clear();
+        const char* cell = line.c_str();
+        while (true) {
+            char* end;
+            values.push_back(std::strtod(cell, &end));
+            while (*end != '\0' && *end != ',') {
+                end++;
+            }
+            if (*end == '\0') {
+                break;
+            }
+            cell = end + 1;
+        }
+        if (values.size() < names.size()) {
+            continue;
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            columns[i].push_back(values[i]);
+        }
+    }
+    return !names.empty();
+}
+
+bool CsvTable::has(const std::string& name) const
+{
+    for (const std::string& known : names) {
+        if (known == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<double>& CsvTable::column(const std::string& name) const
+{
+    static const std::vector<double> empty;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) {
+            return columns[i];
+        }
+    }
+    return empty;
+}
+
+size_t CsvTable::rows() const
+{
+    return columns.empty() ? 0 : columns[0].size();
+}
@@ -0,0 +1,23 @@
+#ifndef CSV_TABLE_H
+#define CSV_TABLE_H
+
+#include <string>
+#include <vector>
+
+// Numeric CSV with a header row, as written by experiment.py and the tools.
+// Columns are looked up by their header name; rows with too few cells are skipped.
+class CsvTable {
+public:
+    bool load(const std::string& path);
+
+    bool has(const std::string& name) const;
+    // Empty for unknown columns
+    const std::vector<double>& column(const std::string& name) const;
+    size_t rows() const;
+
+private:
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> columns;
+};
+
+#endif // CSV_TABLE_H
@@ -0,0 +1,133 @@
+#include <FaultChannel.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+bool parseFaultSpec(const std::string& spec, FaultConfig& config)
+{
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        std::string item = spec.substr(start, end - start);
+        start = end + 1;
+
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        std::string key = item.substr(0, equals);
+        char* rest = nullptr;
+        double value = std::strtod(item.c_str() + equals + 1, &rest);
+        if (*rest != '\0' || value < 0.0) {
+            return false;
+        }
+
+        if (key == "drop") {
+            config.dropRate = value;
+        } else if (key == "dup") {
+            config.duplicateRate = value;
+        } else if (key == "flip") {
+            config.bitFlipRate = value;
+        } else if (key == "reorder") {
+            config.reorderRate = value;
+        } else if (key == "delay") {
+            config.delayUs = value;
+        } else if (key == "jitter") {
+            config.jitterUs = value;
+        } else if (key == "span") {
+            config.reorderUs = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string describeFaults(const FaultConfig& config)
+{
+    char text[256];
+    std::snprintf(text, sizeof(text), "drop %g, dup %g, flip %g, reorder %g (%g us), delay %g us +/- %g us",
+        config.dropRate, config.duplicateRate, config.bitFlipRate, config.reorderRate, config.reorderUs,
+        config.delayUs, config.jitterUs);
+    return text;
+}
+
+FaultChannel::FaultChannel(const FaultConfig& config, uint32_t seed)
+    : config(config)
+    , random(seed)
+    , uniform(0.0, 1.0)
+    , lastInOrderUs(0)
+    , nextOrder(0)
+{
+}
+
+bool FaultChannel::chance(double rate)
+{
+    return rate > 0.0 && uniform(random) < rate;
+}
+
+void FaultChannel::schedule(uint8_t value, int64_t nowUs)
+{
+    int64_t dueUs = nowUs + static_cast<int64_t>(config.delayUs + config.jitterUs * uniform(random));
+
+    // Jitter alone never reorders, like the latency of a real adapter
+    if (chance(config.reorderRate)) {
+        dueUs = std::max(dueUs, lastInOrderUs) + static_cast<int64_t>(config.reorderUs);
+        counters.reordered++;
+    } else {
+        dueUs = std::max(dueUs, lastInOrderUs);
+        lastInOrderUs = dueUs;
+    }
+
+    pending.push({ dueUs, nextOrder++, value });
+}
+
+void FaultChannel::push(const uint8_t* data, size_t length, int64_t nowUs)
+{
+    for (size_t i = 0; i < length; i++) {
+        counters.bytesIn++;
+        if (chance(config.dropRate)) {
+            counters.dropped++;
+            continue;
+        }
+
+        uint8_t value = data[i];
+        if (chance(config.bitFlipRate)) {
+            value ^= static_cast<uint8_t>(1u << (random() % 8));
+            counters.flipped++;
+        }
+
+        schedule(value, nowUs);
+        if (chance(config.duplicateRate)) {
+            schedule(value, nowUs);
+            counters.duplicated++;
+        }
+    }
+}
+
+size_t FaultChannel::pop(uint8_t* buffer, size_t capacity, int64_t nowUs)
+{
+    size_t count = 0;
+    while (count < capacity && !pending.empty() && pending.top().dueUs <= nowUs) {
+        buffer[count++] = pending.top().value;
+        pending.pop();
+    }
+    counters.bytesOut += count;
+    return count;
+}
+
+int64_t FaultChannel::nextDueUs() const
+{
+    return pending.empty() ? -1 : pending.top().dueUs;
+}
+
+void FaultChannel::clear()
+{
+    while (!pending.empty()) {
+        pending.pop();
+    }
+}
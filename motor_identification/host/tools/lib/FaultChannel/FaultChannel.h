@@ -0,0 +1,82 @@
+#ifndef FAULT_CHANNEL_H
+#define FAULT_CHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+// One direction of a simulated noisy link. Bytes go in with push(), pick up faults on the
+// way and come out of pop() once their delivery time is due. Rates are per byte.
+typedef struct {
+    double dropRate = 0.0;
+    double duplicateRate = 0.0;
+    double bitFlipRate = 0.0;  // One random bit of the byte flipped
+    double reorderRate = 0.0;  // Held back by reorderUs, so the bytes behind it overtake it
+    double delayUs = 0.0;      // Added to every byte
+    double jitterUs = 0.0;     // Uniform extra delay; bytes still arrive in order
+    double reorderUs = 2000.0;
+} FaultConfig;
+
+typedef struct {
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t dropped = 0;
+    uint64_t duplicated = 0;
+    uint64_t flipped = 0;
+    uint64_t reordered = 0;
+} FaultStats;
+
+// Parses "drop=1e-3,flip=1e-4,dup=0,reorder=1e-4,delay=200,jitter=50,span=2000"
+// (times in microseconds). Keys left out keep their current value.
+bool parseFaultSpec(const std::string& spec, FaultConfig& config);
+std::string describeFaults(const FaultConfig& config);
+
+class FaultChannel {
+public:
+    explicit FaultChannel(const FaultConfig& config = FaultConfig(), uint32_t seed = 1);
+
+    void setConfig(const FaultConfig& config) { this->config = config; }
+    const FaultConfig& faults() const { return config; }
+
+    void push(const uint8_t* data, size_t length, int64_t nowUs);
+
+    // Moves the bytes due at nowUs into buffer. Returns how many.
+    size_t pop(uint8_t* buffer, size_t capacity, int64_t nowUs);
+
+    // Delivery time of the next byte, or -1 when nothing is in flight
+    int64_t nextDueUs() const;
+    size_t inFlight() const { return pending.size(); }
+    void clear();
+
+    const FaultStats& stats() const { return counters; }
+
+private:
+    typedef struct {
+        int64_t dueUs;
+        uint64_t order; // Keeps bytes due at the same time in push order
+        uint8_t value;
+    } PendingByte;
+
+    struct Later {
+        bool operator()(const PendingByte& a, const PendingByte& b) const
+        {
+            return a.dueUs != b.dueUs ? a.dueUs > b.dueUs : a.order > b.order;
+        }
+    };
+
+    bool chance(double rate);
+    void schedule(uint8_t value, int64_t nowUs);
+
+    FaultConfig config;
+    FaultStats counters;
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform;
+    std::priority_queue<PendingByte, std::vector<PendingByte>, Later> pending;
+    int64_t lastInOrderUs;
+    uint64_t nextOrder;
+};
+
+#endif // FAULT_CHANNEL_H
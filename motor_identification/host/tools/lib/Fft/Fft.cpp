@@ -0,0 +1,62 @@
+#include <Fft.h>
+
+#include <cmath>
+#include <utility>
+
+Fft::Fft(size_t size)
+    : length(size)
+    , reversed(size)
+    , twiddles(size / 2)
+{
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < size) {
+        bits++;
+    }
+    for (size_t i = 0; i < size; i++) {
+        size_t r = 0;
+        for (size_t bit = 0; bit < bits; bit++) {
+            r |= ((i >> bit) & 1) << (bits - 1 - bit);
+        }
+        reversed[i] = r;
+    }
+    for (size_t k = 0; k < size / 2; k++) {
+        double angle = -2.0 * M_PI * k / size;
+        twiddles[k] = std::complex<double>(std::cos(angle), std::sin(angle));
+    }
+}
+
+void Fft::transform(std::complex<double>* data) const
+{
+    for (size_t i = 0; i < length; i++) {
+        if (i < reversed[i]) {
+            std::swap(data[i], data[reversed[i]]);
+        }
+    }
+    for (size_t span = 2; span <= length; span *= 2) {
+        size_t half = span / 2, stride = length / span;
+        for (size_t start = 0; start < length; start += span) {
+            for (size_t k = 0; k < half; k++) {
+                std::complex<double> odd = twiddles[k * stride] * data[start + k + half];
+                data[start + k + half] = data[start + k] - odd;
+                data[start + k] += odd;
+            }
+        }
+    }
+}
+
+void Fft::transformPair(const double* a, const double* b, std::complex<double>* spectrumA, std::complex<double>* spectrumB,
+    std::vector<std::complex<double>>& scratch) const
+{
+    // z = a + i b; A(k) = (Z(k) + conj Z(N - k)) / 2, B(k) = (Z(k) - conj Z(N - k)) / 2i
+    scratch.resize(length);
+    for (size_t n = 0; n < length; n++) {
+        scratch[n] = std::complex<double>(a[n], b[n]);
+    }
+    transform(scratch.data());
+
+    for (size_t k = 0; k <= length / 2; k++) {
+        std::complex<double> z = scratch[k], mirror = std::conj(scratch[(length - k) % length]);
+        spectrumA[k] = 0.5 * (z + mirror);
+        spectrumB[k] = std::complex<double>(0.0, -0.5) * (z - mirror);
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Radix-2 FFT plan: bit reversal and twiddles are computed once, after that transform()
+// only reads the plan, so one plan can serve any number of threads.
+class Fft {
+public:
+    // size must be a power of two
+    explicit Fft(size_t size);
+
+    size_t size() const { return length; }
+
+    // In place, X(k) = sum x(n) exp(-2 pi i k n / N), no scaling
+    void transform(std::complex<double>* data) const;
+
+    // Spectra of two real signals of size() samples through one complex transform.
+    // Bins 0 to size() / 2 of each are written to spectrumA and spectrumB.
+    void transformPair(const double* a, const double* b, std::complex<double>* spectrumA, std::complex<double>* spectrumB,
+        std::vector<std::complex<double>>& scratch) const;
+
+    static bool isPowerOfTwo(size_t value) { return value >= 2 && (value & (value - 1)) == 0; }
+
+private:
+    size_t length;
+    std::vector<size_t> reversed;
+    std::vector<std::complex<double>> twiddles;
+};
+
+#endif // FFT_H
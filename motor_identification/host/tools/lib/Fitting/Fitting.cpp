@@ -0,0 +1,194 @@
+#include <Fitting.h>
+
+#include <cmath>
+#include <utility>
+
+bool solveLinear(std::vector<double>& a, std::vector<double>& b, size_t n)
+{
+    for (size_t col = 0; col < n; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; row++) {
+            if (std::fabs(a[row * n + col]) > std::fabs(a[pivot * n + col])) {
+                pivot = row;
+            }
+        }
+        if (std::fabs(a[pivot * n + col]) < 1e-300) {
+            return false;
+        }
+        for (size_t k = 0; k < n; k++) {
+            std::swap(a[col * n + k], a[pivot * n + k]);
+        }
+        std::swap(b[col], b[pivot]);
+
+        for (size_t row = col + 1; row < n; row++) {
+            double factor = a[row * n + col] / a[col * n + col];
+            for (size_t k = col; k < n; k++) {
+                a[row * n + k] -= factor * a[col * n + k];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+    for (size_t col = n; col-- > 0;) {
+        for (size_t k = col + 1; k < n; k++) {
+            b[col] -= a[col * n + k] * b[k];
+        }
+        b[col] /= a[col * n + col];
+    }
+    return true;
+}
+
+LeastSquares::LeastSquares(size_t unknowns)
+    : size(unknowns)
+    , normal(unknowns * unknowns, 0.0)
+    , rhs(unknowns, 0.0)
+{
+}
+
+void LeastSquares::add(const double* row, double target)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (row[i] == 0.0) {
+            continue;
+        }
+        for (size_t j = 0; j < size; j++) {
+            normal[i * size + j] += row[i] * row[j];
+        }
+        rhs[i] += row[i] * target;
+    }
+}
+
+void LeastSquares::merge(const LeastSquares& other)
+{
+    for (size_t i = 0; i < normal.size(); i++) {
+        normal[i] += other.normal[i];
+    }
+    for (size_t i = 0; i < size; i++) {
+        rhs[i] += other.rhs[i];
+    }
+}
+
+bool LeastSquares::solve(std::vector<double>& solution) const
+{
+    std::vector<double> a = normal;
+    solution = rhs;
+    return solveLinear(a, solution, size);
+}
+
+// Coefficients of the fit over t = -half..half, evaluated at t = position
+static std::vector<double> savgolCoefficientsAt(unsigned int window, unsigned int order, unsigned int derivative, double dt, int position)
+{
+    int half = window / 2;
+    size_t terms = order + 1;
+
+    // Normal matrix of the polynomial fit over t = -half..half
+    std::vector<double> normal(terms * terms, 0.0);
+    for (int t = -half; t <= half; t++) {
+        for (size_t i = 0; i < terms; i++) {
+            for (size_t j = 0; j < terms; j++) {
+                normal[i * terms + j] += std::pow(t, i + j);
+            }
+        }
+    }
+
+    // d^derivative/dt^derivative of every term at position, through the inverse normal matrix
+    std::vector<double> weights(terms, 0.0);
+    for (size_t i = derivative; i < terms; i++) {
+        double factor = 1.0;
+        for (size_t k = i - derivative + 1; k <= i; k++) {
+            factor *= k;
+        }
+        weights[i] = factor * std::pow(position, i - derivative);
+    }
+    solveLinear(normal, weights, terms);
+
+    std::vector<double> coefficients(window);
+    for (int t = -half; t <= half; t++) {
+        double value = 0.0;
+        for (size_t i = 0; i < terms; i++) {
+            value += weights[i] * std::pow(t, i);
+        }
+        coefficients[t + half] = value / std::pow(dt, derivative);
+    }
+    return coefficients;
+}
+
+std::vector<double> savgolCoefficients(unsigned int window, unsigned int order, unsigned int derivative, double dt)
+{
+    return savgolCoefficientsAt(window, order, derivative, dt, 0);
+}
+
+std::vector<double> savgolFilter(const std::vector<double>& x, unsigned int window, unsigned int order, unsigned int derivative, double dt)
+{
+    std::vector<double> coefficients = savgolCoefficients(window, order, derivative, dt);
+    std::vector<double> y(x.size(), 0.0);
+    size_t half = window / 2;
+    for (size_t k = half; k + half < x.size(); k++) {
+        double value = 0.0;
+        for (size_t j = 0; j < window; j++) {
+            value += coefficients[j] * x[k + j - half];
+        }
+        y[k] = value;
+    }
+    return y;
+}
+
+std::vector<double> savgolFilterInterp(const double* x, size_t length, unsigned int window, unsigned int order, unsigned int derivative, double dt)
+{
+    std::vector<double> y(length, 0.0);
+    if (length < window) {
+        return y;
+    }
+    std::vector<double> coefficients = savgolCoefficients(window, order, derivative, dt);
+    size_t half = window / 2;
+    for (size_t k = half; k + half < length; k++) {
+        double value = 0.0;
+        for (size_t j = 0; j < window; j++) {
+            value += coefficients[j] * x[k + j - half];
+        }
+        y[k] = value;
+    }
+
+    // The edges from the first and the last window, evaluated off centre
+    for (size_t k = 0; k < half; k++) {
+        int offset = static_cast<int>(half - k);
+        std::vector<double> head = savgolCoefficientsAt(window, order, derivative, dt, -offset);
+        std::vector<double> tail = savgolCoefficientsAt(window, order, derivative, dt, offset);
+        y[k] = 0.0;
+        y[length - 1 - k] = 0.0;
+        for (size_t j = 0; j < window; j++) {
+            y[k] += head[j] * x[j];
+            y[length - 1 - k] += tail[j] * x[length - window + j];
+        }
+    }
+    return y;
+}
+
+LineFit fitLine(const double* x, const double* y, size_t length)
+{
+    LineFit fit;
+    if (length < 2) {
+        return fit;
+    }
+    double meanX = 0.0, meanY = 0.0;
+    for (size_t k = 0; k < length; k++) {
+        meanX += x[k];
+        meanY += y[k];
+    }
+    meanX /= length;
+    meanY /= length;
+
+    double sxx = 0.0, syy = 0.0, sxy = 0.0;
+    for (size_t k = 0; k < length; k++) {
+        double dx = x[k] - meanX, dy = y[k] - meanY;
+        sxx += dx * dx;
+        syy += dy * dy;
+        sxy += dx * dy;
+    }
+    if (sxx > 0.0) {
+        fit.slope = sxy / sxx;
+        fit.intercept = meanY - fit.slope * meanX;
+        fit.r = syy > 0.0 ? sxy / std::sqrt(sxx * syy) : 0.0;
+        fit.valid = true;
+    }
+    return fit;
+}
@@ -0,0 +1,54 @@
+#ifndef FITTING_H
+#define FITTING_H
+
+#include <cstddef>
+#include <vector>
+
+// Solves the n x n system a x = b (row-major) in place, leaving x in b.
+// Gaussian elimination with partial pivoting; false if a is singular.
+bool solveLinear(std::vector<double>& a, std::vector<double>& b, size_t n);
+
+// Linear least squares accumulated one row at a time through the normal equations,
+// so the regressor matrix is never stored. Fine for the few, well-scaled unknowns here.
+class LeastSquares {
+public:
+    explicit LeastSquares(size_t unknowns);
+
+    void add(const double* row, double target);
+    // Adds the rows another fit has seen, for fits split across threads
+    void merge(const LeastSquares& other);
+    bool solve(std::vector<double>& solution) const;
+
+    size_t unknowns() const { return size; }
+
+private:
+    size_t size;
+    std::vector<double> normal;
+    std::vector<double> rhs;
+};
+
+// Savitzky-Golay filter coefficients for the given derivative, like scipy's savgol_coeffs:
+// applied to window samples centred on k, they give the derivative at k (units per dt^derivative)
+std::vector<double> savgolCoefficients(unsigned int window, unsigned int order, unsigned int derivative, double dt);
+
+// The filter above applied along x, the way estimate.py differentiates the angle.
+// The first and last window / 2 values have no full window and are left at 0.
+std::vector<double> savgolFilter(const std::vector<double>& x, unsigned int window, unsigned int order, unsigned int derivative, double dt);
+
+// savgolFilter with the edges too, the way scipy's savgol_filter(mode='interp') and so
+// estimate.py do it: the first and last window / 2 values come from the polynomial fitted to
+// the first and last window samples. All 0 when x is shorter than the window.
+std::vector<double> savgolFilterInterp(const double* x, size_t length, unsigned int window, unsigned int order, unsigned int derivative, double dt);
+
+// Straight line y = slope * x + intercept by least squares, with the correlation r of
+// scipy.stats.linregress. Not valid when x is constant.
+typedef struct {
+    double slope = 0.0;
+    double intercept = 0.0;
+    double r = 0.0;
+    bool valid = false;
+} LineFit;
+
+LineFit fitLine(const double* x, const double* y, size_t length);
+
+#endif // FITTING_H
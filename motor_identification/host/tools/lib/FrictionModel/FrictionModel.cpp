@@ -0,0 +1,128 @@
+#include <FrictionModel.h>
+#include <Fitting.h>
+
+#include <algorithm>
+#include <cmath>
+
+static const unsigned int stribeckGridPoints = 48;
+static const unsigned int goldenIterations = 40;
+// Closer than this share of a grid step to an end of the search range counts as on it
+static const double boundTolerance = 0.01;
+
+static double stribeckShape(double speed, double stribeck, double shape)
+{
+    return std::exp(-std::pow(std::fabs(speed / stribeck), shape));
+}
+
+static double sign(double value)
+{
+    return (value > 0.0) - (value < 0.0);
+}
+
+double frictionTorque(const FrictionModel& model, double speed, double shape)
+{
+    double level = model.coulomb;
+    if (model.stribeck > 0.0) {
+        level += (model.stiction - model.coulomb) * stribeckShape(speed, model.stribeck, shape);
+    }
+    return sign(speed) * level + model.viscous * speed;
+}
+
+FrictionModel fitFrictionLinear(const FrictionData& data, double stribeck, double shape)
+{
+    const size_t n = stribeck > 0.0 ? 5 : 4;
+    LeastSquares fit(n);
+    double row[5];
+
+    for (size_t k = 0; k < data.speed.size(); k++) {
+        double w = data.speed[k];
+        row[0] = data.input[k];
+        row[1] = 1.0;
+        row[2] = -sign(w);
+        row[3] = -w;
+        if (n == 5) {
+            row[4] = -sign(w) * stribeckShape(w, stribeck, shape);
+        }
+        fit.add(row, data.torque[k]);
+    }
+
+    FrictionModel model;
+    std::vector<double> rhs;
+    if (!fit.solve(rhs)) {
+        return model;
+    }
+    model.gain = rhs[0];
+    model.offset = rhs[1];
+    model.coulomb = rhs[2];
+    model.viscous = rhs[3];
+    model.stribeck = stribeck;
+    model.stiction = model.coulomb + (n == 5 ? rhs[4] : 0.0);
+
+    for (size_t k = 0; k < data.speed.size(); k++) {
+        double predicted = model.gain * data.input[k] + model.offset - frictionTorque(model, data.speed[k], shape);
+        model.rss += (data.torque[k] - predicted) * (data.torque[k] - predicted);
+    }
+    model.valid = true;
+    return model;
+}
+
+// A Stribeck fit only counts when friction drops from standstill, as the model demands
+static bool physical(const FrictionModel& model)
+{
+    return model.valid && model.stiction >= model.coulomb;
+}
+
+FrictionModel fitFrictionStribeck(const FrictionData& data, double minSpeed, double maxSpeed, double shape)
+{
+    // Log grid from below the slowest to the fastest speed that was seen
+    std::vector<double> logGrid(stribeckGridPoints);
+    double low = std::log(0.5 * minSpeed), high = std::log(maxSpeed);
+    FrictionModel best;
+    size_t bestIndex = 0;
+    for (size_t i = 0; i < stribeckGridPoints; i++) {
+        logGrid[i] = low + (high - low) * i / (stribeckGridPoints - 1);
+        FrictionModel model = fitFrictionLinear(data, std::exp(logGrid[i]), shape);
+        if (physical(model) && (!best.valid || model.rss < best.rss)) {
+            best = model;
+            bestIndex = i;
+        }
+    }
+    if (!best.valid) {
+        return best;
+    }
+
+    // Golden section between the grid neighbours of the best point
+    const double ratio = 0.5 * (std::sqrt(5.0) - 1.0);
+    double a = logGrid[bestIndex > 0 ? bestIndex - 1 : 0];
+    double b = logGrid[std::min<size_t>(bestIndex + 1, stribeckGridPoints - 1)];
+    double c = b - ratio * (b - a), d = a + ratio * (b - a);
+    FrictionModel fc = fitFrictionLinear(data, std::exp(c), shape), fd = fitFrictionLinear(data, std::exp(d), shape);
+    for (unsigned int i = 0; i < goldenIterations; i++) {
+        if (fc.rss < fd.rss) {
+            b = d;
+            d = c;
+            fd = fc;
+            c = b - ratio * (b - a);
+            fc = fitFrictionLinear(data, std::exp(c), shape);
+        } else {
+            a = c;
+            c = d;
+            fc = fd;
+            d = a + ratio * (b - a);
+            fd = fitFrictionLinear(data, std::exp(d), shape);
+        }
+    }
+    FrictionModel refined = fc.rss < fd.rss ? fc : fd;
+    return physical(refined) && refined.rss < best.rss ? refined : best;
+}
+
+bool stribeckOnBound(const FrictionModel& model, double minSpeed, double maxSpeed)
+{
+    if (!(model.stribeck > 0.0)) {
+        return true;
+    }
+    double low = std::log(0.5 * minSpeed), high = std::log(maxSpeed);
+    double tolerance = boundTolerance * (high - low) / (stribeckGridPoints - 1);
+    double value = std::log(model.stribeck);
+    return value - low < tolerance || high - value < tolerance;
+}
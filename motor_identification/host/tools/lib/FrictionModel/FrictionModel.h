@@ -0,0 +1,46 @@
+#ifndef FRICTION_MODEL_H
+#define FRICTION_MODEL_H
+
+#include <cstddef>
+#include <vector>
+
+// Coulomb + viscous + Stribeck friction of the wheel, with speeds w and accelerations a
+// from Savitzky-Golay derivatives of the angle:
+//   J * a = K * u + c - F(w)
+//   F(w)  = sign(w) * (Fc + (Fs - Fc) * exp(-|w / vs|^shape)) + b * w
+// For a given Stribeck velocity vs the model is linear in K, c, Fc, Fs - Fc and b, so vs is
+// searched on a log grid and refined by golden section.
+
+// Samples that take part in the fit
+typedef struct {
+    std::vector<double> input;
+    std::vector<double> speed;
+    std::vector<double> torque; // J * acceleration
+} FrictionData;
+
+typedef struct {
+    double gain = 0.0;       // K, N*m per unit of input
+    double offset = 0.0;     // c, N*m
+    double coulomb = 0.0;    // Fc, N*m
+    double stiction = 0.0;   // Fs, N*m
+    double stribeck = 0.0;   // vs, rad/s; 0 without a Stribeck term
+    double viscous = 0.0;    // b, N*m*s/rad
+    double rss = 0.0;
+    bool valid = false;
+} FrictionModel;
+
+// F(w), the friction torque at the given speed
+double frictionTorque(const FrictionModel& model, double speed, double shape);
+
+// Linear least squares for a fixed Stribeck velocity (0: no Stribeck term)
+FrictionModel fitFrictionLinear(const FrictionData& data, double stribeck, double shape);
+
+// Best physical fit (Fs >= Fc) with vs between half the slowest and the fastest speed.
+// Not valid when no grid point gives one.
+FrictionModel fitFrictionStribeck(const FrictionData& data, double minSpeed, double maxSpeed, double shape);
+
+// True when the data do not pin vs down: no Stribeck term, or vs at an end of the range
+// fitFrictionStribeck searched for the same minSpeed and maxSpeed
+bool stribeckOnBound(const FrictionModel& model, double minSpeed, double maxSpeed);
+
+#endif // FRICTION_MODEL_H
@@ -0,0 +1,228 @@
+#include <Linalg.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+Matrix::Matrix()
+    : rowCount(0)
+    , colCount(0)
+{
+}
+
+Matrix::Matrix(size_t rows, size_t cols, double value)
+    : rowCount(rows)
+    , colCount(cols)
+    , values(rows * cols, value)
+{
+}
+
+Matrix Matrix::block(size_t row, size_t col, size_t rows, size_t cols) const
+{
+    Matrix result(rows, cols);
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cols; j++) {
+            result(i, j) = (*this)(row + i, col + j);
+        }
+    }
+    return result;
+}
+
+Matrix Matrix::transpose() const
+{
+    Matrix result(colCount, rowCount);
+    for (size_t i = 0; i < rowCount; i++) {
+        for (size_t j = 0; j < colCount; j++) {
+            result(j, i) = (*this)(i, j);
+        }
+    }
+    return result;
+}
+
+Matrix Matrix::operator*(const Matrix& other) const
+{
+    Matrix result;
+    multiply(*this, other, result);
+    return result;
+}
+
+void multiply(const Matrix& a, const Matrix& b, Matrix& result)
+{
+    if (result.rows() != a.rows() || result.cols() != b.cols()) {
+        result = Matrix(a.rows(), b.cols());
+    }
+    for (size_t i = 0; i < a.rows(); i++) {
+        double* target = result.row(i);
+        std::fill(target, target + b.cols(), 0.0);
+        for (size_t k = 0; k < a.cols(); k++) {
+            double factor = a(i, k);
+            if (factor == 0.0) {
+                continue;
+            }
+            const double* source = b.row(k);
+            for (size_t j = 0; j < b.cols(); j++) {
+                target[j] += factor * source[j];
+            }
+        }
+    }
+}
+
+void householderTriangularize(Matrix& a)
+{
+    const size_t rows = a.rows(), cols = a.cols();
+    std::vector<double> v(rows), dots(cols);
+
+    for (size_t k = 0; k < std::min(rows, cols); k++) {
+        double norm = 0.0;
+        for (size_t i = k; i < rows; i++) {
+            v[i] = a(i, k);
+            norm += v[i] * v[i];
+        }
+        norm = std::sqrt(norm);
+        if (norm == 0.0) {
+            continue;
+        }
+
+        // v = x - alpha e0 with alpha = -sign(x0) |x|, applied as I - 2 v v^T / (v^T v)
+        double alpha = v[k] > 0.0 ? -norm : norm;
+        v[k] -= alpha;
+        double vv = norm * norm - a(k, k) * a(k, k) + v[k] * v[k];
+        if (vv == 0.0) {
+            continue;
+        }
+
+        // Row by row, so the inner loops run along contiguous memory
+        std::fill(dots.begin() + k + 1, dots.end(), 0.0);
+        for (size_t i = k; i < rows; i++) {
+            const double* source = a.row(i);
+            for (size_t j = k + 1; j < cols; j++) {
+                dots[j] += v[i] * source[j];
+            }
+        }
+        for (size_t j = k + 1; j < cols; j++) {
+            dots[j] *= 2.0 / vv;
+        }
+        for (size_t i = k; i < rows; i++) {
+            double* target = a.row(i);
+            for (size_t j = k + 1; j < cols; j++) {
+                target[j] -= dots[j] * v[i];
+            }
+        }
+
+        a(k, k) = alpha;
+        for (size_t i = k + 1; i < rows; i++) {
+            a(i, k) = 0.0;
+        }
+    }
+}
+
+void qrUpdate(Matrix& r, const double* rows, size_t count)
+{
+    const size_t cols = r.cols();
+    Matrix stacked(cols + count, cols);
+    for (size_t i = 0; i < cols; i++) {
+        std::copy(r.row(i), r.row(i) + cols, stacked.row(i));
+    }
+    std::copy(rows, rows + count * cols, stacked.row(cols));
+
+    householderTriangularize(stacked);
+    for (size_t i = 0; i < cols; i++) {
+        std::copy(stacked.row(i), stacked.row(i) + cols, r.row(i));
+    }
+}
+
+void svd(const Matrix& a, Matrix& u, std::vector<double>& s, Matrix& v)
+{
+    // Wide matrices go through their transpose, the rotations want at least as many rows
+    if (a.rows() < a.cols()) {
+        svd(a.transpose(), v, s, u);
+        return;
+    }
+
+    const size_t rows = a.rows(), cols = a.cols();
+    Matrix w = a;
+    Matrix rotations(cols, cols);
+    for (size_t i = 0; i < cols; i++) {
+        rotations(i, i) = 1.0;
+    }
+
+    // Rotate column pairs until all of them are orthogonal
+    for (int sweep = 0; sweep < 60; sweep++) {
+        double offDiagonal = 0.0;
+        for (size_t p = 0; p + 1 < cols; p++) {
+            for (size_t q = p + 1; q < cols; q++) {
+                double alpha = 0.0, beta = 0.0, gamma = 0.0;
+                for (size_t i = 0; i < rows; i++) {
+                    alpha += w(i, p) * w(i, p);
+                    beta += w(i, q) * w(i, q);
+                    gamma += w(i, p) * w(i, q);
+                }
+                if (gamma == 0.0 || std::fabs(gamma) <= 1e-15 * std::sqrt(alpha * beta)) {
+                    continue;
+                }
+                offDiagonal = std::max(offDiagonal, std::fabs(gamma) / std::sqrt(alpha * beta));
+
+                double zeta = (beta - alpha) / (2.0 * gamma);
+                double t = (zeta >= 0.0 ? 1.0 : -1.0) / (std::fabs(zeta) + std::sqrt(1.0 + zeta * zeta));
+                double c = 1.0 / std::sqrt(1.0 + t * t), sn = c * t;
+                for (size_t i = 0; i < rows; i++) {
+                    double wp = w(i, p), wq = w(i, q);
+                    w(i, p) = c * wp - sn * wq;
+                    w(i, q) = sn * wp + c * wq;
+                }
+                for (size_t i = 0; i < cols; i++) {
+                    double vp = rotations(i, p), vq = rotations(i, q);
+                    rotations(i, p) = c * vp - sn * vq;
+                    rotations(i, q) = sn * vp + c * vq;
+                }
+            }
+        }
+        if (offDiagonal < 1e-15) {
+            break;
+        }
+    }
+
+    std::vector<double> norms(cols);
+    for (size_t j = 0; j < cols; j++) {
+        double norm = 0.0;
+        for (size_t i = 0; i < rows; i++) {
+            norm += w(i, j) * w(i, j);
+        }
+        norms[j] = std::sqrt(norm);
+    }
+    std::vector<size_t> order(cols);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&norms](size_t x, size_t y) { return norms[x] > norms[y]; });
+
+    u = Matrix(rows, cols);
+    v = Matrix(cols, cols);
+    s.assign(cols, 0.0);
+    for (size_t k = 0; k < cols; k++) {
+        size_t j = order[k];
+        s[k] = norms[j];
+        for (size_t i = 0; i < rows; i++) {
+            u(i, k) = norms[j] > 0.0 ? w(i, j) / norms[j] : 0.0;
+        }
+        for (size_t i = 0; i < cols; i++) {
+            v(i, k) = rotations(i, j);
+        }
+    }
+}
+
+Matrix solveLeastSquares(const Matrix& a, const Matrix& b, double tolerance)
+{
+    Matrix u, v;
+    std::vector<double> s;
+    svd(a, u, s, v);
+
+    // x = V diag(1/s) U^T b over the kept singular values
+    Matrix utb = u.transpose() * b;
+    double limit = s.empty() ? 0.0 : tolerance * s[0];
+    for (size_t k = 0; k < s.size(); k++) {
+        double scale = s[k] > limit ? 1.0 / s[k] : 0.0;
+        for (size_t j = 0; j < utb.cols(); j++) {
+            utb(k, j) *= scale;
+        }
+    }
+    return v * utb;
+}
@@ -0,0 +1,50 @@
+#ifndef LINALG_H
+#define LINALG_H
+
+#include <cstddef>
+#include <vector>
+
+// Dense row-major matrix, enough for the identification tools. The heavy lifting
+// (tall Hankel data) never lives in one of these; only factors and models do.
+class Matrix {
+public:
+    Matrix();
+    Matrix(size_t rows, size_t cols, double value = 0.0);
+
+    size_t rows() const { return rowCount; }
+    size_t cols() const { return colCount; }
+
+    double& operator()(size_t row, size_t col) { return values[row * colCount + col]; }
+    double operator()(size_t row, size_t col) const { return values[row * colCount + col]; }
+    double* row(size_t index) { return &values[index * colCount]; }
+    const double* row(size_t index) const { return &values[index * colCount]; }
+
+    Matrix block(size_t row, size_t col, size_t rows, size_t cols) const;
+    Matrix transpose() const;
+    Matrix operator*(const Matrix& other) const;
+
+private:
+    size_t rowCount;
+    size_t colCount;
+    std::vector<double> values;
+};
+
+// result = a * b, reusing result's storage when it already has the right shape.
+// For the inner loops of simulations, where operator* would allocate every step.
+void multiply(const Matrix& a, const Matrix& b, Matrix& result);
+
+// Householder QR in place: leaves R in the upper triangle and zeros below it
+void householderTriangularize(Matrix& a);
+
+// R factor of [r; rows], with count rows of r.cols() values each. Feeding a tall matrix
+// through this a block at a time gives its R without ever storing it.
+void qrUpdate(Matrix& r, const double* rows, size_t count);
+
+// Thin SVD a = u * diag(s) * v^T by one-sided Jacobi rotations, s in descending order
+void svd(const Matrix& a, Matrix& u, std::vector<double>& s, Matrix& v);
+
+// Minimum-norm least squares solution of a * x = b through the SVD; singular values below
+// tolerance times the largest are dropped
+Matrix solveLeastSquares(const Matrix& a, const Matrix& b, double tolerance = 1e-12);
+
+#endif // LINALG_H
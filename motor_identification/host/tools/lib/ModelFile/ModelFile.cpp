@@ -0,0 +1,237 @@
+#include <ModelFile.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+void skipSpace(const std::string& s, size_t& pos)
+{
+    while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' || s[pos] == '\r')) {
+        pos++;
+    }
+}
+
+bool parseString(const std::string& s, size_t& pos, std::string& out)
+{
+    if (pos >= s.size() || s[pos] != '"') {
+        return false;
+    }
+    pos++;
+    out.clear();
+    while (pos < s.size() && s[pos] != '"') {
+        if (s[pos] == '\\' && pos + 1 < s.size()) {
+            pos++;
+            switch (s[pos]) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            default: out += s[pos]; break;
+            }
+        } else {
+            out += s[pos];
+        }
+        pos++;
+    }
+    if (pos >= s.size()) {
+        return false;
+    }
+    pos++;
+    return true;
+}
+
+std::string escape(const std::string& text)
+{
+    std::string out;
+    for (char c : text) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default: out += c; break;
+        }
+    }
+    return out;
+}
+
+// Shortest form that reads back as the same double, as Python's json writes it, so values
+// a tool did not touch keep their text (0.09 stays 0.09 instead of 0.089999999999999997)
+std::string formatNumber(double value)
+{
+    char text[32];
+    for (int precision = 15; precision < 17; precision++) {
+        std::snprintf(text, sizeof(text), "%.*g", precision, value);
+        if (std::strtod(text, nullptr) == value) {
+            return text;
+        }
+    }
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    return text;
+}
+
+} // namespace
+
+bool ModelFile::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string s = buffer.str();
+
+    entries.clear();
+    size_t pos = 0;
+
+    skipSpace(s, pos);
+    if (pos >= s.size() || s[pos] != '{') {
+        return false;
+    }
+    pos++;
+    skipSpace(s, pos);
+    if (pos < s.size() && s[pos] == '}') {
+        return true;
+    }
+
+    while (pos < s.size()) {
+        Entry entry;
+        skipSpace(s, pos);
+        if (!parseString(s, pos, entry.key)) {
+            return false;
+        }
+        skipSpace(s, pos);
+        if (pos >= s.size() || s[pos] != ':') {
+            return false;
+        }
+        pos++;
+        skipSpace(s, pos);
+
+        if (pos < s.size() && s[pos] == '"') {
+            entry.isNumber = false;
+            entry.number = 0.0;
+            if (!parseString(s, pos, entry.text)) {
+                return false;
+            }
+        } else {
+            const char* start = s.c_str() + pos;
+            char* end = nullptr;
+            entry.isNumber = true;
+            entry.number = std::strtod(start, &end);
+            if (end == start) {
+                return false; // Nested objects, arrays and literals are not part of the format
+            }
+            pos += end - start;
+        }
+        entries.push_back(entry);
+
+        skipSpace(s, pos);
+        if (pos < s.size() && s[pos] == ',') {
+            pos++;
+        } else if (pos < s.size() && s[pos] == '}') {
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool ModelFile::save(const std::string& path) const
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    // Same layout as json.dump(indent=4)
+    std::fprintf(file, "{\n");
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        if (entry.isNumber) {
+            std::fprintf(file, "    \"%s\": %s", escape(entry.key).c_str(), formatNumber(entry.number).c_str());
+        } else {
+            std::fprintf(file, "    \"%s\": \"%s\"", escape(entry.key).c_str(), escape(entry.text).c_str());
+        }
+        std::fprintf(file, i + 1 < entries.size() ? ",\n" : "\n");
+    }
+    std::fprintf(file, "}");
+
+    return std::fclose(file) == 0;
+}
+
+bool ModelFile::has(const std::string& key) const
+{
+    return find(key) != nullptr;
+}
+
+double ModelFile::number(const std::string& key, double fallback) const
+{
+    const Entry* entry = find(key);
+    return (entry != nullptr && entry->isNumber) ? entry->number : fallback;
+}
+
+std::string ModelFile::text(const std::string& key, const std::string& fallback) const
+{
+    const Entry* entry = find(key);
+    return (entry != nullptr && !entry->isNumber) ? entry->text : fallback;
+}
+
+void ModelFile::setNumber(const std::string& key, double value)
+{
+    Entry* entry = find(key);
+    if (entry == nullptr) {
+        entries.push_back(Entry());
+        entry = &entries.back();
+        entry->key = key;
+    }
+    entry->isNumber = true;
+    entry->number = value;
+    entry->text.clear();
+}
+
+void ModelFile::setText(const std::string& key, const std::string& value)
+{
+    Entry* entry = find(key);
+    if (entry == nullptr) {
+        entries.push_back(Entry());
+        entry = &entries.back();
+        entry->key = key;
+    }
+    entry->isNumber = false;
+    entry->number = 0.0;
+    entry->text = value;
+}
+
+void ModelFile::remove(const std::string& key)
+{
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].key == key) {
+            entries.erase(entries.begin() + i);
+            return;
+        }
+    }
+}
+
+ModelFile::Entry* ModelFile::find(const std::string& key)
+{
+    for (Entry& entry : entries) {
+        if (entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const ModelFile::Entry* ModelFile::find(const std::string& key) const
+{
+    for (const Entry& entry : entries) {
+        if (entry.key == key) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,36 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include <string>
+#include <vector>
+
+// Flat JSON object of numbers and strings, as written by estimate.py.
+// Key order is preserved, so rewriting a file only shows the changed entries in a diff.
+class ModelFile {
+public:
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    bool has(const std::string& key) const;
+    double number(const std::string& key, double fallback = 0.0) const;
+    std::string text(const std::string& key, const std::string& fallback = "") const;
+
+    void setNumber(const std::string& key, double value);
+    void setText(const std::string& key, const std::string& value);
+    void remove(const std::string& key);
+
+private:
+    typedef struct {
+        std::string key;
+        bool isNumber;
+        double number;
+        std::string text;
+    } Entry;
+
+    Entry* find(const std::string& key);
+    const Entry* find(const std::string& key) const;
+
+    std::vector<Entry> entries;
+};
+
+#endif // MODEL_FILE_H
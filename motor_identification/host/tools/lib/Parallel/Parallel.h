@@ -0,0 +1,49 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Threads to use when the user leaves it at 0: one per core
+inline unsigned int threadCount(unsigned int requested)
+{
+    return requested > 0 ? requested : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs work(thread, begin, end) over [0, count) split evenly across the threads
+template <typename Work>
+void parallelFor(unsigned int threads, size_t count, Work work)
+{
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; t++) {
+        size_t begin = count * t / threads, end = count * (t + 1) / threads;
+        pool.emplace_back([&work, t, begin, end]() { work(t, begin, end); });
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+// Runs task(index) for every index in [0, count), each thread taking the next free one.
+// For independent tasks of uneven cost, where an even split would leave threads idle.
+template <typename Task>
+void parallelTasks(unsigned int threads, size_t count, Task task)
+{
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    for (unsigned int t = 0; t < threads; t++) {
+        pool.emplace_back([&task, &next, count]() {
+            for (size_t index = next++; index < count; index = next++) {
+                task(index);
+            }
+        });
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+#endif // PARALLEL_H
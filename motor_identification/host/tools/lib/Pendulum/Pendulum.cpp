@@ -0,0 +1,49 @@
+#include <Pendulum.h>
+
+#include <algorithm>
+#include <cmath>
+
+double pendulumTorque(const PendulumParams& params, double input, double wheelSpeed)
+{
+    input = std::min(std::max(input, -1.0), 1.0);
+    double available = std::max(1.0 - std::fabs(wheelSpeed) / params.noLoadSpeed, 0.0);
+    return params.torqueGain * input * available - params.wheelFriction * wheelSpeed;
+}
+
+void pendulumDerivative(const PendulumParams& params, const double state[PENDULUM_STATES], double input, double derivative[PENDULUM_STATES])
+{
+    double torque = pendulumTorque(params, input, state[PENDULUM_WHEEL_SPEED]);
+    double gravityTorque = params.bodyMass * params.gravity * params.comHeight * std::sin(state[PENDULUM_TILT]);
+
+    // The wheel torque reacts on the body
+    double tiltAccel = (gravityTorque - torque) / params.bodyInertia;
+
+    derivative[PENDULUM_TILT] = state[PENDULUM_TILT_RATE];
+    derivative[PENDULUM_TILT_RATE] = tiltAccel;
+    derivative[PENDULUM_WHEEL_ANGLE] = state[PENDULUM_WHEEL_SPEED];
+    derivative[PENDULUM_WHEEL_SPEED] = torque / params.wheelInertia - tiltAccel;
+}
+
+void pendulumStep(const PendulumParams& params, double state[PENDULUM_STATES], double input, double dt)
+{
+    double k1[PENDULUM_STATES], k2[PENDULUM_STATES], k3[PENDULUM_STATES], k4[PENDULUM_STATES];
+    double temp[PENDULUM_STATES];
+
+    pendulumDerivative(params, state, input, k1);
+    for (unsigned int i = 0; i < PENDULUM_STATES; i++) {
+        temp[i] = state[i] + 0.5 * dt * k1[i];
+    }
+    pendulumDerivative(params, temp, input, k2);
+    for (unsigned int i = 0; i < PENDULUM_STATES; i++) {
+        temp[i] = state[i] + 0.5 * dt * k2[i];
+    }
+    pendulumDerivative(params, temp, input, k3);
+    for (unsigned int i = 0; i < PENDULUM_STATES; i++) {
+        temp[i] = state[i] + dt * k3[i];
+    }
+    pendulumDerivative(params, temp, input, k4);
+
+    for (unsigned int i = 0; i < PENDULUM_STATES; i++) {
+        state[i] += dt / 6.0 * (k1[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef PENDULUM_H
+#define PENDULUM_H
+
+// Reaction wheel pendulum, the nonlinear counterpart of the model linearized in gain_schedule.py.
+// State: tilt (rad), tilt rate (rad/s), wheel angle (rad), wheel speed (rad/s).
+// The wheel angle and speed are relative to the body, as the encoder sees them.
+
+const unsigned int PENDULUM_STATES = 4;
+
+typedef enum {
+    PENDULUM_TILT = 0,
+    PENDULUM_TILT_RATE = 1,
+    PENDULUM_WHEEL_ANGLE = 2,
+    PENDULUM_WHEEL_SPEED = 3,
+} PendulumState;
+
+typedef struct {
+    // Must match the constants in gain_schedule.py
+    double bodyMass = 0.8;         // kg
+    double comHeight = 0.12;       // m, pivot to centre of mass
+    double bodyInertia = 0.015;    // kg*m^2, about the pivot
+    double noLoadSpeed = 400.0;    // rad/s
+    double wheelFriction = 1e-5;   // N*m*s/rad
+    double gravity = 9.81;         // m/s^2
+
+    // From model_parameters.json
+    double torqueGain = 0.108;     // N*m per unit of input ("slope")
+    double wheelInertia = 2.745e-4; // kg*m^2 ("inertia")
+} PendulumParams;
+
+// Motor torque on the wheel for an input in [-1, 1]
+double pendulumTorque(const PendulumParams& params, double input, double wheelSpeed);
+
+void pendulumDerivative(const PendulumParams& params, const double state[PENDULUM_STATES], double input, double derivative[PENDULUM_STATES]);
+
+// One RK4 step with the input held constant
+void pendulumStep(const PendulumParams& params, double state[PENDULUM_STATES], double input, double dt);
+
+#endif // PENDULUM_H
@@ -0,0 +1,199 @@
+#include <SerialPort.h>
+
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/serial.h>
+#endif
+
+namespace {
+
+speed_t toSpeed(unsigned int baudRate)
+{
+    switch (baudRate) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+#ifdef B1500000
+    case 1500000: return B1500000;
+#endif
+#ifdef B2000000
+    case 2000000: return B2000000;
+#endif
+    default: return 0;
+    }
+}
+
+} // namespace
+
+int64_t monotonicMicros()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+SerialPort::SerialPort() : fd(-1)
+{
+}
+
+SerialPort::~SerialPort()
+{
+    close();
+}
+
+bool SerialPort::open(const std::string& path, unsigned int baudRate)
+{
+    close();
+
+    fd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return false;
+    }
+
+    termios tty;
+    if (tcgetattr(fd, &tty) != 0) {
+        close();
+        return false;
+    }
+    cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+        close();
+        return false;
+    }
+
+    if (!setBaudRate(baudRate)) {
+        close();
+        return false;
+    }
+
+#ifdef __linux__
+    // USB-UART bridges otherwise hold received bytes back for up to 16 ms.
+    // Ptys and some drivers do not support the flag, which is fine.
+    serial_struct serial;
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        ioctl(fd, TIOCSSERIAL, &serial);
+    }
+#endif
+
+    discardInput();
+    return true;
+}
+
+void SerialPort::close()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool SerialPort::setBaudRate(unsigned int baudRate)
+{
+    speed_t speed = toSpeed(baudRate);
+    if (speed == 0) {
+        return false;
+    }
+
+    termios tty;
+    if (tcgetattr(fd, &tty) != 0) {
+        return false;
+    }
+    cfsetispeed(&tty, speed);
+    cfsetospeed(&tty, speed);
+    return tcsetattr(fd, TCSADRAIN, &tty) == 0;
+}
+
+long SerialPort::readSome(uint8_t* buffer, size_t capacity, long timeoutUs)
+{
+    pollfd request = { fd, POLLIN, 0 };
+
+    // poll() only has millisecond resolution; sub-millisecond waits spin on it instead
+    int64_t deadline = monotonicMicros() + timeoutUs;
+    while (true) {
+        long remainingUs = static_cast<long>(deadline - monotonicMicros());
+        int timeoutMs = remainingUs >= 1000 ? static_cast<int>(remainingUs / 1000) : 0;
+
+        int ready = poll(&request, 1, timeoutMs);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (ready > 0) {
+            break;
+        }
+        if (remainingUs <= 0) {
+            return 0;
+        }
+    }
+
+    ssize_t count = ::read(fd, buffer, capacity);
+    if (count < 0) {
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    }
+    return count;
+}
+
+size_t SerialPort::readExact(uint8_t* buffer, size_t length, long timeoutUs)
+{
+    int64_t deadline = monotonicMicros() + timeoutUs;
+    size_t received = 0;
+
+    while (received < length) {
+        long remainingUs = static_cast<long>(deadline - monotonicMicros());
+        if (remainingUs < 0) {
+            break;
+        }
+        long count = readSome(buffer + received, length - received, remainingUs);
+        if (count < 0) {
+            break;
+        }
+        received += count;
+    }
+    return received;
+}
+
+bool SerialPort::writeAll(const uint8_t* data, size_t length)
+{
+    size_t written = 0;
+
+    while (written < length) {
+        ssize_t count = ::write(fd, data + written, length - written);
+        if (count < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                pollfd request = { fd, POLLOUT, 0 };
+                poll(&request, 1, 10);
+                continue;
+            }
+            return false;
+        }
+        written += count;
+    }
+    return true;
+}
+
+void SerialPort::discardInput()
+{
+    tcflush(fd, TCIFLUSH);
+}
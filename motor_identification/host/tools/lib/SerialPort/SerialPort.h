@@ -0,0 +1,45 @@
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Raw, non-blocking POSIX serial port tuned for latency rather than throughput:
+// no line discipline, no read batching (VMIN = VTIME = 0) and the driver's
+// low latency flag set when the adapter supports it. Works on ptys as well.
+class SerialPort {
+public:
+    SerialPort();
+    ~SerialPort();
+
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+
+    bool open(const std::string& path, unsigned int baudRate);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    int fileDescriptor() const { return fd; }
+
+    bool setBaudRate(unsigned int baudRate);
+
+    // Waits at most timeoutUs for the first byte, then returns whatever is already buffered.
+    // Returns the number of bytes read, 0 on timeout and -1 on error.
+    long readSome(uint8_t* buffer, size_t capacity, long timeoutUs);
+
+    // Keeps reading until length bytes arrived or timeoutUs elapsed. Returns the bytes read.
+    size_t readExact(uint8_t* buffer, size_t length, long timeoutUs);
+
+    // Blocks until every byte was handed to the driver
+    bool writeAll(const uint8_t* data, size_t length);
+
+    void discardInput();
+
+private:
+    int fd;
+};
+
+// Monotonic clock for latency measurements
+int64_t monotonicMicros();
+
+#endif // SERIAL_PORT_H
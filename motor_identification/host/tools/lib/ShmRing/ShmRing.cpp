@@ -0,0 +1,221 @@
+#include <ShmRing.h>
+
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+const uint32_t ringMagic = 0x474E5252; // "RRNG"
+const size_t slotAlignment = 64; // Slots start on a cache line, no false sharing between neighbours
+const size_t headerSize = 128;   // The write counter gets a cache line of its own
+
+size_t slotSize(size_t recordSize)
+{
+    size_t size = sizeof(std::atomic<uint64_t>) + recordSize;
+    return (size + slotAlignment - 1) / slotAlignment * slotAlignment;
+}
+
+size_t ringSize(size_t recordSize, size_t capacity)
+{
+    return headerSize + capacity * slotSize(recordSize);
+}
+
+std::atomic<uint64_t>* slotSequence(uint8_t* memory, size_t recordSize, uint64_t index, uint64_t capacity)
+{
+    return reinterpret_cast<std::atomic<uint64_t>*>(memory + headerSize + (index & (capacity - 1)) * slotSize(recordSize));
+}
+
+} // namespace
+
+ShmRingWriter::ShmRingWriter()
+    : memory(nullptr)
+    , mappedSize(0)
+    , header(nullptr)
+    , next(0)
+{
+}
+
+ShmRingWriter::~ShmRingWriter()
+{
+    destroy();
+}
+
+bool ShmRingWriter::create(const std::string& ringName, size_t recordSize, size_t capacity)
+{
+    static_assert(sizeof(RingHeader) <= headerSize, "Ring header must fit in front of the slots");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared counters must be lock-free");
+
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return false;
+    }
+    destroy();
+
+    shm_unlink(ringName.c_str());
+    int fd = shm_open(ringName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    mappedSize = ringSize(recordSize, capacity);
+    if (ftruncate(fd, mappedSize) != 0) {
+        ::close(fd);
+        shm_unlink(ringName.c_str());
+        return false;
+    }
+    void* mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        shm_unlink(ringName.c_str());
+        return false;
+    }
+
+    // The file is zero-filled, which is also the empty state of every slot counter
+    memory = static_cast<uint8_t*>(mapping);
+    header = new (memory) RingHeader;
+    header->recordSize = recordSize;
+    header->capacity = capacity;
+    header->written.store(0, std::memory_order_relaxed);
+    name = ringName;
+    next = 0;
+
+    // Readers check the magic last, so they never see a half-initialized header
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = ringMagic;
+    return true;
+}
+
+void ShmRingWriter::destroy()
+{
+    if (memory == nullptr) {
+        return;
+    }
+    munmap(memory, mappedSize);
+    shm_unlink(name.c_str());
+    memory = nullptr;
+    header = nullptr;
+}
+
+void ShmRingWriter::publish(const void* record)
+{
+    std::atomic<uint64_t>* sequence = slotSequence(memory, header->recordSize, next, header->capacity);
+
+    sequence->store(2 * next + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(reinterpret_cast<uint8_t*>(sequence + 1), record, header->recordSize);
+    sequence->store(2 * next + 2, std::memory_order_release);
+
+    next++;
+    header->written.store(next, std::memory_order_release);
+}
+
+uint64_t ShmRingWriter::written() const
+{
+    return next;
+}
+
+ShmRingReader::ShmRingReader()
+    : memory(nullptr)
+    , mappedSize(0)
+    , header(nullptr)
+    , recordSize(0)
+    , cursor(0)
+    , lostRecords(0)
+{
+}
+
+ShmRingReader::~ShmRingReader()
+{
+    detach();
+}
+
+bool ShmRingReader::attach(const std::string& name, size_t expectedRecordSize, bool fromOldest)
+{
+    detach();
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    // Map the header first to learn the ring size
+    void* mapping = mmap(nullptr, headerSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    const RingHeader* probe = static_cast<const RingHeader*>(mapping);
+    bool valid = probe->magic == ringMagic && probe->recordSize == expectedRecordSize;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t capacity = probe->capacity;
+    munmap(mapping, headerSize);
+
+    if (!valid) {
+        ::close(fd);
+        return false;
+    }
+
+    mappedSize = ringSize(expectedRecordSize, capacity);
+    mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    memory = static_cast<uint8_t*>(mapping);
+    header = reinterpret_cast<const RingHeader*>(memory);
+    recordSize = expectedRecordSize;
+    lostRecords = 0;
+
+    uint64_t written = header->written.load(std::memory_order_acquire);
+    cursor = (fromOldest && written > capacity) ? written - capacity : (fromOldest ? 0 : written);
+    return true;
+}
+
+void ShmRingReader::detach()
+{
+    if (memory == nullptr) {
+        return;
+    }
+    munmap(memory, mappedSize);
+    memory = nullptr;
+    header = nullptr;
+}
+
+RingStatus ShmRingReader::read(void* record)
+{
+    const uint64_t capacity = header->capacity;
+    uint64_t written = header->written.load(std::memory_order_acquire);
+
+    if (cursor == written) {
+        return RING_EMPTY;
+    }
+    if (written - cursor > capacity) {
+        lostRecords += written - capacity - cursor;
+        cursor = written - capacity;
+        return RING_LAPPED;
+    }
+
+    // Readers never write, so the mapping is read-only and the counter is only loaded
+    const std::atomic<uint64_t>* sequence = slotSequence(memory, recordSize, cursor, capacity);
+    uint64_t before = sequence->load(std::memory_order_acquire);
+    if (before != 2 * cursor + 2) {
+        // Being rewritten for a later lap
+        lostRecords++;
+        cursor++;
+        return RING_LAPPED;
+    }
+
+    std::memcpy(record, reinterpret_cast<const uint8_t*>(sequence + 1), recordSize);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence->load(std::memory_order_relaxed) != before) {
+        lostRecords++;
+        cursor++;
+        return RING_LAPPED;
+    }
+
+    cursor++;
+    return RING_OK;
+}
@@ -0,0 +1,87 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Single-writer, multi-reader ring of fixed-size records in POSIX shared memory.
+//
+// Every slot carries its own sequence counter (a per-slot seqlock): odd while the writer
+// copies a record in, even once it is complete. Readers only ever map the ring read-only
+// and keep their position to themselves, so they attach and detach at any time, never
+// slow the writer down, and detect on their own when the writer lapped them.
+
+// Decoded telemetry sample, as published by telemetry_rx --shm
+typedef struct {
+    uint32_t sequence; // Telemetry frame it arrived in
+    uint32_t timeUs;   // Device clock
+    int64_t hostUs;    // monotonicMicros() when it was received
+    uint8_t channels;
+    uint8_t reserved[7];
+    float values[8];
+} SampleRecord;
+
+typedef enum {
+    RING_OK,
+    RING_EMPTY,
+    RING_LAPPED, // Records were overwritten before this reader got to them, see lost()
+} RingStatus;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t recordSize;
+    uint64_t capacity; // Power of two
+    alignas(64) std::atomic<uint64_t> written;
+} RingHeader;
+
+class ShmRingWriter {
+public:
+    ShmRingWriter();
+    ~ShmRingWriter();
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    // name as for shm_open(), e.g. "/motor_telemetry". Replaces any ring of that name.
+    bool create(const std::string& name, size_t recordSize, size_t capacity);
+    // Unlinks the ring; attached readers keep their mapping until they detach
+    void destroy();
+
+    void publish(const void* record);
+    uint64_t written() const;
+
+private:
+    std::string name;
+    uint8_t* memory;
+    size_t mappedSize;
+    RingHeader* header;
+    uint64_t next;
+};
+
+class ShmRingReader {
+public:
+    ShmRingReader();
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    // Starts at the newest record, or at the oldest one still in the ring
+    bool attach(const std::string& name, size_t recordSize, bool fromOldest = false);
+    void detach();
+
+    RingStatus read(void* record);
+    uint64_t lost() const { return lostRecords; }
+
+private:
+    uint8_t* memory;
+    size_t mappedSize;
+    const RingHeader* header;
+    size_t recordSize;
+    uint64_t cursor;
+    uint64_t lostRecords;
+};
+
+#endif // SHM_RING_H
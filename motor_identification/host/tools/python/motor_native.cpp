@@ -0,0 +1,193 @@
+// Python bindings of the host tool libraries, so the scripts in motor_identification/host
+// keep their structure while their hot paths run natively (see host/native.py, which falls
+// back to numpy/scipy when this module is not built).
+//
+// Written against the CPython and NumPy C APIs only, so building it needs nothing beyond
+// numpy, which the scripts require anyway. Results are handed to NumPy without copies: each
+// array takes over the vector the C++ code filled. The filter and the line fit read
+// contiguous float64 inputs in place; other inputs are converted once. The GIL is released
+// while the C++ code runs.
+//
+// Build: pip install ./motor_identification/host/tools/python
+//    or: cd motor_identification/host/tools/python && python setup.py build_ext --inplace
+// Test:  python -m unittest discover motor_identification/host/tools/python
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <Capture.h>
+#include <Fitting.h>
+
+#include <utility>
+#include <vector>
+
+namespace {
+
+template <typename T>
+struct NumpyType;
+template <>
+struct NumpyType<float> {
+    static const int value = NPY_FLOAT32;
+};
+template <>
+struct NumpyType<double> {
+    static const int value = NPY_FLOAT64;
+};
+template <>
+struct NumpyType<uint32_t> {
+    static const int value = NPY_UINT32;
+};
+
+template <typename T>
+void deleteVector(PyObject* capsule)
+{
+    delete static_cast<std::vector<T>*>(PyCapsule_GetPointer(capsule, nullptr));
+}
+
+// 1-D array over the vector, which a capsule set as the array base owns from here on
+template <typename T>
+PyObject* toArray(std::vector<T>&& values)
+{
+    auto* owned = new std::vector<T>(std::move(values));
+    PyObject* capsule = PyCapsule_New(owned, nullptr, deleteVector<T>);
+    if (capsule == nullptr) {
+        delete owned;
+        return nullptr;
+    }
+    npy_intp size = static_cast<npy_intp>(owned->size());
+    PyObject* array = PyArray_SimpleNewFromData(1, &size, NumpyType<T>::value, owned->data());
+    if (array == nullptr) {
+        Py_DECREF(capsule);
+        return nullptr;
+    }
+    if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(array), capsule) < 0) { // Steals capsule
+        Py_DECREF(array);
+        return nullptr;
+    }
+    return array;
+}
+
+// Contiguous float64 view of any array-like, converted only when it is not one already
+PyArrayObject* toDoubles(PyObject* object)
+{
+    return reinterpret_cast<PyArrayObject*>(
+        PyArray_FROMANY(object, NPY_FLOAT64, 0, 0, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST));
+}
+
+PyObject* decodeCaptureBytes(PyObject*, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = { "data", nullptr };
+    Py_buffer view;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*", const_cast<char**>(keywords), &view)) {
+        return nullptr;
+    }
+    Capture capture;
+    bool decoded;
+    Py_BEGIN_ALLOW_THREADS
+    decoded = decodeCapture(static_cast<const uint8_t*>(view.buf), view.len, capture);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&view);
+    if (!decoded) {
+        PyErr_SetString(PyExc_ValueError, "capture length is not a whole number of samples");
+        return nullptr;
+    }
+    PyObject* input = toArray(std::move(capture.input));
+    PyObject* angle = input != nullptr ? toArray(std::move(capture.angle)) : nullptr;
+    PyObject* timeUs = angle != nullptr ? toArray(std::move(capture.timeUs)) : nullptr;
+    if (timeUs == nullptr) {
+        Py_XDECREF(input);
+        Py_XDECREF(angle);
+        return nullptr;
+    }
+    return Py_BuildValue("(NNN)", input, angle, timeUs);
+}
+
+PyObject* savgol(PyObject*, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = { "x", "window_length", "polyorder", "deriv", "delta", nullptr };
+    PyObject* object;
+    int window, order, derivative = 0;
+    double delta = 1.0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Oii|id", const_cast<char**>(keywords), &object, &window, &order,
+            &derivative, &delta)) {
+        return nullptr;
+    }
+    PyArrayObject* x = toDoubles(object);
+    if (x == nullptr) {
+        return nullptr;
+    }
+    if (PyArray_NDIM(x) != 1 || order < 0 || derivative < 0 || window % 2 == 0 || window <= order
+        || window > PyArray_SIZE(x) || derivative > order) {
+        Py_DECREF(x);
+        PyErr_SetString(PyExc_ValueError, "need a 1-D array of at least window_length samples, an odd window_length > "
+                                          "polyorder and deriv <= polyorder");
+        return nullptr;
+    }
+    std::vector<double> y;
+    Py_BEGIN_ALLOW_THREADS
+    y = savgolFilterInterp(static_cast<const double*>(PyArray_DATA(x)), PyArray_SIZE(x), window, order, derivative, delta);
+    Py_END_ALLOW_THREADS
+    Py_DECREF(x);
+    return toArray(std::move(y));
+}
+
+PyObject* linregress(PyObject*, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = { "x", "y", nullptr };
+    PyObject* xObject;
+    PyObject* yObject;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO", const_cast<char**>(keywords), &xObject, &yObject)) {
+        return nullptr;
+    }
+    PyArrayObject* x = toDoubles(xObject);
+    PyArrayObject* y = x != nullptr ? toDoubles(yObject) : nullptr;
+    if (y == nullptr) {
+        Py_XDECREF(x);
+        return nullptr;
+    }
+    if (PyArray_NDIM(x) != 1 || PyArray_NDIM(y) != 1 || PyArray_SIZE(x) != PyArray_SIZE(y)) {
+        Py_DECREF(x);
+        Py_DECREF(y);
+        PyErr_SetString(PyExc_ValueError, "x and y must be 1-D arrays of the same length");
+        return nullptr;
+    }
+    LineFit fit;
+    Py_BEGIN_ALLOW_THREADS
+    fit = fitLine(static_cast<const double*>(PyArray_DATA(x)), static_cast<const double*>(PyArray_DATA(y)), PyArray_SIZE(x));
+    Py_END_ALLOW_THREADS
+    Py_DECREF(x);
+    Py_DECREF(y);
+    if (!fit.valid) {
+        PyErr_SetString(PyExc_ValueError, "x is constant");
+        return nullptr;
+    }
+    return Py_BuildValue("(ddd)", fit.slope, fit.intercept, fit.r);
+}
+
+PyMethodDef methods[] = {
+    { "decode_capture", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(decodeCaptureBytes)),
+        METH_VARARGS | METH_KEYWORDS,
+        "decode_capture(data)\n--\n\nSplits a motor test download into (input float32, angle float32, time_us uint32) arrays." },
+    { "savgol_filter", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(savgol)), METH_VARARGS | METH_KEYWORDS,
+        "savgol_filter(x, window_length, polyorder, deriv=0, delta=1.0)\n--\n\n"
+        "scipy.signal.savgol_filter(x, window_length, polyorder, deriv, delta) with mode='interp'." },
+    { "linregress", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(linregress)), METH_VARARGS | METH_KEYWORDS,
+        "linregress(x, y)\n--\n\nLeast-squares line: (slope, intercept, r_value) as scipy.stats.linregress gives them." },
+    { nullptr, nullptr, 0, nullptr },
+};
+
+PyModuleDef module = {
+    PyModuleDef_HEAD_INIT, "motor_native", "Native kernels of the motor identification host tools", -1, methods,
+    nullptr, nullptr, nullptr, nullptr,
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_motor_native()
+{
+    import_array();
+    return PyModule_Create(&module);
+}
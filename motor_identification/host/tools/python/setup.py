@@ -0,0 +1,22 @@
+import os
+import numpy
+from setuptools import setup, Extension
+
+# The libraries of the host tools the bindings use, compiled from lib/ as they are
+LIBS = ['Capture', 'Fitting']
+LIB_DIR = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'lib'))
+
+extension = Extension(
+    'motor_native',
+    ['motor_native.cpp'] + [os.path.join(LIB_DIR, name, f'{name}.cpp') for name in LIBS],
+    include_dirs=[numpy.get_include()] + [os.path.join(LIB_DIR, name) for name in LIBS],
+    extra_compile_args=['-std=c++17', '-O2'],
+    language='c++',
+)
+
+setup(
+    name='motor_native',
+    version='1.0',
+    description='Native kernels of the motor identification host tools',
+    ext_modules=[extension],
+)
@@ -0,0 +1,60 @@
+import os
+import sys
+import unittest
+import numpy as np
+from scipy import signal, stats
+
+# The in-place build next to this file, as host/native.py finds it
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import motor_native
+
+class MotorNativeTest(unittest.TestCase):
+    """
+    The native kernels against the numpy/scipy code host/native.py falls back to.
+    Build the module first (python setup.py build_ext --inplace).
+    """
+
+    def setUp(self):
+        generator = np.random.default_rng(1)
+        self.time = np.arange(2000) * 0.01
+        self.input = generator.uniform(-0.25, 0.25, self.time.size)
+        self.angle = np.cumsum(np.cumsum(self.input)) * 1e-3 + generator.normal(0.0, 0.005, self.time.size)
+
+    def test_decode_capture(self):
+        samples = 100
+        input_values = np.linspace(-1.0, 1.0, samples, dtype='<f4')
+        angle_values = np.linspace(0.0, 50.0, samples, dtype='<f4')
+        time_values = np.arange(samples, dtype='<u4') * 10000 + 4294000000 # Wraps within the run
+        raw_data = input_values.tobytes() + angle_values.tobytes() + time_values.tobytes()
+
+        decoded = motor_native.decode_capture(raw_data)
+        for got, expected in zip(decoded, (input_values, angle_values, time_values)):
+            self.assertEqual(got.dtype, expected.dtype.newbyteorder('='))
+            np.testing.assert_array_equal(got, expected)
+        with self.assertRaises(ValueError):
+            motor_native.decode_capture(raw_data[:-1])
+
+    def test_savgol_filter(self):
+        dt = self.time[1] - self.time[0]
+        for deriv in range(3):
+            expected = signal.savgol_filter(self.angle, 11, 3, deriv=deriv, delta=dt)
+            got = motor_native.savgol_filter(self.angle, 11, 3, deriv, dt)
+            np.testing.assert_allclose(got, expected, rtol=1e-9, atol=1e-9 * np.abs(expected).max())
+        # Lists and other dtypes are converted
+        np.testing.assert_allclose(motor_native.savgol_filter(list(self.angle[:50]), 5, 2),
+                                   signal.savgol_filter(self.angle[:50], 5, 2), rtol=1e-9, atol=1e-12)
+        with self.assertRaises(ValueError):
+            motor_native.savgol_filter(self.angle, 10, 3)
+
+    def test_linregress(self):
+        torque = 0.11 * self.input - 0.0015 + np.random.default_rng(2).normal(0.0, 0.01, self.input.size)
+        expected = stats.linregress(self.input, torque)
+        slope, intercept, r_value = motor_native.linregress(self.input, torque)
+        self.assertAlmostEqual(slope, expected.slope, delta=1e-12)
+        self.assertAlmostEqual(intercept, expected.intercept, delta=1e-12)
+        self.assertAlmostEqual(r_value, expected.rvalue, delta=1e-12)
+        with self.assertRaises(ValueError):
+            motor_native.linregress(np.ones(10), np.arange(10.0))
+
+if __name__ == '__main__':
+    unittest.main()
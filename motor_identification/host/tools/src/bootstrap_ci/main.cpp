@@ -0,0 +1,390 @@
+// Bootstrap confidence intervals for the identified wheel parameters: the slope and
+// intercept of estimate.py and, once friction_fit has run, the friction model.
+//
+// Consecutive samples are not independent (the derivative filter alone spreads every bit
+// of noise over a whole window), so whole blocks of samples are resampled: each refit
+// draws random block starts with replacement until it has as many samples as the run, fits
+// the models again exactly as estimate.py and friction_fit do, and keeps the parameters.
+// The refits are spread over all cores; every refit seeds its own generator, so the result
+// does not depend on the thread count. The percentile intervals go into the model file as
+// <parameter>_ci_low and <parameter>_ci_high.
+//
+// The Stribeck velocity is searched over a bounded range. When the full-run estimate, or more
+// refits than one tail of the interval, end up on an end of that range, the data do not pin
+// it down and its percentiles only show where the search stopped. That interval is flagged
+// instead: friction_stribeck_velocity_ci_unreliable holds the share of refits on the bound
+// and no _ci_low / _ci_high are written for it.
+//
+// Without --block the block length follows the residual correlation of the linear fit:
+// twice the lag where it falls below 0.1, at least one derivative window.
+//
+// Usage: bootstrap_ci [--data ../experiment_data.csv] [--model ../model_parameters.json]
+//                     [--refits 2000] [--confidence 0.95] [--block 0 (auto)] [--window 11]
+//                     [--min-speed 0.5] [--threads 0 (all cores)] [--seed 1] [--csv bootstrap_ci.csv]
+
+#include <CsvTable.h>
+#include <Fitting.h>
+#include <FrictionModel.h>
+#include <ModelFile.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const double correlationCutoff = 0.1;
+// Friction fits with fewer samples above the speed threshold count as failed
+const size_t minFrictionSamples = 50;
+
+typedef struct {
+    std::string dataPath = "../experiment_data.csv";
+    std::string modelPath = "../model_parameters.json";
+    std::string csvPath = "bootstrap_ci.csv";
+    unsigned int refits = 2000;
+    double confidence = 0.95;
+    unsigned int block = 0;
+    unsigned int window = 11;
+    double minSpeed = 0.5;  // rad/s, as in friction_fit
+    unsigned int threads = 0;
+    unsigned int seed = 1;
+} Options;
+
+// One run, sample by sample, inside the derivative window
+typedef struct {
+    std::vector<double> input;
+    std::vector<double> speed;
+    std::vector<double> torque; // J * acceleration
+} Series;
+
+// Model file keys, in the order of the parameter vectors below
+const char* const linearKeys[] = { "slope", "intercept" };
+const char* const frictionKeys[] = { "friction_torque_gain", "friction_offset", "friction_coulomb", "friction_static",
+    "friction_stribeck_velocity", "friction_viscous" };
+const size_t linearCount = sizeof(linearKeys) / sizeof(linearKeys[0]);
+const size_t frictionCount = sizeof(frictionKeys) / sizeof(frictionKeys[0]);
+const size_t stribeckIndex = linearCount + 4; // friction_stribeck_velocity
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--data") {
+            options.dataPath = value;
+        } else if (flag == "--model") {
+            options.modelPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--refits") {
+            options.refits = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--confidence") {
+            options.confidence = std::strtod(value, nullptr);
+        } else if (flag == "--block") {
+            options.block = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--window") {
+            options.window = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--min-speed") {
+            options.minSpeed = std::strtod(value, nullptr);
+        } else if (flag == "--threads") {
+            options.threads = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--seed") {
+            options.seed = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.refits >= 100 && options.confidence > 0.0 && options.confidence < 1.0
+        && options.window >= 5 && options.window % 2 == 1 && options.minSpeed > 0.0;
+}
+
+// Torque = slope * input + intercept, like the linregress in estimate.py
+bool fitLine(const Series& series, const std::vector<size_t>& samples, double* parameters)
+{
+    LeastSquares fit(2);
+    for (size_t k : samples) {
+        double row[2] = { series.input[k], 1.0 };
+        fit.add(row, series.torque[k]);
+    }
+    std::vector<double> line;
+    if (!fit.solve(line)) {
+        return false;
+    }
+    parameters[0] = line[0];
+    parameters[1] = line[1];
+    return true;
+}
+
+// The friction_fit model on the samples above the speed threshold. onBound tells whether the
+// Stribeck velocity came out on an end of its search range.
+bool fitFriction(const Series& series, const std::vector<size_t>& samples, double minSpeed, double shape, double* parameters,
+    bool* onBound)
+{
+    FrictionData data;
+    double maxSpeed = 0.0;
+    for (size_t k : samples) {
+        if (std::fabs(series.speed[k]) >= minSpeed) {
+            data.input.push_back(series.input[k]);
+            data.speed.push_back(series.speed[k]);
+            data.torque.push_back(series.torque[k]);
+            maxSpeed = std::max(maxSpeed, std::fabs(series.speed[k]));
+        }
+    }
+    if (data.speed.size() < minFrictionSamples) {
+        return false;
+    }
+
+    FrictionModel fit = fitFrictionStribeck(data, minSpeed, maxSpeed, shape);
+    FrictionModel plain = fitFrictionLinear(data, 0.0, shape);
+    if (!fit.valid || (plain.valid && plain.rss <= fit.rss)) {
+        fit = plain;
+    }
+    if (!fit.valid || fit.gain <= 0.0) {
+        return false;
+    }
+    const double values[frictionCount] = { fit.gain, fit.offset, fit.coulomb, fit.stiction, fit.stribeck, fit.viscous };
+    std::copy(values, values + frictionCount, parameters);
+    *onBound = stribeckOnBound(fit, minSpeed, maxSpeed);
+    return true;
+}
+
+// Twice the first lag where the residual autocorrelation drops below the cutoff
+size_t blockLength(const Series& series, const double* line, unsigned int window)
+{
+    const size_t n = series.torque.size();
+    std::vector<double> residual(n);
+    double variance = 0.0;
+    for (size_t k = 0; k < n; k++) {
+        residual[k] = series.torque[k] - line[0] * series.input[k] - line[1];
+        variance += residual[k] * residual[k];
+    }
+    if (variance <= 0.0) {
+        return window;
+    }
+
+    size_t lag = 1;
+    for (; lag < n / 8; lag++) {
+        double sum = 0.0;
+        for (size_t k = lag; k < n; k++) {
+            sum += residual[k] * residual[k - lag];
+        }
+        if (std::fabs(sum / variance) < correlationCutoff) {
+            break;
+        }
+    }
+    return std::min(std::max<size_t>(2 * lag, window), std::max<size_t>(n / 8, 1));
+}
+
+// Moving-block resample: random block starts until the run length is filled
+void resample(std::mt19937_64& generator, size_t samples, size_t block, std::vector<size_t>& indices)
+{
+    std::uniform_int_distribution<size_t> start(0, samples - block);
+    indices.clear();
+    while (indices.size() < samples) {
+        size_t first = start(generator);
+        for (size_t k = first; k < first + block && indices.size() < samples; k++) {
+            indices.push_back(k);
+        }
+    }
+}
+
+// Linear interpolation between order statistics, like numpy's default percentile
+double quantile(const std::vector<double>& sorted, double q)
+{
+    double position = q * (sorted.size() - 1);
+    size_t below = static_cast<size_t>(position);
+    size_t above = std::min(below + 1, sorted.size() - 1);
+    return sorted[below] + (position - below) * (sorted[above] - sorted[below]);
+}
+
+bool writeCsv(const std::string& path, const std::vector<std::string>& keys, const std::vector<std::vector<double>>& draws,
+    const std::vector<char>& succeeded)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "Refit");
+    for (const std::string& key : keys) {
+        std::fprintf(file, ",%s", key.c_str());
+    }
+    std::fprintf(file, "\n");
+    for (size_t r = 0; r < draws.size(); r++) {
+        if (!succeeded[r]) {
+            continue;
+        }
+        std::fprintf(file, "%zu", r);
+        for (double value : draws[r]) {
+            std::fprintf(file, ",%.9e", value);
+        }
+        std::fprintf(file, "\n");
+    }
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--data file] [--model file] [--refits n >= 100] [--confidence 0-1] [--block n] "
+            "[--window odd n] [--min-speed rad/s] [--threads n] [--seed n] [--csv file]\n", argv[0]);
+        return 1;
+    }
+    unsigned int threads = threadCount(options.threads);
+
+    std::printf("--- Block Bootstrap Confidence Intervals ---\n");
+
+    CsvTable run;
+    if (!run.load(options.dataPath) || !run.has("Time(s)") || !run.has("Input") || !run.has("Angle")
+        || run.rows() < 4 * options.window) {
+        std::fprintf(stderr, "Error: could not read Time(s), Input and Angle from %s. Run experiment.py first.\n",
+            options.dataPath.c_str());
+        return 1;
+    }
+
+    ModelFile model;
+    if (!model.load(options.modelPath) || !model.has("inertia") || !model.has("slope")) {
+        std::fprintf(stderr, "Error: could not read the model from %s. Run estimate.py first.\n", options.modelPath.c_str());
+        return 1;
+    }
+    double inertia = model.number("inertia");
+    bool friction = model.has("friction_stribeck_shape");
+    double shape = model.number("friction_stribeck_shape", 2.0);
+
+    const std::vector<double>& time = run.column("Time(s)");
+    const std::vector<double>& angle = run.column("Angle");
+    double dt = (time.back() - time.front()) / (time.size() - 1);
+    std::vector<double> speeds = savgolFilter(angle, options.window, 3, 1, dt);
+    std::vector<double> accels = savgolFilter(angle, options.window, 3, 2, dt);
+
+    Series series;
+    size_t half = options.window / 2;
+    for (size_t k = half; k + half < angle.size(); k++) {
+        series.input.push_back(run.column("Input")[k]);
+        series.speed.push_back(speeds[k]);
+        series.torque.push_back(inertia * accels[k]);
+    }
+    const size_t samples = series.torque.size();
+
+    std::vector<std::string> keys(linearKeys, linearKeys + linearCount);
+    if (friction) {
+        keys.insert(keys.end(), frictionKeys, frictionKeys + frictionCount);
+    }
+    auto estimate = [&](const std::vector<size_t>& indices, double* parameters, bool* onBound) {
+        *onBound = false;
+        return fitLine(series, indices, parameters)
+            && (!friction || fitFriction(series, indices, options.minSpeed, shape, parameters + linearCount, onBound));
+    };
+
+    std::vector<size_t> all(samples);
+    for (size_t k = 0; k < samples; k++) {
+        all[k] = k;
+    }
+    std::vector<double> point(keys.size());
+    bool pointOnBound;
+    if (!estimate(all, point.data(), &pointOnBound)) {
+        std::fprintf(stderr, "Error: the fit fails on the full run, there is nothing to resample.\n");
+        return 1;
+    }
+
+    size_t block = options.block > 0 ? std::min<size_t>(options.block, samples) : blockLength(series, point.data(), options.window);
+    std::printf("Data: %zu samples, %.1f ms period, from %s\n", samples, dt * 1000.0, options.dataPath.c_str());
+    std::printf("Models: linear%s\n", friction ? " + friction (friction_fit found in the model file)" : "");
+    std::printf("Blocks: %zu samples (%.0f ms)%s, %u refits on %u threads\n", block, block * dt * 1000.0,
+        options.block > 0 ? "" : " from the residual correlation", options.refits, threads);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<double>> draws(options.refits, std::vector<double>(keys.size()));
+    std::vector<char> succeeded(options.refits, 0);
+    std::vector<char> onBound(options.refits, 0);
+    parallelFor(threads, options.refits, [&](unsigned int, size_t begin, size_t end) {
+        std::vector<size_t> indices;
+        for (size_t r = begin; r < end; r++) {
+            std::seed_seq seed = { static_cast<size_t>(options.seed), r };
+            std::mt19937_64 generator(seed);
+            resample(generator, samples, block, indices);
+            bool bound;
+            succeeded[r] = estimate(indices, draws[r].data(), &bound);
+            onBound[r] = bound;
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t good = std::count(succeeded.begin(), succeeded.end(), 1);
+    std::printf("Refits: %zu of %u succeeded in %.2f s\n", good, options.refits, seconds);
+    if (good < 100) {
+        std::fprintf(stderr, "Error: too few refits succeeded for an interval. Is the run long enough for %zu-sample blocks?\n", block);
+        return 1;
+    }
+
+    double tail = 0.5 * (1.0 - options.confidence);
+    size_t boundCount = 0;
+    for (size_t r = 0; r < draws.size(); r++) {
+        boundCount += succeeded[r] && onBound[r];
+    }
+    double boundShare = static_cast<double>(boundCount) / good;
+    bool stribeckUnreliable = friction && (pointOnBound || boundShare > tail);
+
+    std::printf("\n--- Results (%.0f %% intervals) ---\n", options.confidence * 100.0);
+    std::printf("Parameter                    In file       Refit         Std. error    Interval\n");
+    for (size_t p = 0; p < keys.size(); p++) {
+        std::vector<double> values;
+        for (size_t r = 0; r < draws.size(); r++) {
+            if (succeeded[r]) {
+                values.push_back(draws[r][p]);
+            }
+        }
+        std::sort(values.begin(), values.end());
+        double mean = 0.0, variance = 0.0;
+        for (double value : values) {
+            mean += value / values.size();
+        }
+        for (double value : values) {
+            variance += (value - mean) * (value - mean) / (values.size() - 1);
+        }
+        double low = quantile(values, tail), high = quantile(values, 1.0 - tail);
+
+        if (p == stribeckIndex && stribeckUnreliable) {
+            std::printf("%-28s %+.4e  %+.4e  %.4e    unreliable, on the search bound in %.0f %% of refits%s\n",
+                keys[p].c_str(), model.number(keys[p]), point[p], std::sqrt(variance), boundShare * 100.0,
+                pointOnBound ? " and the full run" : "");
+            model.remove(keys[p] + "_ci_low");
+            model.remove(keys[p] + "_ci_high");
+            model.setNumber(keys[p] + "_ci_unreliable", boundShare);
+            continue;
+        }
+        std::printf("%-28s %+.4e  %+.4e  %.4e    [%+.4e, %+.4e]\n", keys[p].c_str(), model.number(keys[p]), point[p],
+            std::sqrt(variance), low, high);
+        model.setNumber(keys[p] + "_ci_low", low);
+        model.setNumber(keys[p] + "_ci_high", high);
+        model.remove(keys[p] + "_ci_unreliable");
+    }
+    if (stribeckUnreliable) {
+        std::printf("The run does not pin the Stribeck velocity down: its interval is left out (_ci_unreliable).\n");
+    }
+
+    model.setNumber("bootstrap_confidence", options.confidence);
+    model.setNumber("bootstrap_refits", static_cast<double>(good));
+    model.setNumber("bootstrap_block_samples", static_cast<double>(block));
+    if (!model.save(options.modelPath)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.modelPath.c_str());
+        return 1;
+    }
+    std::printf("\nIntervals saved to %s (<parameter>_ci_low / _ci_high)\n", options.modelPath.c_str());
+
+    if (!writeCsv(options.csvPath, keys, draws, succeeded)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("Refit parameters saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
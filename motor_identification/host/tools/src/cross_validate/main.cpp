@@ -0,0 +1,368 @@
+// Cross-validation matrix: simulates every model file against every capture and tabulates
+// the fit, so a drifting board or an outlier run shows up as a bad row or column.
+//
+// Each model drives the wheel of estimate.py, J * dw/dt = K * u + c [- F(w)], from the
+// recorded input, with the friction F of friction_fit when the model file has one (and then
+// its K and c as well). The speed to compare with comes from Savitzky-Golay derivatives of
+// the angle ("Angle", or "Real_Angle" as validate.py saves it). The rigid wheel integrates
+// every torque error, so the simulation restarts from the measured speed every --horizon
+// seconds (0: one free run over the whole capture). Per cell:
+//   RMSE      of the simulated speed, rad/s
+//   NRMSE     RMSE over the standard deviation of the measured speed, %
+//   max error the largest speed error, rad/s
+// The captures are read and the M x N cells simulated on all cores.
+//
+// Usage: cross_validate [--models ../model_parameters.json[,more.json...]]
+//                       [--data ../validation_data.csv[,more.csv...]] [--horizon 1.0] [--window 11]
+//                       [--outlier 2.0] [--threads 0 (all cores)] [--csv cross_validate.csv]
+
+#include <CsvTable.h>
+#include <Fitting.h>
+#include <FrictionModel.h>
+#include <ModelFile.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Simulated speeds beyond this many times the measured range count as diverged
+const double divergenceFactor = 100.0;
+const unsigned int polyOrder = 3;
+
+typedef struct {
+    std::string modelPaths = "../model_parameters.json";
+    std::string dataPaths = "../validation_data.csv";
+    std::string csvPath = "cross_validate.csv";
+    double horizon = 1.0;
+    unsigned int window = 11;
+    double outlier = 2.0;  // times the median NRMSE
+    unsigned int threads = 0;
+} Options;
+
+typedef struct {
+    std::string path;
+    FrictionModel motor;  // gain and offset always; friction terms when identified
+    double inertia;
+    double shape;
+    bool friction;
+} Model;
+
+typedef struct {
+    std::string path;
+    double dt;
+    std::vector<double> input;
+    std::vector<double> speed;
+    size_t first, last;  // samples with a full filter window
+    double spread;       // standard deviation of the speed
+} Capture;
+
+typedef struct {
+    double rmse = std::numeric_limits<double>::quiet_NaN();
+    double nrmse = std::numeric_limits<double>::quiet_NaN();
+    double maxError = std::numeric_limits<double>::quiet_NaN();
+} Cell;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--models") {
+            options.modelPaths = value;
+        } else if (flag == "--data") {
+            options.dataPaths = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--horizon") {
+            options.horizon = std::strtod(value, nullptr);
+        } else if (flag == "--window") {
+            options.window = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--outlier") {
+            options.outlier = std::strtod(value, nullptr);
+        } else if (flag == "--threads") {
+            options.threads = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.horizon >= 0.0 && options.window % 2 == 1 && options.window > polyOrder
+        && options.outlier > 1.0;
+}
+
+std::vector<std::string> splitPaths(const std::string& list)
+{
+    std::vector<std::string> paths;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        if (end > start) {
+            paths.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return paths;
+}
+
+bool loadModel(const std::string& path, Model& model)
+{
+    ModelFile file;
+    if (!file.load(path) || !file.has("slope") || !file.has("inertia")) {
+        return false;
+    }
+    model.path = path;
+    model.inertia = file.number("inertia");
+    model.friction = file.has("friction_coulomb") && file.has("friction_torque_gain");
+    model.shape = file.number("friction_stribeck_shape", 2.0);
+    if (model.friction) {
+        model.motor.gain = file.number("friction_torque_gain");
+        model.motor.offset = file.number("friction_offset");
+        model.motor.coulomb = file.number("friction_coulomb");
+        model.motor.stiction = file.number("friction_static", model.motor.coulomb);
+        model.motor.stribeck = file.number("friction_stribeck_velocity");
+        model.motor.viscous = file.number("friction_viscous");
+    } else {
+        model.motor.gain = file.number("slope");
+        model.motor.offset = file.number("intercept");
+    }
+    return model.inertia > 0.0;
+}
+
+bool loadCapture(const std::string& path, unsigned int window, Capture& capture)
+{
+    CsvTable run;
+    if (!run.load(path) || !run.has("Time(s)") || !run.has("Input")) {
+        return false;
+    }
+    const char* angleColumn = run.has("Angle") ? "Angle" : "Real_Angle";
+    const std::vector<double>& time = run.column("Time(s)");
+    if (!run.has(angleColumn) || time.size() < 2 * window) {
+        return false;
+    }
+    capture.path = path;
+    capture.dt = (time.back() - time.front()) / (time.size() - 1);
+    capture.input = run.column("Input");
+    capture.speed = savgolFilter(run.column(angleColumn), window, polyOrder, 1, capture.dt);
+    capture.first = window / 2;
+    capture.last = time.size() - window / 2;
+
+    double mean = 0.0, squares = 0.0;
+    for (size_t k = capture.first; k < capture.last; k++) {
+        mean += capture.speed[k];
+    }
+    mean /= capture.last - capture.first;
+    for (size_t k = capture.first; k < capture.last; k++) {
+        squares += (capture.speed[k] - mean) * (capture.speed[k] - mean);
+    }
+    capture.spread = std::sqrt(squares / (capture.last - capture.first));
+    return capture.dt > 0.0;
+}
+
+// One model on one capture. The input recorded at sample k + 1 drove the wheel from k to
+// k + 1 (see motorTestSample in the firmware).
+Cell simulate(const Model& model, const Capture& capture, double horizon)
+{
+    size_t restart = horizon > 0.0 ? std::max<size_t>(1, static_cast<size_t>(std::lround(horizon / capture.dt)))
+                                   : std::numeric_limits<size_t>::max();
+    double range = 0.0;
+    for (size_t k = capture.first; k < capture.last; k++) {
+        range = std::max(range, std::fabs(capture.speed[k]));
+    }
+
+    Cell cell;
+    double speed = 0.0, squares = 0.0, maxError = 0.0;
+    for (size_t k = capture.first; k + 1 < capture.last; k++) {
+        if ((k - capture.first) % restart == 0) {
+            speed = capture.speed[k];
+        }
+        double torque = model.motor.gain * capture.input[k + 1] + model.motor.offset;
+        if (model.friction) {
+            torque -= frictionTorque(model.motor, speed, model.shape);
+        }
+        speed += capture.dt * torque / model.inertia;
+        if (!(std::fabs(speed) < divergenceFactor * std::max(range, 1.0))) {
+            return cell;
+        }
+        double error = speed - capture.speed[k + 1];
+        squares += error * error;
+        maxError = std::max(maxError, std::fabs(error));
+    }
+    cell.rmse = std::sqrt(squares / (capture.last - capture.first - 1));
+    cell.nrmse = capture.spread > 0.0 ? 100.0 * cell.rmse / capture.spread : std::numeric_limits<double>::quiet_NaN();
+    cell.maxError = maxError;
+    return cell;
+}
+
+double median(std::vector<double> values)
+{
+    values.erase(std::remove_if(values.begin(), values.end(), [](double value) { return std::isnan(value); }), values.end());
+    if (values.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+// Rows are models and metrics, columns are captures
+bool writeCsv(const std::string& path, const std::vector<Model>& models, const std::vector<Capture>& captures,
+    const std::vector<Cell>& cells)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "model,metric");
+    for (const Capture& capture : captures) {
+        std::fprintf(file, ",%s", capture.path.c_str());
+    }
+    std::fprintf(file, "\n");
+    const struct {
+        const char* name;
+        double Cell::*value;
+    } metrics[] = { { "rmse", &Cell::rmse }, { "nrmse_percent", &Cell::nrmse }, { "max_error", &Cell::maxError } };
+    for (size_t m = 0; m < models.size(); m++) {
+        for (const auto& metric : metrics) {
+            std::fprintf(file, "%s,%s", models[m].path.c_str(), metric.name);
+            for (size_t c = 0; c < captures.size(); c++) {
+                std::fprintf(file, ",%.6g", cells[m * captures.size() + c].*metric.value);
+            }
+            std::fprintf(file, "\n");
+        }
+    }
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--models a.json,b.json] [--data a.csv,b.csv] [--horizon s] [--window n] "
+            "[--outlier factor] [--threads n] [--csv file]\n", argv[0]);
+        return 1;
+    }
+    unsigned int threads = threadCount(options.threads);
+
+    std::printf("--- Cross-Validation Matrix ---\n");
+
+    std::vector<Model> models;
+    for (const std::string& path : splitPaths(options.modelPaths)) {
+        Model model;
+        if (!loadModel(path, model)) {
+            std::printf("Skipping %s: no slope and inertia.\n", path.c_str());
+            continue;
+        }
+        models.push_back(model);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> paths = splitPaths(options.dataPaths);
+    std::vector<Capture> loaded(paths.size());
+    std::vector<char> usable(paths.size(), 0);
+    parallelTasks(std::min<unsigned int>(threads, paths.size()), paths.size(),
+        [&](size_t i) { usable[i] = loadCapture(paths[i], options.window, loaded[i]); });
+    std::vector<Capture> captures;
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!usable[i]) {
+            std::printf("Skipping %s: no Time(s), Input and Angle columns with at least %u rows.\n", paths[i].c_str(),
+                2 * options.window);
+            continue;
+        }
+        captures.push_back(std::move(loaded[i]));
+    }
+    if (models.empty() || captures.empty()) {
+        std::fprintf(stderr, "Error: need at least one model file and one capture. Run estimate.py and validate.py first.\n");
+        return 1;
+    }
+
+    std::vector<Cell> cells(models.size() * captures.size());
+    parallelTasks(threads, cells.size(), [&](size_t i) {
+        cells[i] = simulate(models[i / captures.size()], captures[i % captures.size()], options.horizon);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t m = 0; m < models.size(); m++) {
+        std::printf("M%-3zu %s%s\n", m + 1, models[m].path.c_str(), models[m].friction ? " (with friction)" : "");
+    }
+    for (size_t c = 0; c < captures.size(); c++) {
+        std::printf("C%-3zu %s (%zu samples, %.1f ms)\n", c + 1, captures[c].path.c_str(), captures[c].speed.size(),
+            captures[c].dt * 1000.0);
+    }
+    std::printf("%zu x %zu cells in %.2f s, %s\n", models.size(), captures.size(), seconds,
+        options.horizon > 0.0 ? "restarting from the measured speed every horizon" : "free run");
+
+    // NRMSE matrix with the median of every row and column
+    std::vector<double> rowMedians(models.size()), columnMedians(captures.size()), all;
+    for (size_t m = 0; m < models.size(); m++) {
+        std::vector<double> row;
+        for (size_t c = 0; c < captures.size(); c++) {
+            row.push_back(cells[m * captures.size() + c].nrmse);
+        }
+        rowMedians[m] = median(row);
+        all.insert(all.end(), row.begin(), row.end());
+    }
+    for (size_t c = 0; c < captures.size(); c++) {
+        std::vector<double> column;
+        for (size_t m = 0; m < models.size(); m++) {
+            column.push_back(cells[m * captures.size() + c].nrmse);
+        }
+        columnMedians[c] = median(column);
+    }
+    double overall = median(all);
+
+    std::printf("\n--- Results: NRMSE %% (model rows, capture columns) ---\n      ");
+    for (size_t c = 0; c < captures.size(); c++) {
+        std::printf(" %8s", ("C" + std::to_string(c + 1)).c_str());
+    }
+    std::printf("   median\n");
+    for (size_t m = 0; m < models.size(); m++) {
+        std::printf("M%-5zu", m + 1);
+        for (size_t c = 0; c < captures.size(); c++) {
+            double value = cells[m * captures.size() + c].nrmse;
+            std::isnan(value) ? std::printf(" %8s", "diverged") : std::printf(" %8.2f", value);
+        }
+        std::printf(" %8.2f\n", rowMedians[m]);
+    }
+    std::printf("median");
+    for (double value : columnMedians) {
+        std::printf(" %8.2f", value);
+    }
+    std::printf(" %8.2f\n", overall);
+
+    // Rows and columns well above the rest: a model that fits nothing, a capture nothing fits
+    bool flagged = false;
+    for (size_t m = 0; m < models.size() && models.size() > 1; m++) {
+        if (!(rowMedians[m] <= options.outlier * overall)) {
+            std::printf("Outlier model M%zu: median NRMSE %.2f %% against %.2f %% overall\n", m + 1, rowMedians[m], overall);
+            flagged = true;
+        }
+    }
+    for (size_t c = 0; c < captures.size() && captures.size() > 1; c++) {
+        if (!(columnMedians[c] <= options.outlier * overall)) {
+            std::printf("Outlier capture C%zu: median NRMSE %.2f %% against %.2f %% overall\n", c + 1, columnMedians[c], overall);
+            flagged = true;
+        }
+    }
+    if (!flagged) {
+        std::printf("No model or capture above %.1f times the median NRMSE.\n", options.outlier);
+    }
+
+    if (!writeCsv(options.csvPath, models, captures, cells)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("\nRMSE, NRMSE and max error matrices saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
@@ -0,0 +1,353 @@
+// Empirical transfer function estimate (ETFE) with Welch averaging: a model-free Bode plot
+// of the wheel, from input to angle, to check the parametric fits against.
+//
+// Every capture is cut into overlapping segments. Each segment is detrended (a straight
+// line, the angle keeps drifting), windowed and transformed, and the cross and auto spectra
+// are averaged over all segments of all files:
+//   H(f)  = Syu(f) / Suu(f)
+//   C(f)  = |Syu(f)|^2 / (Suu(f) Syy(f))   (coherence, 1 where y is all linear response to u)
+// The files are read and the segments transformed on all cores, one FFT per segment for
+// both channels. Files with a different sample period than the first are left out.
+//
+// With slope and inertia in the model file, the rigid-wheel model of estimate.py,
+// angle / input = slope / (J s^2), is listed next to the estimate.
+//
+// Usage: etfe [--data ../experiment_data.csv[,more.csv...]] [--input Input] [--output Angle]
+//             [--segment 256] [--overlap 0.5] [--window hann|hamming|rect]
+//             [--model ../model_parameters.json] [--min-coherence 0.8] [--threads 0 (all cores)]
+//             [--csv etfe.csv]
+
+#include <CsvTable.h>
+#include <Fft.h>
+#include <ModelFile.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Sample periods closer than this count as the same
+const double periodTolerance = 0.01;
+// Rows in the printed summary, log spaced
+const unsigned int summaryRows = 12;
+
+typedef std::complex<double> Complex;
+
+typedef struct {
+    std::string dataPaths = "../experiment_data.csv";
+    std::string input = "Input";
+    std::string output = "Angle";
+    std::string window = "hann";
+    std::string modelPath = "../model_parameters.json";
+    std::string csvPath = "etfe.csv";
+    unsigned int segment = 256;
+    double overlap = 0.5;
+    double minCoherence = 0.8;
+    unsigned int threads = 0;
+} Options;
+
+typedef struct {
+    std::string path;
+    std::vector<double> input;
+    std::vector<double> output;
+} Capture;
+
+typedef struct {
+    size_t capture;
+    size_t start;
+} Segment;
+
+// Averaged spectra, bins 0 to segment / 2
+typedef struct {
+    std::vector<double> suu;
+    std::vector<double> syy;
+    std::vector<Complex> syu;
+} Spectra;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--data") {
+            options.dataPaths = value;
+        } else if (flag == "--input") {
+            options.input = value;
+        } else if (flag == "--output") {
+            options.output = value;
+        } else if (flag == "--window") {
+            options.window = value;
+        } else if (flag == "--model") {
+            options.modelPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--segment") {
+            options.segment = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--overlap") {
+            options.overlap = std::strtod(value, nullptr);
+        } else if (flag == "--min-coherence") {
+            options.minCoherence = std::strtod(value, nullptr);
+        } else if (flag == "--threads") {
+            options.threads = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && Fft::isPowerOfTwo(options.segment) && options.segment >= 16 && options.overlap >= 0.0
+        && options.overlap < 1.0 && (options.window == "hann" || options.window == "hamming" || options.window == "rect");
+}
+
+std::vector<std::string> splitPaths(const std::string& list)
+{
+    std::vector<std::string> paths;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        if (end > start) {
+            paths.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return paths;
+}
+
+// Periodic windows, as scipy.signal.get_window makes them for spectral analysis
+std::vector<double> makeWindow(const std::string& name, size_t length)
+{
+    std::vector<double> window(length, 1.0);
+    for (size_t n = 0; n < length; n++) {
+        double phase = 2.0 * M_PI * n / length;
+        if (name == "hann") {
+            window[n] = 0.5 - 0.5 * std::cos(phase);
+        } else if (name == "hamming") {
+            window[n] = 0.54 - 0.46 * std::cos(phase);
+        }
+    }
+    return window;
+}
+
+// Least-squares line removed in place
+void detrend(double* values, size_t length)
+{
+    double meanT = 0.5 * (length - 1), mean = 0.0;
+    for (size_t n = 0; n < length; n++) {
+        mean += values[n] / length;
+    }
+    double covariance = 0.0, variance = 0.0;
+    for (size_t n = 0; n < length; n++) {
+        covariance += (n - meanT) * (values[n] - mean);
+        variance += (n - meanT) * (n - meanT);
+    }
+    double slope = covariance / variance;
+    for (size_t n = 0; n < length; n++) {
+        values[n] -= mean + slope * (n - meanT);
+    }
+}
+
+Spectra averageSpectra(const std::vector<Capture>& captures, const std::vector<Segment>& segments, const Fft& fft,
+    const std::vector<double>& window, unsigned int threads)
+{
+    const size_t length = fft.size(), bins = length / 2 + 1;
+    std::vector<Spectra> partial(threads);
+
+    parallelFor(threads, segments.size(), [&](unsigned int t, size_t begin, size_t end) {
+        Spectra& sums = partial[t];
+        sums.suu.assign(bins, 0.0);
+        sums.syy.assign(bins, 0.0);
+        sums.syu.assign(bins, Complex(0.0, 0.0));
+        std::vector<double> u(length), y(length);
+        std::vector<Complex> uSpectrum(bins), ySpectrum(bins), scratch;
+
+        for (size_t s = begin; s < end; s++) {
+            const Capture& capture = captures[segments[s].capture];
+            size_t start = segments[s].start;
+            std::copy(&capture.input[start], &capture.input[start] + length, u.begin());
+            std::copy(&capture.output[start], &capture.output[start] + length, y.begin());
+            detrend(u.data(), length);
+            detrend(y.data(), length);
+            for (size_t n = 0; n < length; n++) {
+                u[n] *= window[n];
+                y[n] *= window[n];
+            }
+
+            fft.transformPair(u.data(), y.data(), uSpectrum.data(), ySpectrum.data(), scratch);
+            for (size_t k = 0; k < bins; k++) {
+                sums.suu[k] += std::norm(uSpectrum[k]);
+                sums.syy[k] += std::norm(ySpectrum[k]);
+                sums.syu[k] += ySpectrum[k] * std::conj(uSpectrum[k]);
+            }
+        }
+    });
+
+    Spectra total = partial[0];
+    for (unsigned int t = 1; t < threads; t++) {
+        for (size_t k = 0; k < bins; k++) {
+            total.suu[k] += partial[t].suu[k];
+            total.syy[k] += partial[t].syy[k];
+            total.syu[k] += partial[t].syu[k];
+        }
+    }
+    return total;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--data file[,file...]] [--input column] [--output column] [--segment power of 2] "
+            "[--overlap 0-1] [--window hann|hamming|rect] [--model file] [--min-coherence 0-1] [--threads n] [--csv file]\n",
+            argv[0]);
+        return 1;
+    }
+    unsigned int threads = threadCount(options.threads);
+    const size_t length = options.segment, bins = length / 2 + 1;
+
+    std::printf("--- Empirical Transfer Function (Welch) ---\n");
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Capture> captures;
+    double dt = 0.0;
+    size_t samples = 0;
+    std::vector<std::string> paths = splitPaths(options.dataPaths);
+    std::vector<CsvTable> runs(paths.size());
+    std::vector<char> loaded(paths.size(), 0);
+    parallelFor(std::min<unsigned int>(threads, paths.size()), paths.size(), [&](unsigned int, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            loaded[i] = runs[i].load(paths[i]);
+        }
+    });
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        const std::string& path = paths[i];
+        const CsvTable& run = runs[i];
+        if (!loaded[i] || !run.has("Time(s)") || !run.has(options.input) || !run.has(options.output)
+            || run.rows() < length) {
+            std::printf("Skipping %s: no %s and %s columns with at least %zu rows.\n", path.c_str(), options.input.c_str(),
+                options.output.c_str(), length);
+            continue;
+        }
+        const std::vector<double>& time = run.column("Time(s)");
+        double period = (time.back() - time.front()) / (time.size() - 1);
+        if (captures.empty()) {
+            dt = period;
+        } else if (std::fabs(period - dt) > periodTolerance * dt) {
+            std::printf("Skipping %s: %.2f ms period, the first file has %.2f ms.\n", path.c_str(), period * 1000.0, dt * 1000.0);
+            continue;
+        }
+        captures.push_back({ path, run.column(options.input), run.column(options.output) });
+        samples += time.size();
+    }
+    if (captures.empty()) {
+        std::fprintf(stderr, "Error: no usable capture in %s. Run experiment.py first.\n", options.dataPaths.c_str());
+        return 1;
+    }
+
+    size_t step = std::max<size_t>(1, static_cast<size_t>(length * (1.0 - options.overlap)));
+    std::vector<Segment> segments;
+    for (size_t c = 0; c < captures.size(); c++) {
+        for (size_t first = 0; first + length <= captures[c].input.size(); first += step) {
+            segments.push_back({ c, first });
+        }
+    }
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double fs = 1.0 / dt, resolution = fs / length;
+    std::printf("Data: %zu files, %zu samples, %.2f ms period (%.2f s)\n", captures.size(), samples, dt * 1000.0, loadSeconds);
+    std::printf("Welch: %zu segments of %zu (%.0f %% overlap, %s window), %.3f Hz resolution\n", segments.size(), length,
+        options.overlap * 100.0, options.window.c_str(), resolution);
+
+    start = std::chrono::steady_clock::now();
+    Fft fft(length);
+    std::vector<double> window = makeWindow(options.window, length);
+    Spectra spectra = averageSpectra(captures, segments, fft, window, threads);
+    std::printf("Spectra: %u threads (%.3f s)\n", threads,
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    // One-sided input density, to see where the excitation actually put its power
+    double windowPower = 0.0;
+    for (double w : window) {
+        windowPower += w * w;
+    }
+    double densityScale = 2.0 / (fs * windowPower * segments.size());
+
+    ModelFile model;
+    bool haveModel = model.load(options.modelPath) && model.has("slope") && model.has("inertia");
+    double slope = model.number("slope"), inertia = model.number("inertia");
+
+    std::vector<double> magnitude(bins), phase(bins), coherence(bins), modelMagnitude(bins, 0.0);
+    double previous = 0.0;
+    for (size_t k = 1; k < bins; k++) {
+        Complex h = spectra.syu[k] / std::max(spectra.suu[k], 1e-300);
+        magnitude[k] = 20.0 * std::log10(std::max(std::abs(h), 1e-300));
+        double raw = std::arg(h) * 180.0 / M_PI;
+        phase[k] = k == 1 ? raw : raw + 360.0 * std::round((previous - raw) / 360.0);
+        previous = phase[k];
+        coherence[k] = std::norm(spectra.syu[k]) / std::max(spectra.suu[k] * spectra.syy[k], 1e-300);
+        if (haveModel) {
+            double w = 2.0 * M_PI * k * resolution;
+            modelMagnitude[k] = 20.0 * std::log10(std::fabs(slope) / (inertia * w * w));
+        }
+    }
+
+    std::printf("\n--- Results ---\n");
+    std::printf("Frequency (Hz)   Gain (dB)   Phase (deg)   Coherence%s\n", haveModel ? "   Model (dB)" : "");
+    double lowLog = std::log(resolution), highLog = std::log(0.5 * fs);
+    size_t last = 0;
+    for (unsigned int row = 0; row < summaryRows; row++) {
+        double f = std::exp(lowLog + (highLog - lowLog) * row / (summaryRows - 1));
+        size_t k = std::min(bins - 1, std::max<size_t>(1, static_cast<size_t>(std::round(f / resolution))));
+        if (k == last) {
+            continue;
+        }
+        last = k;
+        std::printf("%14.3f   %9.2f   %11.1f   %9.3f", k * resolution, magnitude[k], phase[k], coherence[k]);
+        if (haveModel) {
+            std::printf("   %10.2f", modelMagnitude[k]);
+        }
+        std::printf("\n");
+    }
+
+    size_t coherent = 0;
+    double errorSquares = 0.0;
+    for (size_t k = 1; k < bins; k++) {
+        if (coherence[k] >= options.minCoherence) {
+            coherent++;
+            errorSquares += (magnitude[k] - modelMagnitude[k]) * (magnitude[k] - modelMagnitude[k]);
+        }
+    }
+    std::printf("Coherence >= %.2f in %zu of %zu bins\n", options.minCoherence, coherent, bins - 1);
+    if (haveModel && coherent > 0) {
+        std::printf("Model gain error over those bins: %.2f dB RMS (slope %.4f, J %.4e from %s)\n",
+            std::sqrt(errorSquares / coherent), slope, inertia, options.modelPath.c_str());
+    }
+
+    std::FILE* file = std::fopen(options.csvPath.c_str(), "w");
+    if (file == nullptr) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::fprintf(file, "Frequency(Hz),Gain(dB),Phase(deg),Coherence,InputPSD(1/Hz)%s\n", haveModel ? ",ModelGain(dB)" : "");
+    for (size_t k = 1; k < bins; k++) {
+        std::fprintf(file, "%.6f,%.4f,%.3f,%.5f,%.6e", k * resolution, magnitude[k], phase[k], coherence[k],
+            spectra.suu[k] * densityScale);
+        if (haveModel) {
+            std::fprintf(file, ",%.4f", modelMagnitude[k]);
+        }
+        std::fprintf(file, "\n");
+    }
+    std::fclose(file);
+    std::printf("\nBode data saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
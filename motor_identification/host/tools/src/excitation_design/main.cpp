@@ -0,0 +1,547 @@
+// D-optimal excitation design: picks the motor input sequence that makes the recorded wheel
+// angle most informative about the motor parameters, and exports it as a table the firmware
+// replays (lib/Excitation/ExcitationTable.h, run with excitation = 3).
+//
+// The model is the wheel of lib/Pendulum with the intercept of estimate.py:
+//   J * dw/dt = K * u * max(1 - |w| / w0, 0) - b * w + c
+// with K = slope, c = intercept, b = friction_viscous and w0 the no-load speed, J fixed at
+// the model file inertia. Their sensitivities are integrated next to the state, so the Fisher
+// information of a sequence is one simulation: F = sum of dtheta/dp * dtheta/dp^T / sigma^2
+// over the samples, sigma being the angle noise (encoder quantization by default).
+//
+// The input holds one of --levels values in [-amplitude, amplitude] for --hold samples at a
+// time, consecutive levels at most --max-rate * hold time apart (0: no limit). Coordinate
+// exchange changes one hold at a time to the level that raises log det F most; a change only
+// needs the simulation from that hold on, resumed from the state and information kept at the
+// start of every hold. Several random starts run in parallel, and the best design is compared
+// with the default random steps (input_amplitude 0.25, input_change_time_ms 200) over the
+// same duration.
+//
+// The first and last hold are fixed at rest (input 0), and the steps into and out of them
+// obey the rate limit like any other. The table records the sample period it was designed
+// for; the firmware refuses a designed run at any other sample_period_ms.
+//
+// Usage: excitation_design [--model ../model_parameters.json]
+//                          [--header ../../controller/experiment_and_validation/lib/Excitation/ExcitationTable.h]
+//                          [--samples 4096] [--sample-period-ms 10] [--hold 10] [--amplitude 0.25]
+//                          [--max-rate 0] [--levels 9] [--no-load-speed 400] [--noise 0.0045]
+//                          [--starts 4] [--sweeps 20] [--threads 0 (all cores)] [--seed 1]
+//                          [--csv excitation_design.csv]
+
+#include <ModelFile.h>
+#include <Parallel.h>
+#include <Pendulum.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const unsigned int parameterCount = 4;
+const char* const parameterNames[parameterCount] = { "slope", "intercept", "friction_viscous", "no_load_speed" };
+
+// Speed, angle, then the sensitivities of each to every parameter
+const unsigned int stateSize = 2 + 2 * parameterCount;
+const unsigned int SPEED = 0;
+const unsigned int ANGLE = 1;
+const unsigned int SPEED_SENS = 2;
+const unsigned int ANGLE_SENS = 2 + parameterCount;
+
+// Default random steps of the motor test (Params.cpp)
+const double baselineAmplitude = 0.25;
+const double baselineChangeMs = 200.0;
+const unsigned int baselineRuns = 16;
+
+// The exchange stops when a sweep adds less than this to log det F (1 % to det F)
+const double sweepGain = 0.01;
+
+typedef struct {
+    std::string modelPath = "../model_parameters.json";
+    std::string headerPath = "../../controller/experiment_and_validation/lib/Excitation/ExcitationTable.h";
+    std::string csvPath = "excitation_design.csv";
+    unsigned int samples = 4096;
+    unsigned int samplePeriodMs = 10; // Whole milliseconds, like the firmware parameter
+    unsigned int hold = 10;
+    double amplitude = 0.25;
+    double maxRate = 0.0; // input units per second
+    unsigned int levels = 9;
+    double noLoadSpeed = PendulumParams().noLoadSpeed;
+    double noise = 2.0 * M_PI / 400.0 / std::sqrt(12.0); // rad, quantization of a 400-count encoder
+    unsigned int starts = 4;
+    unsigned int sweeps = 20;
+    unsigned int threads = 0;
+    unsigned int seed = 1;
+} Options;
+
+typedef struct {
+    double inertia;
+    double nominal[parameterCount];
+    // Sensitivities are taken against p / scale, which keeps F well conditioned
+    double scale[parameterCount];
+} Motor;
+
+typedef struct {
+    double f[parameterCount][parameterCount];
+} Information;
+
+// Simulation state at the start of a hold, with the information gathered before it
+typedef struct {
+    double state[stateSize];
+    Information information;
+} Checkpoint;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--model") {
+            options.modelPath = value;
+        } else if (flag == "--header") {
+            options.headerPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--samples") {
+            options.samples = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--sample-period-ms") {
+            options.samplePeriodMs = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--hold") {
+            options.hold = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--amplitude") {
+            options.amplitude = std::strtod(value, nullptr);
+        } else if (flag == "--max-rate") {
+            options.maxRate = std::strtod(value, nullptr);
+        } else if (flag == "--levels") {
+            options.levels = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--no-load-speed") {
+            options.noLoadSpeed = std::strtod(value, nullptr);
+        } else if (flag == "--noise") {
+            options.noise = std::strtod(value, nullptr);
+        } else if (flag == "--starts") {
+            options.starts = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--sweeps") {
+            options.sweeps = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--threads") {
+            options.threads = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--seed") {
+            options.seed = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.samples > options.hold && options.samplePeriodMs > 0 && options.hold > 0
+        && options.amplitude > 0.0 && options.amplitude <= 1.0 && options.maxRate >= 0.0 && options.levels >= 2
+        && options.noLoadSpeed > 0.0 && options.noise > 0.0 && options.starts > 0;
+}
+
+void derivative(const Motor& motor, const double x[stateSize], double input, double dx[stateSize])
+{
+    const double gain = motor.nominal[0], offset = motor.nominal[1], viscous = motor.nominal[2], noLoad = motor.nominal[3];
+    double speed = x[SPEED];
+    double available = 1.0 - std::fabs(speed) / noLoad;
+    bool driving = available > 0.0;
+    available = driving ? available : 0.0;
+
+    dx[SPEED] = (gain * input * available - viscous * speed + offset) / motor.inertia;
+    dx[ANGLE] = speed;
+
+    // d/dt dw/dp = df/dw * dw/dp + df/dp
+    double slope = ((driving ? -gain * input * (speed > 0.0 ? 1.0 : -1.0) / noLoad : 0.0) - viscous) / motor.inertia;
+    const double direct[parameterCount] = { input * available, 1.0, -speed,
+        driving ? gain * input * std::fabs(speed) / (noLoad * noLoad) : 0.0 };
+    for (unsigned int i = 0; i < parameterCount; i++) {
+        dx[SPEED_SENS + i] = slope * x[SPEED_SENS + i] + direct[i] * motor.scale[i] / motor.inertia;
+        dx[ANGLE_SENS + i] = x[SPEED_SENS + i];
+    }
+}
+
+void rk4(const Motor& motor, double x[stateSize], double input, double dt)
+{
+    double k1[stateSize], k2[stateSize], k3[stateSize], k4[stateSize], temp[stateSize];
+    derivative(motor, x, input, k1);
+    for (unsigned int i = 0; i < stateSize; i++) {
+        temp[i] = x[i] + 0.5 * dt * k1[i];
+    }
+    derivative(motor, temp, input, k2);
+    for (unsigned int i = 0; i < stateSize; i++) {
+        temp[i] = x[i] + 0.5 * dt * k2[i];
+    }
+    derivative(motor, temp, input, k3);
+    for (unsigned int i = 0; i < stateSize; i++) {
+        temp[i] = x[i] + dt * k3[i];
+    }
+    derivative(motor, temp, input, k4);
+    for (unsigned int i = 0; i < stateSize; i++) {
+        x[i] += dt / 6.0 * (k1[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]);
+    }
+}
+
+// log det by Cholesky; -infinity when F is singular
+double logDet(const Information& information)
+{
+    double l[parameterCount][parameterCount] = {};
+    double result = 0.0;
+    for (unsigned int j = 0; j < parameterCount; j++) {
+        double diagonal = information.f[j][j];
+        for (unsigned int k = 0; k < j; k++) {
+            diagonal -= l[j][k] * l[j][k];
+        }
+        if (!(diagonal > 0.0)) {
+            return -std::numeric_limits<double>::infinity();
+        }
+        l[j][j] = std::sqrt(diagonal);
+        result += 2.0 * std::log(l[j][j]);
+        for (unsigned int i = j + 1; i < parameterCount; i++) {
+            double sum = information.f[i][j];
+            for (unsigned int k = 0; k < j; k++) {
+                sum -= l[i][k] * l[j][k];
+            }
+            l[i][j] = sum / l[j][j];
+        }
+    }
+    return result;
+}
+
+// Cramer-Rao bounds: square roots of the diagonal of F^-1, back in parameter units
+bool standardDeviations(const Motor& motor, const Information& information, double deviations[parameterCount])
+{
+    double a[parameterCount][2 * parameterCount] = {};
+    for (unsigned int i = 0; i < parameterCount; i++) {
+        for (unsigned int j = 0; j < parameterCount; j++) {
+            a[i][j] = information.f[i][j];
+        }
+        a[i][parameterCount + i] = 1.0;
+    }
+    for (unsigned int col = 0; col < parameterCount; col++) {
+        unsigned int pivot = col;
+        for (unsigned int row = col + 1; row < parameterCount; row++) {
+            if (std::fabs(a[row][col]) > std::fabs(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (a[pivot][col] == 0.0) {
+            return false;
+        }
+        std::swap(a[pivot], a[col]);
+        for (unsigned int row = 0; row < parameterCount; row++) {
+            if (row != col) {
+                double factor = a[row][col] / a[col][col];
+                for (unsigned int k = col; k < 2 * parameterCount; k++) {
+                    a[row][k] -= factor * a[col][k];
+                }
+            }
+        }
+    }
+    for (unsigned int i = 0; i < parameterCount; i++) {
+        deviations[i] = std::sqrt(std::max(a[i][parameterCount + i] / a[i][i], 0.0)) * motor.scale[i];
+    }
+    return true;
+}
+
+// Runs the sequence from the start of hold `from` to the end. Interval k, from sample k to
+// k + 1, has the level of hold k / hold. With store, the checkpoints of the later holds are
+// brought up to date for the new levels.
+Information simulate(const Motor& motor, const Options& options, const std::vector<double>& levels, unsigned int from,
+    std::vector<Checkpoint>& checkpoints, bool store, double* peakSpeed = nullptr)
+{
+    const double dt = options.samplePeriodMs * 1e-3;
+    const double weight = 1.0 / (options.noise * options.noise);
+    Checkpoint point = checkpoints[from];
+    double input = 0.0;
+    for (unsigned int k = from * options.hold; k + 1 < options.samples; k++) {
+        if (k % options.hold == 0) {
+            if (store) {
+                checkpoints[k / options.hold] = point;
+            }
+            input = levels[k / options.hold];
+        }
+        rk4(motor, point.state, input, dt);
+
+        const double* sens = &point.state[ANGLE_SENS];
+        for (unsigned int i = 0; i < parameterCount; i++) {
+            for (unsigned int j = 0; j <= i; j++) {
+                point.information.f[i][j] += weight * sens[i] * sens[j];
+            }
+        }
+        if (peakSpeed != nullptr) {
+            *peakSpeed = std::max(*peakSpeed, std::fabs(point.state[SPEED]));
+        }
+    }
+    for (unsigned int i = 0; i < parameterCount; i++) {
+        for (unsigned int j = i + 1; j < parameterCount; j++) {
+            point.information.f[i][j] = point.information.f[j][i];
+        }
+    }
+    return point.information;
+}
+
+typedef struct {
+    std::vector<double> levels;
+    double logDet = -std::numeric_limits<double>::infinity();
+    unsigned int sweeps = 0;
+} Design;
+
+// Coordinate exchange from a random sequence that meets the rate limit, until a sweep
+// over all holds no longer pays off
+Design optimize(const Motor& motor, const Options& options, const std::vector<double>& grid, double maxChange, size_t start)
+{
+    const size_t holds = (options.samples - 1 + options.hold - 1) / options.hold;
+    std::seed_seq seed = { static_cast<size_t>(options.seed), start };
+    std::mt19937_64 generator(seed);
+
+    // Holds 0 and holds - 1 stay at rest, only the ones between are free
+    auto allowed = [&](const std::vector<double>& levels, size_t j, double level) {
+        return std::fabs(level - levels[j - 1]) <= maxChange && std::fabs(levels[j + 1] - level) <= maxChange;
+    };
+
+    // Random start: hold j may sit at most (holds - 1 - j) changes from zero, so that the
+    // last hold can still be at rest
+    Design design;
+    design.levels.assign(holds, 0.0);
+    for (size_t j = 1; j + 1 < holds; j++) {
+        std::vector<double> choices;
+        for (double level : grid) {
+            if (std::fabs(level - design.levels[j - 1]) <= maxChange && std::fabs(level) <= (holds - 1 - j) * maxChange) {
+                choices.push_back(level);
+            }
+        }
+        design.levels[j] = choices[std::uniform_int_distribution<size_t>(0, choices.size() - 1)(generator)];
+    }
+
+    std::vector<Checkpoint> checkpoints(holds, Checkpoint{});
+    design.logDet = logDet(simulate(motor, options, design.levels, 0, checkpoints, true));
+    for (design.sweeps = 1; design.sweeps <= options.sweeps; design.sweeps++) {
+        double before = design.logDet;
+        for (size_t j = 1; j + 1 < holds; j++) {
+            double current = design.levels[j], best = current;
+            for (double level : grid) {
+                if (level == current || !allowed(design.levels, j, level)) {
+                    continue;
+                }
+                design.levels[j] = level;
+                double value = logDet(simulate(motor, options, design.levels, j, checkpoints, false));
+                if (value > design.logDet + 1e-9) {
+                    design.logDet = value;
+                    best = level;
+                }
+            }
+            design.levels[j] = best;
+            if (best != current) {
+                simulate(motor, options, design.levels, j, checkpoints, true);
+            }
+        }
+        if (design.logDet - before < sweepGain) {
+            break;
+        }
+    }
+    return design;
+}
+
+std::string cFloat(double value)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    std::string result = text;
+    if (result.find_first_of(".e") == std::string::npos) {
+        result += ".0";
+    }
+    return result + "f";
+}
+
+// Same layout as FrictionTable.h
+bool writeHeader(const std::string& path, const Options& options, const Design& design)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "// Generated by motor_identification/host/tools excitation_design. Do not edit.\n");
+    std::fprintf(file, "// D-optimal for sample_period_ms = %u, %u samples, log det F = %.3f\n", options.samplePeriodMs,
+        options.samples, design.logDet);
+    std::fprintf(file, "#ifndef EXCITATION_TABLE_H\n#define EXCITATION_TABLE_H\n\n");
+    std::fprintf(file, "constexpr unsigned int EXCITATION_TABLE_LENGTH = %zu;\n", design.levels.size());
+    std::fprintf(file, "constexpr unsigned int EXCITATION_TABLE_HOLD_SAMPLES = %u;\n", options.hold);
+    std::fprintf(file, "constexpr unsigned int EXCITATION_TABLE_SAMPLE_PERIOD_MS = %u;\n\n", options.samplePeriodMs);
+    std::fprintf(file, "// Motor input per hold of EXCITATION_TABLE_HOLD_SAMPLES samples\n");
+    std::fprintf(file, "constexpr float EXCITATION_TABLE[EXCITATION_TABLE_LENGTH] = {\n");
+    for (size_t i = 0; i < design.levels.size(); i++) {
+        std::fprintf(file, "%s%s,%s", i % 8 == 0 ? "    " : " ", cFloat(design.levels[i]).c_str(),
+            i % 8 == 7 || i + 1 == design.levels.size() ? "\n" : "");
+    }
+    std::fprintf(file, "};\n\n#endif // EXCITATION_TABLE_H\n");
+    std::fclose(file);
+    return true;
+}
+
+// The designed run as the firmware would record it, with the simulated wheel
+bool writeCsv(const std::string& path, const Motor& motor, const Options& options, const std::vector<double>& levels)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "time,input,speed,angle\n");
+    double state[stateSize] = {};
+    double input = 0.0;
+    for (unsigned int n = 0; n < options.samples; n++) {
+        std::fprintf(file, "%.3f,%.4f,%.4f,%.5f\n", n * options.samplePeriodMs * 1e-3, input, state[SPEED], state[ANGLE]);
+        input = n / options.hold < levels.size() ? levels[n / options.hold] : 0.0;
+        rk4(motor, state, input, options.samplePeriodMs * 1e-3);
+    }
+    std::fclose(file);
+    return true;
+}
+
+void printDeviations(const char* name, const Motor& motor, const Information& information)
+{
+    double deviations[parameterCount];
+    if (!standardDeviations(motor, information, deviations)) {
+        std::printf("%-22s (not identifiable)\n", name);
+        return;
+    }
+    std::printf("%-22s", name);
+    for (unsigned int i = 0; i < parameterCount; i++) {
+        std::printf("  %.3e", deviations[i]);
+    }
+    std::printf("  %9.2f\n", logDet(information));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--model file] [--header file] [--samples n] [--sample-period-ms ms] [--hold samples] "
+            "[--amplitude u] [--max-rate u/s] [--levels n] [--no-load-speed rad/s] [--noise rad] [--starts n] [--sweeps n] "
+            "[--threads n] [--seed n] [--csv file]\n", argv[0]);
+        return 1;
+    }
+    unsigned int threads = threadCount(options.threads);
+
+    std::printf("--- Excitation Design ---\n");
+
+    ModelFile model;
+    if (!model.load(options.modelPath) || !model.has("slope") || !model.has("inertia")) {
+        std::fprintf(stderr, "Error: %s has no slope and inertia. Run estimate.py first.\n", options.modelPath.c_str());
+        return 1;
+    }
+    Motor motor;
+    motor.inertia = model.number("inertia");
+    motor.nominal[0] = model.number("slope");
+    motor.nominal[1] = model.number("intercept");
+    motor.nominal[2] = model.number("friction_viscous", PendulumParams().wheelFriction);
+    motor.nominal[3] = options.noLoadSpeed;
+    for (unsigned int i = 0; i < parameterCount; i++) {
+        // The intercept may be zero: scale it by the torque at 1 % input instead
+        motor.scale[i] = motor.nominal[i] != 0.0 ? std::fabs(motor.nominal[i]) : 0.01 * motor.nominal[0];
+    }
+    std::printf("Model: K = %.4e N*m, c = %+.4e N*m, b = %.4e N*m*s/rad, w0 = %.1f rad/s, J = %.4e kg*m^2\n",
+        motor.nominal[0], motor.nominal[1], motor.nominal[2], motor.nominal[3], motor.inertia);
+
+    std::vector<double> grid(options.levels);
+    for (unsigned int i = 0; i < options.levels; i++) {
+        grid[i] = options.amplitude * (2.0 * i / (options.levels - 1) - 1.0);
+    }
+    double holdSec = options.hold * options.samplePeriodMs * 1e-3;
+    double maxChange = options.maxRate > 0.0 ? options.maxRate * holdSec : 2.0 * options.amplitude;
+    // Whole level steps, so that every hold can still get back to rest in time
+    double spacing = grid[1] - grid[0];
+    maxChange = std::floor(maxChange / spacing + 1e-6) * spacing;
+    if (maxChange < spacing) {
+        std::fprintf(stderr, "Error: --max-rate allows no change between neighbouring levels; raise it or --levels.\n");
+        return 1;
+    }
+    maxChange += 1e-9 * spacing;
+    size_t holds = (options.samples - 1 + options.hold - 1) / options.hold;
+    if (holds < 3) {
+        std::fprintf(stderr, "Error: the run needs at least one hold between the two at rest; raise --samples or lower --hold.\n");
+        return 1;
+    }
+    std::printf("Design: %zu holds of %.3f s over %.2f s, %u levels in +/- %.3f, max change %.3f per hold\n", holds, holdSec,
+        (options.samples - 1) * options.samplePeriodMs * 1e-3, options.levels, options.amplitude, maxChange);
+    std::printf("Starts: %u on %u threads\n", options.starts, threads);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Design> designs(options.starts);
+    parallelTasks(threads, options.starts, [&](size_t index) { designs[index] = optimize(motor, options, grid, maxChange, index); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const Design* best = &designs[0];
+    for (const Design& design : designs) {
+        std::printf("  start: log det F = %9.3f after %u sweeps\n", design.logDet, design.sweeps);
+        if (design.logDet > best->logDet) {
+            best = &design;
+        }
+    }
+    std::printf("Optimized in %.2f s\n", seconds);
+
+    // The default random steps, averaged over a few realisations, for comparison
+    Options baseline = options;
+    baseline.hold = std::max(1u, static_cast<unsigned int>(std::lround(baselineChangeMs / options.samplePeriodMs)));
+    size_t baselineHolds = (options.samples - 1 + baseline.hold - 1) / baseline.hold;
+    Information expected = {};
+    std::mt19937_64 generator(options.seed);
+    std::uniform_real_distribution<double> uniform(-baselineAmplitude, baselineAmplitude);
+    for (unsigned int run = 0; run < baselineRuns; run++) {
+        std::vector<double> levels(baselineHolds);
+        for (double& level : levels) {
+            level = uniform(generator);
+        }
+        std::vector<Checkpoint> checkpoints(baselineHolds, Checkpoint{});
+        Information information = simulate(motor, baseline, levels, 0, checkpoints, false);
+        for (unsigned int i = 0; i < parameterCount; i++) {
+            for (unsigned int j = 0; j < parameterCount; j++) {
+                expected.f[i][j] += information.f[i][j] / baselineRuns;
+            }
+        }
+    }
+
+    std::vector<Checkpoint> checkpoints(holds, Checkpoint{});
+    double peakSpeed = 0.0;
+    Information designed = simulate(motor, options, best->levels, 0, checkpoints, true, &peakSpeed);
+
+    std::printf("\n--- Results ---\n");
+    std::printf("Predicted standard deviations (Cramer-Rao bound, noise %.2e rad):\n", options.noise);
+    std::printf("%-22s", "");
+    for (const char* name : parameterNames) {
+        std::printf("  %-9s", std::string(name).substr(0, 9).c_str());
+    }
+    std::printf("  log det F\n");
+    printDeviations("Designed", motor, designed);
+    printDeviations("Random steps (default)", motor, expected);
+
+    // How soon the designed run holds as much information as the whole default run
+    double baselineLogDet = logDet(expected);
+    for (size_t j = 1; j <= holds; j++) {
+        const Information& prefix = j < holds ? checkpoints[j].information : designed;
+        double value = logDet(prefix);
+        if (value >= baselineLogDet) {
+            std::printf("The designed input matches the information of the full default run after %.2f s (%.0f %% of it)\n",
+                std::min<double>(j * options.hold, options.samples - 1) * options.samplePeriodMs * 1e-3,
+                100.0 * std::min<double>(j * options.hold, options.samples - 1) / (options.samples - 1));
+            break;
+        }
+    }
+    std::printf("Peak wheel speed of the designed run: %.1f rad/s\n", peakSpeed);
+
+    if (!writeHeader(options.headerPath, options, *best)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.headerPath.c_str());
+        return 1;
+    }
+    if (!writeCsv(options.csvPath, motor, options, best->levels)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("\nFirmware table written to %s (run with excitation = 3, sample_period_ms = %u)\n", options.headerPath.c_str(),
+        options.samplePeriodMs);
+    std::printf("Simulated run saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
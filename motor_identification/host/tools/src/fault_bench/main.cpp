@@ -0,0 +1,487 @@
+// Protocol recovery benchmark: drives a device through an in-process fault-injecting link
+// (see FaultChannel.h) and measures, for each error rate, how command throughput and the
+// time to get back in sync degrade, and what the CRC-checked chunked download of the test
+// data still achieves.
+//
+// The device must be idle after a finished run (e.g. after experiment.py, or the native
+// build driven by any host script): from then on it only services commands, so corrupted
+// bytes can never start the motor, and the test data is there to be downloaded.
+//
+// Usage: fault_bench <port> [--kind all|drop|dup|flip|reorder] [--rates 0,1e-5,1e-4,1e-3,1e-2]
+//                    [--exchanges 300] [--budget 20] [--seed 1] [--csv fault_bench.csv]
+
+#include <FaultChannel.h>
+#include <SerialPort.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// --- Protocol Definitions (Must match Comms.h) ---
+const uint8_t HOST_PING = 0x16;
+const uint8_t DEVICE_PING = 0x17;
+const uint8_t HOST_ECHO = 0x18;
+const uint8_t DEVICE_ECHO = 0x19;
+const uint8_t HOST_READ_CHUNK = 0x24;
+const uint8_t DEVICE_CHUNK = 0x25;
+const uint16_t maxChunkSize = 1024;
+const uint16_t minChunkSize = 16;
+
+const uint32_t testDataSize = 4096 * 12; // sizeof(TestData) in main.cpp
+const unsigned int baudRate = 115200;
+const size_t echoPayloadSize = 64;
+const unsigned int bitsPerByte = 10; // 8N1
+const long replyTimeoutUs = 50000;   // Turnaround allowance on top of the time on the wire
+const long quietUs = 20000;
+const unsigned int maxChunkAttempts = 50;
+
+typedef struct {
+    std::string port;
+    std::string kind = "all";
+    std::vector<double> rates = { 0.0, 1e-5, 1e-4, 1e-3, 1e-2 };
+    unsigned int exchanges = 300;
+    double budgetSec = 20.0;
+    uint32_t seed = 1;
+    std::string csvPath = "fault_bench.csv";
+} Options;
+
+typedef struct {
+    double rate;
+    unsigned int exchanges;
+    unsigned int failed;
+    double exchangesPerSec;
+    std::vector<double> recoveryMs;
+    double downloadBytesPerSec;
+    unsigned int chunkRetries;
+    uint32_t downloaded;
+    bool downloadComplete;
+    bool downloadMatches; // Over the part that was downloaded
+    FaultStats up;
+    FaultStats down;
+} RateResult;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    if (argc < 2) {
+        return false;
+    }
+    options.port = argv[1];
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--kind") {
+            options.kind = value;
+        } else if (flag == "--rates") {
+            options.rates.clear();
+            for (char* end = const_cast<char*>(value); *end != '\0';) {
+                options.rates.push_back(std::strtod(end, &end));
+                if (*end == ',') {
+                    end++;
+                }
+            }
+        } else if (flag == "--exchanges") {
+            options.exchanges = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--budget") {
+            options.budgetSec = std::strtod(value, nullptr);
+        } else if (flag == "--seed") {
+            options.seed = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 0 && !options.rates.empty();
+}
+
+bool faultsFor(const std::string& kind, double rate, FaultConfig& config)
+{
+    config = FaultConfig();
+    bool all = kind == "all";
+    if (all || kind == "drop") {
+        config.dropRate = rate;
+    }
+    if (all || kind == "dup") {
+        config.duplicateRate = rate;
+    }
+    if (all || kind == "flip") {
+        config.bitFlipRate = rate;
+    }
+    if (all || kind == "reorder") {
+        config.reorderRate = rate;
+    }
+    return all || kind == "drop" || kind == "dup" || kind == "flip" || kind == "reorder";
+}
+
+// A lost byte costs a full timeout, so it is kept as short as the reply allows
+long replyTimeout(size_t length)
+{
+    return replyTimeoutUs + static_cast<long>(2e6 * length * bitsPerByte / baudRate);
+}
+
+uint16_t crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF)
+{
+    // CRC-16/CCITT, must match transportCrc16 in Transport.cpp
+    for (size_t i = 0; i < length; i++) {
+        crc ^= static_cast<uint16_t>(data[i]) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// The serial port with a FaultChannel in each direction. Everything is pumped from the
+// calling thread: bytes move whenever the benchmark waits for a reply.
+class FaultyLink {
+public:
+    FaultyLink(SerialPort& port, uint32_t seed)
+        : port(port)
+        , up(FaultConfig(), seed)
+        , down(FaultConfig(), seed * 2654435761u + 1)
+    {
+    }
+
+    void setFaults(const FaultConfig& config)
+    {
+        up.setConfig(config);
+        down.setConfig(config);
+    }
+
+    const FaultChannel& upChannel() const { return up; }
+    const FaultChannel& downChannel() const { return down; }
+
+    void send(const uint8_t* data, size_t length)
+    {
+        up.push(data, length, monotonicMicros());
+        pump(0);
+    }
+
+    size_t readExact(uint8_t* buffer, size_t length, long timeoutUs)
+    {
+        int64_t deadlineUs = monotonicMicros() + timeoutUs;
+        while (received.size() < length) {
+            int64_t remainingUs = deadlineUs - monotonicMicros();
+            if (remainingUs <= 0) {
+                break;
+            }
+            pump(remainingUs);
+        }
+        size_t count = std::min(length, received.size());
+        std::copy(received.begin(), received.begin() + count, buffer);
+        received.erase(received.begin(), received.begin() + count);
+        return count;
+    }
+
+    // Drops everything until the link has been silent for quietUs, or maxUs passed
+    void discardUntilQuiet(long quietUs, long maxUs)
+    {
+        int64_t startUs = monotonicMicros();
+        int64_t lastByteUs = startUs;
+        while (true) {
+            int64_t nowUs = monotonicMicros();
+            if (nowUs - lastByteUs >= quietUs || nowUs - startUs >= maxUs) {
+                break;
+            }
+            if (!received.empty() || down.inFlight() > 0) {
+                lastByteUs = nowUs;
+            }
+            received.clear();
+            pump(quietUs);
+        }
+        received.clear();
+    }
+
+private:
+    void pump(int64_t waitUs)
+    {
+        uint8_t buffer[4096];
+        int64_t nowUs = monotonicMicros();
+
+        for (int64_t dueUs : { up.nextDueUs(), down.nextDueUs() }) {
+            if (dueUs >= 0) {
+                waitUs = std::min(waitUs, std::max<int64_t>(0, dueUs - nowUs));
+            }
+        }
+
+        long length = port.readSome(buffer, sizeof(buffer), waitUs);
+        nowUs = monotonicMicros();
+        if (length > 0) {
+            down.push(buffer, length, nowUs);
+        }
+
+        size_t count;
+        while ((count = up.pop(buffer, sizeof(buffer), nowUs)) > 0) {
+            port.writeAll(buffer, count);
+        }
+        while ((count = down.pop(buffer, sizeof(buffer), nowUs)) > 0) {
+            received.insert(received.end(), buffer, buffer + count);
+        }
+    }
+
+    SerialPort& port;
+    FaultChannel up;
+    FaultChannel down;
+    std::deque<uint8_t> received;
+};
+
+// Back in sync once a ping is answered by exactly one DEVICE_PING. A request the device is
+// still completing (e.g. an echo short of payload) swallows pings until its read times out.
+bool resync(FaultyLink& link, long maxUs)
+{
+    int64_t deadlineUs = monotonicMicros() + maxUs;
+    while (monotonicMicros() < deadlineUs) {
+        link.discardUntilQuiet(quietUs, maxUs);
+
+        uint8_t code = 0;
+        link.send(&HOST_PING, 1);
+        if (link.readExact(&code, 1, replyTimeout(1)) != 1 || code != DEVICE_PING) {
+            continue;
+        }
+        uint8_t extra;
+        if (link.readExact(&extra, 1, quietUs) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool exchangeEcho(FaultyLink& link, std::mt19937& random)
+{
+    // Payload bytes never look like command codes, so a lost length byte cannot turn
+    // them into parameter writes
+    uint8_t request[2 + echoPayloadSize] = { HOST_ECHO, static_cast<uint8_t>(echoPayloadSize) };
+    for (size_t i = 0; i < echoPayloadSize; i++) {
+        request[2 + i] = static_cast<uint8_t>(0x80 | (random() & 0x7F));
+    }
+    link.send(request, sizeof(request));
+
+    uint8_t reply[sizeof(request)];
+    if (link.readExact(reply, sizeof(reply), replyTimeout(sizeof(reply))) != sizeof(reply)) {
+        return false;
+    }
+    reply[0] ^= DEVICE_ECHO ^ HOST_ECHO;
+    return std::memcmp(reply, request, sizeof(request)) == 0;
+}
+
+// One chunk, verified against its CRC. False on any damage or timeout.
+bool readChunk(FaultyLink& link, uint32_t offset, uint16_t length, uint8_t* data)
+{
+    uint8_t request[1 + 4 + 2] = { HOST_READ_CHUNK };
+    std::memcpy(&request[1], &offset, sizeof(offset));
+    std::memcpy(&request[5], &length, sizeof(length));
+    link.send(request, sizeof(request));
+
+    uint8_t header[1 + 4 + 2];
+    uint8_t crc[2];
+    int64_t deadlineUs = monotonicMicros() + replyTimeout(sizeof(header) + length + sizeof(crc));
+    if (link.readExact(header, sizeof(header), deadlineUs - monotonicMicros()) != sizeof(header)
+        || header[0] != DEVICE_CHUNK || std::memcmp(&header[1], &request[1], 6) != 0) {
+        return false;
+    }
+    if (link.readExact(data, length, deadlineUs - monotonicMicros()) != length
+        || link.readExact(crc, 2, deadlineUs - monotonicMicros()) != 2) {
+        return false;
+    }
+    return crc16(data, length, crc16(&header[1], 6)) == (crc[0] | (crc[1] << 8));
+}
+
+// Returns false when some chunk could not be read within maxChunkAttempts or the deadline;
+// completed then tells how far it got. Chunks shrink
+// after every failure and grow back after every success, so a noisy link still gets
+// chunks through that are short enough to arrive intact.
+bool download(FaultyLink& link, std::vector<uint8_t>& data, uint32_t* completed, unsigned int* retries,
+    int64_t deadlineUs)
+{
+    data.assign(testDataSize, 0);
+    uint16_t chunkSize = maxChunkSize;
+    uint32_t& offset = *completed;
+
+    for (offset = 0; offset < testDataSize;) {
+        unsigned int attempt = 0;
+        while (true) {
+            uint16_t length = std::min<uint32_t>(chunkSize, testDataSize - offset);
+            if (readChunk(link, offset, length, &data[offset])) {
+                offset += length;
+                chunkSize = std::min<uint32_t>(2 * chunkSize, maxChunkSize);
+                break;
+            }
+            if (++attempt >= maxChunkAttempts || monotonicMicros() > deadlineUs) {
+                return false;
+            }
+            (*retries)++;
+            chunkSize = std::max<uint16_t>(chunkSize / 2, minChunkSize);
+            resync(link, 5000000);
+        }
+    }
+    return true;
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+}
+
+RateResult runRate(FaultyLink& link, const Options& options, double rate, const std::vector<uint8_t>& reference,
+    std::mt19937& random)
+{
+    RateResult result = {};
+    result.rate = rate;
+
+    FaultConfig config;
+    faultsFor(options.kind, rate, config);
+    link.setFaults(config);
+    FaultStats upBefore = link.upChannel().stats();
+    FaultStats downBefore = link.downChannel().stats();
+
+    // Command exchanges: a recovery runs from the start of the first failed exchange to the
+    // end of the next good one
+    int64_t startUs = monotonicMicros();
+    int64_t budgetEndUs = startUs + static_cast<int64_t>(options.budgetSec * 1e6);
+    int64_t failedSinceUs = -1;
+
+    while (result.exchanges < options.exchanges && monotonicMicros() < budgetEndUs) {
+        int64_t exchangeStartUs = monotonicMicros();
+        result.exchanges++;
+        if (exchangeEcho(link, random)) {
+            if (failedSinceUs >= 0) {
+                result.recoveryMs.push_back((monotonicMicros() - failedSinceUs) * 1e-3);
+                failedSinceUs = -1;
+            }
+            continue;
+        }
+        result.failed++;
+        if (failedSinceUs < 0) {
+            failedSinceUs = exchangeStartUs;
+        }
+        resync(link, 5000000);
+    }
+    double exchangeSec = (monotonicMicros() - startUs) * 1e-6;
+    result.exchangesPerSec = (result.exchanges - result.failed) / exchangeSec;
+
+    // Chunked download of the test data
+    std::vector<uint8_t> data;
+    startUs = monotonicMicros();
+    result.downloadComplete = download(link, data, &result.downloaded, &result.chunkRetries,
+        startUs + static_cast<int64_t>(options.budgetSec * 1e6));
+    double downloadSec = (monotonicMicros() - startUs) * 1e-6;
+    result.downloadBytesPerSec = result.downloaded / downloadSec;
+    result.downloadMatches = std::equal(data.begin(), data.begin() + result.downloaded, reference.begin());
+
+    const FaultStats& up = link.upChannel().stats();
+    const FaultStats& down = link.downChannel().stats();
+    result.up = up;
+    result.down = down;
+    result.up.bytesIn -= upBefore.bytesIn;
+    result.up.dropped -= upBefore.dropped;
+    result.up.duplicated -= upBefore.duplicated;
+    result.up.flipped -= upBefore.flipped;
+    result.up.reordered -= upBefore.reordered;
+    result.down.bytesIn -= downBefore.bytesIn;
+    result.down.dropped -= downBefore.dropped;
+    result.down.duplicated -= downBefore.duplicated;
+    result.down.flipped -= downBefore.flipped;
+    result.down.reordered -= downBefore.reordered;
+
+    // Leave the link clean and in sync for the next rate
+    link.setFaults(FaultConfig());
+    resync(link, 5000000);
+    return result;
+}
+
+bool writeCsv(const std::string& path, const Options& options, const std::vector<RateResult>& results)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "Kind,Rate,Exchanges,Failed,GoodExchangesPerSec,RecoveryP50(ms),RecoveryP99(ms),RecoveryMax(ms),"
+        "DownloadBytesPerSec,Downloaded,ChunkRetries,DownloadOk,FaultsUp,FaultsDown\n");
+    for (const RateResult& r : results) {
+        std::fprintf(file, "%s,%g,%u,%u,%.1f,%.2f,%.2f,%.2f,%.0f,%u,%u,%d,%llu,%llu\n", options.kind.c_str(), r.rate,
+            r.exchanges, r.failed, r.exchangesPerSec, percentile(r.recoveryMs, 0.5), percentile(r.recoveryMs, 0.99),
+            percentile(r.recoveryMs, 1.0), r.downloadBytesPerSec, r.downloaded, r.chunkRetries,
+            r.downloadComplete && r.downloadMatches ? 1 : 0,
+            static_cast<unsigned long long>(r.up.dropped + r.up.duplicated + r.up.flipped + r.up.reordered),
+            static_cast<unsigned long long>(r.down.dropped + r.down.duplicated + r.down.flipped + r.down.reordered));
+    }
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    FaultConfig probe;
+    if (!parseOptions(argc, argv, options) || !faultsFor(options.kind, 0.0, probe)) {
+        std::fprintf(stderr, "Usage: %s <port> [--kind all|drop|dup|flip|reorder] [--rates a,b,...] "
+            "[--exchanges N] [--budget s] [--seed N] [--csv file]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("--- Fault Recovery Benchmark ---\n");
+
+    SerialPort port;
+    if (!port.open(options.port, baudRate)) {
+        std::fprintf(stderr, "Error: could not open %s: %s\n", options.port.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    FaultyLink link(port, options.seed);
+    std::mt19937 random(options.seed);
+
+    if (!resync(link, 5000000)) {
+        std::fprintf(stderr, "Error: device does not answer pings.\n");
+        return 1;
+    }
+
+    std::vector<uint8_t> reference;
+    uint32_t downloaded = 0;
+    unsigned int retries = 0;
+    if (!download(link, reference, &downloaded, &retries, monotonicMicros() + 10000000) || retries > 0) {
+        std::fprintf(stderr, "Error: clean download failed. Is the device idle after a finished run?\n");
+        return 1;
+    }
+    std::printf("Reference: %u bytes of test data, %s faults, %u exchanges of %zu bytes per rate\n\n", testDataSize,
+        options.kind.c_str(), options.exchanges, echoPayloadSize);
+
+    std::printf("%-8s %9s %8s %10s %10s %10s %10s %12s %8s %6s\n", "Rate", "Exchanges", "Failed", "Good/s",
+        "Rec p50", "Rec p99", "Rec max", "Download", "Retries", "Data");
+    std::printf("%-8s %9s %8s %10s %10s %10s %10s %12s %8s %6s\n", "(/byte)", "", "", "", "(ms)", "(ms)", "(ms)",
+        "(B/s)", "", "");
+
+    std::vector<RateResult> results;
+    for (double rate : options.rates) {
+        RateResult r = runRate(link, options, rate, reference, random);
+        results.push_back(r);
+
+        std::printf("%-8g %9u %8u %10.1f %10.2f %10.2f %10.2f %12.0f %8u %6s\n", r.rate, r.exchanges, r.failed,
+            r.exchangesPerSec, percentile(r.recoveryMs, 0.5), percentile(r.recoveryMs, 0.99),
+            percentile(r.recoveryMs, 1.0), r.downloadBytesPerSec, r.chunkRetries,
+            !r.downloadMatches ? "BAD" : (r.downloadComplete ? "ok" : "partial"));
+        std::fflush(stdout);
+    }
+
+    if (!writeCsv(options.csvPath, options, results)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("\nResults saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
@@ -0,0 +1,251 @@
+// Fault-injecting link: relays between a device port (usually the pty of the native
+// firmware build) and a new pty for the host scripts, dropping, duplicating, corrupting,
+// delaying and reordering bytes on the way. Point experiment.py or any other host tool
+// at the printed path (or at --link) to see how it copes with a noisy cable.
+//
+// Usage: fault_link <device port> [--faults spec] [--up spec] [--down spec] [--seed 1]
+//                   [--baud 115200] [--link /tmp/fault_link]
+//
+// spec: drop=1e-3,dup=0,flip=1e-4,reorder=0,span=2000,delay=0,jitter=0 (rates per byte,
+// times in us). --faults applies to both directions, --up (host to device) and --down
+// (device to host) override it per direction.
+
+#include <FaultChannel.h>
+#include <SerialPort.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t relayChunkSize = 4096;
+
+typedef struct {
+    std::string devicePort;
+    FaultConfig up;
+    FaultConfig down;
+    uint32_t seed = 1;
+    unsigned int baudRate = 115200;
+    std::string linkPath;
+} Options;
+
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int)
+{
+    stopRequested = 1;
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    if (argc < 2) {
+        return false;
+    }
+    options.devicePort = argv[1];
+
+    // --faults first, so --up and --down refine it whatever the order on the command line
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (std::string(argv[i]) == "--faults") {
+            if (!parseFaultSpec(argv[i + 1], options.up) || !parseFaultSpec(argv[i + 1], options.down)) {
+                return false;
+            }
+        }
+    }
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--faults") {
+            continue;
+        } else if (flag == "--up") {
+            if (!parseFaultSpec(value, options.up)) {
+                return false;
+            }
+        } else if (flag == "--down") {
+            if (!parseFaultSpec(value, options.down)) {
+                return false;
+            }
+        } else if (flag == "--seed") {
+            options.seed = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--baud") {
+            options.baudRate = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--link") {
+            options.linkPath = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 0;
+}
+
+// Host side of the relay. The slave end is kept open so the master never reads EIO while
+// no host script has the port open.
+int openHostPty(int* slave, std::string* path)
+{
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        return -1;
+    }
+
+    *path = ptsname(fd);
+    *slave = open(path->c_str(), O_RDWR | O_NOCTTY);
+    if (*slave < 0) {
+        close(fd);
+        return -1;
+    }
+
+    termios options;
+    tcgetattr(*slave, &options);
+    cfmakeraw(&options);
+    tcsetattr(*slave, TCSANOW, &options);
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+bool writeAllFd(int fd, const uint8_t* data, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                return false;
+            }
+            pollfd request = { fd, POLLOUT, 0 };
+            poll(&request, 1, 10);
+            continue;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+void printStats(const char* name, const FaultStats& stats)
+{
+    std::printf("   %-14s %10llu in %10llu out %8llu dropped %8llu duplicated %8llu flipped %8llu reordered\n", name,
+        static_cast<unsigned long long>(stats.bytesIn), static_cast<unsigned long long>(stats.bytesOut),
+        static_cast<unsigned long long>(stats.dropped), static_cast<unsigned long long>(stats.duplicated),
+        static_cast<unsigned long long>(stats.flipped), static_cast<unsigned long long>(stats.reordered));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s <device port> [--faults spec] [--up spec] [--down spec] [--seed N] "
+            "[--baud N] [--link path]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("--- Fault-Injecting Link ---\n");
+
+    SerialPort device;
+    if (!device.open(options.devicePort, options.baudRate)) {
+        std::fprintf(stderr, "Error: could not open %s: %s\n", options.devicePort.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    int hostSlave;
+    std::string hostPath;
+    int host = openHostPty(&hostSlave, &hostPath);
+    if (host < 0) {
+        std::fprintf(stderr, "Error: could not create a pty: %s\n", std::strerror(errno));
+        return 1;
+    }
+    if (!options.linkPath.empty()) {
+        unlink(options.linkPath.c_str());
+        if (symlink(hostPath.c_str(), options.linkPath.c_str()) != 0) {
+            std::fprintf(stderr, "Error: could not link %s: %s\n", options.linkPath.c_str(), std::strerror(errno));
+            return 1;
+        }
+    }
+
+    // Different seeds per direction, so both do not fail on the same byte index
+    FaultChannel up(options.up, options.seed);
+    FaultChannel down(options.down, options.seed * 2654435761u + 1);
+
+    std::printf("Device:  %s\n", options.devicePort.c_str());
+    std::printf("Host:    %s%s%s\n", hostPath.c_str(), options.linkPath.empty() ? "" : " <- ", options.linkPath.c_str());
+    std::printf("Up:      %s\n", describeFaults(options.up).c_str());
+    std::printf("Down:    %s\n", describeFaults(options.down).c_str());
+    std::printf("Relaying, Ctrl+C to stop...\n");
+    std::fflush(stdout);
+
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+
+    uint8_t buffer[relayChunkSize];
+    int64_t lastStatsUs = monotonicMicros();
+
+    while (!stopRequested) {
+        int64_t nowUs = monotonicMicros();
+
+        // Sleep until there is input or the next delayed byte is due
+        int timeoutMs = 100;
+        for (int64_t dueUs : { up.nextDueUs(), down.nextDueUs() }) {
+            if (dueUs >= 0) {
+                timeoutMs = std::min<int64_t>(timeoutMs, std::max<int64_t>(0, (dueUs - nowUs + 999) / 1000));
+            }
+        }
+        pollfd requests[2] = { { host, POLLIN, 0 }, { device.fileDescriptor(), POLLIN, 0 } };
+        poll(requests, 2, timeoutMs);
+        nowUs = monotonicMicros();
+
+        if (requests[0].revents & POLLIN) {
+            ssize_t length = read(host, buffer, sizeof(buffer));
+            if (length > 0) {
+                up.push(buffer, length, nowUs);
+            }
+        }
+        if (requests[1].revents & POLLIN) {
+            long length = device.readSome(buffer, sizeof(buffer), 0);
+            if (length < 0) {
+                std::fprintf(stderr, "Error: device port closed.\n");
+                break;
+            }
+            down.push(buffer, length, nowUs);
+        }
+
+        size_t length;
+        while ((length = up.pop(buffer, sizeof(buffer), nowUs)) > 0) {
+            if (!device.writeAll(buffer, length)) {
+                std::fprintf(stderr, "Error: could not write to the device.\n");
+                stopRequested = 1;
+                break;
+            }
+        }
+        while ((length = down.pop(buffer, sizeof(buffer), nowUs)) > 0) {
+            writeAllFd(host, buffer, length);
+        }
+
+        if (nowUs - lastStatsUs > 10000000) {
+            printStats("host->device", up.stats());
+            printStats("device->host", down.stats());
+            std::fflush(stdout);
+            lastStatsUs = nowUs;
+        }
+    }
+
+    std::printf("\n--- Link Report ---\n");
+    printStats("host->device", up.stats());
+    printStats("device->host", down.stats());
+
+    if (!options.linkPath.empty()) {
+        unlink(options.linkPath.c_str());
+    }
+    close(hostSlave);
+    close(host);
+    return 0;
+}
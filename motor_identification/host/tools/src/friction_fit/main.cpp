@@ -0,0 +1,274 @@
+// Friction fitter: identifies a Coulomb + viscous + Stribeck friction model of the wheel
+// from a motor test run with excitation = 1 (slow ramps and low-speed dwells, see
+// Excitation.h), saves it to the model file and exports a compensation table for the
+// firmware (lib/Friction/FrictionTable.h).
+//
+// The model and its fit are in lib/FrictionModel; J comes from the model file. A fit with a
+// negative friction term leaves both files alone and exits with an error.
+//
+// Usage: friction_fit [--data ../experiment_data.csv] [--model ../model_parameters.json]
+//                     [--header ../../controller/experiment_and_validation/lib/Friction/FrictionTable.h]
+//                     [--min-speed 0.5] [--shape 2] [--window 11] [--points 41] [--csv friction_fit.csv]
+
+#include <CsvTable.h>
+#include <Fitting.h>
+#include <FrictionModel.h>
+#include <ModelFile.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+const unsigned int fitBins = 60;
+
+typedef struct {
+    std::string dataPath = "../experiment_data.csv";
+    std::string modelPath = "../model_parameters.json";
+    std::string headerPath = "../../controller/experiment_and_validation/lib/Friction/FrictionTable.h";
+    std::string csvPath = "friction_fit.csv";
+    double minSpeed = 0.5;  // rad/s, slower samples are left out: the sign of friction is unknown there
+    double shape = 2.0;
+    unsigned int window = 11;
+    unsigned int points = 41;
+} Options;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--data") {
+            options.dataPath = value;
+        } else if (flag == "--model") {
+            options.modelPath = value;
+        } else if (flag == "--header") {
+            options.headerPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--min-speed") {
+            options.minSpeed = std::strtod(value, nullptr);
+        } else if (flag == "--shape") {
+            options.shape = std::strtod(value, nullptr);
+        } else if (flag == "--window") {
+            options.window = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--points") {
+            options.points = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.window >= 5 && options.window % 2 == 1 && options.points >= 3
+        && options.shape > 0.0 && options.minSpeed > 0.0;
+}
+
+std::string cFloat(double value)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.9g", value);
+    std::string result = text;
+    if (result.find_first_of(".e") == std::string::npos) {
+        result += ".0";
+    }
+    return result + "f";
+}
+
+// Same layout as GainTable.h, written by gain_schedule.py
+bool writeHeader(const std::string& path, const FrictionModel& model, double shape, double maxSpeed, unsigned int points)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    double step = 2.0 * maxSpeed / (points - 1);
+    std::fprintf(file, "// Generated by motor_identification/host/tools friction_fit. Do not edit.\n");
+    std::fprintf(file, "// Fc = %.6g N*m, Fs = %.6g N*m, vs = %.6g rad/s, b = %.6g N*m*s/rad, K = %.6g N*m\n",
+        model.coulomb, model.stiction, model.stribeck, model.viscous, model.gain);
+    std::fprintf(file, "#ifndef FRICTION_TABLE_H\n#define FRICTION_TABLE_H\n\n");
+    std::fprintf(file, "constexpr unsigned int FRICTION_SPEED_POINTS = %u;\n\n", points);
+    std::fprintf(file, "constexpr float FRICTION_SPEED_MIN = %s;\n", cFloat(-maxSpeed).c_str());
+    std::fprintf(file, "constexpr float FRICTION_SPEED_MAX = %s;\n", cFloat(maxSpeed).c_str());
+    std::fprintf(file, "constexpr float FRICTION_SPEED_STEP_INV = %s;\n\n", cFloat(1.0 / step).c_str());
+    std::fprintf(file, "// Motor input per wheel speed, from FRICTION_SPEED_MIN to FRICTION_SPEED_MAX\n");
+    std::fprintf(file, "constexpr float FRICTION_TABLE[FRICTION_SPEED_POINTS] = {\n");
+    for (unsigned int i = 0; i < points; i++) {
+        double speed = -maxSpeed + i * step;
+        double input = frictionTorque(model, std::fabs(speed) < 0.5 * step ? 0.0 : speed, shape) / model.gain;
+        std::fprintf(file, "%s%s,%s", i % 8 == 0 ? "    " : " ", cFloat(input).c_str(),
+            i % 8 == 7 || i + 1 == points ? "\n" : "");
+    }
+    std::fprintf(file, "};\n\n#endif // FRICTION_TABLE_H\n");
+    std::fclose(file);
+    return true;
+}
+
+// Measured friction (K * u + c - J * a), averaged per speed bin, next to the model
+bool writeFitCsv(const std::string& path, const FrictionData& data, const FrictionModel& model, double shape, double maxSpeed)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    std::vector<double> sum(fitBins, 0.0);
+    std::vector<size_t> count(fitBins, 0);
+    double width = 2.0 * maxSpeed / fitBins;
+    for (size_t k = 0; k < data.speed.size(); k++) {
+        size_t bin = std::min<size_t>(fitBins - 1, static_cast<size_t>((data.speed[k] + maxSpeed) / width));
+        sum[bin] += model.gain * data.input[k] + model.offset - data.torque[k];
+        count[bin]++;
+    }
+
+    std::fprintf(file, "Speed(rad/s),Samples,MeasuredFriction(N*m),ModelFriction(N*m)\n");
+    for (size_t bin = 0; bin < fitBins; bin++) {
+        if (count[bin] == 0) {
+            continue;
+        }
+        double speed = -maxSpeed + (bin + 0.5) * width;
+        std::fprintf(file, "%.4f,%zu,%.6e,%.6e\n", speed, count[bin], sum[bin] / count[bin], frictionTorque(model, speed, shape));
+    }
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--data file] [--model file] [--header file] [--min-speed rad/s] "
+            "[--shape n] [--window odd n] [--points n] [--csv file]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("--- Friction Fitter ---\n");
+
+    CsvTable run;
+    if (!run.load(options.dataPath) || !run.has("Time(s)") || !run.has("Input") || !run.has("Angle") || run.rows() < 2) {
+        std::fprintf(stderr, "Error: could not read Time(s), Input and Angle from %s. Run experiment.py with "
+            "excitation = 1 first.\n", options.dataPath.c_str());
+        return 1;
+    }
+    const std::vector<double>& time = run.column("Time(s)");
+    const std::vector<double>& input = run.column("Input");
+    const std::vector<double>& angle = run.column("Angle");
+
+    ModelFile model;
+    if (!model.load(options.modelPath) || !model.has("inertia")) {
+        std::fprintf(stderr, "Error: could not read the inertia from %s. Run estimate.py first.\n", options.modelPath.c_str());
+        return 1;
+    }
+    double inertia = model.number("inertia");
+
+    double dt = (time.back() - time.front()) / (time.size() - 1);
+    std::printf("Data: %zu samples, %.1f ms period, from %s\n", time.size(), dt * 1000.0, options.dataPath.c_str());
+    std::printf("Wheel inertia: %.6e kg*m^2\n", inertia);
+
+    // Same smoothing as estimate.py
+    std::vector<double> speeds = savgolFilter(angle, options.window, 3, 1, dt);
+    std::vector<double> accels = savgolFilter(angle, options.window, 3, 2, dt);
+    size_t half = options.window / 2;
+
+    FrictionData data;
+    double maxSpeed = 0.0;
+    for (size_t k = half; k + half < angle.size(); k++) {
+        if (std::fabs(speeds[k]) >= options.minSpeed) {
+            data.input.push_back(input[k]);
+            data.speed.push_back(speeds[k]);
+            data.torque.push_back(inertia * accels[k]);
+            maxSpeed = std::max(maxSpeed, std::fabs(speeds[k]));
+        }
+    }
+    if (data.speed.size() < 50) {
+        std::fprintf(stderr, "Error: only %zu samples above %.2f rad/s. Was the run made with excitation = 1?\n",
+            data.speed.size(), options.minSpeed);
+        return 1;
+    }
+    std::printf("Fit samples: %zu above %.2f rad/s, up to %.1f rad/s\n", data.speed.size(), options.minSpeed, maxSpeed);
+
+    // Reference: the linear model of estimate.py, fitted on the same samples
+    double mean = 0.0, total = 0.0, linearRss = 0.0;
+    for (double torque : data.torque) {
+        mean += torque / data.torque.size();
+    }
+    for (double torque : data.torque) {
+        total += (torque - mean) * (torque - mean);
+    }
+    LeastSquares linear(2);
+    for (size_t k = 0; k < data.speed.size(); k++) {
+        double row[2] = { data.input[k], 1.0 };
+        linear.add(row, data.torque[k]);
+    }
+    std::vector<double> line;
+    if (linear.solve(line)) {
+        for (size_t k = 0; k < data.speed.size(); k++) {
+            double residual = data.torque[k] - line[0] * data.input[k] - line[1];
+            linearRss += residual * residual;
+        }
+    }
+
+    FrictionModel fit = fitFrictionStribeck(data, options.minSpeed, maxSpeed, options.shape);
+    FrictionModel plain = fitFrictionLinear(data, 0.0, options.shape);
+    if (!fit.valid || (plain.valid && plain.rss <= fit.rss)) {
+        std::printf("No Stribeck effect found, fitting Coulomb + viscous only.\n");
+        fit = plain;
+    }
+    if (!fit.valid || fit.gain <= 0.0) {
+        std::fprintf(stderr, "Error: the fit failed (torque gain %.4g). Is the excitation rich enough?\n", fit.gain);
+        return 1;
+    }
+
+    std::printf("\n--- Results ---\n");
+    std::printf("Torque gain K:         %.6f N*m per unit of input (slope in the file: %.6f)\n", fit.gain, model.number("slope"));
+    std::printf("Offset c:              %+.4e N*m\n", fit.offset);
+    std::printf("Coulomb friction Fc:   %.4e N*m (%.4f of input)\n", fit.coulomb, fit.coulomb / fit.gain);
+    std::printf("Static friction Fs:    %.4e N*m (%.4f of input)\n", fit.stiction, fit.stiction / fit.gain);
+    std::printf("Stribeck velocity vs:  %.4f rad/s (shape %.1f)\n", fit.stribeck, options.shape);
+    std::printf("Viscous friction b:    %.4e N*m*s/rad\n", fit.viscous);
+    std::printf("R^2:                   %.4f (linear model without friction: %.4f)\n",
+        total > 0.0 ? 1.0 - fit.rss / total : 0.0, total > 0.0 ? 1.0 - linearRss / total : 0.0);
+
+    // Friction only ever opposes motion: a negative term means the fit explains something else
+    if (fit.coulomb < 0.0 || fit.stiction < 0.0 || fit.viscous < 0.0) {
+        if (writeFitCsv(options.csvPath, data, fit, options.shape, maxSpeed)) {
+            std::printf("Friction curve saved to %s for inspection\n", options.csvPath.c_str());
+        }
+        std::fprintf(stderr, "Error: negative friction terms, the data may not cover enough of the speed range. "
+                             "%s and %s were left unchanged.\n", options.modelPath.c_str(), options.headerPath.c_str());
+        return 1;
+    }
+
+    model.setNumber("friction_torque_gain", fit.gain);
+    model.setNumber("friction_offset", fit.offset);
+    model.setNumber("friction_coulomb", fit.coulomb);
+    model.setNumber("friction_static", fit.stiction);
+    model.setNumber("friction_stribeck_velocity", fit.stribeck);
+    model.setNumber("friction_stribeck_shape", options.shape);
+    model.setNumber("friction_viscous", fit.viscous);
+    if (!model.save(options.modelPath)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.modelPath.c_str());
+        return 1;
+    }
+    std::printf("\nModel saved to %s\n", options.modelPath.c_str());
+
+    // The table covers the speeds that were seen, rounded up to whole rad/s
+    double tableSpeed = std::ceil(maxSpeed);
+    if (!writeHeader(options.headerPath, fit, options.shape, tableSpeed, options.points)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.headerPath.c_str());
+        return 1;
+    }
+    std::printf("Compensation table (%u points, +/- %.0f rad/s) written to %s\n", options.points, tableSpeed, options.headerPath.c_str());
+
+    if (!writeFitCsv(options.csvPath, data, fit, options.shape, maxSpeed)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("Friction curve saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
@@ -0,0 +1,354 @@
+// Hardware-in-the-loop simulator: the firmware controller runs on the device and
+// talks to a simulated pendulum here, one actuator/sensor frame pair per 1 ms tick.
+//
+// Usage: hil_sim <port> [--baud 921600] [--ticks 10000] [--tilt 0.02]
+//                [--model ../model_parameters.json] [--log hil_log.csv]
+
+#include <ModelFile.h>
+#include <Pendulum.h>
+#include <SerialPort.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// --- Protocol Definitions (Must match Comms.h) ---
+const uint8_t HOST_CHECK_CONNECTION = 0x01;
+const uint8_t DEVICE_CHECK_CONNECTION = 0x02;
+const uint8_t DEVICE_ACK_START = 0x04;
+const uint8_t HOST_PARAM_SET = 0x0A;
+const uint8_t DEVICE_PARAM_VALUE = 0x0C;
+const uint8_t HOST_START_HIL = 0x0E;
+const uint8_t DEVICE_HIL_ACTUATOR = 0x0F;
+const uint8_t HOST_HIL_SENSOR = 0x10;
+const uint8_t DEVICE_HIL_REPORT = 0x11;
+const uint8_t HOST_GET_CAPABILITIES = 0x28;
+const uint8_t DEVICE_CAPABILITIES = 0x29;
+
+// Must match Params.h
+const uint8_t PARAM_HIL_TICKS = 0x03;
+
+const size_t actuatorFrameSize = 1 + 2 + 4;
+const size_t sensorFrameSize = 1 + 2 + 4 + 4;
+const size_t reportFrameSize = 1 + 5 * 4;
+const size_t capabilityFrameSize = 1 + 8 * 4;
+
+const double tickPeriodSec = 0.001;
+const unsigned int substeps = 4;
+const double encoderResolution = 2.0 * M_PI / 400.0; // 400 pulses per revolution
+
+typedef struct {
+    std::string port;
+    unsigned int baudRate = 921600;
+    uint32_t ticks = 10000;
+    double initialTilt = 0.02;
+    std::string modelPath = "../model_parameters.json";
+    std::string logPath = "hil_log.csv";
+} Options;
+
+typedef struct {
+    uint32_t tick;
+    float input;
+    double state[PENDULUM_STATES];
+} LogRow;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    if (argc < 2) {
+        return false;
+    }
+    options.port = argv[1];
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--baud") {
+            options.baudRate = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--ticks") {
+            options.ticks = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--tilt") {
+            options.initialTilt = std::strtod(value, nullptr);
+        } else if (flag == "--model") {
+            options.modelPath = value;
+        } else if (flag == "--log") {
+            options.logPath = value;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+double percentile(std::vector<int64_t> values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return static_cast<double>(values[index]);
+}
+
+uint32_t readU32(const uint8_t* bytes)
+{
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+bool handshake(SerialPort& port)
+{
+    uint8_t byte = 0;
+
+    // The device drops anything before it is ready, so the check is repeated
+    for (int attempt = 0; attempt < 10; attempt++) {
+        port.writeAll(&HOST_CHECK_CONNECTION, 1);
+        while (port.readExact(&byte, 1, 500000) == 1) {
+            if (byte == DEVICE_CHECK_CONNECTION) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Checks the device's boot-time probe (CapabilityReport in Comms.h) against a 1 kHz tick.
+// Returns false with the reason when the run would miss ticks; firmware without the probe passes.
+bool hilFeasible(SerialPort& port, std::string& reason)
+{
+    port.writeAll(&HOST_GET_CAPABILITIES, 1);
+    uint8_t frame[capabilityFrameSize];
+    if (port.readExact(frame, sizeof(frame), 500000) != sizeof(frame) || frame[0] != DEVICE_CAPABILITIES) {
+        port.discardInput();
+        return true;
+    }
+
+    uint32_t hilWorstUs = readU32(&frame[1 + 4 * 4]);
+    uint32_t hilPeriodUs = readU32(&frame[1 + 5 * 4]);
+    uint32_t baudRate = readU32(&frame[1 + 6 * 4]);
+    if (hilPeriodUs == 0) {
+        return true;
+    }
+
+    char text[160];
+    double neededBaud = std::max(actuatorFrameSize, sensorFrameSize) * 10.0 * 1e6 / hilPeriodUs;
+    if (hilWorstUs >= hilPeriodUs) {
+        std::snprintf(text, sizeof(text), "the controller step takes up to %u us of the %u us tick", hilWorstUs, hilPeriodUs);
+    } else if (baudRate != 0 && baudRate < neededBaud) {
+        std::snprintf(text, sizeof(text), "%u baud cannot carry a frame per tick, it needs %.0f (nodemcu-32s-hil build)", baudRate, neededBaud);
+    } else {
+        std::printf("   -> Device: controller step up to %u us of %u us, link at %u baud (0: unpaced).\n", hilWorstUs, hilPeriodUs, baudRate);
+        return true;
+    }
+    reason = text;
+    return false;
+}
+
+bool setTicks(SerialPort& port, uint32_t ticks)
+{
+    uint8_t request[2 + sizeof(ticks)] = { HOST_PARAM_SET, PARAM_HIL_TICKS };
+    std::memcpy(&request[2], &ticks, sizeof(ticks));
+    port.writeAll(request, sizeof(request));
+
+    uint8_t reply[2 + sizeof(ticks)];
+    return port.readExact(reply, sizeof(reply), 1000000) == sizeof(reply) && reply[0] == DEVICE_PARAM_VALUE;
+}
+
+void tryRealtime()
+{
+    // Page faults and preemption show up directly as deadline misses
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::printf("   -> Note: could not lock memory (needs CAP_IPC_LOCK).\n");
+    }
+    sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+        std::printf("   -> Note: running without real-time priority (needs CAP_SYS_NICE).\n");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s <port> [--baud N] [--ticks N] [--tilt rad] [--model file] [--log file]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("--- Hardware-in-the-Loop Simulator ---\n");
+
+    PendulumParams params;
+    ModelFile model;
+    if (model.load(options.modelPath)) {
+        params.torqueGain = model.number("slope", params.torqueGain);
+        params.wheelInertia = model.number("inertia", params.wheelInertia);
+        std::printf("Motor model from %s: slope = %.4f, inertia = %.6e\n", options.modelPath.c_str(), params.torqueGain, params.wheelInertia);
+    } else {
+        std::printf("Warning: could not read %s, using default motor parameters.\n", options.modelPath.c_str());
+    }
+
+    SerialPort port;
+    if (!port.open(options.port, options.baudRate)) {
+        std::fprintf(stderr, "Error opening serial port %s at %u baud.\n", options.port.c_str(), options.baudRate);
+        return 1;
+    }
+    sleep(2); // Wait for the board to reset after the port opened
+    port.discardInput();
+
+    std::printf("1. Checking connection with controller...\n");
+    if (!handshake(port)) {
+        std::fprintf(stderr, "Error: device did not answer the connection check.\n");
+        return 1;
+    }
+
+    std::string reason;
+    if (!hilFeasible(port, reason)) {
+        std::fprintf(stderr, "Error: the device cannot keep up with HIL: %s.\n", reason.c_str());
+        return 1;
+    }
+
+    std::printf("2. Configuring %u ticks and starting HIL mode...\n", options.ticks);
+    if (!setTicks(port, options.ticks)) {
+        std::fprintf(stderr, "Error: device rejected the tick count.\n");
+        return 1;
+    }
+    port.writeAll(&HOST_START_HIL, 1);
+    uint8_t ack = 0;
+    if (port.readExact(&ack, 1, 1000000) != 1 || ack != DEVICE_ACK_START) {
+        std::fprintf(stderr, "Error: device did not acknowledge the start. Received: 0x%02x\n", ack);
+        return 1;
+    }
+
+    tryRealtime();
+
+    double state[PENDULUM_STATES] = { options.initialTilt, 0.0, 0.0, 0.0 };
+    std::vector<LogRow> log;
+    log.reserve(options.ticks);
+    std::vector<int64_t> turnaroundUs, gapUs;
+    turnaroundUs.reserve(options.ticks);
+    gapUs.reserve(options.ticks);
+
+    uint8_t buffer[4096];
+    size_t buffered = 0;
+    size_t skippedBytes = 0;
+    int64_t lastFrameUs = 0;
+    bool done = false;
+    uint8_t report[reportFrameSize];
+
+    const int64_t deadline = monotonicMicros() + static_cast<int64_t>(options.ticks) * 2000 + 5000000;
+
+    std::printf("3. Running...\n");
+    while (!done && monotonicMicros() < deadline) {
+        long count = port.readSome(buffer + buffered, sizeof(buffer) - buffered, 100000);
+        if (count < 0) {
+            std::fprintf(stderr, "Error: serial read failed.\n");
+            return 1;
+        }
+        int64_t receivedUs = monotonicMicros();
+        buffered += count;
+
+        size_t pos = 0;
+        while (pos < buffered) {
+            uint8_t code = buffer[pos];
+
+            if (code == DEVICE_HIL_ACTUATOR) {
+                if (buffered - pos < actuatorFrameSize) {
+                    break;
+                }
+                uint16_t tick;
+                float input;
+                std::memcpy(&tick, &buffer[pos + 1], sizeof(tick));
+                std::memcpy(&input, &buffer[pos + 3], sizeof(input));
+                pos += actuatorFrameSize;
+
+                for (unsigned int i = 0; i < substeps; i++) {
+                    pendulumStep(params, state, input, tickPeriodSec / substeps);
+                }
+
+                float tilt = static_cast<float>(state[PENDULUM_TILT]);
+                float wheelAngle = static_cast<float>(std::round(state[PENDULUM_WHEEL_ANGLE] / encoderResolution) * encoderResolution);
+
+                uint8_t frame[sensorFrameSize];
+                frame[0] = HOST_HIL_SENSOR;
+                std::memcpy(&frame[1], &tick, sizeof(tick));
+                std::memcpy(&frame[3], &tilt, sizeof(tilt));
+                std::memcpy(&frame[7], &wheelAngle, sizeof(wheelAngle));
+                port.writeAll(frame, sizeof(frame));
+
+                int64_t sentUs = monotonicMicros();
+                turnaroundUs.push_back(sentUs - receivedUs);
+                if (lastFrameUs != 0) {
+                    gapUs.push_back(receivedUs - lastFrameUs);
+                }
+                lastFrameUs = receivedUs;
+
+                LogRow row;
+                row.tick = static_cast<uint32_t>(log.size());
+                row.input = input;
+                std::memcpy(row.state, state, sizeof(state));
+                log.push_back(row);
+            } else if (code == DEVICE_HIL_REPORT) {
+                if (buffered - pos < reportFrameSize) {
+                    break;
+                }
+                std::memcpy(report, &buffer[pos], reportFrameSize);
+                pos += reportFrameSize;
+                done = true;
+                break;
+            } else {
+                pos++;
+                skippedBytes++;
+            }
+        }
+
+        std::memmove(buffer, buffer + pos, buffered - pos);
+        buffered -= pos;
+    }
+
+    if (!done) {
+        std::fprintf(stderr, "Error: no report from the device after %zu frames.\n", log.size());
+        return 1;
+    }
+
+    uint32_t ticks = readU32(&report[1]);
+    uint32_t misses = readU32(&report[5]);
+    const double periodUs = tickPeriodSec * 1e6;
+    size_t lateFrames = std::count_if(gapUs.begin(), gapUs.end(), [periodUs](int64_t gap) { return gap > 1.5 * periodUs; });
+
+    std::printf("\n--- HIL Link Report ---\n");
+    std::printf("Ticks:                 %u (%zu actuator frames received)\n", ticks, log.size());
+    std::printf("Deadline misses:       %u (%.2f %%)\n", misses, ticks > 0 ? 100.0 * misses / ticks : 0.0);
+    std::printf("Device RTT (us):       min %u, mean %u, max %u\n", readU32(&report[9]), readU32(&report[13]), readU32(&report[17]));
+    std::printf("Host turnaround (us):  p50 %.0f, p99 %.0f, max %.0f\n",
+        percentile(turnaroundUs, 0.5), percentile(turnaroundUs, 0.99), percentile(turnaroundUs, 1.0));
+    std::printf("Frame spacing (us):    p50 %.0f, p99 %.0f, max %.0f, %zu gaps > 1.5 periods\n",
+        percentile(gapUs, 0.5), percentile(gapUs, 0.99), percentile(gapUs, 1.0), lateFrames);
+    std::printf("Bytes skipped:         %zu\n", skippedBytes);
+    std::printf("Link keeps up:         %s\n", misses == 0 ? "yes" : "no");
+
+    std::FILE* file = std::fopen(options.logPath.c_str(), "w");
+    if (file == nullptr) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.logPath.c_str());
+        return 1;
+    }
+    std::fprintf(file, "Time(s),Input,Tilt,TiltRate,WheelAngle,WheelSpeed\n");
+    for (const LogRow& row : log) {
+        std::fprintf(file, "%.3f,%.6f,%.6f,%.6f,%.6f,%.6f\n", row.tick * tickPeriodSec, row.input,
+            row.state[PENDULUM_TILT], row.state[PENDULUM_TILT_RATE], row.state[PENDULUM_WHEEL_ANGLE], row.state[PENDULUM_WHEEL_SPEED]);
+    }
+    std::fclose(file);
+    std::printf("Trajectory saved to %s\n", options.logPath.c_str());
+
+    return misses == 0 ? 0 : 2;
+}
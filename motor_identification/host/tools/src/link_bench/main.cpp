@@ -0,0 +1,464 @@
+// Serial link benchmark: ping and echo round-trip times and bulk throughput in both
+// directions, at each baud rate the firmware supports. Every run appends one row per
+// baud rate to a CSV report, tagged with host, port, firmware version and a free label,
+// so cables, hosts and firmware versions can be compared over time.
+//
+// Usage: link_bench <port> [--bauds 115200,230400,460800,921600] [--pings 1000]
+//                   [--bulk 262144] [--label text] [--report link_report.csv]
+
+#include <SerialPort.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// --- Protocol Definitions (Must match Comms.h) ---
+const uint8_t HOST_CHECK_CONNECTION = 0x01;
+const uint8_t DEVICE_CHECK_CONNECTION = 0x02;
+const uint8_t HOST_PING = 0x16;
+const uint8_t DEVICE_PING = 0x17;
+const uint8_t HOST_ECHO = 0x18;
+const uint8_t DEVICE_ECHO = 0x19;
+const uint8_t HOST_BULK_REQUEST = 0x1A;
+const uint8_t DEVICE_BULK_DATA = 0x1B;
+const uint8_t HOST_BULK_SEND = 0x1C;
+const uint8_t DEVICE_BULK_RESULT = 0x1D;
+const uint8_t HOST_SET_BAUD = 0x1E;
+const uint8_t DEVICE_BAUD_ACK = 0x1F;
+const uint8_t HOST_GET_VERSION = 0x20;
+const uint8_t DEVICE_VERSION = 0x21;
+
+const unsigned int defaultBaudRate = 115200; // COMMS_BAUD_RATE of the default build
+const size_t echoSizes[] = { 1, 16, 64, 255 };
+const long replyTimeoutUs = 500000;
+const unsigned int bitsPerByte = 10; // 8N1
+
+typedef struct {
+    std::string port;
+    std::vector<unsigned int> baudRates = { 115200, 230400, 460800, 921600 };
+    unsigned int pings = 1000;
+    uint32_t bulkSize = 262144;
+    std::string label;
+    std::string reportPath = "link_report.csv";
+} Options;
+
+typedef struct {
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    double mean;
+    size_t lost;
+} RttStats;
+
+typedef struct {
+    unsigned int baudRate;
+    RttStats ping;
+    RttStats echo[sizeof(echoSizes) / sizeof(echoSizes[0])];
+    double downBytesPerSec;
+    size_t downErrors;
+    double upBytesPerSec;
+    size_t upErrors;
+} BaudResult;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    if (argc < 2) {
+        return false;
+    }
+    options.port = argv[1];
+
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--bauds") {
+            options.baudRates.clear();
+            for (char* end = const_cast<char*>(value); *end != '\0';) {
+                options.baudRates.push_back(std::strtoul(end, &end, 10));
+                if (*end == ',') {
+                    end++;
+                }
+            }
+        } else if (flag == "--pings") {
+            options.pings = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--bulk") {
+            options.bulkSize = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--label") {
+            options.label = value;
+        } else if (flag == "--report") {
+            options.reportPath = value;
+        } else {
+            return false;
+        }
+    }
+    return !options.baudRates.empty() && options.pings > 0;
+}
+
+uint8_t bulkPattern(uint32_t index)
+{
+    // Must match Comms.cpp
+    return static_cast<uint8_t>(index ^ (index >> 8) ^ (index >> 16));
+}
+
+uint32_t readU32(const uint8_t* bytes)
+{
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+RttStats summarize(std::vector<int64_t> values, size_t lost)
+{
+    RttStats stats = {};
+    stats.lost = lost;
+    if (values.empty()) {
+        return stats;
+    }
+
+    std::sort(values.begin(), values.end());
+    auto at = [&values](double fraction) {
+        return static_cast<double>(values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))]);
+    };
+    stats.p50 = at(0.5);
+    stats.p90 = at(0.9);
+    stats.p99 = at(0.99);
+    stats.max = static_cast<double>(values.back());
+
+    double sum = 0.0;
+    for (int64_t value : values) {
+        sum += value;
+    }
+    stats.mean = sum / values.size();
+    return stats;
+}
+
+bool handshake(SerialPort& port)
+{
+    uint8_t byte = 0;
+
+    // The device drops anything before it is ready, so the check is repeated
+    for (int attempt = 0; attempt < 10; attempt++) {
+        port.writeAll(&HOST_CHECK_CONNECTION, 1);
+        while (port.readExact(&byte, 1, 500000) == 1) {
+            if (byte == DEVICE_CHECK_CONNECTION) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::string firmwareVersion(SerialPort& port)
+{
+    port.writeAll(&HOST_GET_VERSION, 1);
+
+    uint8_t header[2];
+    if (port.readExact(header, sizeof(header), replyTimeoutUs) != sizeof(header) || header[0] != DEVICE_VERSION) {
+        return "unknown";
+    }
+    std::string version(header[1], '\0');
+    if (port.readExact(reinterpret_cast<uint8_t*>(&version[0]), version.size(), replyTimeoutUs) != version.size()) {
+        return "unknown";
+    }
+    return version;
+}
+
+bool switchBaudRate(SerialPort& port, unsigned int baudRate)
+{
+    uint8_t request[1 + 4] = { HOST_SET_BAUD };
+    uint32_t value = baudRate;
+    std::memcpy(&request[1], &value, sizeof(value));
+    port.writeAll(request, sizeof(request));
+
+    uint8_t reply[1 + 4];
+    if (port.readExact(reply, sizeof(reply), replyTimeoutUs) != sizeof(reply) || reply[0] != DEVICE_BAUD_ACK) {
+        return false;
+    }
+    if (readU32(&reply[1]) != baudRate) {
+        return false; // Unsupported, the device stays at the current rate
+    }
+
+    // Give the device time to reconfigure its UART before talking at the new rate
+    usleep(50000);
+    port.setBaudRate(baudRate);
+    port.discardInput();
+
+    uint8_t pong = 0;
+    port.writeAll(&HOST_PING, 1);
+    return port.readExact(&pong, 1, replyTimeoutUs) == 1 && pong == DEVICE_PING;
+}
+
+RttStats measurePing(SerialPort& port, unsigned int count)
+{
+    std::vector<int64_t> rttUs;
+    rttUs.reserve(count);
+    size_t lost = 0;
+
+    for (unsigned int i = 0; i < count; i++) {
+        uint8_t pong = 0;
+        int64_t startUs = monotonicMicros();
+        port.writeAll(&HOST_PING, 1);
+        if (port.readExact(&pong, 1, replyTimeoutUs) == 1 && pong == DEVICE_PING) {
+            rttUs.push_back(monotonicMicros() - startUs);
+        } else {
+            lost++;
+            port.discardInput();
+        }
+    }
+    return summarize(rttUs, lost);
+}
+
+RttStats measureEcho(SerialPort& port, unsigned int count, size_t size)
+{
+    std::vector<int64_t> rttUs;
+    rttUs.reserve(count);
+    size_t lost = 0;
+
+    uint8_t request[2 + 255] = { HOST_ECHO, static_cast<uint8_t>(size) };
+    uint8_t reply[2 + 255];
+
+    for (unsigned int i = 0; i < count; i++) {
+        for (size_t j = 0; j < size; j++) {
+            request[2 + j] = static_cast<uint8_t>(i + j);
+        }
+
+        int64_t startUs = monotonicMicros();
+        port.writeAll(request, 2 + size);
+        bool ok = port.readExact(reply, 2 + size, replyTimeoutUs) == 2 + size && reply[0] == DEVICE_ECHO
+            && reply[1] == size && std::memcmp(&reply[2], &request[2], size) == 0;
+
+        if (ok) {
+            rttUs.push_back(monotonicMicros() - startUs);
+        } else {
+            lost++;
+            port.discardInput();
+        }
+    }
+    return summarize(rttUs, lost);
+}
+
+// Device to host: rate from the first to the last payload byte, as seen by the host
+bool measureDownload(SerialPort& port, uint32_t size, double& bytesPerSec, size_t& errors)
+{
+    uint8_t request[1 + 4] = { HOST_BULK_REQUEST };
+    std::memcpy(&request[1], &size, sizeof(size));
+    port.writeAll(request, sizeof(request));
+
+    uint8_t header[1 + 4];
+    if (port.readExact(header, sizeof(header), replyTimeoutUs) != sizeof(header) || header[0] != DEVICE_BULK_DATA) {
+        return false;
+    }
+    uint32_t expected = readU32(&header[1]);
+
+    uint8_t buffer[4096];
+    uint32_t received = 0;
+    int64_t firstUs = 0;
+    int64_t lastUs = 0;
+    errors = 0;
+
+    while (received < expected) {
+        long count = port.readSome(buffer, std::min(static_cast<size_t>(expected - received), sizeof(buffer)), replyTimeoutUs);
+        if (count <= 0) {
+            return false;
+        }
+        lastUs = monotonicMicros();
+        if (received == 0) {
+            firstUs = lastUs;
+        }
+        for (long i = 0; i < count; i++) {
+            errors += buffer[i] != bulkPattern(received + i);
+        }
+        received += count;
+    }
+
+    bytesPerSec = lastUs > firstUs ? (received - 1) * 1e6 / (lastUs - firstUs) : 0.0;
+    return true;
+}
+
+// Host to device: rate from the first to the last payload byte, as seen by the device
+bool measureUpload(SerialPort& port, uint32_t size, double& bytesPerSec, size_t& errors)
+{
+    std::vector<uint8_t> request(1 + 4 + size);
+    request[0] = HOST_BULK_SEND;
+    std::memcpy(&request[1], &size, sizeof(size));
+    for (uint32_t i = 0; i < size; i++) {
+        request[5 + i] = bulkPattern(i);
+    }
+    port.writeAll(request.data(), request.size());
+
+    // The device answers once the last byte arrived, which may be long after the write returned
+    uint8_t reply[1 + 3 * 4];
+    long timeoutUs = replyTimeoutUs + static_cast<long>(size) * 1000;
+    if (port.readExact(reply, sizeof(reply), timeoutUs) != sizeof(reply) || reply[0] != DEVICE_BULK_RESULT) {
+        return false;
+    }
+    uint32_t received = readU32(&reply[1]);
+    uint32_t elapsedUs = readU32(&reply[9]);
+
+    errors = readU32(&reply[5]) + (size - received);
+    bytesPerSec = elapsedUs > 0 ? (received - 1) * 1e6 / elapsedUs : 0.0;
+    return true;
+}
+
+std::string hostName()
+{
+    char name[256] = "unknown";
+    gethostname(name, sizeof(name) - 1);
+    return name;
+}
+
+std::string timestamp()
+{
+    char text[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    return text;
+}
+
+// Commas would break the CSV columns
+std::string csvField(std::string text)
+{
+    std::replace(text.begin(), text.end(), ',', ';');
+    return text;
+}
+
+void printResult(const BaudResult& result)
+{
+    const double nominal = static_cast<double>(result.baudRate) / bitsPerByte;
+
+    std::printf("\n--- %u baud ---\n", result.baudRate);
+    std::printf("%-12s %9s %9s %9s %9s %9s %6s\n", "RTT (us)", "p50", "p90", "p99", "max", "mean", "lost");
+    std::printf("%-12s %9.0f %9.0f %9.0f %9.0f %9.0f %6zu\n", "ping", result.ping.p50, result.ping.p90,
+        result.ping.p99, result.ping.max, result.ping.mean, result.ping.lost);
+    for (size_t i = 0; i < sizeof(echoSizes) / sizeof(echoSizes[0]); i++) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "echo %zu B", echoSizes[i]);
+        const RttStats& echo = result.echo[i];
+        std::printf("%-12s %9.0f %9.0f %9.0f %9.0f %9.0f %6zu\n", name, echo.p50, echo.p90, echo.p99, echo.max, echo.mean, echo.lost);
+    }
+    std::printf("Device -> host: %9.0f B/s (%5.1f %% of nominal), %zu bad bytes\n",
+        result.downBytesPerSec, 100.0 * result.downBytesPerSec / nominal, result.downErrors);
+    std::printf("Host -> device: %9.0f B/s (%5.1f %% of nominal), %zu bad bytes\n",
+        result.upBytesPerSec, 100.0 * result.upBytesPerSec / nominal, result.upErrors);
+}
+
+bool appendReport(const Options& options, const std::string& version, const std::vector<BaudResult>& results)
+{
+    struct stat info;
+    bool exists = stat(options.reportPath.c_str(), &info) == 0 && info.st_size > 0;
+
+    std::FILE* file = std::fopen(options.reportPath.c_str(), "a");
+    if (file == nullptr) {
+        return false;
+    }
+
+    if (!exists) {
+        std::fprintf(file, "Timestamp,Host,Port,Firmware,Label,Baud,BulkBytes,"
+                           "PingP50(us),PingP90(us),PingP99(us),PingMax(us),PingLost");
+        for (size_t size : echoSizes) {
+            std::fprintf(file, ",Echo%zuP50(us),Echo%zuP99(us),Echo%zuLost", size, size, size);
+        }
+        std::fprintf(file, ",Down(B/s),DownErrors,Up(B/s),UpErrors\n");
+    }
+
+    const std::string prefix = timestamp() + "," + csvField(hostName()) + "," + csvField(options.port) + ","
+        + csvField(version) + "," + csvField(options.label);
+
+    for (const BaudResult& result : results) {
+        std::fprintf(file, "%s,%u,%u,%.0f,%.0f,%.0f,%.0f,%zu", prefix.c_str(), result.baudRate, options.bulkSize,
+            result.ping.p50, result.ping.p90, result.ping.p99, result.ping.max, result.ping.lost);
+        for (const RttStats& echo : result.echo) {
+            std::fprintf(file, ",%.0f,%.0f,%zu", echo.p50, echo.p99, echo.lost);
+        }
+        std::fprintf(file, ",%.0f,%zu,%.0f,%zu\n", result.downBytesPerSec, result.downErrors, result.upBytesPerSec, result.upErrors);
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s <port> [--bauds a,b,...] [--pings N] [--bulk bytes] [--label text] [--report file]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("--- Serial Link Benchmark ---\n");
+
+    SerialPort port;
+    if (!port.open(options.port, defaultBaudRate)) {
+        std::fprintf(stderr, "Error opening serial port %s.\n", options.port.c_str());
+        return 1;
+    }
+    sleep(2); // Wait for the board to reset after the port opened
+    port.discardInput();
+
+    std::printf("1. Checking connection with controller...\n");
+    if (!handshake(port)) {
+        std::fprintf(stderr, "Error: device did not answer the connection check.\n");
+        return 1;
+    }
+    const std::string version = firmwareVersion(port);
+    std::printf("   Firmware: %s\n", version.c_str());
+
+    std::printf("2. Measuring %u pings, echoes and %u byte transfers per baud rate...\n", options.pings, options.bulkSize);
+    std::vector<BaudResult> results;
+    unsigned int currentBaudRate = defaultBaudRate;
+
+    for (unsigned int baudRate : options.baudRates) {
+        if (baudRate != currentBaudRate) {
+            if (!switchBaudRate(port, baudRate)) {
+                std::printf("   -> Skipping %u baud: device refused or lost the link.\n", baudRate);
+                // Fall back to the rate the device answered at before
+                port.setBaudRate(currentBaudRate);
+                port.discardInput();
+                continue;
+            }
+            currentBaudRate = baudRate;
+        }
+
+        BaudResult result = {};
+        result.baudRate = baudRate;
+        result.ping = measurePing(port, options.pings);
+        for (size_t i = 0; i < sizeof(echoSizes) / sizeof(echoSizes[0]); i++) {
+            result.echo[i] = measureEcho(port, std::max(1u, options.pings / 4), echoSizes[i]);
+        }
+        if (!measureDownload(port, options.bulkSize, result.downBytesPerSec, result.downErrors)) {
+            std::printf("   -> Device to host transfer at %u baud timed out.\n", baudRate);
+            port.discardInput();
+        }
+        if (!measureUpload(port, options.bulkSize, result.upBytesPerSec, result.upErrors)) {
+            std::printf("   -> Host to device transfer at %u baud timed out.\n", baudRate);
+            port.discardInput();
+        }
+
+        printResult(result);
+        results.push_back(result);
+    }
+
+    // Leave the device where the other host scripts expect it
+    if (currentBaudRate != defaultBaudRate && !switchBaudRate(port, defaultBaudRate)) {
+        std::printf("Warning: could not restore %u baud, reset the board.\n", defaultBaudRate);
+    }
+
+    if (!appendReport(options, version, results)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.reportPath.c_str());
+        return 1;
+    }
+    std::printf("\nReport appended to %s\n", options.reportPath.c_str());
+
+    return results.size() == options.baudRates.size() ? 0 : 2;
+}
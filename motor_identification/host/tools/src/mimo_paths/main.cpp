@@ -0,0 +1,313 @@
+// MIMO path separation: splits one two-wheel run (mimo_experiment.py, shifted PRBS on both
+// motors) into the direct paths (input i -> wheel i) and the cross paths (input i -> wheel j).
+//
+// Each wheel's torque J * a, with speeds and accelerations from Savitzky-Golay derivatives of
+// the angles, is fitted as one FIR filter per input, a term per wheel speed and an offset:
+//   J * a_j(k) = sum_m g_j0(m) u_0(k - m) + sum_m g_j1(m) u_1(k - m) - b_j0 w_0(k) - b_j1 w_1(k) + c_j
+// The inputs are uncorrelated, so the four impulse responses separate in a single fit.
+// The derivative filter is centred, so the responses start window / 2 samples early.
+// With the speeds taken out, the torque an input step adds does not fade as the wheel
+// spins up, and the taps of each response sum to its instantaneous gain: the same N*m per
+// unit of input as the slope of estimate.py, whatever the number of taps.
+//
+// Usage: mimo_paths [--data ../mimo_data.csv] [--model ../model_parameters.json]
+//                   [--taps 40] [--window 11] [--csv mimo_paths.csv]
+
+#include <CsvTable.h>
+#include <Fitting.h>
+#include <ModelFile.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+const unsigned int wheels = 2;
+// Input correlation above this makes the split unreliable
+const double correlationWarning = 0.2;
+
+typedef struct {
+    std::string dataPath = "../mimo_data.csv";
+    std::string modelPath = "../model_parameters.json";
+    std::string csvPath = "mimo_paths.csv";
+    unsigned int taps = 40;
+    unsigned int window = 11;
+} Options;
+
+// g[output][input] impulse response, N*m per unit of input, from lag -lead on;
+// damping[output][wheel] N*m per rad/s of that wheel's speed
+typedef struct {
+    unsigned int lead;
+    std::vector<double> g[wheels][wheels];
+    double damping[wheels][wheels];
+    double offset[wheels];
+    double r2[wheels];
+} Paths;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--data") {
+            options.dataPath = value;
+        } else if (flag == "--model") {
+            options.modelPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--taps") {
+            options.taps = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--window") {
+            options.window = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.window >= 5 && options.window % 2 == 1 && options.taps > options.window / 2;
+}
+
+// Largest normalized cross-correlation between the inputs within +/- maxLag samples
+double inputCorrelation(const std::vector<double>& a, const std::vector<double>& b, unsigned int maxLag)
+{
+    double meanA = 0.0, meanB = 0.0;
+    for (size_t k = 0; k < a.size(); k++) {
+        meanA += a[k] / a.size();
+        meanB += b[k] / b.size();
+    }
+    double varA = 0.0, varB = 0.0;
+    for (size_t k = 0; k < a.size(); k++) {
+        varA += (a[k] - meanA) * (a[k] - meanA);
+        varB += (b[k] - meanB) * (b[k] - meanB);
+    }
+    if (varA <= 0.0 || varB <= 0.0) {
+        return 1.0;
+    }
+
+    double worst = 0.0;
+    for (int lag = -static_cast<int>(maxLag); lag <= static_cast<int>(maxLag); lag++) {
+        double sum = 0.0;
+        for (size_t k = 0; k < a.size(); k++) {
+            long other = static_cast<long>(k) + lag;
+            if (other >= 0 && other < static_cast<long>(b.size())) {
+                sum += (a[k] - meanA) * (b[other] - meanB);
+            }
+        }
+        worst = std::max(worst, std::fabs(sum) / std::sqrt(varA * varB));
+    }
+    return worst;
+}
+
+bool fitPaths(const std::vector<double>* inputs, const std::vector<double>* speeds, const std::vector<double>* torques,
+    size_t first, size_t last, unsigned int taps, Paths& paths)
+{
+    const size_t unknowns = wheels * taps + wheels + 1;
+    const unsigned int lead = paths.lead;
+    std::vector<double> row(unknowns);
+
+    // Samples whose whole input history (lags -lead to taps - lead - 1) lies in the run
+    first += taps - lead - 1;
+    last -= lead;
+
+    for (unsigned int output = 0; output < wheels; output++) {
+        LeastSquares fit(unknowns);
+        for (size_t k = first; k < last; k++) {
+            for (unsigned int input = 0; input < wheels; input++) {
+                for (unsigned int m = 0; m < taps; m++) {
+                    row[input * taps + m] = inputs[input][k + lead - m];
+                }
+            }
+            for (unsigned int wheel = 0; wheel < wheels; wheel++) {
+                row[wheels * taps + wheel] = -speeds[wheel][k];
+            }
+            row[unknowns - 1] = 1.0;
+            fit.add(row.data(), torques[output][k]);
+        }
+
+        std::vector<double> solution;
+        if (!fit.solve(solution)) {
+            return false;
+        }
+        for (unsigned int input = 0; input < wheels; input++) {
+            paths.g[output][input].assign(solution.begin() + input * taps, solution.begin() + (input + 1) * taps);
+        }
+        for (unsigned int wheel = 0; wheel < wheels; wheel++) {
+            paths.damping[output][wheel] = solution[wheels * taps + wheel];
+        }
+        paths.offset[output] = solution[unknowns - 1];
+
+        // Share of the torque variance the fit explains
+        double mean = 0.0, total = 0.0, rss = 0.0;
+        size_t count = last - first;
+        for (size_t k = first; k < last; k++) {
+            mean += torques[output][k] / count;
+        }
+        for (size_t k = first; k < last; k++) {
+            double predicted = paths.offset[output];
+            for (unsigned int wheel = 0; wheel < wheels; wheel++) {
+                predicted -= paths.damping[output][wheel] * speeds[wheel][k];
+            }
+            for (unsigned int input = 0; input < wheels; input++) {
+                for (unsigned int m = 0; m < taps; m++) {
+                    predicted += paths.g[output][input][m] * inputs[input][k + lead - m];
+                }
+            }
+            rss += (torques[output][k] - predicted) * (torques[output][k] - predicted);
+            total += (torques[output][k] - mean) * (torques[output][k] - mean);
+        }
+        paths.r2[output] = total > 0.0 ? 1.0 - rss / total : 0.0;
+    }
+    return true;
+}
+
+double sum(const std::vector<double>& values)
+{
+    double total = 0.0;
+    for (double value : values) {
+        total += value;
+    }
+    return total;
+}
+
+double energy(const std::vector<double>& values)
+{
+    double total = 0.0;
+    for (double value : values) {
+        total += value * value;
+    }
+    return total;
+}
+
+bool writeCsv(const std::string& path, const Paths& paths, double dt, unsigned int taps)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    // Impulse responses, then the step responses they add up to
+    std::fprintf(file, "Lag(s),G00,G01,G10,G11,Step00,Step01,Step10,Step11\n");
+    double step[wheels][wheels] = {};
+    for (unsigned int m = 0; m < taps; m++) {
+        std::fprintf(file, "%.4f", (static_cast<double>(m) - paths.lead) * dt);
+        for (unsigned int output = 0; output < wheels; output++) {
+            for (unsigned int input = 0; input < wheels; input++) {
+                std::fprintf(file, ",%.6e", paths.g[output][input][m]);
+                step[output][input] += paths.g[output][input][m];
+            }
+        }
+        for (unsigned int output = 0; output < wheels; output++) {
+            for (unsigned int input = 0; input < wheels; input++) {
+                std::fprintf(file, ",%.6e", step[output][input]);
+            }
+        }
+        std::fprintf(file, "\n");
+    }
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--data file] [--model file] [--taps n] [--window odd n] [--csv file]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("--- MIMO Path Separation ---\n");
+
+    CsvTable run;
+    const char* columns[] = { "Time(s)", "Input0", "Angle0", "Input1", "Angle1" };
+    bool complete = run.load(options.dataPath);
+    for (const char* column : columns) {
+        complete = complete && run.has(column);
+    }
+    if (!complete || run.rows() < 4 * options.taps + options.window) {
+        std::fprintf(stderr, "Error: could not read a two-wheel run from %s. Run mimo_experiment.py first.\n", options.dataPath.c_str());
+        return 1;
+    }
+
+    ModelFile model;
+    if (!model.load(options.modelPath) || !model.has("inertia")) {
+        std::fprintf(stderr, "Error: could not read the inertia from %s. Run estimate.py first.\n", options.modelPath.c_str());
+        return 1;
+    }
+    double inertia = model.number("inertia");
+
+    const std::vector<double>& time = run.column("Time(s)");
+    double dt = (time.back() - time.front()) / (time.size() - 1);
+    std::printf("Data: %zu samples, %.1f ms period, from %s\n", time.size(), dt * 1000.0, options.dataPath.c_str());
+    std::printf("Wheel inertia: %.6e kg*m^2 (both wheels)\n", inertia);
+
+    std::vector<double> inputs[wheels] = { run.column("Input0"), run.column("Input1") };
+    std::vector<double> speeds[wheels];
+    std::vector<double> torques[wheels];
+    for (unsigned int wheel = 0; wheel < wheels; wheel++) {
+        const std::vector<double>& angles = run.column(wheel == 0 ? "Angle0" : "Angle1");
+        speeds[wheel] = savgolFilter(angles, options.window, 3, 1, dt);
+        std::vector<double> accels = savgolFilter(angles, options.window, 3, 2, dt);
+        torques[wheel].resize(accels.size());
+        for (size_t k = 0; k < accels.size(); k++) {
+            torques[wheel][k] = inertia * accels[k];
+        }
+    }
+
+    double correlation = inputCorrelation(inputs[0], inputs[1], options.taps);
+    std::printf("Input cross-correlation: %.3f (max over +/- %u lags)\n", correlation, options.taps);
+    if (correlation > correlationWarning) {
+        std::printf("Warning: the inputs are correlated, direct and cross paths will leak into each other.\n");
+    }
+
+    size_t half = options.window / 2;
+    Paths paths;
+    paths.lead = half;
+    if (!fitPaths(inputs, speeds, torques, half, time.size() - half, options.taps, paths)) {
+        std::fprintf(stderr, "Error: the fit failed. Is the excitation rich enough for %u taps?\n", options.taps);
+        return 1;
+    }
+
+    std::printf("\n--- Results (%u taps from %.0f ms to %.0f ms) ---\n", options.taps, -(half * dt * 1000.0),
+        (options.taps - half - 1) * dt * 1000.0);
+    std::printf("Path              Gain (N*m/input)   Peak (N*m/input)\n");
+    for (unsigned int output = 0; output < wheels; output++) {
+        for (unsigned int input = 0; input < wheels; input++) {
+            const std::vector<double>& g = paths.g[output][input];
+            double peak = 0.0;
+            for (double value : g) {
+                peak = std::fabs(value) > std::fabs(peak) ? value : peak;
+            }
+            std::printf("u%u -> wheel %u %s  %+15.6f   %+16.6f\n", input, output, input == output ? "(direct)" : "(cross) ",
+                sum(g), peak);
+        }
+    }
+    for (unsigned int output = 0; output < wheels; output++) {
+        unsigned int other = 1 - output;
+        double ratio = energy(paths.g[output][other]) / std::max(energy(paths.g[output][output]), 1e-300);
+        std::printf("Wheel %u: cross/direct energy %.1f dB, R^2 %.4f, speed terms %.3e (own) %.3e (other) N*m/(rad/s)\n",
+            output, 10.0 * std::log10(std::max(ratio, 1e-30)), paths.r2[output], paths.damping[output][output],
+            paths.damping[output][other]);
+    }
+
+    model.setNumber("torque_gain_0", sum(paths.g[0][0]));
+    model.setNumber("torque_gain_1", sum(paths.g[1][1]));
+    model.setNumber("coupling_gain_01", sum(paths.g[0][1]));
+    model.setNumber("coupling_gain_10", sum(paths.g[1][0]));
+    if (!model.save(options.modelPath)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.modelPath.c_str());
+        return 1;
+    }
+    std::printf("\nGains saved to %s (coupling_gain_ij: input j on wheel i)\n", options.modelPath.c_str());
+
+    if (!writeCsv(options.csvPath, paths, dt, options.taps)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("Impulse and step responses saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
@@ -0,0 +1,428 @@
+// Monte Carlo robustness check of the balance controller: draws motor and pendulum parameters
+// from their spread, runs the closed loop for each draw and reports how many trials stay up
+// and how well they do, before the gains go near the hardware.
+//
+// Every trial runs the firmware controller itself: the Balance and GainSchedule libraries of
+// the firmware are built into this tool (see platformio.ini), so balanceStep and the gains of
+// the GainTable.h it was built with are the ones that go to the hardware, float arithmetic
+// included. To check a new table, run gain_schedule.py and build the tool again. The loop
+// runs at 1 kHz on the nonlinear pendulum of lib/Pendulum, with the encoder quantizing the
+// wheel angle and four RK4 steps per control period, as in hil_sim. Trials run in batches of
+// batchLanes: the plant state of a batch is one SIMD vector per quantity, so the RK4 steps
+// advance all lanes at once, and the batches are spread over all cores.
+//
+// Parameters: the torque gain (slope) is normal around the model file value with the spread
+// of its bootstrap interval (bootstrap_ci), when there is one. Everything else, including the
+// pendulum placeholders shared with gain_schedule.py, gets a normal spread of --spread times
+// its nominal value. A trial is stable when it never tilts past --fall-tilt and spends the
+// last holdTime seconds inside +/- --band.
+//
+// Usage: monte_carlo [--model ../model_parameters.json] [--trials 20000] [--duration 5] [--tilt 0.05] [--spread 0.1] [--fall-tilt 0.5] [--band 0.01]
+//                    [--threads 0 (all cores)] [--seed 1] [--csv monte_carlo.csv]
+
+#include <Balance.h>
+#include <ModelFile.h>
+#include <Parallel.h>
+#include <Pendulum.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Trials per SIMD batch. GCC splits the vectors to whatever width the target has; the
+// helpers below are all inlined, so its note on passing wide vectors by value does not apply.
+#pragma GCC diagnostic ignored "-Wpsabi"
+const unsigned int batchLanes = 8;
+typedef double Batch __attribute__((vector_size(batchLanes * sizeof(double))));
+typedef long long Mask __attribute__((vector_size(batchLanes * sizeof(long long))));
+
+// Must match the firmware: 1 kHz HIL loop (hilPeriodUs in main.cpp)
+const double controlPeriodSec = 0.001;
+// RK4 steps per control period, as in hil_sim
+const unsigned int substeps = 4;
+const double encoderResolution = 2.0 * M_PI / 400.0;
+// A stable trial ends inside the band for at least this long
+const double holdTime = 0.5;
+
+typedef struct {
+    std::string modelPath = "../model_parameters.json";
+    std::string csvPath = "monte_carlo.csv";
+    unsigned int trials = 20000;
+    double duration = 5.0;
+    double tilt = 0.05;
+    double spread = 0.1;
+    double fallTilt = 0.5;
+    double band = 0.01;
+    unsigned int threads = 0;
+    unsigned int seed = 1;
+} Options;
+
+// Sampled parameters, in the order of parameterNames
+const unsigned int parameterCount = 7;
+const char* const parameterNames[parameterCount] = { "torque_gain", "wheel_inertia", "body_mass", "com_height",
+    "body_inertia", "no_load_speed", "wheel_friction" };
+
+typedef struct {
+    double parameters[parameterCount];
+    double initialTilt;
+    bool balanced;
+    bool stable;
+    double fallTime;
+    double settleTime;
+    double peakTilt;
+    double maxWheelSpeed;
+    double rmsInput;
+    double saturation;
+} Trial;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--model") {
+            options.modelPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--trials") {
+            options.trials = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--duration") {
+            options.duration = std::strtod(value, nullptr);
+        } else if (flag == "--tilt") {
+            options.tilt = std::strtod(value, nullptr);
+        } else if (flag == "--spread") {
+            options.spread = std::strtod(value, nullptr);
+        } else if (flag == "--fall-tilt") {
+            options.fallTilt = std::strtod(value, nullptr);
+        } else if (flag == "--band") {
+            options.band = std::strtod(value, nullptr);
+        } else if (flag == "--threads") {
+            options.threads = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--seed") {
+            options.seed = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.trials > 0 && options.duration > holdTime && options.spread >= 0.0
+        && options.fallTilt > 0.0 && options.fallTilt < 1.5 && options.band > 0.0;
+}
+
+inline Batch splat(double value)
+{
+    return Batch{} + value;
+}
+
+inline Batch absolute(Batch x)
+{
+    return x < 0.0 ? -x : x;
+}
+
+// Odd Taylor series to x^11: under 1e-7 off up to pi / 2, and fallen lanes stop well before
+inline Batch sine(Batch x)
+{
+    Batch x2 = x * x;
+    return x * (1.0 + x2 * (-1.0 / 6.0 + x2 * (1.0 / 120.0 + x2 * (-1.0 / 5040.0 + x2 * (1.0 / 362880.0 + x2 * (-1.0 / 39916800.0))))));
+}
+
+// Nearest integer, ties to even; exact for |x| < 2^51, far beyond any encoder count
+inline Batch roundNearest(Batch x)
+{
+    const double shift = 6755399441055744.0; // 1.5 * 2^52
+    return (x + shift) - shift;
+}
+
+// Structure of arrays: lane i of every member belongs to trial i of the batch
+typedef struct {
+    // Reciprocals, to keep divisions out of the derivative
+    Batch torqueGain, wheelInertiaInv, gravityTorque, bodyInertiaInv, noLoadSpeedInv, wheelFriction;
+} BatchParams;
+
+typedef struct {
+    Batch tilt, tiltRate, wheelAngle, wheelSpeed;
+} BatchState;
+
+// pendulumDerivative for a whole batch
+inline BatchState derivative(const BatchParams& p, const BatchState& s, Batch input)
+{
+    Batch available = 1.0 - absolute(s.wheelSpeed) * p.noLoadSpeedInv;
+    available = available < 0.0 ? splat(0.0) : available;
+    Batch torque = p.torqueGain * input * available - p.wheelFriction * s.wheelSpeed;
+    Batch tiltAccel = (p.gravityTorque * sine(s.tilt) - torque) * p.bodyInertiaInv;
+    return { s.tiltRate, tiltAccel, s.wheelSpeed, torque * p.wheelInertiaInv - tiltAccel };
+}
+
+inline BatchState advance(const BatchState& s, const BatchState& d, double h)
+{
+    return { s.tilt + h * d.tilt, s.tiltRate + h * d.tiltRate, s.wheelAngle + h * d.wheelAngle, s.wheelSpeed + h * d.wheelSpeed };
+}
+
+inline void rk4(const BatchParams& p, BatchState& s, Batch input, double h)
+{
+    BatchState k1 = derivative(p, s, input);
+    BatchState k2 = derivative(p, advance(s, k1, 0.5 * h), input);
+    BatchState k3 = derivative(p, advance(s, k2, 0.5 * h), input);
+    BatchState k4 = derivative(p, advance(s, k3, h), input);
+    s.tilt += h / 6.0 * (k1.tilt + 2.0 * k2.tilt + 2.0 * k3.tilt + k4.tilt);
+    s.tiltRate += h / 6.0 * (k1.tiltRate + 2.0 * k2.tiltRate + 2.0 * k3.tiltRate + k4.tiltRate);
+    s.wheelAngle += h / 6.0 * (k1.wheelAngle + 2.0 * k2.wheelAngle + 2.0 * k3.wheelAngle + k4.wheelAngle);
+    s.wheelSpeed += h / 6.0 * (k1.wheelSpeed + 2.0 * k2.wheelSpeed + 2.0 * k3.wheelSpeed + k4.wheelSpeed);
+}
+
+// Runs batchLanes trials from their sampled parameters and initial tilts
+void simulateBatch(const Options& options, Trial* trials)
+{
+    BatchParams p;
+    BatchState s = {};
+    for (unsigned int lane = 0; lane < batchLanes; lane++) {
+        const double* q = trials[lane].parameters;
+        p.torqueGain[lane] = q[0];
+        p.wheelInertiaInv[lane] = 1.0 / q[1];
+        p.gravityTorque[lane] = q[2] * PendulumParams().gravity * q[3];
+        p.bodyInertiaInv[lane] = 1.0 / q[4];
+        p.noLoadSpeedInv[lane] = 1.0 / q[5];
+        p.wheelFriction[lane] = q[6];
+        s.tilt[lane] = trials[lane].initialTilt;
+    }
+
+    // One firmware controller per lane; its first step only takes the measurements
+    BalanceState controllers[batchLanes];
+    for (BalanceState& controller : controllers) {
+        resetBalance(&controller);
+    }
+    Mask active = s.tilt == s.tilt;
+    Batch fallTime = splat(options.duration), lastOutside = splat(0.0), peakTilt = absolute(s.tilt);
+    Batch maxWheelSpeed = splat(0.0), inputSquares = splat(0.0), saturated = splat(0.0);
+
+    const unsigned int steps = static_cast<unsigned int>(std::lround(options.duration / controlPeriodSec));
+    const double h = controlPeriodSec / substeps;
+    for (unsigned int step = 0; step < steps; step++) {
+        double time = step * controlPeriodSec;
+
+        // Sensors: the encoder counts whole pulses, the tilt is taken as exact. The controller
+        // is scalar firmware code, so only the plant is advanced as a batch.
+        Batch angle = roundNearest(s.wheelAngle * (1.0 / encoderResolution)) * encoderResolution;
+        Batch input;
+        for (unsigned int lane = 0; lane < batchLanes; lane++) {
+            input[lane] = balanceStep(&controllers[lane], static_cast<float>(s.tilt[lane]), static_cast<float>(angle[lane]),
+                static_cast<float>(controlPeriodSec));
+        }
+
+        BatchState next = s;
+        for (unsigned int i = 0; i < substeps; i++) {
+            rk4(p, next, input, h);
+        }
+        s.tilt = active ? next.tilt : s.tilt;
+        s.tiltRate = active ? next.tiltRate : s.tiltRate;
+        s.wheelAngle = active ? next.wheelAngle : s.wheelAngle;
+        s.wheelSpeed = active ? next.wheelSpeed : s.wheelSpeed;
+
+        Batch tiltSize = absolute(s.tilt), zero = splat(0.0);
+        peakTilt = active && tiltSize > peakTilt ? tiltSize : peakTilt;
+        lastOutside = active && tiltSize > options.band ? splat(time + controlPeriodSec) : lastOutside;
+        maxWheelSpeed = active && absolute(s.wheelSpeed) > maxWheelSpeed ? absolute(s.wheelSpeed) : maxWheelSpeed;
+        inputSquares += active ? input * input : zero;
+        saturated += active && absolute(input) >= 1.0 ? splat(1.0) : zero;
+
+        Mask fell = active && tiltSize > options.fallTilt;
+        fallTime = fell ? splat(time + controlPeriodSec) : fallTime;
+        active = active && !fell;
+
+        bool any = false;
+        for (unsigned int lane = 0; lane < batchLanes; lane++) {
+            any = any || active[lane];
+        }
+        if (!any) {
+            break;
+        }
+    }
+
+    for (unsigned int lane = 0; lane < batchLanes; lane++) {
+        Trial& trial = trials[lane];
+        double ran = fallTime[lane] / controlPeriodSec;
+        trial.balanced = active[lane] != 0;
+        trial.fallTime = fallTime[lane];
+        trial.settleTime = lastOutside[lane];
+        trial.stable = trial.balanced && trial.settleTime <= options.duration - holdTime;
+        trial.peakTilt = peakTilt[lane];
+        trial.maxWheelSpeed = maxWheelSpeed[lane];
+        trial.rmsInput = std::sqrt(inputSquares[lane] / std::max(ran, 1.0));
+        trial.saturation = saturated[lane] / std::max(ran, 1.0);
+    }
+}
+
+// z with P(|Z| < z) = confidence for a standard normal, by bisection on erf
+double normalQuantile(double confidence)
+{
+    double low = 0.0, high = 10.0;
+    for (int i = 0; i < 100; i++) {
+        double middle = 0.5 * (low + high);
+        (std::erf(middle / std::sqrt(2.0)) < confidence ? low : high) = middle;
+    }
+    return 0.5 * (low + high);
+}
+
+double percentile(std::vector<double> values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+bool writeCsv(const std::string& path, const std::vector<Trial>& trials)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    for (const char* name : parameterNames) {
+        std::fprintf(file, "%s,", name);
+    }
+    std::fprintf(file, "initial_tilt,balanced,stable,fall_time,settle_time,peak_tilt,max_wheel_speed,rms_input,saturation\n");
+    for (const Trial& trial : trials) {
+        for (double value : trial.parameters) {
+            std::fprintf(file, "%.6e,", value);
+        }
+        std::fprintf(file, "%.5f,%d,%d,%.3f,%.3f,%.5f,%.2f,%.4f,%.4f\n", trial.initialTilt, trial.balanced ? 1 : 0,
+            trial.stable ? 1 : 0, trial.fallTime, trial.settleTime, trial.peakTilt, trial.maxWheelSpeed, trial.rmsInput,
+            trial.saturation);
+    }
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--model file] [--trials n] [--duration s] "
+            "[--tilt rad] [--spread fraction] [--fall-tilt rad] [--band rad] [--threads n] [--seed n] [--csv file]\n", argv[0]);
+        return 1;
+    }
+    unsigned int threads = threadCount(options.threads);
+
+    std::printf("--- Monte Carlo Robustness ---\n");
+
+    std::printf("Gains: %ux%u schedule of the firmware GainTable.h\n", GAIN_TILT_POINTS, GAIN_SPEED_POINTS);
+
+    // Nominal values and standard deviations
+    PendulumParams nominal;
+    ModelFile model;
+    if (model.load(options.modelPath)) {
+        nominal.torqueGain = model.number("slope", nominal.torqueGain);
+        nominal.wheelInertia = model.number("inertia", nominal.wheelInertia);
+    }
+    const double means[parameterCount] = { nominal.torqueGain, nominal.wheelInertia, nominal.bodyMass, nominal.comHeight,
+        nominal.bodyInertia, nominal.noLoadSpeed, nominal.wheelFriction };
+    double deviations[parameterCount];
+    for (unsigned int i = 0; i < parameterCount; i++) {
+        deviations[i] = options.spread * means[i];
+    }
+    bool interval = model.has("slope_ci_low") && model.has("slope_ci_high");
+    if (interval) {
+        double z = normalQuantile(model.number("bootstrap_confidence", 0.95));
+        deviations[0] = (model.number("slope_ci_high") - model.number("slope_ci_low")) / (2.0 * z);
+    }
+
+    std::printf("Parameter         Nominal        Std. dev.\n");
+    for (unsigned int i = 0; i < parameterCount; i++) {
+        std::printf("%-16s  %+.4e    %.4e%s\n", parameterNames[i], means[i], deviations[i],
+            i == 0 && interval ? " (bootstrap interval)" : "");
+    }
+
+    // Whole batches; the trials are drawn per batch so the result does not depend on the threads
+    size_t batches = (options.trials + batchLanes - 1) / batchLanes;
+    std::vector<Trial> trials(batches * batchLanes);
+    std::printf("Trials: %zu in batches of %u, %.1f s each, initial tilt within +/- %.3f rad, %u threads\n", trials.size(),
+        batchLanes, options.duration, options.tilt, threads);
+
+    auto start = std::chrono::steady_clock::now();
+    parallelTasks(threads, batches, [&](size_t batch) {
+        std::seed_seq seed = { static_cast<size_t>(options.seed), batch };
+        std::mt19937_64 generator(seed);
+        std::normal_distribution<double> normal(0.0, 1.0);
+        std::uniform_real_distribution<double> uniform(-options.tilt, options.tilt);
+        Trial* first = &trials[batch * batchLanes];
+        for (unsigned int lane = 0; lane < batchLanes; lane++) {
+            for (unsigned int i = 0; i < parameterCount; i++) {
+                // Physical parameters stay positive
+                first[lane].parameters[i] = std::max(means[i] + deviations[i] * normal(generator), 0.2 * means[i]);
+            }
+            first[lane].initialTilt = uniform(generator);
+        }
+        simulateBatch(options, first);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Simulated in %.2f s (%.0f trials/s)\n", seconds, trials.size() / seconds);
+
+    size_t balanced = 0, stable = 0;
+    std::vector<double> settle, peak, wheel, rms, saturation;
+    for (const Trial& trial : trials) {
+        balanced += trial.balanced;
+        stable += trial.stable;
+        if (trial.stable) {
+            settle.push_back(trial.settleTime);
+            peak.push_back(trial.peakTilt);
+            wheel.push_back(trial.maxWheelSpeed);
+            rms.push_back(trial.rmsInput);
+            saturation.push_back(trial.saturation * 100.0);
+        }
+    }
+
+    std::printf("\n--- Results ---\n");
+    std::printf("Balanced (never past %.2f rad): %6.2f %% (%zu of %zu)\n", options.fallTilt, 100.0 * balanced / trials.size(),
+        balanced, trials.size());
+    std::printf("Stable (inside +/- %.3f rad for the last %.1f s): %6.2f %%\n", options.band, holdTime,
+        100.0 * stable / trials.size());
+    if (!settle.empty()) {
+        std::printf("Over the stable trials          median       95th pct     99th pct\n");
+        const struct {
+            const char* name;
+            const std::vector<double>* values;
+        } rows[] = { { "Settling time (s)", &settle }, { "Peak tilt (rad)", &peak }, { "Max wheel speed (rad/s)", &wheel },
+            { "RMS input", &rms }, { "Input saturated (%)", &saturation } };
+        for (const auto& row : rows) {
+            std::printf("%-30s %10.4f   %10.4f   %10.4f\n", row.name, percentile(*row.values, 0.5), percentile(*row.values, 0.95),
+                percentile(*row.values, 0.99));
+        }
+    }
+
+    // Which parameters the failures come from: failure rate below and above each median
+    if (stable < trials.size()) {
+        std::printf("Failure rate by parameter     below median   above median\n");
+        for (unsigned int i = 0; i < parameterCount; i++) {
+            std::vector<double> values;
+            for (const Trial& trial : trials) {
+                values.push_back(trial.parameters[i]);
+            }
+            double median = percentile(values, 0.5);
+            size_t count[2] = {}, failed[2] = {};
+            for (const Trial& trial : trials) {
+                int half = trial.parameters[i] > median;
+                count[half]++;
+                failed[half] += !trial.stable;
+            }
+            std::printf("%-28s  %10.2f %%   %10.2f %%\n", parameterNames[i], 100.0 * failed[0] / std::max<size_t>(count[0], 1),
+                100.0 * failed[1] / std::max<size_t>(count[1], 1));
+        }
+    }
+
+    if (!writeCsv(options.csvPath, trials)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("\nTrials saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
@@ -0,0 +1,274 @@
+// Shared-memory ring fan-out benchmark: one writer process publishes sample records as
+// fast as it can (or at --rate records/s) while N reader processes follow the ring.
+// Reports per-reader throughput, losses to lapping and write-to-read latency, for each
+// reader count.
+//
+// Usage: shm_bench [--readers 1,2,4,8] [--records 5000000] [--capacity 65536] [--rate 0]
+
+#include <SerialPort.h>
+#include <ShmRing.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const char ringName[] = "/motor_shm_bench";
+const uint32_t endMarker = UINT32_MAX;
+const unsigned int latencyStride = 16; // Every 16th record is timed, to keep the arrays small
+
+typedef struct {
+    std::vector<unsigned int> readerCounts = { 1, 2, 4, 8 };
+    uint64_t records = 5000000;
+    size_t capacity = 65536;
+    double rate = 0.0;
+} Options;
+
+// Sent back from every reader process through a pipe
+typedef struct {
+    uint64_t received;
+    uint64_t lost;
+    uint64_t corrupted;
+    double elapsedSec;
+    double latencyP50Us;
+    double latencyP99Us;
+    double latencyMaxUs;
+} ReaderResult;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--readers") {
+            options.readerCounts.clear();
+            for (char* end = const_cast<char*>(value); *end != '\0';) {
+                options.readerCounts.push_back(std::strtoul(end, &end, 10));
+                if (*end == ',') {
+                    end++;
+                }
+            }
+        } else if (flag == "--records") {
+            options.records = std::strtoull(value, nullptr, 10);
+        } else if (flag == "--capacity") {
+            options.capacity = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--rate") {
+            options.rate = std::strtod(value, nullptr);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && !options.readerCounts.empty();
+}
+
+// Channel values derived from the index, so readers can spot torn records
+void fillRecord(SampleRecord& record, uint32_t index)
+{
+    record.sequence = index;
+    record.timeUs = index * 1000;
+    record.channels = 8;
+    for (int i = 0; i < 8; i++) {
+        record.values[i] = static_cast<float>((index + i) & 0xFFFF);
+    }
+    record.hostUs = monotonicMicros();
+}
+
+bool recordIsConsistent(const SampleRecord& record)
+{
+    if (record.timeUs != record.sequence * 1000 || record.channels != 8) {
+        return false;
+    }
+    for (int i = 0; i < 8; i++) {
+        if (record.values[i] != static_cast<float>((record.sequence + i) & 0xFFFF)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+double percentile(std::vector<int64_t>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return static_cast<double>(values[index]);
+}
+
+void runReader(int readyFd, int resultFd)
+{
+    ShmRingReader reader;
+    ReaderResult result = {};
+
+    if (!reader.attach(ringName, sizeof(SampleRecord))) {
+        std::fprintf(stderr, "Error: reader could not attach to %s\n", ringName);
+        _exit(1);
+    }
+    char ready = 'R';
+    if (write(readyFd, &ready, 1) != 1) {
+        _exit(1);
+    }
+
+    std::vector<int64_t> latencyUs;
+    SampleRecord record;
+    int64_t startUs = 0;
+    unsigned int idlePolls = 0;
+
+    while (true) {
+        RingStatus status = reader.read(&record);
+        if (status == RING_EMPTY) {
+            if (++idlePolls > 64) {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+        idlePolls = 0;
+        if (status != RING_OK) {
+            continue;
+        }
+
+        int64_t nowUs = monotonicMicros();
+        if (record.sequence == endMarker) {
+            result.elapsedSec = (nowUs - startUs) * 1e-6;
+            break;
+        }
+        if (startUs == 0) {
+            startUs = nowUs;
+        }
+
+        result.received++;
+        if (!recordIsConsistent(record)) {
+            result.corrupted++;
+        }
+        if (record.sequence % latencyStride == 0) {
+            latencyUs.push_back(nowUs - record.hostUs);
+        }
+    }
+
+    result.lost = reader.lost();
+    result.latencyP50Us = percentile(latencyUs, 0.5);
+    result.latencyP99Us = percentile(latencyUs, 0.99);
+    result.latencyMaxUs = percentile(latencyUs, 1.0);
+
+    if (write(resultFd, &result, sizeof(result)) != sizeof(result)) {
+        _exit(1);
+    }
+    _exit(0);
+}
+
+bool runRound(const Options& options, unsigned int readerCount)
+{
+    ShmRingWriter writer;
+    if (!writer.create(ringName, sizeof(SampleRecord), options.capacity)) {
+        std::fprintf(stderr, "Error: could not create %s (capacity must be a power of two)\n", ringName);
+        return false;
+    }
+
+    int readyPipe[2], resultPipe[2];
+    if (pipe(readyPipe) != 0 || pipe(resultPipe) != 0) {
+        return false;
+    }
+
+    std::vector<pid_t> readers;
+    for (unsigned int i = 0; i < readerCount; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            runReader(readyPipe[1], resultPipe[1]);
+        }
+        readers.push_back(pid);
+    }
+
+    // Every reader is attached before the first record goes out
+    for (unsigned int i = 0; i < readerCount; i++) {
+        char ready;
+        if (read(readyPipe[0], &ready, 1) != 1) {
+            return false;
+        }
+    }
+
+    SampleRecord record;
+    std::memset(&record, 0, sizeof(record));
+    const int64_t startUs = monotonicMicros();
+
+    for (uint64_t i = 0; i < options.records; i++) {
+        if (options.rate > 0.0) {
+            int64_t dueUs = startUs + static_cast<int64_t>(i * 1e6 / options.rate);
+            while (monotonicMicros() < dueUs) {
+            }
+        }
+        fillRecord(record, static_cast<uint32_t>(i));
+        writer.publish(&record);
+    }
+    double writeSec = (monotonicMicros() - startUs) * 1e-6;
+
+    record.sequence = endMarker;
+    writer.publish(&record);
+
+    std::vector<ReaderResult> results(readerCount);
+    for (unsigned int i = 0; i < readerCount; i++) {
+        if (read(resultPipe[0], &results[i], sizeof(ReaderResult)) != sizeof(ReaderResult)) {
+            std::fprintf(stderr, "Error: a reader did not report.\n");
+            return false;
+        }
+    }
+    for (pid_t pid : readers) {
+        waitpid(pid, nullptr, 0);
+    }
+    close(readyPipe[0]);
+    close(readyPipe[1]);
+    close(resultPipe[0]);
+    close(resultPipe[1]);
+
+    uint64_t totalReceived = 0;
+    double slowestSec = 0.0;
+    for (const ReaderResult& result : results) {
+        totalReceived += result.received;
+        slowestSec = std::max(slowestSec, result.elapsedSec);
+    }
+
+    std::printf("\n--- %u reader%s ---\n", readerCount, readerCount == 1 ? "" : "s");
+    std::printf("Writer:   %.2f M records/s (%.0f MB/s)\n", options.records / writeSec * 1e-6,
+        options.records * sizeof(SampleRecord) / writeSec * 1e-6);
+    std::printf("%-8s %12s %10s %9s %10s %9s %9s %9s\n", "Reader", "Mrec/s", "received", "lost", "corrupted", "p50 (us)", "p99 (us)", "max (us)");
+    for (unsigned int i = 0; i < readerCount; i++) {
+        const ReaderResult& result = results[i];
+        std::printf("%-8u %12.2f %10llu %9llu %10llu %9.1f %9.1f %9.1f\n", i,
+            result.elapsedSec > 0.0 ? result.received / result.elapsedSec * 1e-6 : 0.0,
+            static_cast<unsigned long long>(result.received), static_cast<unsigned long long>(result.lost),
+            static_cast<unsigned long long>(result.corrupted), result.latencyP50Us, result.latencyP99Us, result.latencyMaxUs);
+    }
+    std::printf("Fan-out:  %.2f M records/s (%.0f MB/s) delivered across all readers\n",
+        slowestSec > 0.0 ? totalReceived / slowestSec * 1e-6 : 0.0,
+        slowestSec > 0.0 ? totalReceived * sizeof(SampleRecord) / slowestSec * 1e-6 : 0.0);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--readers a,b,...] [--records N] [--capacity N] [--rate records/s]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("--- Shared-Memory Ring Benchmark ---\n");
+    std::printf("%llu records of %zu bytes, ring of %zu slots, %s\n", static_cast<unsigned long long>(options.records),
+        sizeof(SampleRecord), options.capacity, options.rate > 0.0 ? "rate-limited" : "writer unthrottled");
+
+    for (unsigned int readerCount : options.readerCounts) {
+        if (!runRound(options, readerCount)) {
+            return 1;
+        }
+    }
+    return 0;
+}
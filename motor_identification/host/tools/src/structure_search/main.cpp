@@ -0,0 +1,384 @@
+// Model structure search: fits a grid of candidate wheel speed models to one motor test run
+// and ranks them, so the structure is chosen from the data instead of assumed.
+//
+// Every candidate predicts the next speed sample (from Savitzky-Golay derivatives of the angle):
+//   w(k+1) = a_1 w(k) + ... + a_na w(k-na+1) + b_1 u(k-d) + ... + b_nb u(k-d-nb+1) + c [- f sign(w(k))]
+//   na = 0: rigid wheel, w(k+1) = w(k) + b u(k-d) + c, the model of estimate.py
+//   na = 1: first order, back-EMF or viscous damping
+//   na = 2, 3: an extra pole, e.g. winding inductance or a flexible coupling
+//   d: dead time in samples; f: Coulomb friction
+// Each is a linear least-squares fit on the first part of the run, independent of the others,
+// so the whole grid runs as parallel tasks. The candidates are ranked by how well a free-run
+// simulation follows the held-out part (fit = 100 (1 - |w - w_sim| / |w - mean w|) %), and by
+// AIC and BIC on the estimation part. Both criteria use the free-run (output-error) residuals
+// there: one-step predictions of the filtered speed reward every extra pole, since each one
+// fits more of the filter's own smoothing. The winner is the best held-out fit.
+//
+// Usage: structure_search [--data ../experiment_data.csv] [--model ../model_parameters.json]
+//                         [--max-order 3] [--max-inputs 2] [--max-delay 3] [--holdout 0.3]
+//                         [--window 11] [--threads 0 (all cores)] [--csv structure_search.csv]
+
+#include <CsvTable.h>
+#include <Fitting.h>
+#include <ModelFile.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Simulated speeds beyond this many times the measured range count as diverged
+const double divergenceFactor = 100.0;
+
+typedef struct {
+    std::string dataPath = "../experiment_data.csv";
+    std::string modelPath = "../model_parameters.json";
+    std::string csvPath = "structure_search.csv";
+    unsigned int maxOrder = 3;
+    unsigned int maxInputs = 2;
+    unsigned int maxDelay = 3;
+    double holdout = 0.3;
+    unsigned int window = 11;
+    unsigned int threads = 0;
+} Options;
+
+typedef struct {
+    unsigned int order;    // na
+    unsigned int inputs;   // nb
+    unsigned int delay;    // d
+    bool friction;
+} Structure;
+
+typedef struct {
+    Structure structure;
+    std::vector<double> parameters; // a_1..a_na, b_1..b_nb, c, [f]
+    bool valid = false; // Fitted, and the free run over the estimation part stays bounded
+    double rss = 0.0;   // Free run over the estimation part
+    double aic = 0.0;
+    double bic = 0.0;
+    double fit = -std::numeric_limits<double>::infinity(); // held-out simulation, %
+} Candidate;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--data") {
+            options.dataPath = value;
+        } else if (flag == "--model") {
+            options.modelPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--max-order") {
+            options.maxOrder = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--max-inputs") {
+            options.maxInputs = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--max-delay") {
+            options.maxDelay = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--holdout") {
+            options.holdout = std::strtod(value, nullptr);
+        } else if (flag == "--window") {
+            options.window = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--threads") {
+            options.threads = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.maxOrder <= 3 && options.maxInputs >= 1 && options.holdout > 0.05 && options.holdout < 0.95
+        && options.window >= 5 && options.window % 2 == 1;
+}
+
+std::string describe(const Structure& structure)
+{
+    static const char* const names[] = { "rigid", "1st order", "2nd order", "3rd order" };
+    char text[96];
+    std::snprintf(text, sizeof(text), "%s, %u input tap%s, delay %u%s", names[structure.order], structure.inputs,
+        structure.inputs == 1 ? "" : "s", structure.delay, structure.friction ? ", Coulomb" : "");
+    return text;
+}
+
+double sign(double value)
+{
+    return (value > 0.0) - (value < 0.0);
+}
+
+size_t parameterCount(const Structure& structure)
+{
+    return structure.order + structure.inputs + 1 + (structure.friction ? 1 : 0);
+}
+
+// Regressors for predicting w(k + 1) from the given speed history
+void regressors(const Structure& structure, const std::vector<double>& speed, const std::vector<double>& input, size_t k,
+    double* row)
+{
+    size_t index = 0;
+    for (unsigned int i = 0; i < structure.order; i++) {
+        row[index++] = speed[k - i];
+    }
+    for (unsigned int j = 0; j < structure.inputs; j++) {
+        row[index++] = input[k - structure.delay - j];
+    }
+    row[index++] = 1.0;
+    if (structure.friction) {
+        row[index++] = -sign(speed[k]);
+    }
+}
+
+// The rigid wheel integrates: its regression target is the speed change
+double prediction(const Candidate& candidate, const std::vector<double>& speed, const std::vector<double>& input, size_t k,
+    std::vector<double>& row)
+{
+    regressors(candidate.structure, speed, input, k, row.data());
+    double next = candidate.structure.order == 0 ? speed[k] : 0.0;
+    for (size_t p = 0; p < row.size(); p++) {
+        next += candidate.parameters[p] * row[p];
+    }
+    return next;
+}
+
+// Free run from sample begin to end, started from the measured history before begin.
+// False if the simulation diverges.
+bool simulate(const Candidate& candidate, const std::vector<double>& speed, const std::vector<double>& input, size_t begin,
+    size_t end, double range, std::vector<double>& simulated)
+{
+    std::vector<double> row(parameterCount(candidate.structure));
+    simulated.assign(speed.begin(), speed.begin() + begin);
+    simulated.resize(end, 0.0);
+    for (size_t k = begin - 1; k + 1 < end; k++) {
+        simulated[k + 1] = prediction(candidate, simulated, input, k, row);
+        if (!(std::fabs(simulated[k + 1]) < divergenceFactor * range)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void fitCandidate(const std::vector<double>& speed, const std::vector<double>& input, size_t first, size_t split, size_t last,
+    double range, Candidate& candidate)
+{
+    const Structure& structure = candidate.structure;
+    const size_t count = parameterCount(structure);
+    std::vector<double> row(count);
+
+    LeastSquares fit(count);
+    for (size_t k = first; k + 1 < split; k++) {
+        regressors(structure, speed, input, k, row.data());
+        fit.add(row.data(), speed[k + 1] - (structure.order == 0 ? speed[k] : 0.0));
+    }
+    if (!fit.solve(candidate.parameters)) {
+        return;
+    }
+
+    std::vector<double> simulated;
+    if (!simulate(candidate, speed, input, first + 1, split, range, simulated)) {
+        return;
+    }
+    size_t n = split - 1 - first;
+    for (size_t k = first + 1; k < split; k++) {
+        candidate.rss += (speed[k] - simulated[k]) * (speed[k] - simulated[k]);
+    }
+    double logLikelihood = n * std::log(std::max(candidate.rss / n, 1e-300));
+    candidate.aic = logLikelihood + 2.0 * count;
+    candidate.bic = logLikelihood + count * std::log(static_cast<double>(n));
+    candidate.valid = true;
+
+    // Free run over the held-out part, started from the measured history
+    if (!simulate(candidate, speed, input, split, last, range, simulated)) {
+        return;
+    }
+    double mean = 0.0;
+    for (size_t k = split; k < last; k++) {
+        mean += speed[k] / (last - split);
+    }
+    double error = 0.0, spread = 0.0;
+    for (size_t k = split; k < last; k++) {
+        error += (speed[k] - simulated[k]) * (speed[k] - simulated[k]);
+        spread += (speed[k] - mean) * (speed[k] - mean);
+    }
+    candidate.fit = spread > 0.0 ? 100.0 * (1.0 - std::sqrt(error / spread)) : 0.0;
+}
+
+// Rank of each candidate (1 = best) under the given ordering
+template <typename Better>
+std::vector<size_t> ranks(const std::vector<Candidate>& candidates, Better better)
+{
+    std::vector<size_t> order(candidates.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) { return better(candidates[x], candidates[y]); });
+    std::vector<size_t> rank(candidates.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        rank[order[i]] = i + 1;
+    }
+    return rank;
+}
+
+void printParameters(const Candidate& candidate, double dt, double inertia)
+{
+    const Structure& structure = candidate.structure;
+    const std::vector<double>& p = candidate.parameters;
+    size_t index = 0;
+    for (unsigned int i = 0; i < structure.order; i++, index++) {
+        std::printf("  a%u = %+.6f\n", i + 1, p[index]);
+    }
+    double inputSum = 0.0;
+    for (unsigned int j = 0; j < structure.inputs; j++, index++) {
+        std::printf("  b%u = %+.6e rad/s per unit of input\n", j + 1, p[index]);
+        inputSum += p[index];
+    }
+    std::printf("  c  = %+.6e rad/s\n", p[index++]);
+    if (structure.friction) {
+        std::printf("  f  = %+.6e rad/s (Coulomb friction per sample)\n", p[index++]);
+    }
+
+    double poleSum = 0.0;
+    for (unsigned int i = 0; i < structure.order; i++) {
+        poleSum += p[i];
+    }
+    if (structure.order == 0 && inertia > 0.0) {
+        std::printf("  Torque gain J * b / dt = %.6f N*m per unit of input (slope in estimate.py)\n", inertia * inputSum / dt);
+    } else if (structure.order == 1 && p[0] > 0.0 && p[0] < 1.0) {
+        std::printf("  Time constant %.1f ms, steady-state speed %.2f rad/s per unit of input\n", -dt / std::log(p[0]) * 1000.0,
+            inputSum / (1.0 - p[0]));
+    } else if (structure.order > 1 && poleSum < 1.0) {
+        std::printf("  Steady-state speed %.2f rad/s per unit of input\n", inputSum / (1.0 - poleSum));
+    }
+    if (structure.delay > 0) {
+        std::printf("  Dead time %.1f ms\n", structure.delay * dt * 1000.0);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--data file] [--model file] [--max-order 0-3] [--max-inputs n] [--max-delay n] "
+            "[--holdout 0-1] [--window odd n] [--threads n] [--csv file]\n", argv[0]);
+        return 1;
+    }
+    unsigned int threads = threadCount(options.threads);
+
+    std::printf("--- Model Structure Search ---\n");
+
+    CsvTable run;
+    if (!run.load(options.dataPath) || !run.has("Time(s)") || !run.has("Input") || !run.has("Angle") || run.rows() < 200) {
+        std::fprintf(stderr, "Error: could not read Time(s), Input and Angle from %s. Run experiment.py first.\n",
+            options.dataPath.c_str());
+        return 1;
+    }
+    ModelFile model;
+    bool haveModel = model.load(options.modelPath);
+    double inertia = model.number("inertia");
+
+    const std::vector<double>& time = run.column("Time(s)");
+    const std::vector<double>& input = run.column("Input");
+    double dt = (time.back() - time.front()) / (time.size() - 1);
+    std::vector<double> speed = savgolFilter(run.column("Angle"), options.window, 3, 1, dt);
+
+    // All candidates are scored on the same samples: after the longest history any of them needs
+    size_t half = options.window / 2;
+    size_t first = half + std::max<size_t>(options.maxOrder, options.maxDelay + options.maxInputs);
+    size_t last = speed.size() - half;
+    size_t split = first + static_cast<size_t>((last - first) * (1.0 - options.holdout));
+    double range = 0.0;
+    for (size_t k = first; k < last; k++) {
+        range = std::max(range, std::fabs(speed[k]));
+    }
+
+    std::vector<Candidate> candidates;
+    for (unsigned int order = 0; order <= options.maxOrder; order++) {
+        for (unsigned int inputs = 1; inputs <= options.maxInputs; inputs++) {
+            for (unsigned int delay = 0; delay <= options.maxDelay; delay++) {
+                for (int friction = 0; friction <= 1; friction++) {
+                    Candidate candidate;
+                    candidate.structure = { order, inputs, delay, friction == 1 };
+                    candidates.push_back(candidate);
+                }
+            }
+        }
+    }
+
+    std::printf("Data: %zu samples, %.1f ms period, from %s\n", time.size(), dt * 1000.0, options.dataPath.c_str());
+    std::printf("Estimation: %zu samples, validation (held out): %zu samples\n", split - first, last - split);
+    std::printf("Candidates: %zu (orders 0-%u, 1-%u input taps, delays 0-%u, with and without Coulomb friction) on %u threads\n",
+        candidates.size(), options.maxOrder, options.maxInputs, options.maxDelay, threads);
+
+    parallelTasks(threads, candidates.size(), [&](size_t index) {
+        fitCandidate(speed, input, first, split, last, range, candidates[index]);
+    });
+
+    std::vector<size_t> aicRank = ranks(candidates, [](const Candidate& x, const Candidate& y) {
+        return x.valid && (!y.valid || x.aic < y.aic);
+    });
+    std::vector<size_t> bicRank = ranks(candidates, [](const Candidate& x, const Candidate& y) {
+        return x.valid && (!y.valid || x.bic < y.bic);
+    });
+    std::vector<size_t> fitRank = ranks(candidates, [](const Candidate& x, const Candidate& y) { return x.fit > y.fit; });
+
+    size_t best = 0, bestBic = 0;
+    for (size_t i = 0; i < candidates.size(); i++) {
+        best = fitRank[i] == 1 ? i : best;
+        bestBic = bicRank[i] == 1 ? i : bestBic;
+    }
+    if (!std::isfinite(candidates[best].fit)) {
+        std::fprintf(stderr, "Error: no candidate follows the held-out data. Is the run long and rich enough?\n");
+        return 1;
+    }
+
+    std::vector<size_t> listed(candidates.size());
+    for (size_t i = 0; i < candidates.size(); i++) {
+        listed[fitRank[i] - 1] = i;
+    }
+    std::printf("\n--- Results (top 10 by held-out fit) ---\n");
+    std::printf("Rank  Structure                                     Params   Fit (%%)   AIC rank   BIC rank\n");
+    for (size_t r = 0; r < std::min<size_t>(10, listed.size()); r++) {
+        const Candidate& candidate = candidates[listed[r]];
+        std::printf("%4zu  %-44s  %6zu   %7.2f   %8zu   %8zu\n", r + 1, describe(candidate.structure).c_str(),
+            parameterCount(candidate.structure), candidate.fit, aicRank[listed[r]], bicRank[listed[r]]);
+    }
+
+    const Candidate& winner = candidates[best];
+    std::printf("\nWinner: %s, %.2f %% held-out fit\n", describe(winner.structure).c_str(), winner.fit);
+    printParameters(winner, dt, inertia);
+    if (bestBic != best) {
+        std::printf("BIC prefers %s (%.2f %% held-out fit)\n", describe(candidates[bestBic].structure).c_str(),
+            candidates[bestBic].fit);
+    }
+
+    if (haveModel) {
+        model.setText("structure_best", describe(winner.structure));
+        model.setNumber("structure_fit_percent", winner.fit);
+        if (model.save(options.modelPath)) {
+            std::printf("\nWinner saved to %s\n", options.modelPath.c_str());
+        }
+    }
+
+    std::FILE* file = std::fopen(options.csvPath.c_str(), "w");
+    if (file == nullptr) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::fprintf(file, "Order,InputTaps,Delay,Coulomb,Parameters,FreeRunRSS,AIC,BIC,Fit(%%),AICRank,BICRank,FitRank\n");
+    for (size_t r = 0; r < listed.size(); r++) {
+        size_t i = listed[r];
+        const Candidate& candidate = candidates[i];
+        std::fprintf(file, "%u,%u,%u,%d,%zu,%.6e,%.4f,%.4f,%.4f,%zu,%zu,%zu\n", candidate.structure.order,
+            candidate.structure.inputs, candidate.structure.delay, candidate.structure.friction ? 1 : 0,
+            parameterCount(candidate.structure), candidate.rss, candidate.aic, candidate.bic, candidate.fit, aicRank[i],
+            bicRank[i], fitRank[i]);
+    }
+    std::fclose(file);
+    std::printf("All candidates saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
@@ -0,0 +1,566 @@
+// Subspace identification (PO-MOESP): fits a discrete state-space model
+//   x(k+1) = A x(k) + B u(k)
+//   y(k)   = C x(k) + D u(k)
+// to a multichannel capture, e.g. both wheels of mimo_experiment.py or one of experiment.py.
+//
+// The block Hankel matrix [future inputs; past inputs; past outputs; future outputs], with
+// s block rows and one column per sample, is never stored: its transpose is reduced to
+// R (the LQ factor of the Hankel matrix) a block of rows at a time, split over threads, and
+// the per-thread R factors are merged with one more QR. The SVD of the block that maps the
+// past onto the future outputs gives the singular values the order is read from, and the
+// extended observability matrix that holds A and C. B, D and the initial state follow from
+// one linear least-squares fit over the simulated unit responses, again split over threads.
+//
+// Channels are centred and scaled to unit variance before the fit; the saved model is in the
+// original units, around the saved offsets. Angle outputs only integrate the input, so by
+// default they are differentiated into speeds first (--derivative 0 keeps the raw columns).
+//
+// Usage: subspace_id [--data ../mimo_data.csv] [--inputs Input0,Input1] [--outputs Angle0,Angle1]
+//                    [--derivative 1] [--window 11] [--block-rows 10] [--order 0 (auto)]
+//                    [--max-order 8] [--threads 0 (all cores)]
+//                    [--out ../state_space_model.json] [--csv subspace_id.csv]
+
+#include <CsvTable.h>
+#include <Fitting.h>
+#include <Linalg.h>
+#include <Parallel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Hankel rows folded into R per QR update
+const size_t qrBlockRows = 1024;
+// Unit responses growing past this mean an unstable A, the B/D fit is meaningless then
+const double divergenceLimit = 1e12;
+// Unit responses below this no longer matter against unit-variance data
+const double negligible = 1e-100;
+
+typedef struct {
+    std::string dataPath = "../mimo_data.csv";
+    std::string inputs = "Input0,Input1";
+    std::string outputs = "Angle0,Angle1";
+    std::string outPath = "../state_space_model.json";
+    std::string csvPath = "subspace_id.csv";
+    unsigned int derivative = 1;
+    unsigned int window = 11;
+    unsigned int blockRows = 10;
+    unsigned int order = 0;
+    unsigned int maxOrder = 8;
+    unsigned int threads = 0;
+} Options;
+
+// Centred, unit-variance channels, time-major: value(k, channel) = values[k * channels + channel]
+typedef struct {
+    size_t samples;
+    size_t channels;
+    std::vector<double> values;
+    std::vector<double> offset;
+    std::vector<double> scale;
+} Signals;
+
+typedef struct {
+    Matrix a, b, c, d;
+    std::vector<double> x0;
+} StateSpace;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--data") {
+            options.dataPath = value;
+        } else if (flag == "--inputs") {
+            options.inputs = value;
+        } else if (flag == "--outputs") {
+            options.outputs = value;
+        } else if (flag == "--out") {
+            options.outPath = value;
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--derivative") {
+            options.derivative = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--window") {
+            options.window = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--block-rows") {
+            options.blockRows = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--order") {
+            options.order = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--max-order") {
+            options.maxOrder = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--threads") {
+            options.threads = std::strtoul(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.derivative <= 2 && options.window >= 5 && options.window % 2 == 1
+        && options.blockRows >= 2 && options.maxOrder >= 1;
+}
+
+std::vector<std::string> splitNames(const std::string& list)
+{
+    std::vector<std::string> names;
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        if (end > start) {
+            names.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return names;
+}
+
+Signals makeSignals(const std::vector<std::vector<double>>& columns, size_t first, size_t count)
+{
+    Signals signals;
+    signals.samples = count;
+    signals.channels = columns.size();
+    signals.values.resize(count * columns.size());
+    for (const std::vector<double>& column : columns) {
+        double mean = 0.0, variance = 0.0;
+        for (size_t k = first; k < first + count; k++) {
+            mean += column[k] / count;
+        }
+        for (size_t k = first; k < first + count; k++) {
+            variance += (column[k] - mean) * (column[k] - mean) / count;
+        }
+        signals.offset.push_back(mean);
+        signals.scale.push_back(variance > 0.0 ? std::sqrt(variance) : 1.0);
+    }
+    for (size_t k = 0; k < count; k++) {
+        for (size_t channel = 0; channel < columns.size(); channel++) {
+            signals.values[k * columns.size() + channel] =
+                (columns[channel][first + k] - signals.offset[channel]) / signals.scale[channel];
+        }
+    }
+    return signals;
+}
+
+// Column j of the block Hankel matrix, laid out as [U_f; U_p; Y_p; Y_f]
+void hankelColumn(const Signals& u, const Signals& y, size_t s, size_t j, double* out)
+{
+    const size_t m = u.channels, l = y.channels;
+    std::copy(&u.values[(j + s) * m], &u.values[(j + 2 * s) * m], out);
+    out += s * m;
+    std::copy(&u.values[j * m], &u.values[(j + s) * m], out);
+    out += s * m;
+    std::copy(&y.values[j * l], &y.values[(j + s) * l], out);
+    out += s * l;
+    std::copy(&y.values[(j + s) * l], &y.values[(j + 2 * s) * l], out);
+}
+
+// Lower-triangular L of the Hankel matrix H = L Q, as the transpose of R in H^T = Q^T R
+Matrix hankelFactor(const Signals& u, const Signals& y, size_t s, unsigned int threads)
+{
+    const size_t width = 2 * s * (u.channels + y.channels);
+    const size_t columns = u.samples - 2 * s + 1;
+
+    std::vector<Matrix> factors(threads, Matrix(width, width));
+    parallelFor(threads, columns, [&](unsigned int t, size_t begin, size_t end) {
+        std::vector<double> rows(qrBlockRows * width);
+        for (size_t j = begin; j < end; j += qrBlockRows) {
+            size_t count = std::min(qrBlockRows, end - j);
+            for (size_t i = 0; i < count; i++) {
+                hankelColumn(u, y, s, j + i, &rows[i * width]);
+            }
+            qrUpdate(factors[t], rows.data(), count);
+        }
+    });
+
+    Matrix r = factors[0];
+    for (unsigned int t = 1; t < threads; t++) {
+        qrUpdate(r, factors[t].row(0), width);
+    }
+    return r.transpose();
+}
+
+// Order at the largest drop between consecutive singular values
+unsigned int chooseOrder(const std::vector<double>& singular, unsigned int maxOrder)
+{
+    unsigned int best = 1;
+    double bestGap = 0.0;
+    for (unsigned int n = 1; n <= maxOrder && n < singular.size(); n++) {
+        double gap = singular[n - 1] / std::max(singular[n], 1e-300 * singular[0]);
+        if (gap > bestGap) {
+            bestGap = gap;
+            best = n;
+        }
+    }
+    return best;
+}
+
+// A and C from the column space of the past-to-future block
+void observability(const Matrix& u1, const std::vector<double>& singular, size_t n, size_t s, size_t l, StateSpace& model)
+{
+    Matrix gamma(s * l, n);
+    for (size_t i = 0; i < s * l; i++) {
+        for (size_t k = 0; k < n; k++) {
+            gamma(i, k) = u1(i, k) * std::sqrt(singular[k]);
+        }
+    }
+    model.c = gamma.block(0, 0, l, n);
+    // Shift invariance: gamma without its last block row times A is gamma without its first
+    model.a = solveLeastSquares(gamma.block(0, 0, (s - 1) * l, n), gamma.block(l, 0, (s - 1) * l, n));
+}
+
+// Unknowns of the B/D fit: B (n x m), D (l x m), x0 (n). The output is linear in all of them;
+// each B and x0 entry contributes a simulated response, each D entry the input itself.
+bool fitInputMatrices(const Signals& u, const Signals& y, unsigned int threads, StateSpace& model)
+{
+    const size_t n = model.a.rows(), m = u.channels, l = y.channels;
+    const size_t responses = n * m + n;
+    const size_t unknowns = n * m + l * m + n;
+
+    // One state per response; x0 responses start from a unit state, B responses from zero
+    Matrix start(n, responses);
+    for (size_t i = 0; i < n; i++) {
+        start(i, n * m + i) = 1.0;
+    }
+    auto step = [&](Matrix& states, Matrix& next, size_t k) {
+        multiply(model.a, states, next);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < m; j++) {
+                next(i, i * m + j) += u.values[k * m + j];
+            }
+            // The x0 responses decay into denormals, which would slow every later step down
+            for (size_t r = n * m; r < responses; r++) {
+                if (std::fabs(next(i, r)) < negligible) {
+                    next(i, r) = 0.0;
+                }
+            }
+        }
+        std::swap(states, next);
+    };
+
+    // A cheap sequential pass for the state at each thread's first sample
+    std::vector<Matrix> chunkStart(threads);
+    Matrix states = start, next;
+    for (unsigned int t = 0; t < threads; t++) {
+        size_t begin = u.samples * t / threads, end = u.samples * (t + 1) / threads;
+        chunkStart[t] = states;
+        for (size_t k = begin; k < end; k++) {
+            step(states, next, k);
+        }
+    }
+
+    std::vector<LeastSquares> fits(threads, LeastSquares(unknowns));
+    std::vector<char> diverged(threads, 0);
+    parallelFor(threads, u.samples, [&](unsigned int t, size_t begin, size_t end) {
+        Matrix states = chunkStart[t], next, outputs;
+        std::vector<double> row(unknowns);
+        for (size_t k = begin; k < end && !diverged[t]; k++) {
+            multiply(model.c, states, outputs);
+            for (size_t channel = 0; channel < l; channel++) {
+                std::fill(row.begin(), row.end(), 0.0);
+                for (size_t r = 0; r < responses; r++) {
+                    size_t index = r < n * m ? r : r + l * m;
+                    row[index] = outputs(channel, r);
+                }
+                for (size_t j = 0; j < m; j++) {
+                    row[n * m + channel * m + j] = u.values[k * m + j];
+                }
+                for (double value : row) {
+                    diverged[t] |= !(std::fabs(value) < divergenceLimit);
+                }
+                fits[t].add(row.data(), y.values[k * l + channel]);
+            }
+            step(states, next, k);
+        }
+    });
+    for (unsigned int t = 0; t < threads; t++) {
+        if (diverged[t]) {
+            return false;
+        }
+        if (t > 0) {
+            fits[0].merge(fits[t]);
+        }
+    }
+
+    std::vector<double> solution;
+    if (!fits[0].solve(solution)) {
+        return false;
+    }
+    model.b = Matrix(n, m);
+    model.d = Matrix(l, m);
+    model.x0.assign(solution.begin() + n * m + l * m, solution.end());
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < m; j++) {
+            model.b(i, j) = solution[i * m + j];
+        }
+    }
+    for (size_t i = 0; i < l; i++) {
+        for (size_t j = 0; j < m; j++) {
+            model.d(i, j) = solution[n * m + i * m + j];
+        }
+    }
+    return true;
+}
+
+// Variance accounted for per output, in %, simulating the model over the data it was fitted to
+std::vector<double> varianceAccountedFor(const Signals& u, const Signals& y, const StateSpace& model)
+{
+    const size_t n = model.a.rows(), m = u.channels, l = y.channels;
+    Matrix x(n, 1), input(m, 1), output, direct, next, driven;
+    for (size_t i = 0; i < n; i++) {
+        x(i, 0) = model.x0[i];
+    }
+    std::vector<double> errorSum(l, 0.0), errorSquares(l, 0.0);
+    for (size_t k = 0; k < u.samples; k++) {
+        for (size_t j = 0; j < m; j++) {
+            input(j, 0) = u.values[k * m + j];
+        }
+        multiply(model.c, x, output);
+        multiply(model.d, input, direct);
+        for (size_t channel = 0; channel < l; channel++) {
+            double error = y.values[k * l + channel] - output(channel, 0) - direct(channel, 0);
+            errorSum[channel] += error;
+            errorSquares[channel] += error * error;
+        }
+        multiply(model.a, x, next);
+        multiply(model.b, input, driven);
+        for (size_t i = 0; i < n; i++) {
+            x(i, 0) = next(i, 0) + driven(i, 0);
+        }
+    }
+
+    // The outputs have unit variance after scaling
+    std::vector<double> vaf(l);
+    for (size_t channel = 0; channel < l; channel++) {
+        double mean = errorSum[channel] / u.samples;
+        vaf[channel] = 100.0 * (1.0 - (errorSquares[channel] / u.samples - mean * mean));
+    }
+    return vaf;
+}
+
+// Back to the units of the data: B and D per unit of input, C and D in output units
+void unscale(const Signals& u, const Signals& y, StateSpace& model)
+{
+    for (size_t i = 0; i < model.b.rows(); i++) {
+        for (size_t j = 0; j < u.channels; j++) {
+            model.b(i, j) /= u.scale[j];
+        }
+    }
+    for (size_t i = 0; i < y.channels; i++) {
+        for (size_t k = 0; k < model.c.cols(); k++) {
+            model.c(i, k) *= y.scale[i];
+        }
+        for (size_t j = 0; j < u.channels; j++) {
+            model.d(i, j) *= y.scale[i] / u.scale[j];
+        }
+    }
+}
+
+void printMatrix(const char* name, const Matrix& matrix)
+{
+    for (size_t i = 0; i < matrix.rows(); i++) {
+        std::printf("%s %s", i == 0 ? name : " ", i == 0 ? "=" : " ");
+        for (size_t j = 0; j < matrix.cols(); j++) {
+            std::printf(" %+12.5e", matrix(i, j));
+        }
+        std::printf("\n");
+    }
+}
+
+void writeMatrix(std::FILE* file, const char* name, const Matrix& matrix)
+{
+    std::fprintf(file, "    \"%s\": [", name);
+    for (size_t i = 0; i < matrix.rows(); i++) {
+        std::fprintf(file, "%s[", i == 0 ? "" : ", ");
+        for (size_t j = 0; j < matrix.cols(); j++) {
+            std::fprintf(file, "%s%.10g", j == 0 ? "" : ", ", matrix(i, j));
+        }
+        std::fprintf(file, "]");
+    }
+    std::fprintf(file, "],\n");
+}
+
+void writeList(std::FILE* file, const char* name, const std::vector<double>& values)
+{
+    std::fprintf(file, "    \"%s\": [", name);
+    for (size_t i = 0; i < values.size(); i++) {
+        std::fprintf(file, "%s%.10g", i == 0 ? "" : ", ", values[i]);
+    }
+    std::fprintf(file, "],\n");
+}
+
+void writeNames(std::FILE* file, const char* name, const std::vector<std::string>& values)
+{
+    std::fprintf(file, "    \"%s\": [", name);
+    for (size_t i = 0; i < values.size(); i++) {
+        std::fprintf(file, "%s\"%s\"", i == 0 ? "" : ", ", values[i].c_str());
+    }
+    std::fprintf(file, "],\n");
+}
+
+bool writeModel(const std::string& path, const Options& options, const std::vector<std::string>& inputs,
+    const std::vector<std::string>& outputs, const Signals& u, const Signals& y, double dt,
+    const StateSpace& model, const std::vector<double>& vaf)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "    \"method\": \"PO-MOESP\",\n");
+    std::fprintf(file, "    \"dt\": %.10g,\n", dt);
+    std::fprintf(file, "    \"order\": %zu,\n", model.a.rows());
+    std::fprintf(file, "    \"block_rows\": %u,\n", options.blockRows);
+    std::fprintf(file, "    \"output_derivative\": %u,\n", options.derivative);
+    writeNames(file, "inputs", inputs);
+    writeNames(file, "outputs", outputs);
+    writeList(file, "input_offset", u.offset);
+    writeList(file, "output_offset", y.offset);
+    writeMatrix(file, "A", model.a);
+    writeMatrix(file, "B", model.b);
+    writeMatrix(file, "C", model.c);
+    writeMatrix(file, "D", model.d);
+    std::vector<double> vafFractions;
+    for (double value : vaf) {
+        vafFractions.push_back(value / 100.0);
+    }
+    writeList(file, "vaf", vafFractions);
+    std::fprintf(file, "    \"samples\": %zu\n", u.samples);
+    std::fprintf(file, "}\n");
+    std::fclose(file);
+    return true;
+}
+
+bool writeCsv(const std::string& path, const std::vector<double>& singular)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "Index,SingularValue,Relative\n");
+    for (size_t i = 0; i < singular.size(); i++) {
+        std::fprintf(file, "%zu,%.6e,%.6e\n", i + 1, singular[i], singular[i] / singular[0]);
+    }
+    std::fclose(file);
+    return true;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--data file] [--inputs a,b] [--outputs a,b] [--derivative 0-2] [--window odd n]\n"
+                             "          [--block-rows n] [--order n] [--max-order n] [--threads n] [--out file] [--csv file]\n",
+            argv[0]);
+        return 1;
+    }
+    unsigned int threads = threadCount(options.threads);
+
+    std::printf("--- Subspace Identification (PO-MOESP) ---\n");
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> inputNames = splitNames(options.inputs), outputNames = splitNames(options.outputs);
+    CsvTable run;
+    bool complete = run.load(options.dataPath) && run.has("Time(s)") && !inputNames.empty() && !outputNames.empty();
+    for (const std::vector<std::string>* names : { &inputNames, &outputNames }) {
+        for (const std::string& name : *names) {
+            complete = complete && run.has(name);
+        }
+    }
+    size_t edge = options.derivative > 0 ? options.window / 2 : 0;
+    size_t minimum = 2 * edge + 20 * options.blockRows * (inputNames.size() + outputNames.size());
+    if (!complete || run.rows() < minimum) {
+        std::fprintf(stderr, "Error: could not read Time(s), %s and %s from %s (at least %zu rows).\n", options.inputs.c_str(),
+            options.outputs.c_str(), options.dataPath.c_str(), minimum);
+        return 1;
+    }
+
+    const std::vector<double>& time = run.column("Time(s)");
+    double dt = (time.back() - time.front()) / (time.size() - 1);
+    std::vector<std::vector<double>> inputColumns, outputColumns;
+    for (const std::string& name : inputNames) {
+        inputColumns.push_back(run.column(name));
+    }
+    for (const std::string& name : outputNames) {
+        if (options.derivative > 0) {
+            outputColumns.push_back(savgolFilter(run.column(name), options.window, 3, options.derivative, dt));
+        } else {
+            outputColumns.push_back(run.column(name));
+        }
+    }
+
+    // The derivative filter has no full window at the ends
+    size_t samples = time.size() - 2 * edge;
+    Signals u = makeSignals(inputColumns, edge, samples);
+    Signals y = makeSignals(outputColumns, edge, samples);
+    const size_t s = options.blockRows, m = u.channels, l = y.channels;
+    std::printf("Data: %zu samples, %.2f ms period, %zu inputs, %zu outputs%s, from %s (%.2f s)\n", samples, dt * 1000.0, m, l,
+        options.derivative == 1 ? " (differentiated)" : options.derivative == 2 ? " (differentiated twice)" : "",
+        options.dataPath.c_str(), secondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    Matrix lower = hankelFactor(u, y, s, threads);
+    std::printf("Hankel LQ: %zu x %zu, %u threads (%.2f s)\n", 2 * s * (m + l), samples - 2 * s + 1, threads, secondsSince(start));
+
+    start = std::chrono::steady_clock::now();
+    Matrix u1, v1;
+    std::vector<double> singular;
+    svd(lower.block(2 * s * m + s * l, s * m, s * l, s * (m + l)), u1, singular, v1);
+    if (singular.empty() || !(singular[0] > 0.0)) {
+        std::fprintf(stderr, "Error: the outputs do not depend on the past. Are the channels constant?\n");
+        return 1;
+    }
+
+    unsigned int maxOrder = std::min<unsigned int>(options.maxOrder, s * l - 1);
+    unsigned int order = options.order > 0 ? std::min<unsigned int>(options.order, s * l - 1) : chooseOrder(singular, maxOrder);
+    std::printf("Singular values (relative):");
+    for (size_t i = 0; i < singular.size() && i <= maxOrder; i++) {
+        std::printf(" %.2e%s", singular[i] / singular[0], i + 1 == order ? " |" : "");
+    }
+    std::printf("\nOrder: %u (%s)\n", order, options.order > 0 ? "given" : "largest singular value gap");
+
+    StateSpace model;
+    observability(u1, singular, order, s, l, model);
+    if (!fitInputMatrices(u, y, threads, model)) {
+        std::fprintf(stderr, "Error: the identified A is unstable or B/D are undetermined. Try a lower --order or --derivative 1.\n");
+        return 1;
+    }
+    std::vector<double> vaf = varianceAccountedFor(u, y, model);
+    unscale(u, y, model);
+    std::printf("Model: %.2f s\n", secondsSince(start));
+
+    std::printf("\n--- Results (order %u, dt %.2f ms) ---\n", order, dt * 1000.0);
+    printMatrix("A", model.a);
+    printMatrix("B", model.b);
+    printMatrix("C", model.c);
+    printMatrix("D", model.d);
+    for (size_t channel = 0; channel < l; channel++) {
+        std::printf("Output %s: variance accounted for %.2f %%\n", outputNames[channel].c_str(), vaf[channel]);
+    }
+
+    if (!writeModel(options.outPath, options, inputNames, outputNames, u, y, dt, model, vaf)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.outPath.c_str());
+        return 1;
+    }
+    std::printf("\nModel saved to %s\n", options.outPath.c_str());
+
+    if (!writeCsv(options.csvPath, singular)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("Singular values saved to %s\n", options.csvPath.c_str());
+    return 0;
+}
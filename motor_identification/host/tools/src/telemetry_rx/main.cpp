@@ -0,0 +1,347 @@
+// Telemetry receiver: collects the UDP sample stream of a TELEMETRY_UDP firmware build
+// (board over Wi-Fi, or the native build over loopback) and accounts for every frame.
+//
+// Usage: telemetry_rx [--port 5600] [--duration 0] [--idle 5] [--csv telemetry.csv]
+//                     [--shm /motor_telemetry]
+//
+// --duration 0 runs until the stream has been idle for --idle seconds.
+// --shm also publishes every sample as it arrives to a shared-memory ring (see ShmRing.h),
+// which any number of analysis or plotting processes can follow.
+
+#include <SerialPort.h>
+#include <ShmRing.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// --- Frame Definitions (Must match Telemetry.h) ---
+const uint8_t TELEMETRY_VERSION = 1;
+const uint8_t TELEMETRY_MAX_CHANNELS = 8;
+const size_t TELEMETRY_HEADER_SIZE = 12;
+
+const size_t maxDatagramSize = 65536;
+const size_t shmCapacity = 65536; // About a minute of 1 kHz samples
+
+typedef struct {
+    uint16_t port = 5600;
+    double durationSec = 0.0;
+    double idleSec = 5.0;
+    std::string csvPath = "telemetry.csv";
+    std::string shmName;
+} Options;
+
+typedef struct {
+    uint32_t sequence;
+    uint32_t timeUs;
+    uint8_t channels;
+    float values[TELEMETRY_MAX_CHANNELS];
+} Sample;
+
+// Every frame the device numbered is either received, lost in the network or reported
+// by the device itself as not sent
+typedef struct {
+    size_t frames = 0;
+    size_t samples = 0;
+    size_t bytes = 0;
+    size_t duplicates = 0;
+    size_t reordered = 0;
+    size_t malformed = 0;
+    uint32_t firstSequence = 0;
+    uint32_t lastSequence = 0;
+    uint32_t deviceFailed = 0;
+    std::vector<bool> seen; // Indexed by sequence - firstSequence
+} Accounting;
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i];
+        const char* value = argv[i + 1];
+        if (flag == "--port") {
+            options.port = std::strtoul(value, nullptr, 10);
+        } else if (flag == "--duration") {
+            options.durationSec = std::strtod(value, nullptr);
+        } else if (flag == "--idle") {
+            options.idleSec = std::strtod(value, nullptr);
+        } else if (flag == "--csv") {
+            options.csvPath = value;
+        } else if (flag == "--shm") {
+            options.shmName = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+int openSocket(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Bursts of kilohertz samples must not overflow the default receive buffer
+    int size = 4 * 1024 * 1024;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Returns false for datagrams that are not telemetry frames
+bool parseFrame(const uint8_t* data, size_t length, Accounting& accounting, std::vector<Sample>& samples)
+{
+    if (length < TELEMETRY_HEADER_SIZE || data[0] != TELEMETRY_VERSION) {
+        return false;
+    }
+
+    uint8_t channels = data[1];
+    uint8_t count = data[2];
+    size_t sampleSize = 4 + 4 * channels;
+    if (channels > TELEMETRY_MAX_CHANNELS || length != TELEMETRY_HEADER_SIZE + count * sampleSize) {
+        return false;
+    }
+
+    uint32_t sequence, failed;
+    std::memcpy(&sequence, &data[4], sizeof(sequence));
+    std::memcpy(&failed, &data[8], sizeof(failed));
+
+    if (accounting.frames == 0) {
+        accounting.firstSequence = sequence;
+        accounting.lastSequence = sequence;
+    }
+
+    // Frames from before the first one received cannot be told apart from a previous run
+    if (static_cast<int32_t>(sequence - accounting.firstSequence) < 0) {
+        accounting.reordered++;
+        return true;
+    }
+
+    size_t index = sequence - accounting.firstSequence;
+    if (index >= accounting.seen.size()) {
+        accounting.seen.resize(index + 1, false);
+    }
+    if (accounting.seen[index]) {
+        accounting.duplicates++;
+        return true;
+    }
+    accounting.seen[index] = true;
+
+    if (accounting.frames > 0 && static_cast<int32_t>(sequence - accounting.lastSequence) < 0) {
+        accounting.reordered++;
+    } else {
+        accounting.lastSequence = sequence;
+        accounting.deviceFailed = failed;
+    }
+    accounting.frames++;
+    accounting.bytes += length;
+
+    const uint8_t* cursor = data + TELEMETRY_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; i++) {
+        Sample sample;
+        sample.sequence = sequence;
+        sample.channels = channels;
+        std::memcpy(&sample.timeUs, cursor, sizeof(sample.timeUs));
+        std::memcpy(sample.values, cursor + 4, 4 * channels);
+        cursor += sampleSize;
+        samples.push_back(sample);
+    }
+    accounting.samples += count;
+    return true;
+}
+
+void publishSamples(ShmRingWriter& ring, const std::vector<Sample>& samples, size_t first, int64_t receivedUs)
+{
+    SampleRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.hostUs = receivedUs;
+
+    for (size_t i = first; i < samples.size(); i++) {
+        record.sequence = samples[i].sequence;
+        record.timeUs = samples[i].timeUs;
+        record.channels = samples[i].channels;
+        std::memcpy(record.values, samples[i].values, sizeof(record.values));
+        ring.publish(&record);
+    }
+}
+
+size_t lostFrames(const Accounting& accounting)
+{
+    size_t lost = 0;
+    for (bool seen : accounting.seen) {
+        lost += !seen;
+    }
+    return lost;
+}
+
+void printProgress(const Accounting& accounting, double elapsedSec)
+{
+    std::printf("   %6.1f s: %zu frames, %zu samples, %zu lost, %zu duplicates, %zu reordered, %u failed on device\n",
+        elapsedSec, accounting.frames, accounting.samples, lostFrames(accounting), accounting.duplicates,
+        accounting.reordered, accounting.deviceFailed);
+}
+
+bool writeCsv(const std::string& path, std::vector<Sample>& samples)
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+
+    // Reordered frames are put back in place; device time wraps after about 71 minutes
+    std::stable_sort(samples.begin(), samples.end(), [](const Sample& a, const Sample& b) {
+        return static_cast<int32_t>(a.sequence - b.sequence) < 0;
+    });
+
+    uint8_t channels = 0;
+    for (const Sample& sample : samples) {
+        channels = std::max(channels, sample.channels);
+    }
+
+    std::fprintf(file, "Sequence,DeviceTime(s)");
+    for (uint8_t i = 0; i < channels; i++) {
+        std::fprintf(file, ",Ch%u", i);
+    }
+    std::fprintf(file, "\n");
+
+    for (const Sample& sample : samples) {
+        std::fprintf(file, "%u,%.6f", sample.sequence, sample.timeUs * 1e-6);
+        for (uint8_t i = 0; i < channels; i++) {
+            if (i < sample.channels) {
+                std::fprintf(file, ",%.6f", sample.values[i]);
+            } else {
+                std::fprintf(file, ",");
+            }
+        }
+        std::fprintf(file, "\n");
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--port N] [--duration s] [--idle s] [--csv file] [--shm name]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("--- Telemetry Receiver ---\n");
+
+    int fd = openSocket(options.port);
+    if (fd < 0) {
+        std::fprintf(stderr, "Error: could not bind UDP port %u: %s\n", options.port, std::strerror(errno));
+        return 1;
+    }
+    std::printf("Listening on UDP port %u...\n", options.port);
+
+    ShmRingWriter ring;
+    if (!options.shmName.empty()) {
+        if (!ring.create(options.shmName, sizeof(SampleRecord), shmCapacity)) {
+            std::fprintf(stderr, "Error: could not create shared-memory ring %s\n", options.shmName.c_str());
+            return 1;
+        }
+        std::printf("Publishing samples to shared memory %s\n", options.shmName.c_str());
+    }
+
+    Accounting accounting;
+    std::vector<Sample> samples;
+    std::vector<uint8_t> datagram(maxDatagramSize);
+
+    int64_t startUs = 0;
+    int64_t lastFrameUs = monotonicMicros();
+    int64_t lastProgressUs = lastFrameUs;
+
+    while (true) {
+        int64_t nowUs = monotonicMicros();
+        if (options.durationSec > 0.0 && startUs != 0 && nowUs - startUs > options.durationSec * 1e6) {
+            break;
+        }
+        if (accounting.frames > 0 && nowUs - lastFrameUs > options.idleSec * 1e6) {
+            break;
+        }
+
+        pollfd request = { fd, POLLIN, 0 };
+        if (poll(&request, 1, 100) <= 0) {
+            continue;
+        }
+
+        ssize_t length = recv(fd, datagram.data(), datagram.size(), 0);
+        if (length < 0) {
+            continue;
+        }
+
+        nowUs = monotonicMicros();
+        size_t parsed = samples.size();
+        if (!parseFrame(datagram.data(), length, accounting, samples)) {
+            accounting.malformed++;
+            continue;
+        }
+        if (!options.shmName.empty()) {
+            publishSamples(ring, samples, parsed, nowUs);
+        }
+        if (startUs == 0) {
+            startUs = nowUs;
+            std::printf("Receiving...\n");
+        }
+        lastFrameUs = nowUs;
+
+        if (nowUs - lastProgressUs > 1000000) {
+            printProgress(accounting, (nowUs - startUs) * 1e-6);
+            lastProgressUs = nowUs;
+        }
+    }
+    close(fd);
+
+    double elapsedSec = (lastFrameUs - startUs) * 1e-6;
+    size_t lost = lostFrames(accounting);
+    size_t numbered = accounting.seen.size();
+
+    std::printf("\n--- Telemetry Report ---\n");
+    std::printf("Frames received:       %zu of %zu numbered (%.3f %% lost)\n", accounting.frames, numbered,
+        numbered > 0 ? 100.0 * lost / numbered : 0.0);
+    std::printf("Lost in the network:   %zu\n", lost);
+    std::printf("Failed on the device:  %u\n", accounting.deviceFailed);
+    std::printf("Duplicates:            %zu\n", accounting.duplicates);
+    std::printf("Reordered:             %zu\n", accounting.reordered);
+    std::printf("Malformed datagrams:   %zu\n", accounting.malformed);
+    std::printf("Samples:               %zu (%.0f /s)\n", accounting.samples, elapsedSec > 0.0 ? accounting.samples / elapsedSec : 0.0);
+    std::printf("Throughput:            %.0f B/s\n", elapsedSec > 0.0 ? accounting.bytes / elapsedSec : 0.0);
+
+    if (accounting.frames == 0) {
+        std::fprintf(stderr, "Error: no telemetry received.\n");
+        return 1;
+    }
+    if (!writeCsv(options.csvPath, samples)) {
+        std::fprintf(stderr, "Error: could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    std::printf("Samples saved to %s\n", options.csvPath.c_str());
+
+    return lost == 0 && accounting.deviceFailed == 0 ? 0 : 2;
+}
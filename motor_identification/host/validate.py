@@ -1,6 +1,5 @@
 import serial
 import time
-import struct
 import csv
 import json
 import pandas as pd
@@ -8,7 +7,9 @@ import numpy as np
 import matplotlib.pyplot as plt
 import os
 import sys
-from scipy.signal import savgol_filter
+from clock_sync import ClockSync
+from chunks import resync, read_chunks
+from native import decode_capture, savgol_filter
 
 # --- Configuration ---
 SERIAL_PORT = '/dev/ttyUSB0' 
@@ -53,6 +54,9 @@ def run_experiment_and_process_data(inertia_value):
             pass
         print("   -> Connection confirmed.")
 
+        sync = ClockSync(ser)
+        sync.burst()
+
         # 2. User Start
         input("Press [Enter] to start the validation experiment...")
 
@@ -67,12 +71,11 @@ def run_experiment_and_process_data(inertia_value):
 
         # 4. Wait for completion
         print("Waiting for test completion (~41 seconds)...")
-        ser.timeout = 60 
-        if ser.read(1) != DEVICE_TEST_SUCCESS:
+        if sync.wait_for_byte(60) != DEVICE_TEST_SUCCESS:
             print("Error: Test failed or timed out.")
             return None
         print("   -> Test completed.")
-        ser.timeout = TIMEOUT_SEC 
+        sync.burst()
 
         # 5. Request Data
         print("Requesting data...")
@@ -84,27 +87,32 @@ def run_experiment_and_process_data(inertia_value):
 
         # 6. Read Data
         print("Downloading data stream...")
-        if ser.read(len(DEVICE_DATA_STREAM_START)) != DEVICE_DATA_STREAM_START:
-            print("Error: Invalid header.")
-            return None
-
         bytes_to_read = TEST_DATA_LENGTH * 4
-        raw_input = ser.read(bytes_to_read)
-        raw_angle = ser.read(bytes_to_read)
-
-        if ser.read(len(DEVICE_DATA_STREAM_END)) != DEVICE_DATA_STREAM_END:
-            print("Warning: Invalid footer.")
-
-        fmt = f'<{TEST_DATA_LENGTH}f'
-        input_values = struct.unpack(fmt, raw_input)
-        angle_values = struct.unpack(fmt, raw_angle)
+        raw_data = b''
+        if ser.read(len(DEVICE_DATA_STREAM_START)) == DEVICE_DATA_STREAM_START:
+            raw_data = ser.read(3 * bytes_to_read)
+            if ser.read(len(DEVICE_DATA_STREAM_END)) != DEVICE_DATA_STREAM_END:
+                raw_data = b''
+
+        # A damaged stream is fetched again in CRC-checked chunks
+        if len(raw_data) != 3 * bytes_to_read:
+            print("   -> Stream damaged, fetching it again in checked chunks...")
+            try:
+                resync(ser)
+                raw_data = read_chunks(ser, 3 * bytes_to_read)
+            except IOError as e:
+                print(f"Error: {e}")
+                return None
+
+        input_values, angle_values, time_values = decode_capture(raw_data)
         
-        # Create DataFrame
-        time_axis = [i * SAMPLE_PERIOD_SEC for i in range(TEST_DATA_LENGTH)]
+        # Create DataFrame, timed by the device clock
+        device_time = sync.unwrap(time_values) / 1e6
         df = pd.DataFrame({
-            'Time(s)': time_axis,
-            'Input': input_values,
-            'Real_Angle': angle_values
+            'Time(s)': device_time - device_time[0],
+            'Input': input_values.astype(np.float64),
+            'Real_Angle': angle_values.astype(np.float64),
+            'HostTime(s)': sync.to_host_time(time_values)
         })
         
         # --- Process Derivatives to find Real Torque ---